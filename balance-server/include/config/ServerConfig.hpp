@@ -1,8 +1,11 @@
 #ifndef _INIREADER_HPP_
 #define _INIREADER_HPP_
+#include <algorithm>
+#include <cctype>
 #include <inicpp.h>
 #include <memory>
 #include <singleton/singleton.hpp>
+#include <sstream>
 #include <spdlog/spdlog.h>
 #include <vector>
 
@@ -24,6 +27,9 @@ public:
   std::string Redis_passwd;
   std::size_t Redis_timeout;
 
+  /*every redis node, only [Redis] host/port when nodes is not set*/
+  std::vector<std::pair<std::string, unsigned short>> Redis_nodes;
+
   std::string BalanceServiceAddress;
   std::string BalanceServicePort;
 
@@ -40,6 +46,25 @@ private:
     Redis_ip_addr = m_ini["Redis"]["host"].as<std::string>();
     Redis_passwd = m_ini["Redis"]["password"].as<std::string>();
     Redis_timeout = m_ini["Redis"]["timeout"].as<unsigned long>();
+
+    /*nodes = host1:port1,host2:port2*/
+    std::stringstream ss(m_ini["Redis"]["nodes"].as<std::string>());
+    for (std::string node; std::getline(ss, node, ',');) {
+      node.erase(
+          std::remove_if(node.begin(), node.end(),
+                         [](unsigned char c) { return std::isspace(c); }),
+          node.end());
+      auto pos = node.rfind(':');
+      if (pos == std::string::npos) {
+        continue;
+      }
+      Redis_nodes.emplace_back(
+          node.substr(0, pos),
+          static_cast<unsigned short>(std::stoul(node.substr(pos + 1))));
+    }
+    if (Redis_nodes.empty()) {
+      Redis_nodes.emplace_back(Redis_ip_addr, Redis_port);
+    }
   }
 
   void loadBalanceServiceInfo() {
@@ -83,6 +83,21 @@ enum class ServiceType : uint8_t {
   SERVICE_HEARTBEAT_REQUEST,
   SERVICE_HEARTBEAT_RESPONSE,
 
+  /*user has read messages of a thread until msg_id, reset unread counter*/
+  SERVICE_MARKREADREQUEST,
+  SERVICE_MARKREADRESPONSE,
+
+  /*
+   * client sends the last msg_id of every thread, server returns all newer
+   * messages in several large frames, the last one has is_complete = true
+   */
+  SERVICE_SYNCCHATMSGREQUEST,
+  SERVICE_SYNCCHATMSGRESPONSE,
+
+  /*full-text search over messages of one thread, paged and ranked*/
+  SERVICE_SEARCHCHATMSGREQUEST,
+  SERVICE_SEARCHCHATMSGRESPONSE,
+
   SERVICE_UNKNOWN // unkown service
 };
 
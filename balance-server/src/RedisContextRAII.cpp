@@ -6,18 +6,32 @@
 redis::RedisContext::RedisContext() noexcept
     : m_valid(false), m_redisContext(nullptr) {}
 
-redis::RedisContext::RedisContext(const std::string &ip, unsigned short port,
+redis::RedisContext::RedisContext(std::shared_ptr<const RedisShardRing> ring,
                                   const std::string &password) noexcept
-    : m_valid(false), m_redisContext(redisConnect(ip.c_str(), port)) {
+    : m_valid(false), m_ring(std::move(ring)), m_redisContext(nullptr) {
+
+  for (const auto &[ip, port] : m_ring->nodes()) {
+    m_nodes.emplace_back(redisConnect(ip.c_str(), port));
+  }
+
   /*error occured*/
   if (!checkError()) {
-    m_redisContext.reset();
+    m_nodes.clear();
   } else {
     checkAuth(password);
-    spdlog::info("[Redis]: Connection to Redis Server Successful!");
+    spdlog::info("[Redis]: Connection to {} Redis Node(s) Successful!",
+                 m_nodes.size());
   }
 }
 
+void redis::RedisContext::use(const std::size_t node) {
+  m_redisContext = node < m_nodes.size() ? m_nodes[node].get() : nullptr;
+}
+
+void redis::RedisContext::route(std::string_view key) {
+  use(m_ring ? m_ring->locate(key) : 0);
+}
+
 bool redis::RedisContext::isValid() { return m_valid; }
 
 bool redis::RedisContext::setValue(const std::string &key,
@@ -26,6 +40,7 @@ bool redis::RedisContext::setValue(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("SET %s %s"),
                                               key.c_str(), value.c_str());
@@ -45,6 +60,7 @@ bool redis::RedisContext::setValue2Hash(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status =
@@ -67,6 +83,7 @@ bool redis::RedisContext::delValueFromHash(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("HDEL %s %s"),
@@ -88,6 +105,7 @@ bool redis::RedisContext::leftPush(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("LPUSH %s %s"),
@@ -107,6 +125,7 @@ bool redis::RedisContext::rightPush(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("RPUSH %s %s"),
@@ -125,6 +144,7 @@ bool redis::RedisContext::delPair(const std::string &key) {
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status =
@@ -142,6 +162,7 @@ bool redis::RedisContext::existKey(const std::string &key) {
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("exists %s"),
@@ -155,20 +176,25 @@ bool redis::RedisContext::existKey(const std::string &key) {
 }
 
 bool redis::RedisContext::heartBeat() {
-  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
-  if (!m_replyDelegate->redisCommand(*this, std::string("PING"))) {
-    return false;
-  }
+  /*a broken node breaks the whole context*/
+  for (std::size_t node = 0; node < m_nodes.size(); ++node) {
+    use(node);
+    std::unique_ptr<RedisReply> m_replyDelegate =
+        std::make_unique<RedisReply>();
+    if (!m_replyDelegate->redisCommand(*this, std::string("PING"))) {
+      return false;
+    }
 
-  if (m_replyDelegate->getType().has_value() &&
-      m_replyDelegate->getType().value() != REDIS_REPLY_STRING) {
-    return false;
-  }
-  if (m_replyDelegate->getMessage() == "PONG") {
-    spdlog::info("[Redis]: Execute command [ PING ] successfully!");
-    return true;
+    if (m_replyDelegate->getType().has_value() &&
+        m_replyDelegate->getType().value() != REDIS_REPLY_STRING) {
+      return false;
+    }
+    if (m_replyDelegate->getMessage() != "PONG") {
+      return false;
+    }
   }
-  return false;
+  spdlog::info("[Redis]: Execute command [ PING ] successfully!");
+  return !m_nodes.empty();
 }
 
 std::optional<std::string>
@@ -177,6 +203,7 @@ redis::RedisContext::checkValue(const std::string &key) {
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("GET %s"),
@@ -198,6 +225,7 @@ redis::RedisContext::leftPop(const std::string &key) {
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("LPOP %s"),
@@ -222,6 +250,7 @@ redis::RedisContext::rightPop(const std::string &key) {
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("RPOP %s"),
@@ -244,6 +273,7 @@ redis::RedisContext::getValueFromHash(const std::string &key,
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("HGET %s %s"),
@@ -316,6 +346,7 @@ bool redis::RedisContext::acquireLock(const std::string &lockName,
     return false;
   }
 
+  route(lockName);
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
 
   auto status = m_replyDelegate->redisCommand(
@@ -344,6 +375,7 @@ bool redis::RedisContext::release(const std::string &lockName,
 bool redis::RedisContext::releaseLock(const std::string &lockName,
                                       const std::string &identifer) {
 
+  route(lockName);
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
 
   // Use EVAL to execute lua script
@@ -363,16 +395,23 @@ bool redis::RedisContext::releaseLock(const std::string &lockName,
 }
 
 bool redis::RedisContext::checkError() {
-  if (m_redisContext.get() == nullptr) {
+  if (m_nodes.empty()) {
     spdlog::error("Connection to Redis server failed! No instance!");
     return m_valid; // false;
   }
 
-  /*error occured*/
-  if (m_redisContext->err) {
-    spdlog::error("Connection to Redis server failed! error code {}",
-                  m_redisContext->errstr);
-    return m_valid;
+  for (const auto &node : m_nodes) {
+    if (node.get() == nullptr) {
+      spdlog::error("Connection to Redis server failed! No instance!");
+      return m_valid; // false;
+    }
+
+    /*error occured*/
+    if (node->err) {
+      spdlog::error("Connection to Redis server failed! error code {}",
+                    node->errstr);
+      return m_valid;
+    }
   }
 
   m_valid = true;
@@ -380,18 +419,21 @@ bool redis::RedisContext::checkError() {
 }
 
 bool redis::RedisContext::checkAuth(std::string_view sv) {
-  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
-  auto status =
-      m_replyDelegate->redisCommand(*this, std::string("AUTH %s"), sv.data());
-  if (status) {
-    // spdlog::info("Excute command  [ AUTH ] successfully!");
+  bool status = !m_nodes.empty();
+  for (std::size_t node = 0; node < m_nodes.size(); ++node) {
+    use(node);
+    std::unique_ptr<RedisReply> m_replyDelegate =
+        std::make_unique<RedisReply>();
+    status = m_replyDelegate->redisCommand(*this, std::string("AUTH %s"),
+                                           sv.data()) &&
+             status;
   }
   return status;
 }
 
 std::optional<tools::RedisContextWrapper> redis::RedisContext::operator->() {
   if (isValid()) {
-    return tools::RedisContextWrapper(m_redisContext.get());
+    return tools::RedisContextWrapper(m_redisContext);
   }
   return std::nullopt;
 }
@@ -319,6 +319,14 @@ struct ChatMsgPageResult {
   std::vector<std::shared_ptr<ChattingRecordBase>> m_list;
 };
 
+struct ChatSyncResult {
+  // is this the last frame of a sync request?
+  bool m_is_complete = false;
+
+  // messages grouped by thread, m_load_more means thread needs another round
+  std::vector<std::shared_ptr<ChatMsgPageResult>> m_threads;
+};
+
 /*store the friend's identity and the historical info sent before*/
 class UserChatThread {
 public:
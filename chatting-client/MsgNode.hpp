@@ -17,9 +17,22 @@ class TCPNetworkConnection;
 
 enum class MsgNodeType {
   MSGNODE_NORMAL,
-  MSGNODE_FILE_TRANSFER /*file size no more then 4GB*/
+  MSGNODE_FILE_TRANSFER, /*file size no more then 4GB*/
+  MSGNODE_EXTENDED       /*32-bit length with fragmentation flags*/
 };
 
+/*
+ * extended frame is marked by the highest bit of id, so a receiver knows how
+ * to read the rest of header after the first 4 bytes
+ */
+static constexpr uint16_t MSGNODE_EXTENDED_BIT = 0x8000;
+
+/*more fragments of the same message follow this frame*/
+static constexpr uint16_t MSGNODE_FLAG_MORE_FRAGMENTS = 0x0001;
+
+/*body of the whole message is compressed, set on all of its fragments*/
+static constexpr uint16_t MSGNODE_FLAG_COMPRESSED = 0x0002;
+
 // SFINAE test for qFromBigEndian
 template <typename T, typename = void>
 struct has_qt_endian : std::false_type {};
@@ -128,10 +141,13 @@ template <typename Container> struct MsgHeader {
 
   static std::size_t MSGNODE_NORMAL_HEADER_LENGTH;
   static std::size_t MSGNODE_FILE_HEADER_LENGTH;
+  static std::size_t MSGNODE_EXTENDED_HEADER_LENGTH;
 
   std::size_t get_header_length() {
     if (this->_type == MsgNodeType::MSGNODE_FILE_TRANSFER) {
       return MSGNODE_FILE_HEADER_LENGTH;
+    } else if (this->_type == MsgNodeType::MSGNODE_EXTENDED) {
+      return MSGNODE_EXTENDED_HEADER_LENGTH;
     }
     return MSGNODE_NORMAL_HEADER_LENGTH;
   }
@@ -211,6 +227,16 @@ template <typename Container> struct MsgHeader {
     _cur_length += increment;
   }
 
+  /*
+   * replace the body with reassembled fragments, header is not rewritten, it
+   * is only used after the whole message has been received
+   */
+  void replace_msg_body(const Container &body) {
+    _buffer.resize(this->get_header_length());
+    _buffer.append(body);
+    _length = _cur_length = _buffer.size();
+  }
+
   void clear() {
     /*clean previous packet*/
     _buffer.clear();
@@ -234,6 +260,14 @@ protected:
 
   typename std::iterator_traits<typename Container::iterator>::pointer
   get_length_base() {
+    if (_type == MsgNodeType::MSGNODE_EXTENDED) {
+      return get_header_base() + sizeof(uint16_t) + sizeof(uint16_t);
+    }
+    return get_header_base() + sizeof(uint16_t);
+  }
+
+  typename std::iterator_traits<typename Container::iterator>::pointer
+  get_flags_base() {
     return get_header_base() + sizeof(uint16_t);
   }
 
@@ -244,6 +278,10 @@ protected:
   /* ---------------------------------------------
    * name |  _id  |  _length  |     _buffer      |
    * size |   2B  |   2B(4B)  | _length - 4B(6B) |
+   * --------------------------------------------
+   * extended frame(_id with MSGNODE_EXTENDED_BIT):
+   * name |  _id  |  flags  |  _length  |   _buffer    |
+   * size |   2B  |   2B    |    4B     | _length - 8B |
    * --------------------------------------------*/
   std::size_t _length; /*total length*/
   std::size_t _cur_length;
@@ -281,10 +319,38 @@ public:
 
     /*update converted id*/
     this->_id = *(reinterpret_cast<uint16_t *>(this->get_id_base()));
-    this->_id = m_convertor(this->_id);
+    this->_id =
+        static_cast<uint16_t>(m_convertor(this->_id) & ~MSGNODE_EXTENDED_BIT);
     return this->_id;
   }
 
+  /*only the first 4 bytes are needed to know it is an extended frame*/
+  bool is_extended_header() {
+    if (this->_cur_length < this->MSGNODE_NORMAL_HEADER_LENGTH) {
+      return false;
+    }
+    uint16_t id = *(reinterpret_cast<uint16_t *>(this->get_id_base()));
+    return m_convertor(id) & MSGNODE_EXTENDED_BIT;
+  }
+
+  /*read the rest of extended header after first 4 bytes*/
+  void upgrade_to_extended() {
+    this->_type = MsgNodeType::MSGNODE_EXTENDED;
+    this->_length = this->get_header_length();
+    this->_buffer.resize(this->_length, 0);
+  }
+
+  std::optional<uint16_t> get_flags() {
+    if (this->check_header_remaining()) { /*not OK*/
+      return std::nullopt;
+    }
+    if (this->_type != MsgNodeType::MSGNODE_EXTENDED) {
+      return 0;
+    }
+    uint16_t flags = *(reinterpret_cast<uint16_t *>(this->get_flags_base()));
+    return m_convertor(flags);
+  }
+
   /*
    * when user deploy gen_length, it will ONLY return the size of message!
    */
@@ -294,7 +360,8 @@ public:
     }
 
     /*update converted full length*/
-    if (this->_type == MsgNodeType::MSGNODE_FILE_TRANSFER) {
+    if (this->_type == MsgNodeType::MSGNODE_FILE_TRANSFER ||
+        this->_type == MsgNodeType::MSGNODE_EXTENDED) {
       uint32_t len = *(reinterpret_cast<uint32_t *>(this->get_length_base()));
       this->_length = m_convertor(len);
     } else {
@@ -302,6 +369,11 @@ public:
       this->_length = m_convertor(len);
     }
 
+    /*broken header, total length could not be shorter than header*/
+    if (this->_length < this->get_header_length()) {
+      return std::nullopt;
+    }
+
     /*don't forgot to resize*/
     this->_buffer.resize(this->_length, 0);
 
@@ -343,7 +415,8 @@ struct SendNode<
     : public MsgHeader<Container> {
 
   SendNode(uint16_t msg_id, Container &string, Callable &&Host2Network,
-           MsgNodeType type = MsgNodeType::MSGNODE_NORMAL) noexcept
+           MsgNodeType type = MsgNodeType::MSGNODE_NORMAL,
+           uint16_t flags = 0) noexcept
       : m_convertor(std::move(Host2Network)),
         MsgHeader<Container>(msg_id, string, type) {
 
@@ -353,7 +426,16 @@ struct SendNode<
     uint16_t cv_id = m_convertor(this->_id);
     *reinterpret_cast<uint16_t *>(this->get_header_base()) = cv_id;
 
-    if (this->_type == MsgNodeType::MSGNODE_FILE_TRANSFER) {
+    if (this->_type == MsgNodeType::MSGNODE_EXTENDED) {
+      cv_id = m_convertor(
+          static_cast<uint16_t>(this->_id | MSGNODE_EXTENDED_BIT));
+      *reinterpret_cast<uint16_t *>(this->get_header_base()) = cv_id;
+      *reinterpret_cast<uint16_t *>(this->get_flags_base()) =
+          m_convertor(flags);
+
+      uint32_t len = m_convertor(static_cast<uint32_t>(this->_length));
+      *reinterpret_cast<uint32_t *>(this->get_length_base()) = len;
+    } else if (this->_type == MsgNodeType::MSGNODE_FILE_TRANSFER) {
       uint32_t len = m_convertor(static_cast<uint32_t>(this->_length));
       *reinterpret_cast<uint32_t *>(this->get_length_base()) = len;
     } else {
@@ -380,4 +462,8 @@ template <typename Container>
 std::size_t MsgHeader<Container>::MSGNODE_FILE_HEADER_LENGTH =
     sizeof(uint16_t) + sizeof(uint32_t);
 
+template <typename Container>
+std::size_t MsgHeader<Container>::MSGNODE_EXTENDED_HEADER_LENGTH =
+    sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t);
+
 #endif
@@ -9,6 +9,7 @@
 #include <ChattingThreadDef.hpp>
 #include <QAction>
 #include <QFile>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QMouseEvent>
@@ -21,6 +22,7 @@
 
 /* define how many chat recoreds are going to show up on chat record list */
 std::size_t ChattingDlgMainFrame::CHATRECORED_PER_PAGE = 9;
+std::size_t ChattingDlgMainFrame::SYNC_THREADS_PER_REQUEST = 16;
 
 bool ChattingDlgMainFrame::enable_heartBeart = true;
 
@@ -290,6 +292,14 @@ void ChattingDlgMainFrame::registerSignal() {
           &TCPNetworkConnection::signal_update_chat_msg, this,
           &ChattingDlgMainFrame::slot_update_chat_msg);
 
+  /*
+   * This function is mainly for the main interface
+   * to merge messages of many threads after delta sync
+   */
+  connect(TCPNetworkConnection::get_instance().get(),
+          &TCPNetworkConnection::signal_sync_chat_msg, this,
+          &ChattingDlgMainFrame::slot_sync_chat_msg);
+
   /*
    * This function is mainly for create private chat UI widget
    * Server has already confirmed the behaviour
@@ -916,8 +926,68 @@ void ChattingDlgMainFrame::slot_update_chat_thread(
     return;
   }
 
-  // load chat data!
-  loadMoreChattingHistory();
+  // load chat data of all threads, only newer messages are returned
+  syncChattingHistory(
+      UserAccountManager::get_instance()->getThreadHighWaterMarks());
+}
+
+void ChattingDlgMainFrame::syncChattingHistory(
+    const std::vector<std::pair<QString, QString>> &marks) {
+
+  for (std::size_t i = 0; i < marks.size(); i += SYNC_THREADS_PER_REQUEST) {
+    QJsonArray threads;
+    for (std::size_t j = i;
+         j < std::min(marks.size(), i + SYNC_THREADS_PER_REQUEST); ++j) {
+      QJsonObject mark;
+      mark["thread_id"] = marks[j].first;
+      mark["msg_id"] = marks[j].second;
+      threads.append(mark);
+    }
+
+    QJsonObject obj;
+    obj["uuid"] = UserAccountManager::get_instance()->getCurUserInfo()->m_uuid;
+    obj["threads"] = threads;
+
+    TCPNetworkConnection::send_buffer(ServiceType::SERVICE_SYNCCHATMSGREQUEST,
+                                      std::move(obj));
+  }
+}
+
+void ChattingDlgMainFrame::slot_sync_chat_msg(
+    std::shared_ptr<ChatSyncResult> package) {
+
+  for (const auto &page : package->m_threads) {
+    auto thread_opt =
+        UserAccountManager::get_instance()->getOrCreateChattingThreadData(
+            page->m_thread_id);
+    if (!thread_opt.has_value()) {
+      qDebug() << "No Chatting Thread Data Found!";
+      continue;
+    }
+    auto thread = thread_opt.value();
+
+    for (auto &item : page->m_list) {
+      thread->insertMessage(item);
+    }
+
+    if (!page->m_next_message_id.isEmpty()) {
+      thread->setLastMessageId(page->m_next_message_id);
+    }
+
+    // this thread has more than one round of messages
+    if (page->m_load_more) {
+      m_syncPending.emplace_back(page->m_thread_id, page->m_next_message_id);
+    }
+  }
+
+  // wait for the last frame of this request
+  if (!package->m_is_complete || m_syncPending.empty()) {
+    return;
+  }
+
+  auto pending = std::move(m_syncPending);
+  m_syncPending.clear();
+  syncChattingHistory(pending);
 }
 
 void ChattingDlgMainFrame::slot_update_chat_msg(
@@ -96,6 +96,10 @@ protected:
   /*load more chatting record*/
   void loadMoreChattingHistory();
 
+  /*fetch messages after the high-water mark of every thread*/
+  void syncChattingHistory(
+      const std::vector<std::pair<QString, QString>> &marks);
+
 private:
   void registerSignal();
 
@@ -219,6 +223,12 @@ private slots:
    */
   void slot_update_chat_msg(std::shared_ptr<ChatMsgPageResult> package);
 
+  /*
+   * This function is mainly for the main interface
+   * to merge messages of many threads after delta sync
+   */
+  void slot_sync_chat_msg(std::shared_ptr<ChatSyncResult> package);
+
   /*
    * This function is mainly for create private chat UI widget
    * Server has already confirmed the behaviour
@@ -240,6 +250,13 @@ private:
   static std::size_t CHATRECORED_PER_PAGE;
   std::size_t m_curr_chat_record_loaded = 0;
 
+  /*server limits request size, so threads are synced in several requests*/
+  static std::size_t SYNC_THREADS_PER_REQUEST;
+
+  /*threads which still have more messages after current sync round*/
+  std::vector<std::pair</*thread_id*/ QString, /*msg_id*/ QString>>
+      m_syncPending;
+
   /*reserve for search line edit*/
   QAction *m_searchAction;
 
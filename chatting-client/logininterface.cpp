@@ -217,6 +217,10 @@ void LoginInterface::slot_connection_status(bool status) {
     json_obj["uuid"] = UserAccountManager::get_instance()->get_uuid();
     json_obj["token"] = UserAccountManager::get_instance()->get_token();
 
+    /*large responses could be sent in fragments of extended frame*/
+    json_obj["extended_frame"] = true;
+    json_obj["compression"] = "deflate";
+
     /*after connection to server, send TCP request*/
     TCPNetworkConnection::send_buffer(ServiceType::SERVICE_LOGINSERVER,
                                       std::move(json_obj));
@@ -118,89 +118,105 @@ void TCPNetworkConnection::registerErrorHandling() {
 void TCPNetworkConnection::setupChattingDataRetrieveEvent(
     QTcpSocket &socket, RecvInfo &received, RecvNodeType &buffer) {
 
-  connect(&socket, &QTcpSocket::readyRead,
-          [&socket, &received, &buffer, this]() {
-            while (socket.bytesAvailable() > 0) {
-              QByteArray array = socket.readAll(); // Read all available data
-
-              /*
-               * Ensure the received data is large enough to include the header
-               * if no enough data, then continue waiting
-               */
-              while (array.size() >= buffer.get_header_length()) {
-
-                // Check if we are still receiving the header
-                if (buffer.check_header_remaining()) {
-
-                  /*
-                   * Take the necessary portion from the array for the header
-                   * Insert the header data into the buffer
-                   */
-                  buffer._buffer = array.left(buffer.get_header_length());
-                  buffer.update_pointer_pos(buffer.get_header_length());
-
-                  received._id = buffer.get_id().value();
-                  received._length = buffer.get_length().value();
-
-                  // Clear the header part from the array
-                  array.remove(0, buffer.get_header_length());
-                }
-
-                if (array.size() < received._length) {
-                  return;
-                }
-
-                // If we have remaining data in array, treat it as body
-                if (buffer.check_body_remaining()) {
-
-                  std::memcpy(buffer.get_body_base(), array.data(),
-                              received._length);
-
-                  buffer.update_pointer_pos(received._length);
-
-                  /*
-                   * Clear the body part from the array
-                   * Maybe there are some other data inside
-                   */
-                  array.remove(0, received._length);
-                }
-              }
-
-              // Now, both the header and body are fully received
-              received._msg = buffer.get_msg_body().value();
-
-              // Debug output to show the received message
-              qDebug() << "msg_id = " << received._id << "\n"
-                       << "msg_length = " << received._length << "\n"
-                       << "msg_data = " << received._msg << "\n";
-
-              // Clear the buffer for the next message
-              buffer.clear();
-
-              /*parse it as json*/
-              QJsonDocument json_obj = QJsonDocument::fromJson(received._msg);
-              if (json_obj.isNull()) { // converting failed
-                // journal log system
-                qDebug() << __FILE__ << "[FATAL ERROR]: json object is null!\n";
-                emit signal_login_failed(ServiceStatus::JSONPARSE_ERROR);
-                return;
-              }
-
-              if (!json_obj.isObject()) {
-                // journal log system
-                qDebug() << __FILE__ << "[FATAL ERROR]: json object is null!\n";
-                emit signal_login_failed(ServiceStatus::JSONPARSE_ERROR);
-                return;
-              }
-
-              try {
-                m_callbacks[static_cast<ServiceType>(received._id)](
-                    std::move(json_obj.object()));
-              } catch (const std::exception &e) {
-                qDebug() << e.what();
-              }
-            }
-          });
+  connect(&socket, &QTcpSocket::readyRead, [&socket, &received, &buffer,
+                                            this]() {
+    /*keep incomplete frames until the rest of them arrives*/
+    received._pending.append(socket.readAll());
+
+    const auto normal = static_cast<qsizetype>(
+        MsgHeader<QByteArray>::MSGNODE_NORMAL_HEADER_LENGTH);
+
+    /*parse every complete frame inside pending data*/
+    while (received._pending.size() >= normal) {
+
+      /*every frame starts with a normal 4 bytes header*/
+      buffer.clear();
+      buffer._type = MsgNodeType::MSGNODE_NORMAL;
+      buffer._buffer = received._pending.left(normal);
+      buffer.update_pointer_pos(normal);
+
+      /*extended frame, 32-bit length follows the flags*/
+      if (buffer.is_extended_header()) {
+        buffer.upgrade_to_extended();
+        if (received._pending.size() <
+            static_cast<qsizetype>(buffer.get_header_length())) {
+          return;
+        }
+        buffer._buffer = received._pending.left(buffer.get_header_length());
+        buffer.update_pointer_pos(buffer.get_header_length() - normal);
+      }
+
+      const auto header = static_cast<qsizetype>(buffer.get_header_length());
+      auto length = buffer.get_length();
+      if (!length.has_value()) {
+        qDebug() << __FILE__ << "[FATAL ERROR]: invalid frame header!\n";
+        received._pending.clear();
+        received._fragments.clear();
+        return;
+      }
+
+      received._id = buffer.get_id().value();
+      received._length = static_cast<uint32_t>(length.value());
+
+      /*wait for the rest of this frame*/
+      if (received._pending.size() < header + received._length) {
+        return;
+      }
+
+      std::memcpy(buffer.get_body_base(),
+                  received._pending.constData() + header, received._length);
+      buffer.update_pointer_pos(received._length);
+      received._pending.remove(0, header + received._length);
+
+      const auto flags = buffer.get_flags().value_or(0);
+
+      /*keep the fragment and wait for the rest of this message*/
+      if (flags & MSGNODE_FLAG_MORE_FRAGMENTS) {
+        received._fragments.append(buffer.get_msg_body().value());
+        continue;
+      }
+
+      // Now, both the header and body are fully received
+      received._msg = received._fragments + buffer.get_msg_body().value();
+      received._fragments.clear();
+
+      /*server uses the same layout as qCompress*/
+      if (flags & MSGNODE_FLAG_COMPRESSED) {
+        received._msg = qUncompress(received._msg);
+      }
+
+      // Debug output to show the received message
+      qDebug() << "msg_id = " << received._id << "\n"
+               << "msg_length = " << received._msg.size() << "\n"
+               << "msg_data = " << received._msg << "\n";
+
+      // Clear the buffer for the next message
+      buffer.clear();
+
+      /*parse it as json*/
+      QJsonDocument json_obj = QJsonDocument::fromJson(received._msg);
+      if (json_obj.isNull()) { // converting failed
+        // journal log system
+        qDebug() << __FILE__ << "[FATAL ERROR]: json object is null!\n";
+        emit signal_login_failed(ServiceStatus::JSONPARSE_ERROR);
+        continue;
+      }
+
+      if (!json_obj.isObject()) {
+        // journal log system
+        qDebug() << __FILE__ << "[FATAL ERROR]: json object is null!\n";
+        emit signal_login_failed(ServiceStatus::JSONPARSE_ERROR);
+        continue;
+      }
+
+      try {
+        m_callbacks[static_cast<ServiceType>(received._id)](
+            std::move(json_obj.object()));
+      } catch (const std::exception &e) {
+        qDebug() << e.what();
+      }
+    }
+  });
 }
 
 void TCPNetworkConnection::setupResourcesDataRetrieveEvent(
@@ -303,6 +319,14 @@ void TCPNetworkConnection::registerCallback() {
           return;
         }
 
+        /*server could send and receive fragmented extended frames*/
+        m_extended_frame = json["extended_frame"].toBool();
+        m_frame_chunk_size =
+            static_cast<std::size_t>(json["frame_chunk_size"].toInt());
+        m_compression = json["compression"].toString() == "deflate";
+        m_compression_threshold =
+            static_cast<std::size_t>(json["compression_threshold"].toInt());
+
         /*store current user info inside account manager*/
         UserAccountManager::get_instance()->setUserInfo(
             std::make_shared<UserNameCard>(
@@ -610,15 +634,20 @@ void TCPNetworkConnection::registerCallback() {
 
             auto obj = item.toObject();
 
-            [[maybe_unused]] auto msg_sender = obj["msg_sender"].toString();
-            [[maybe_unused]] auto msg_receiver = obj["msg_receiver"].toString();
-            auto thread_id = obj["thread_id"].toString();
+            /*offline messages are pushed together, senders might differ*/
+            auto msg_sender = obj.contains("msg_sender")
+                                  ? obj["msg_sender"].toString()
+                                  : text_sender;
+            auto msg_receiver = obj.contains("msg_receiver")
+                                    ? obj["msg_receiver"].toString()
+                                    : text_receiver;
+            [[maybe_unused]] auto thread_id = obj["thread_id"].toString();
             auto unique_id = obj["unique_id"].toString();
             auto msg_id = obj["msg_id"].toString();
             auto msg_content = obj["msg_content"].toString();
 
             auto data = std::make_shared<ChattingTextMsg>(
-                text_sender, text_receiver, unique_id, msg_content);
+                msg_sender, msg_receiver, unique_id, msg_content);
             data->setMsgID(msg_id);
 
             emit signal_incoming_msg(MsgType::TEXT, data);
@@ -751,6 +780,71 @@ void TCPNetworkConnection::registerCallback() {
             is_complete, thread_id, next_msg_id, std::move(lists)));
       }));
 
+  m_callbacks.insert(std::pair<ServiceType, Callbackfunction>(
+      ServiceType::SERVICE_SYNCCHATMSGRESPONSE, [this](QJsonObject &&json) {
+        /*error occured!*/
+        if (!json.contains("error")) {
+          qDebug() << "Json Parse Error!";
+          return;
+        }
+        if (json["error"].toInt() !=
+            static_cast<int>(ServiceStatus::SERVICE_SUCCESS)) {
+          qDebug() << "Sync Chatting Messages Return Error!";
+          return;
+        }
+        if (!json["chat_messages"].isArray() || !json["threads"].isArray()) {
+          qDebug() << "Sync Messages Array Error!";
+          return;
+        }
+
+        auto package = std::make_shared<ChatSyncResult>();
+        package->m_is_complete = json["is_complete"].toBool();
+
+        // thread_id -> messages of this thread inside current frame
+        std::unordered_map<QString, std::shared_ptr<ChatMsgPageResult>> pages;
+        auto page = [&pages, &package](const QString &thread_id) {
+          auto &ptr = pages[thread_id];
+          if (!ptr) {
+            ptr = std::make_shared<ChatMsgPageResult>();
+            ptr->m_thread_id = thread_id;
+            package->m_threads.push_back(ptr);
+          }
+          return ptr;
+        };
+
+        for (const auto &item : json["chat_messages"].toArray()) {
+          if (!item.isObject()) {
+            continue;
+          }
+
+          auto obj = item.toObject();
+          auto msg_type = static_cast<MsgType>(obj["msg_type"].toInt());
+          if (msg_type != MsgType::TEXT) {
+            continue;
+          }
+
+          auto ptr = std::make_shared<ChattingTextMsg>(
+              obj["msg_sender"].toString(), obj["msg_receiver"].toString(),
+              obj["msg_content"].toString());
+          ptr->setMsgID(obj["msg_id"].toString());
+
+          page(obj["thread_id"].toString())->m_list.push_back(ptr);
+        }
+
+        for (const auto &item : json["threads"].toArray()) {
+          if (!item.isObject()) {
+            continue;
+          }
+
+          auto obj = item.toObject();
+          auto ptr = page(obj["thread_id"].toString());
+          ptr->m_load_more = !obj["is_complete"].toBool();
+          ptr->m_next_message_id = obj["next_msg_id"].toString();
+        }
+
+        emit signal_sync_chat_msg(package);
+      }));
+
   m_callbacks.insert(std::pair<ServiceType, Callbackfunction>(
       ServiceType::SERVICE_CREATENEWPRIVATECHAT_RESPONSE,
       [this](QJsonObject &&json) {
@@ -853,6 +947,39 @@ void TCPNetworkConnection::send_buffer(ServiceType type, QJsonObject &&obj) {
   QJsonDocument doc(std::move(obj));
   auto byte = doc.toJson(QJsonDocument::Compact);
 
+  auto instance = TCPNetworkConnection::get_instance();
+  const auto chunk =
+      std::max<qsizetype>(static_cast<qsizetype>(instance->m_frame_chunk_size),
+                          1);
+  uint16_t flags = 0;
+
+  /*compressed body is only used when it is really smaller*/
+  if (instance->m_compression &&
+      byte.size() >= static_cast<qsizetype>(instance->m_compression_threshold)) {
+    auto compressed = qCompress(byte);
+    if (compressed.size() < byte.size()) {
+      byte = std::move(compressed);
+      flags |= MSGNODE_FLAG_COMPRESSED;
+    }
+  }
+
+  /*large request is split into fragments if server accepted extended frame*/
+  if (flags || (instance->m_extended_frame && byte.size() > chunk)) {
+    for (qsizetype offset = 0; offset < byte.size(); offset += chunk) {
+      auto part = byte.mid(offset, chunk);
+
+      auto buffer = std::make_shared<SendNodeType>(
+          static_cast<uint16_t>(type), part, ByteOrderConverterReverse{},
+          MsgNodeType::MSGNODE_EXTENDED,
+          offset + chunk < byte.size()
+              ? static_cast<uint16_t>(flags | MSGNODE_FLAG_MORE_FRAGMENTS)
+              : flags);
+
+      emit instance -> signal_send_message(buffer);
+    }
+    return;
+  }
+
   /*it should be store as a temporary object, because send_buffer will modify
    * it!*/
   auto buffer = std::make_shared<SendNodeType>(
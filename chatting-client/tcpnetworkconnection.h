@@ -37,8 +37,14 @@ class TCPNetworkConnection
 
   struct RecvInfo {
     uint16_t _id = 0;
-    uint16_t _length = 0;
+    uint32_t _length = 0;
     QByteArray _msg;
+
+    /*bytes which do not form a complete frame yet*/
+    QByteArray _pending;
+
+    /*fragments of current message*/
+    QByteArray _fragments;
   };
 
 public:
@@ -194,6 +200,12 @@ signals:
    */
   void signal_update_chat_msg(std::shared_ptr<ChatMsgPageResult> package);
 
+  /*
+   * This function is mainly for the main interface
+   * to merge messages of many threads after delta sync
+   */
+  void signal_sync_chat_msg(std::shared_ptr<ChatSyncResult> package);
+
   /*
    * This function is mainly for create private chat UI widget
    * Server has already confirmed the behaviour
@@ -217,6 +229,14 @@ private:
 
   /*according to service type to execute callback*/
   std::map<ServiceType, Callbackfunction> m_callbacks;
+
+  /*server accepted extended frames at login*/
+  bool m_extended_frame = false;
+  std::size_t m_frame_chunk_size = 0;
+
+  /*server inflates frames with MSGNODE_FLAG_COMPRESSED*/
+  bool m_compression = false;
+  std::size_t m_compression_threshold = 0;
 };
 
 #endif // TCPNETWORKCONNECTION_H
@@ -103,6 +103,45 @@ UserAccountManager::getChattingThreadData(const QString &thread_id) {
   return m_ThreadData[thread_id];
 }
 
+std::optional<std::shared_ptr<UserChatThread>>
+UserAccountManager::getOrCreateChattingThreadData(const QString &thread_id) {
+
+  if (auto it = m_ThreadData.find(thread_id); it != m_ThreadData.end())
+    return it->second;
+
+  auto desc = m_threadDescLists.find(thread_id);
+  if (desc == m_threadDescLists.end() || desc->second->isGroupChat())
+    return std::nullopt;
+
+  // find out who is the other user of this private chat
+  auto user_one =
+      QString::fromStdString(desc->second->getUserOneUUID().value_or(""));
+  auto user_two =
+      QString::fromStdString(desc->second->getUserTwoUUID().value_or(""));
+  auto card = findAuthFriendsInfo(user_one == get_uuid() ? user_two : user_one);
+  if (!card.has_value())
+    return std::nullopt;
+
+  auto thread = std::make_shared<UserChatThread>(thread_id, **card);
+  m_ThreadData[thread_id] = thread;
+  return thread;
+}
+
+std::vector<std::pair<QString, QString>>
+UserAccountManager::getThreadHighWaterMarks() const {
+  std::vector<std::pair<QString, QString>> marks;
+  marks.reserve(m_allChattingSessions.size());
+
+  for (const auto &thread_id : m_allChattingSessions) {
+    auto it = m_ThreadData.find(thread_id);
+    if (it == m_ThreadData.end() || it->second->getLastMessageId().isEmpty())
+      marks.emplace_back(thread_id, QString("0"));
+    else
+      marks.emplace_back(thread_id, it->second->getLastMessageId());
+  }
+  return marks;
+}
+
 std::optional<std::vector<std::shared_ptr<UserFriendRequest>>>
 UserAccountManager::getFriendRequestList(std::size_t &begin,
                                          const std::size_t interval) {
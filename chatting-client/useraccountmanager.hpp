@@ -64,6 +64,14 @@ public:
   std::optional<std::shared_ptr<UserChatThread>>
   getChattingThreadData(const QString &thread_id);
 
+  /*create thread data for a private chat thread pulled from server*/
+  std::optional<std::shared_ptr<UserChatThread>>
+  getOrCreateChattingThreadData(const QString &thread_id);
+
+  /*every known thread_id with the last message id fetched from server*/
+  std::vector<std::pair</*thread_id*/ QString, /*msg_id*/ QString>>
+  getThreadHighWaterMarks() const;
+
   /*get limited amount of friending request list*/
   std::optional<std::vector<std::shared_ptr<UserFriendRequest>>>
   getFriendRequestList(std::size_t &begin, const std::size_t interval);
@@ -0,0 +1,73 @@
+#pragma once
+#ifndef _FRAMECOMPRESSION_HPP_
+#define _FRAMECOMPRESSION_HPP_
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <zlib.h>
+
+namespace compression {
+/*
+ * compressed body = [4 bytes big-endian original size][zlib deflate stream]
+ * it is the same layout as qCompress/qUncompress, so client could use Qt
+ */
+static constexpr std::size_t SIZE_PREFIX_LENGTH = sizeof(uint32_t);
+
+inline std::optional<std::string> compress(std::string_view input,
+                                           const int level) {
+  if (input.size() > UINT32_MAX) {
+    return std::nullopt;
+  }
+
+  uLongf bound = compressBound(static_cast<uLong>(input.size()));
+  std::string output(SIZE_PREFIX_LENGTH + bound, '\0');
+
+  const auto size = static_cast<uint32_t>(input.size());
+  output[0] = static_cast<char>((size >> 24) & 0xFF);
+  output[1] = static_cast<char>((size >> 16) & 0xFF);
+  output[2] = static_cast<char>((size >> 8) & 0xFF);
+  output[3] = static_cast<char>(size & 0xFF);
+
+  if (::compress2(reinterpret_cast<Bytef *>(output.data() + SIZE_PREFIX_LENGTH),
+                  &bound, reinterpret_cast<const Bytef *>(input.data()),
+                  static_cast<uLong>(input.size()), level) != Z_OK) {
+    return std::nullopt;
+  }
+
+  output.resize(SIZE_PREFIX_LENGTH + bound);
+  return output;
+}
+
+/*std::nullopt if data is broken or original size is larger than limit*/
+inline std::optional<std::string> decompress(std::string_view input,
+                                             const std::size_t limit) {
+  if (input.size() <= SIZE_PREFIX_LENGTH) {
+    return std::nullopt;
+  }
+
+  const auto *p = reinterpret_cast<const unsigned char *>(input.data());
+  const std::size_t size = (static_cast<uint32_t>(p[0]) << 24) |
+                           (static_cast<uint32_t>(p[1]) << 16) |
+                           (static_cast<uint32_t>(p[2]) << 8) |
+                           static_cast<uint32_t>(p[3]);
+
+  /*never trust the size from peer before allocating memory*/
+  if (size > limit) {
+    return std::nullopt;
+  }
+
+  std::string output(size, '\0');
+  uLongf length = static_cast<uLongf>(size);
+  if (::uncompress(reinterpret_cast<Bytef *>(output.data()), &length,
+                   reinterpret_cast<const Bytef *>(p + SIZE_PREFIX_LENGTH),
+                   static_cast<uLong>(input.size() - SIZE_PREFIX_LENGTH)) !=
+          Z_OK ||
+      length != size) {
+    return std::nullopt;
+  }
+  return output;
+}
+} // namespace compression
+
+#endif //_FRAMECOMPRESSION_HPP_
@@ -0,0 +1,94 @@
+#pragma once
+#ifndef _ARCHIVESEGMENT_HPP_
+#define _ARCHIVESEGMENT_HPP_
+#include <chat/ChattingThreadDef.hpp>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chat {
+/*
+ * Immutable file of archived messages of one thread, it is memory-mapped
+ * and read without copying the whole file
+ *
+ * | magic | thread_id | first msg_id | last msg_id | message count |
+ * | block count | zstd block | ... | sparse index | magic |
+ *
+ * every block holds a few messages in message id order, sparse index has
+ * one entry for each block: | first msg_id | offset | compressed size |
+ * | raw size | message count |, so a page only decompresses the blocks it
+ * needs
+ */
+class ArchiveSegment {
+  ArchiveSegment(const ArchiveSegment &) = delete;
+  ArchiveSegment &operator=(const ArchiveSegment &) = delete;
+
+  ArchiveSegment() = default;
+
+public:
+  ~ArchiveSegment();
+
+  /*map an existing segment, nullptr if it is broken*/
+  [[nodiscard]] static std::shared_ptr<ArchiveSegment>
+  open(const std::string &path);
+
+  /*messages must belong to thread_id and be in message id order*/
+  [[nodiscard]] static bool
+  write(const std::string &path, const std::uint64_t thread_id,
+        const std::vector<std::unique_ptr<chat::MsgInfo>> &messages,
+        const std::size_t block_size, const int level);
+
+  std::uint64_t getThreadID() const { return m_thread_id; }
+  std::uint64_t getFirstID() const { return m_first_id; }
+  std::uint64_t getLastID() const { return m_last_id; }
+
+  /*messages after msg_id(not included), until out holds count messages*/
+  void read(const std::uint64_t msg_id, const std::size_t count,
+            std::vector<std::unique_ptr<chat::MsgInfo>> &out) const;
+
+  /*messages whose id is inside msg_ids*/
+  void find(const std::set<std::uint64_t> &msg_ids,
+            std::vector<std::unique_ptr<chat::MsgInfo>> &out) const;
+
+private:
+  struct Block {
+    std::uint64_t first_id;
+    std::uint64_t offset;
+    std::uint32_t compressed;
+    std::uint32_t raw;
+    std::uint32_t count;
+  };
+
+  bool map(const std::string &path);
+  bool parse();
+
+  /*decompress one block and hand over every message inside*/
+  template <typename _Func>
+  bool visit(const Block &block, _Func &&func) const;
+
+  static void encode(std::string &out, const chat::MsgInfo &info);
+
+private:
+  static constexpr char magic[] = "DIMSARC1";
+  static constexpr std::size_t magic_length = sizeof(magic) - 1;
+
+  const char *m_data = nullptr;
+  std::size_t m_size = 0;
+
+#if defined(_WIN32)
+  void *m_file = nullptr;
+  void *m_mapping = nullptr;
+#endif
+
+  std::uint64_t m_thread_id = 0;
+  std::uint64_t m_first_id = 0;
+  std::uint64_t m_last_id = 0;
+  std::vector<Block> m_blocks;
+};
+} // namespace chat
+
+#endif //_ARCHIVESEGMENT_HPP_
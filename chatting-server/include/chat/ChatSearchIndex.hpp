@@ -0,0 +1,173 @@
+#pragma once
+#ifndef _CHATSEARCHINDEX_HPP_
+#define _CHATSEARCHINDEX_HPP_
+#include <atomic>
+#include <chat/ChattingThreadDef.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLConnectionPool.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace chat {
+/*
+ * Full-text index of chat messages, one posting list for every
+ * (thread_id, term), postings are (message_id, term frequency) in message id
+ * order
+ *
+ * 1. messages handled by this server are indexed as soon as they are stored,
+ *    a background thread tails ChatMsgHistoryBank by message id, so messages
+ *    written by other chatting servers become searchable as well
+ * 2. new postings stay in memory until there are enough of them, then they
+ *    are flushed into an immutable segment file, when there are too many
+ *    segments the background thread merges the smallest ones, so a posting
+ *    is only rewritten a few times and large segments are left alone
+ * 3. the same message might be indexed by both ways, duplicated postings are
+ *    dropped by search and merge
+ *
+ * [dir]/segment_[20 digits id].idx, every integer is a varint
+ * | magic | watermark | term count |
+ * | thread_id | term length | term | posting count | posting bytes |
+ * | delta of message_id | term frequency | ... |
+ *
+ * watermark is the largest message id scanned from MySQL before the segment
+ * was written, tailing continues from there after restart
+ */
+class ChatSearchIndex : public Singleton<ChatSearchIndex> {
+  friend class Singleton<ChatSearchIndex>;
+
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+
+  ChatSearchIndex();
+
+public:
+  struct SearchResult {
+    std::vector<std::uint64_t> msg_ids; // message ids of the requested page
+    std::size_t total = 0;              // matches of all pages
+  };
+
+  ~ChatSearchIndex();
+
+  /*index verified messages, indexing the same message twice is harmless*/
+  void index(const std::vector<std::shared_ptr<chat::MsgInfo>> &info);
+
+  /*
+   * messages of a thread which contain every term of keyword, ranked by
+   * term frequency, newer messages first when they are equally ranked
+   */
+  [[nodiscard]] SearchResult search(const std::uint64_t thread_id,
+                                    std::string_view keyword,
+                                    const std::size_t offset,
+                                    const std::size_t limit) const;
+
+  /*stop background thread and flush postings in memory*/
+  void shutdown();
+
+private:
+  using TermKey = std::pair<std::uint64_t, std::string>; // (thread_id, term)
+
+  struct Posting {
+    std::uint64_t msg_id;
+    std::uint32_t tf;
+  };
+
+  using PostingList = std::vector<Posting>;
+  using PostingMap = std::map<TermKey, PostingList>;
+
+  struct Segment {
+    std::uint64_t id = 0;
+    std::uint64_t watermark = 0;
+    std::string path;
+
+    /*whole segment file, postings are decoded on demand*/
+    std::string data;
+
+    /*term -> (offset of the first posting inside data, posting count)*/
+    std::map<TermKey, std::pair<std::size_t, std::size_t>> terms;
+  };
+
+  using SegmentPtr = std::shared_ptr<const Segment>;
+
+  /*m_index_mtx must be held exclusively*/
+  void add(const std::uint64_t thread_id, const std::uint64_t msg_id,
+           std::string_view content);
+
+  /*postings of a term in memory and all segments, m_index_mtx is held*/
+  PostingList collect(const TermKey &key) const;
+
+  /*load messages after watermark, false if nothing loaded*/
+  bool loadNewMessages();
+  void worker();
+
+  /*flush memory postings into a new segment*/
+  bool flush();
+
+  /*
+   * merge up to merge_factor smallest segments, merged segment stays within
+   * max_segment_size, false if writing it failed
+   */
+  bool merge();
+
+  void loadSegments();
+  std::string segmentPath(const std::uint64_t id) const;
+
+  static std::optional<Segment> readSegment(const std::string &path);
+  static bool writeSegment(const std::string &path, const PostingMap &postings,
+                           const std::uint64_t watermark);
+  static PostingList decodePostings(const Segment &segment,
+                                    const std::size_t offset,
+                                    const std::size_t count);
+
+  /*union of two sorted lists, the same message is kept once*/
+  static void mergePostings(PostingList &dst, const PostingList &src);
+
+private:
+  static constexpr char magic[] = "DIMSIDX1";
+
+  std::atomic<bool> m_stop;
+  std::string m_dir;
+  std::size_t m_batch_size;
+  std::size_t m_flush_threshold;
+  std::size_t m_max_segments;
+  std::size_t m_merge_factor;
+  std::size_t m_max_segment_bytes;
+  std::chrono::milliseconds m_refresh_interval;
+
+  /*
+   * message ids are generated by different servers and committed later in
+   * write-behind mode, messages younger than lag are not tailed yet
+   */
+  std::chrono::milliseconds m_tail_lag;
+
+  mutable std::shared_mutex m_index_mtx;
+  std::uint64_t m_watermark = 0;
+  std::uint64_t m_next_segment = 0;
+
+  /*postings not yet flushed*/
+  PostingMap m_memory;
+  std::size_t m_memory_postings = 0;
+
+  /*postings being flushed, still searchable*/
+  std::shared_ptr<const PostingMap> m_frozen;
+
+  /*in segment id order*/
+  std::vector<SegmentPtr> m_segments;
+
+  std::atomic<bool> m_flush_requested;
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::thread m_worker;
+};
+} // namespace chat
+
+#endif //_CHATSEARCHINDEX_HPP_
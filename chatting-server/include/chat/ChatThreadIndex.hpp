@@ -0,0 +1,115 @@
+#pragma once
+#ifndef _CHATTHREADINDEX_HPP_
+#define _CHATTHREADINDEX_HPP_
+#include <chat/ChattingThreadDef.hpp>
+#include <memory>
+#include <optional>
+#include <redis/RedisManager.hpp>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLConnectionPool.hpp>
+#include <string>
+#include <vector>
+
+namespace chat {
+/*
+ * Chat threads of every user ordered by recent activity
+ * user_threads_{uuid}      sorted set, member = thread_id, score = last
+ *                          activity(milliseconds)
+ * user_threads_meta_{uuid} hash, thread_id -> GROUP / PRIVATE:user1:user2
+ *
+ * 1. every text message moves its thread to the top of all participants'
+ *    index, but only if the index exists(a cold index is never half built)
+ * 2. a cold index is rebuilt from MySQL when the user pulls thread list
+ * 3. pages are cut by the last thread_id of previous page
+ */
+class ChatThreadIndex : public Singleton<ChatThreadIndex> {
+  friend class Singleton<ChatThreadIndex>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+
+  ChatThreadIndex();
+
+public:
+  ~ChatThreadIndex() = default;
+
+  /*thread has new activity, move it to the top for all these users*/
+  void touch([[maybe_unused]] RedisRAII &raii,
+             const std::vector<std::string> &uuids,
+             const chat::ChatThreadMeta &meta);
+
+  /*
+   * threads after cur_thread_id(not included) in recency order
+   * cur_thread_id = 0 means starting from the most recent one
+   * MySQL connection is only acquired if the index has to be rebuilt
+   */
+  [[nodiscard]]
+  std::optional<std::vector<std::unique_ptr<chat::ChatThreadMeta>>>
+  getPage([[maybe_unused]] RedisRAII &raii, const std::size_t uuid,
+          const std::size_t cur_thread_id, const std::size_t interval,
+          std::string &next_thread_id, bool &is_EOF);
+
+private:
+  struct Entry {
+    std::string thread_id;
+    std::string meta;
+    std::size_t score;
+  };
+
+  /*load all threads from MySQL and write them back to redis*/
+  std::optional<std::vector<Entry>> rebuild([[maybe_unused]] RedisRAII &raii,
+                                            const std::size_t uuid);
+
+  static std::string encode(const chat::ChatThreadMeta &meta);
+  static std::optional<std::unique_ptr<chat::ChatThreadMeta>>
+  decode(const std::string &thread_id, const std::string &meta);
+  static std::size_t currentMilliseconds();
+
+private:
+  static std::string index_prefix;
+  static std::string meta_prefix;
+
+  /*a user without any thread still has an index, thread_id 0 never exists*/
+  static constexpr const char *sentinel = "0";
+
+  /*KEYS = {index, meta}, ARGV = {score, thread_id, meta}*/
+  static constexpr const char *touch_lua_script =
+      "if redis.call('EXISTS', KEYS[1]) == 1 then "
+      "redis.call('HSET', KEYS[2], ARGV[2], ARGV[3]) "
+      "redis.call('ZADD', KEYS[1], ARGV[1], ARGV[2]) "
+      "end "
+      "return {}";
+
+  /*
+   * KEYS = {index, meta}, ARGV = {cursor, count, ttl}
+   * returns nil if index does not exist, otherwise {thread_id, meta, ...}
+   */
+  static constexpr const char *page_lua_script =
+      "if redis.call('EXISTS', KEYS[1]) == 0 then return false end "
+      "local start = 0 "
+      "if ARGV[1] ~= '0' then "
+      "local rank = redis.call('ZREVRANK', KEYS[1], ARGV[1]) "
+      "if not rank then return {} end "
+      "start = rank + 1 "
+      "end "
+      "local ids = redis.call('ZREVRANGE', KEYS[1], start, "
+      "start + tonumber(ARGV[2]) - 1) "
+      "local result = {} "
+      "for _, id in ipairs(ids) do "
+      "if id ~= '0' then "
+      "table.insert(result, id) "
+      "table.insert(result, redis.call('HGET', KEYS[2], id) or '') "
+      "end "
+      "end "
+      "redis.call('EXPIRE', KEYS[1], ARGV[3]) "
+      "redis.call('EXPIRE', KEYS[2], ARGV[3]) "
+      "return result";
+
+  /*index expire time(second) after last pull*/
+  std::size_t m_ttl;
+};
+} // namespace chat
+
+#endif //_CHATTHREADINDEX_HPP_
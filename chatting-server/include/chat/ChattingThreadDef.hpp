@@ -98,6 +98,13 @@ struct FriendingConfirmInfo {
   std::string message_content;
 };
 
+/*user has read every message of thread_id until message_id(included)*/
+struct ReadCursor {
+  std::size_t uuid;
+  std::size_t thread_id;
+  std::size_t message_id;
+};
+
 struct MsgInfo {
   MsgInfo() = default;
   MsgInfo(const std::string &threadId, const std::string &uniqueid,
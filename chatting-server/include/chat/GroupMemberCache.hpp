@@ -0,0 +1,67 @@
+#pragma once
+#ifndef _GROUPMEMBERCACHE_HPP_
+#define _GROUPMEMBERCACHE_HPP_
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <redis/RedisManager.hpp>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLConnectionPool.hpp>
+#include <string>
+#include <tbb/concurrent_hash_map.h>
+#include <vector>
+
+namespace chat {
+/*
+ * Membership set of group chats(GroupMember table)
+ * 1. search for thread_id inside local cache, entries are expired by ttl
+ * 2. search for group_member_[thread_id] set inside redis
+ * 3. searching for members inside mysql and write it back to redis
+ */
+class GroupMemberCache : public Singleton<GroupMemberCache> {
+  friend class Singleton<GroupMemberCache>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+
+  GroupMemberCache();
+
+public:
+  /*member uuids are sorted, so membership check could use binary search*/
+  using MemberList = std::shared_ptr<const std::vector<std::string>>;
+
+  ~GroupMemberCache() = default;
+
+  [[nodiscard]] std::optional<MemberList>
+  getMembers(const std::string &thread_id);
+
+  [[nodiscard]] bool isMember(const MemberList &members,
+                              const std::string &uuid) const;
+
+  /*group membership changed, drop both local and redis cache*/
+  void invalidate(const std::string &thread_id);
+
+private:
+  std::optional<MemberList> loadFromRedis(const std::string &thread_id);
+  std::optional<MemberList> loadFromMySQL(const std::string &thread_id);
+  void store(const std::string &thread_id, MemberList members);
+
+private:
+  struct CacheEntry {
+    MemberList members;
+    std::chrono::steady_clock::time_point expire;
+  };
+
+  /*store group members in redis set*/
+  static std::string group_prefix;
+
+  /*local cache ttl(second)*/
+  std::size_t m_ttl;
+
+  tbb::concurrent_hash_map</*thread_id*/ std::string, CacheEntry> m_groups;
+};
+} // namespace chat
+
+#endif //_GROUPMEMBERCACHE_HPP_
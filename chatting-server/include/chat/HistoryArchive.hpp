@@ -0,0 +1,150 @@
+#pragma once
+#ifndef _HISTORYARCHIVE_HPP_
+#define _HISTORYARCHIVE_HPP_
+#include <atomic>
+#include <chat/ArchiveSegment.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <redis/LockService.hpp>
+#include <redis/RedisManager.hpp>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLShardRouter.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace chat {
+/*
+ * Cold tier of chat history, messages older than archive_age are moved out
+ * of ChatMsgHistoryBank into per-thread ArchiveSegment files
+ * [dir]/[thread_id]/segment_[20 digits first id]_[20 digits last id].arc
+ *
+ * 1. archive directory must be shared by all chatting servers(mounted
+ *    volume), archiving enabled or not, only the server holding the archiver
+ *    lock moves messages in one round
+ * 2. a segment is written and synced before its rows are deleted, rows are
+ *    deleted by a later round after every server has refreshed its listing,
+ *    so no reader could miss them in both tiers
+ * 3. readers ask for the largest archived id of a thread, pages before it
+ *    come from segments, MySQL only serves messages after it
+ * 4. every server stores a random token in redis and in
+ *    [dir]/.readers/[server_name], nothing is archived unless archiver finds
+ *    every token inside its own directory, so rows are never deleted while
+ *    any server could not read their segments
+ */
+class HistoryArchive : public Singleton<HistoryArchive> {
+  friend class Singleton<HistoryArchive>;
+
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+
+  HistoryArchive();
+
+public:
+  ~HistoryArchive();
+
+  /*largest archived message id of a thread, 0 if nothing is archived*/
+  [[nodiscard]] std::uint64_t getArchivedUntil(const std::uint64_t thread_id);
+
+  /*archived messages after msg_id(not included), at most count*/
+  [[nodiscard]] std::vector<std::unique_ptr<chat::MsgInfo>>
+  getPage(const std::uint64_t thread_id, const std::uint64_t msg_id,
+          const std::size_t count);
+
+  /*archived messages of a thread by their ids*/
+  [[nodiscard]] std::vector<std::unique_ptr<chat::MsgInfo>>
+  getMessages(const std::uint64_t thread_id,
+              const std::vector<std::size_t> &msg_ids);
+
+  void shutdown();
+
+private:
+  struct SegmentInfo {
+    std::uint64_t first_id;
+    std::uint64_t last_id;
+    std::string path;
+    std::filesystem::file_time_type written;
+  };
+
+  /*segments of one thread in message id order*/
+  struct Listing {
+    std::chrono::steady_clock::time_point loaded;
+    std::vector<SegmentInfo> segments;
+  };
+
+  /*
+   * segment list of a thread, cached for refresh_interval, because other
+   * servers might archive this thread meanwhile
+   */
+  std::shared_ptr<const Listing> list(const std::uint64_t thread_id,
+                                      const bool reload = false);
+
+  /*mapped segments are shared, the least recently used one is unmapped*/
+  std::shared_ptr<ArchiveSegment> open(const SegmentInfo &info);
+
+  void archiver();
+
+  /*
+   * archive messages older than cutoff on one shard, false if there was
+   * nothing to do or lease of archiver lock is lost
+   */
+  bool archiveRound(const mysql::MySQLShardRouter::pool_ptr &pool,
+                    MySQLRAII &mysql, const redis::Lease &lease);
+  bool archiveThread(MySQLRAII &mysql, const redis::Lease &lease,
+                     const std::uint64_t thread_id,
+                     const std::uint64_t cutoff_id,
+                     const std::uint64_t cutoff_time);
+
+  std::string threadDir(const std::uint64_t thread_id) const;
+  std::string readerPath(const std::string &server) const;
+
+  /*announce that this server reads archive_dir*/
+  bool registerReader();
+
+  /*every registered server sees the same archive_dir as this one*/
+  bool isShared();
+
+private:
+  static std::string archiver_lock;
+  static std::string readers_key;
+
+  /*listing cache is dropped as a whole when it grows beyond this*/
+  static constexpr std::size_t max_listings = 65536;
+
+  std::atomic<bool> m_stop;
+  bool m_enabled;
+  std::string m_dir;
+  std::chrono::seconds m_age;
+  std::chrono::seconds m_interval;
+  std::chrono::seconds m_refresh_interval;
+  std::size_t m_batch_size;
+  std::size_t m_block_size;
+  int m_level;
+  std::size_t m_max_threads;
+  std::size_t m_max_open;
+  std::string m_token;
+
+  std::mutex m_listing_mtx;
+  std::unordered_map<std::uint64_t, std::shared_ptr<const Listing>> m_listings;
+
+  std::mutex m_segment_mtx;
+  std::list<std::pair<std::string, std::shared_ptr<ArchiveSegment>>> m_lru;
+  std::unordered_map<
+      std::string,
+      std::list<std::pair<std::string, std::shared_ptr<ArchiveSegment>>>::
+          iterator>
+      m_segments;
+
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::thread m_archiver;
+};
+} // namespace chat
+
+#endif //_HISTORYARCHIVE_HPP_
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef _MESSAGEIDGENERATOR_HPP_
+#define _MESSAGEIDGENERATOR_HPP_
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <redis/RedisManager.hpp>
+#include <singleton/singleton.hpp>
+#include <string>
+#include <thread>
+
+namespace chat {
+/*
+ * 64-bit message id, generated before the message is persisted
+ * | 1 bit unused | 41 bits milliseconds since epoch | 10 bits node | 12 bits seq
+ *
+ * 1. node id is leased from redis(message_node_[0~1023]) during startup and
+ *    renewed by a background thread, so ids are unique among chatting servers
+ * 2. ids are strictly increasing inside one server, if clock moves backwards
+ *    or the sequence is exhausted, generator borrows the next millisecond
+ *    instead of blocking
+ * 3. once the lease might have expired, another server could own the same
+ *    node id, no id is generated until a node id is leased again
+ */
+class MessageIdGenerator : public Singleton<MessageIdGenerator> {
+  friend class Singleton<MessageIdGenerator>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+
+  MessageIdGenerator();
+
+public:
+  ~MessageIdGenerator();
+
+  /*std::nullopt if node id is not leased at the moment*/
+  [[nodiscard]] std::optional<std::uint64_t> next();
+  [[nodiscard]] std::uint64_t getNodeID() const { return m_node; }
+
+  /*smallest id any server could generate at unix time(milliseconds)*/
+  [[nodiscard]] static std::uint64_t lowerBound(const std::uint64_t unix_ms);
+
+  /*give node id back to redis, so other servers could use it at once*/
+  void shutdown();
+
+private:
+  bool leaseNode([[maybe_unused]] RedisRAII &raii);
+  void renewer();
+  static std::uint64_t currentMilliseconds();
+
+  /*lease is valid until lease_ttl after the command was sent*/
+  void leased(const std::chrono::steady_clock::time_point &sent);
+
+private:
+  /*2024-01-01 00:00:00 UTC*/
+  static constexpr std::uint64_t epoch = 1704067200000ULL;
+  static constexpr std::uint64_t node_bits = 10;
+  static constexpr std::uint64_t sequence_bits = 12;
+  static constexpr std::uint64_t max_node = (1ULL << node_bits) - 1;
+  static constexpr std::uint64_t max_sequence = (1ULL << sequence_bits) - 1;
+
+  /*node lease ttl, renewed every lease_ttl / 3 seconds*/
+  static constexpr std::size_t lease_ttl = 30;
+
+  /*stop generating a bit earlier, clocks of redis and server might drift*/
+  static constexpr std::chrono::seconds lease_margin{2};
+
+  /*warn once when generator runs ahead of wall clock for such a long time*/
+  static constexpr std::uint64_t max_borrow = 1000;
+
+  static std::string node_prefix;
+
+  /*lease owner identifier*/
+  std::string m_identifier;
+
+  std::atomic<std::uint64_t> m_node;
+
+  /*steady clock(ns) when the lease of m_node might expire*/
+  std::atomic<std::int64_t> m_expire;
+
+  /*| timestamp | sequence | of the last generated id*/
+  std::atomic<std::uint64_t> m_state;
+
+  std::atomic<bool> m_borrowing;
+  std::atomic<bool> m_stop;
+  std::thread m_renewer;
+};
+} // namespace chat
+
+#endif //_MESSAGEIDGENERATOR_HPP_
@@ -0,0 +1,31 @@
+#pragma once
+#ifndef _MESSAGETOKENIZER_HPP_
+#define _MESSAGETOKENIZER_HPP_
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace chat {
+/*
+ * Split utf-8 message content into search terms
+ * 1. a run of letters and digits is one term, ascii and fullwidth letters
+ *    are folded to lower case ascii
+ * 2. CJK text has no spaces, every CJK character is one term, and every two
+ *    adjacent characters of a CJK run become one more term(bigram)
+ * 3. punctuation, symbols, emoji and broken utf-8 bytes separate terms
+ *
+ * keywords are tokenized the same way, a CJK keyword matches a message when
+ * all of its characters and bigrams are found
+ */
+class MessageTokenizer {
+public:
+  /*terms in order of appearance, duplicated terms are kept*/
+  [[nodiscard]] static std::vector<std::string> tokenize(std::string_view text);
+
+private:
+  /*longer runs are urls or garbage rather than words*/
+  static constexpr std::size_t max_term_length = 64;
+};
+} // namespace chat
+
+#endif //_MESSAGETOKENIZER_HPP_
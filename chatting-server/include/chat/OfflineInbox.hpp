@@ -0,0 +1,86 @@
+#pragma once
+#ifndef _OFFLINEINBOX_HPP_
+#define _OFFLINEINBOX_HPP_
+#include <chat/ChattingThreadDef.hpp>
+#include <memory>
+#include <redis/RedisManager.hpp>
+#include <singleton/singleton.hpp>
+#include <string>
+#include <vector>
+
+namespace chat {
+/*
+ * Messages which could not be delivered because receiver is offline
+ * offline_inbox_{uuid}  stream, every entry holds one message json
+ * offline_cursor_{uuid} id of the last stream entry delivered to user
+ *
+ * 1. stream is trimmed to N entries, older messages are still reachable by
+ *    delta sync(they have been persisted already)
+ * 2. login claims all entries after the cursor and moves the cursor with one
+ *    script, so one entry is never delivered twice
+ */
+class OfflineInbox : public Singleton<OfflineInbox> {
+  friend class Singleton<OfflineInbox>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+
+  OfflineInbox();
+
+public:
+  ~OfflineInbox() = default;
+
+  /*store verified messages for an offline receiver*/
+  void push([[maybe_unused]] RedisRAII &raii, const std::string &uuid,
+            const std::vector<std::shared_ptr<chat::MsgInfo>> &info);
+
+  /*offline members of a group share one pipeline and one encoding*/
+  void push([[maybe_unused]] RedisRAII &raii,
+            const std::vector<std::string> &uuids,
+            const std::vector<std::shared_ptr<chat::MsgInfo>> &info);
+
+  /*claim every undelivered message json of this user, oldest first*/
+  [[nodiscard]] std::vector<std::string> drain([[maybe_unused]] RedisRAII &raii,
+                                               const std::string &uuid);
+
+private:
+  static std::string encode(const chat::MsgInfo &info);
+
+private:
+  static std::string inbox_prefix;
+  static std::string cursor_prefix;
+
+  /*
+   * KEYS = {inbox, cursor}, ARGV = {count, ttl}
+   * returns message jsons after the cursor, delivered entries are removed and
+   * the cursor is moved to the last one, both keys are dropped once empty
+   */
+  static constexpr const char *drain_lua_script =
+      "local cur = redis.call('GET', KEYS[2]) or '-' "
+      "local entries = redis.call('XRANGE', KEYS[1], cur, '+', 'COUNT', "
+      "tonumber(ARGV[1]) + 1) "
+      "local ids, out = {}, {} "
+      "for _, e in ipairs(entries) do "
+      "  if e[1] ~= cur and #ids < tonumber(ARGV[1]) then "
+      "    ids[#ids + 1] = e[1] "
+      "    out[#out + 1] = e[2][2] "
+      "  end "
+      "end "
+      "if #ids == 0 then return out end "
+      "redis.call('XDEL', KEYS[1], unpack(ids)) "
+      "if redis.call('XLEN', KEYS[1]) == 0 then "
+      "  redis.call('DEL', KEYS[1], KEYS[2]) "
+      "else "
+      "  redis.call('SET', KEYS[2], ids[#ids], 'EX', ARGV[2]) "
+      "end "
+      "return out";
+
+  /*how many messages are kept for one user*/
+  std::size_t m_capacity;
+
+  /*inbox expire time(second) after last message*/
+  std::size_t m_ttl;
+};
+} // namespace chat
+
+#endif //_OFFLINEINBOX_HPP_
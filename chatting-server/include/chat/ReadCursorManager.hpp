@@ -0,0 +1,133 @@
+#pragma once
+#ifndef _READCURSORMANAGER_HPP_
+#define _READCURSORMANAGER_HPP_
+#include <atomic>
+#include <chat/ChattingThreadDef.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <redis/RedisManager.hpp>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLConnectionPool.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace chat {
+/*
+ * Read cursor and unread counter of every (user, thread)
+ * read_cursor_{uuid} hash, thread_id -> last read message_id
+ * unread_{uuid}      hash, thread_id -> unread message count
+ * unread_head_{uuid} hash, thread_id -> newest message_id counted
+ *
+ * 1. every new message increases receivers' unread counter and head
+ * 2. mark read moves the cursor forward, the counter is cleared once the
+ *    cursor reaches head, the cursor is also buffered in memory, one
+ *    (user, thread) only keeps the newest
+ * 3. a background thread flushes buffered cursors to MySQL in batches
+ * 4. counters are rebuilt from MySQL when a user has no head in redis, head
+ *    always keeps a _built field afterwards, so it only runs once
+ */
+class ReadCursorManager : public Singleton<ReadCursorManager> {
+  friend class Singleton<ReadCursorManager>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+
+  ReadCursorManager();
+
+public:
+  struct UnreadInfo {
+    std::string thread_id;
+    std::size_t unread = 0;
+    std::string last_read_msg_id = "0";
+  };
+
+  ~ReadCursorManager();
+
+  /*count new messages of thread_id for all receivers*/
+  void addUnread([[maybe_unused]] RedisRAII &raii,
+                 const std::string &thread_id,
+                 const std::vector<std::string> &receivers,
+                 const std::vector<std::shared_ptr<MsgInfo>> &messages);
+
+  /*false if cursor was not moved, because it is already at or after msg_id*/
+  bool markRead([[maybe_unused]] RedisRAII &raii, const std::size_t uuid,
+                const std::size_t thread_id, const std::size_t msg_id);
+
+  /*unread counters and read cursors of every thread*/
+  [[nodiscard]] std::vector<UnreadInfo>
+  getUnreadInfo([[maybe_unused]] RedisRAII &raii, const std::string &uuid);
+
+  /*flush everything left in memory and stop background thread*/
+  void shutdown();
+
+private:
+  void flusher();
+
+  /*recount unread messages of every thread of uuid from MySQL*/
+  void rebuild([[maybe_unused]] RedisRAII &raii, const std::string &uuid);
+
+private:
+  static std::string cursor_prefix;
+  static std::string unread_prefix;
+  static std::string head_prefix;
+  static std::string built_field;
+
+  /*
+   * KEYS = {unread, unread_head, read_cursor}
+   * ARGV = {thread_id, msg_id1 ... msg_idN}
+   * ids are compared as decimal strings, lua number could not hold 64-bit id
+   * only ids after read cursor are counted, so a counter arriving after
+   * markRead of the same messages adds nothing
+   */
+  static constexpr const char *add_unread_lua_script =
+      "local head = redis.call('HGET', KEYS[2], ARGV[1]) or '0' "
+      "local cur = redis.call('HGET', KEYS[3], ARGV[1]) or '0' "
+      "local count = 0 "
+      "for i = 2, #ARGV do "
+      "  if #ARGV[i] > #head or (#ARGV[i] == #head and ARGV[i] > head) "
+      "  then head = ARGV[i] end "
+      "  if #ARGV[i] > #cur or (#ARGV[i] == #cur and ARGV[i] > cur) "
+      "  then count = count + 1 end "
+      "end "
+      "redis.call('HSET', KEYS[2], ARGV[1], head) "
+      "if count > 0 then redis.call('HINCRBY', KEYS[1], ARGV[1], count) end "
+      "return {count}";
+
+  /*
+   * KEYS = {read_cursor, unread, unread_head}, ARGV = {thread_id, msg_id}
+   * returns {msg_id} if cursor was moved, otherwise {}
+   * messages after an older msg_id are still unread, counter is only
+   * cleared once msg_id reaches head
+   */
+  static constexpr const char *mark_read_lua_script =
+      "local cur = redis.call('HGET', KEYS[1], ARGV[1]) "
+      "if cur and (#cur > #ARGV[2] or (#cur == #ARGV[2] and cur >= ARGV[2])) "
+      "then return {} end "
+      "redis.call('HSET', KEYS[1], ARGV[1], ARGV[2]) "
+      "local head = redis.call('HGET', KEYS[3], ARGV[1]) "
+      "if not head or #ARGV[2] > #head or "
+      "   (#ARGV[2] == #head and ARGV[2] >= head) then "
+      "  redis.call('HDEL', KEYS[2], ARGV[1]) "
+      "end "
+      "return {ARGV[2]}";
+
+  std::atomic<bool> m_stop;
+  std::size_t m_batch_size;
+  std::chrono::milliseconds m_flush_interval;
+
+  /*(uuid, thread_id) -> newest read message_id*/
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::map<std::pair<std::size_t, std::size_t>, std::size_t> m_pending;
+
+  std::thread m_flusher;
+};
+} // namespace chat
+
+#endif //_READCURSORMANAGER_HPP_
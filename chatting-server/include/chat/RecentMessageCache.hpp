@@ -0,0 +1,93 @@
+#pragma once
+#ifndef _RECENTMESSAGECACHE_HPP_
+#define _RECENTMESSAGECACHE_HPP_
+#include <atomic>
+#include <chat/ChattingThreadDef.hpp>
+#include <memory>
+#include <optional>
+#include <redis/RedisManager.hpp>
+#include <singleton/singleton.hpp>
+#include <string>
+#include <vector>
+
+namespace chat {
+/*
+ * Newest N messages of every active thread, shared by all chatting servers
+ * thread_recent_[thread_id] is a sorted set, every member is
+ * [20 digits zero-padded message_id]:[message json], so members are ordered
+ * by message id lexicographically(64-bit id does not fit into a double score)
+ *
+ * 1. every write appends messages and trims the set to N members
+ * 2. a page request starting at or after the oldest cached message is served
+ *    without MySQL, otherwise MySQL is used and the newest page is cached
+ * 3. the key expires after a while without any activity, so memory is only
+ *    occupied by active threads
+ */
+class RecentMessageCache : public Singleton<RecentMessageCache> {
+  friend class Singleton<RecentMessageCache>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+
+  RecentMessageCache();
+
+public:
+  ~RecentMessageCache() = default;
+
+  /*messages which have been verified(persisted) are appended*/
+  void append([[maybe_unused]] RedisRAII &raii,
+              const std::vector<std::shared_ptr<chat::MsgInfo>> &info);
+
+  /*
+   * messages after msg_id(not included), std::nullopt if cache could not
+   * answer this request
+   */
+  [[nodiscard]] std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+  getPage([[maybe_unused]] RedisRAII &raii, const std::size_t thread_id,
+          const std::size_t msg_id, const std::size_t interval,
+          std::string &next_msg_id, bool &is_EOF);
+
+  /*
+   * messages of a thread by their ids, only cached ones are returned, in
+   * message id order
+   */
+  [[nodiscard]] std::vector<std::unique_ptr<chat::MsgInfo>>
+  getMessages([[maybe_unused]] RedisRAII &raii, const std::size_t thread_id,
+              const std::vector<std::size_t> &msg_ids);
+
+  /*
+   * store the newest page loaded from MySQL
+   * all messages after msg_id must be inside messages
+   */
+  void fill([[maybe_unused]] RedisRAII &raii, const std::size_t thread_id,
+            const std::size_t msg_id,
+            const std::vector<std::unique_ptr<chat::MsgInfo>> &messages);
+
+private:
+  static std::string encode(const chat::MsgInfo &info);
+  static std::optional<std::unique_ptr<chat::MsgInfo>>
+  decode(const std::string &member);
+  static std::string padding(const std::size_t msg_id);
+
+  void store(RedisRAII &raii, const std::string &thread_id,
+             const std::vector<std::string> &members);
+  void record(const bool hit);
+
+private:
+  static std::string recent_prefix;
+
+  /*20 digits is enough for any 64-bit message id*/
+  static constexpr std::size_t id_width = 20;
+
+  /*how many messages are cached for one thread*/
+  std::size_t m_capacity;
+
+  /*key expire time(second) after last activity*/
+  std::size_t m_ttl;
+
+  std::atomic<std::size_t> m_hits;
+  std::atomic<std::size_t> m_misses;
+};
+} // namespace chat
+
+#endif //_RECENTMESSAGECACHE_HPP_
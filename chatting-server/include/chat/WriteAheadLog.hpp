@@ -0,0 +1,85 @@
+#pragma once
+#ifndef _WRITEAHEADLOG_HPP_
+#define _WRITEAHEADLOG_HPP_
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace chat {
+/*
+ * Append-only local log of chat messages which are not yet stored in MySQL
+ * record layout: | u32 payload length | u32 crc32(payload) | payload |
+ *
+ * [dir]/chatting.wal        log records
+ * [dir]/chatting.checkpoint offset of the first record not yet in MySQL
+ */
+class WriteAheadLog {
+  WriteAheadLog(const WriteAheadLog &) = delete;
+  WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+public:
+  struct Record {
+    std::uint64_t message_id = 0;
+    std::uint64_t thread_id = 0;
+    std::uint64_t sender = 0;
+    std::uint64_t receiver = 0;
+    std::uint64_t timestamp = 0; // seconds since unix epoch
+    std::string content;
+
+    /*offset right after this record inside log, not part of payload*/
+    std::size_t end_offset = 0;
+  };
+
+  explicit WriteAheadLog(const std::string &dir);
+  ~WriteAheadLog();
+
+  /*
+   * open log file and return every record after checkpoint
+   * a torn or corrupted tail(crash during append) will be cut off
+   */
+  [[nodiscard]] std::optional<std::vector<Record>> open();
+
+  /*
+   * write records to the end of log(without fsync), and fill end_offset of
+   * every record
+   */
+  [[nodiscard]] bool append(std::vector<Record> &records);
+
+  /*flush appended records to disk, several appends share one fsync*/
+  bool sync();
+
+  /*
+   * all records before offset are stored in MySQL
+   * if nothing is left, log file is truncated
+   */
+  bool checkpoint(const std::size_t offset);
+
+private:
+  static std::string encode(const Record &record);
+  static std::optional<Record> decode(const std::string &payload);
+  static std::uint32_t crc32(const char *data, std::size_t length);
+
+  std::optional<std::size_t> loadCheckpoint();
+  bool storeCheckpoint(const std::size_t offset);
+  bool reopen(const char *mode);
+
+private:
+  std::string m_log_path;
+  std::string m_checkpoint_path;
+
+  std::mutex m_mtx;
+  std::FILE *m_file;
+
+  /*end of the last complete record*/
+  std::size_t m_end;
+
+  /*is there any record not yet fsynced*/
+  std::atomic<bool> m_dirty;
+};
+} // namespace chat
+
+#endif //_WRITEAHEADLOG_HPP_
@@ -0,0 +1,96 @@
+#pragma once
+#ifndef _WRITEBEHINDCOMMITTER_HPP_
+#define _WRITEBEHINDCOMMITTER_HPP_
+#include <atomic>
+#include <chat/ChattingThreadDef.hpp>
+#include <chat/WriteAheadLog.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLConnectionPool.hpp>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace chat {
+/*
+ * Write-behind persistence of private chat messages(opt-in by config)
+ * 1. message ids are generated in process, messages are appended to local
+ *    WAL, and sender could be acknowledged at once
+ * 2. WAL is fsynced by a background thread, several appends share one fsync
+ * 3. committer thread drains WAL to ChatMsgHistoryBank, one transaction per
+ *    batch, and moves WAL checkpoint forward
+ * 4. after crash, records behind checkpoint are replayed on startup
+ */
+class WriteBehindCommitter : public Singleton<WriteBehindCommitter> {
+  friend class Singleton<WriteBehindCommitter>;
+
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+
+  WriteBehindCommitter();
+
+public:
+  ~WriteBehindCommitter();
+
+  bool isEnabled() const { return m_enabled; }
+
+  /*
+   * assign message_id to every message and append them to WAL
+   * messages are verified as soon as WAL accepts them
+   */
+  [[nodiscard]] bool submit(std::vector<std::shared_ptr<chat::MsgInfo>> &info);
+
+  /*
+   * thread_id is the private chat of sender and receiver, users of a private
+   * chat never change, so MySQL is only asked once for every thread
+   */
+  [[nodiscard]] bool checkPrivateChatThread(const std::size_t thread_id,
+                                            const std::size_t sender,
+                                            const std::size_t receiver);
+
+  /*commit everything left in memory and stop background threads*/
+  void shutdown();
+
+private:
+  void committer();
+  void syncer();
+  bool persist(const std::vector<WriteAheadLog::Record> &batch);
+
+private:
+  /*ChatMsgHistoryBank.message_content is TEXT*/
+  static constexpr std::size_t max_content_length = 65535;
+
+  /*verified threads kept in memory, cache is dropped once it is full*/
+  static constexpr std::size_t max_private_threads = 1 << 20;
+
+  bool m_enabled;
+  std::atomic<bool> m_stop;
+
+  std::size_t m_batch_size;
+  std::chrono::milliseconds m_fsync_interval;
+  std::chrono::milliseconds m_commit_interval;
+
+  std::unique_ptr<WriteAheadLog> m_wal;
+
+  /*records appended to WAL but not yet committed, ordered by WAL offset*/
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::deque<WriteAheadLog::Record> m_pending;
+
+  /*thread_id -> (smaller uuid, larger uuid)*/
+  std::shared_mutex m_threads_mtx;
+  std::unordered_map<std::size_t, std::pair<std::size_t, std::size_t>>
+      m_private_threads;
+
+  std::thread m_committer;
+  std::thread m_syncer;
+};
+} // namespace chat
+
+#endif //_WRITEBEHINDCOMMITTER_HPP_
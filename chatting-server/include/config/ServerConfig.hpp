@@ -1,12 +1,32 @@
 #ifndef _INIREADER_HPP_
 #define _INIREADER_HPP_
+#include <algorithm>
+#include <cctype>
 #include <inicpp.h>
+#include <network/def.hpp>
 #include <singleton/singleton.hpp>
+#include <sstream>
+#include <tools/tools.hpp>
+#include <unordered_map>
+#include <vector>
 
 struct ServerConfig : public Singleton<ServerConfig> {
   friend class Singleton<ServerConfig>;
 
 public:
+  struct MySQLShardInfo {
+    std::string host;
+    std::string port;
+    std::string username;
+    std::string passwd;
+    std::string database;
+  };
+
+  /*read-only copy of a shard*/
+  struct MySQLReplicaInfo : MySQLShardInfo {
+    std::string shard;
+  };
+
   std::string GrpcServerName;
   std::string GrpcServerHost;
   unsigned short GrpcServerPort;
@@ -14,6 +34,61 @@ public:
   unsigned short ChattingServerPort;
   std::size_t ChattingServerQueueSize;
   std::size_t heart_beat_timeout;
+  std::size_t GroupMemberCacheTTL;
+  std::size_t RecentMessageCount;
+  std::size_t RecentMessageTTL; // seconds
+  std::size_t ThreadIndexTTL;   // seconds
+  std::size_t ReadCursorFlushInterval; // milliseconds
+  std::size_t ReadCursorBatchSize;
+  std::size_t SyncPageSize;
+  std::size_t SyncFrameSize; // bytes
+  std::size_t OfflineInboxCapacity;
+  std::size_t OfflineInboxTTL; // seconds
+
+  std::size_t UserSearchScanBatchSize;
+  std::size_t UserSearchRefreshInterval; // milliseconds
+  std::size_t UserSearchPageSize;
+  std::size_t UserSearchMaxPageSize;
+  std::size_t UserSearchMaxTypos;
+
+  std::string ChatSearchDirectory;
+  std::size_t ChatSearchScanBatchSize;
+  std::size_t ChatSearchRefreshInterval; // milliseconds
+  std::size_t ChatSearchTailLag;         // milliseconds
+  std::size_t ChatSearchFlushThreshold;  // postings
+  std::size_t ChatSearchMaxSegments;
+  std::size_t ChatSearchMergeFactor;
+  std::size_t ChatSearchMaxSegmentSize; // MB
+  std::size_t ChatSearchPageSize;
+  std::size_t ChatSearchMaxPageSize;
+
+  std::size_t FrameMaxLength; // bytes
+  std::size_t FrameChunkSize; // bytes
+
+  /*request size limit of every ServiceType, FrameMaxLength by default*/
+  std::unordered_map<ServiceType, std::size_t> FrameLimits;
+
+  bool CompressionEnabled;
+  std::size_t CompressionThreshold; // bytes
+  int CompressionLevel;
+  bool GrpcCompressionEnabled;
+
+  bool WriteBehindEnabled;
+  std::string WriteBehindDirectory;
+  std::size_t WriteBehindBatchSize;
+  std::size_t WriteBehindFsyncInterval;  // milliseconds
+  std::size_t WriteBehindCommitInterval; // milliseconds
+
+  bool ArchiveEnabled;
+  std::string ArchiveDirectory;
+  std::size_t ArchiveAge;      // seconds
+  std::size_t ArchiveInterval; // seconds
+  std::size_t ArchiveBatchSize;
+  std::size_t ArchiveBlockSize;
+  int ArchiveCompressionLevel;
+  std::size_t ArchiveMaxThreadsPerRun;
+  std::size_t ArchiveMaxOpenSegments;
+  std::size_t ArchiveRefreshInterval; // seconds
 
   std::string BalanceServiceAddress;
   std::string BalanceServicePort;
@@ -22,6 +97,21 @@ public:
   unsigned short Redis_port;
   std::string Redis_passwd;
   std::size_t Redis_timeout;
+  std::size_t Redis_async_connections;
+
+  /*every redis node, only [Redis] host/port when nodes is not set*/
+  std::vector<std::pair<std::string, unsigned short>> Redis_nodes;
+
+  bool RedisTrackingEnabled;
+  std::vector<std::string> RedisTrackingPrefixes;
+  std::size_t RedisTrackingCapacity;
+  std::size_t RedisTrackingCheckInterval; // seconds
+
+  std::size_t LockWaitTime;  // milliseconds
+  std::size_t LockLeaseTime; // milliseconds
+
+  std::size_t PoolAcquireTimeout;     // milliseconds
+  std::size_t PoolStatisticsInterval; // seconds
 
   std::string MySQL_host;
   std::string MySQL_port;
@@ -30,17 +120,47 @@ public:
   std::string MySQL_database;
   std::size_t MySQL_timeout;
 
+  std::size_t MySQLShardBuckets;
+  std::size_t MySQLShardRefreshInterval; // seconds
+  std::size_t MySQLShardMigrateBatchSize;
+
+  /*shards other than [MySQL], shard name -> connection info*/
+  std::unordered_map<std::string, MySQLShardInfo> MySQLShards;
+
+  std::size_t MySQLReadYourWritesWindow; // milliseconds
+
+  /*replica name -> connection info and the shard it copies*/
+  std::unordered_map<std::string, MySQLReplicaInfo> MySQLReplicas;
+
   ~ServerConfig() = default;
 
+  std::size_t getFrameLimit(ServiceType type) const {
+    if (auto it = FrameLimits.find(type); it != FrameLimits.end()) {
+      return it->second;
+    }
+    return FrameMaxLength;
+  }
+
 private:
   ServerConfig() {
     /*init config*/
     m_ini.load(CONFIG_HOME "config.ini");
     loadChattingServiceInfo();
+    loadUserSearchInfo();
+    loadChatSearchInfo();
     loadGrpcServerInfo();
     loadBalanceServiceInfo();
     loadMySQLInfo();
+    loadMySQLShardInfo();
+    loadMySQLReplicaInfo();
     loadRedisInfo();
+    loadRedisTrackingInfo();
+    loadDistributedLockInfo();
+    loadConnectionPoolInfo();
+    loadWriteBehindInfo();
+    loadArchiveInfo();
+    loadFrameLimitInfo();
+    loadCompressionInfo();
   }
 
   void loadRedisInfo() {
@@ -49,6 +169,58 @@ private:
     Redis_passwd = m_ini["Redis"]["password"].as<std::string>();
 
     Redis_timeout = m_ini["Redis"]["timeout"].as<unsigned long>();
+    Redis_async_connections =
+        m_ini["Redis"]["async_connections"].as<unsigned long>();
+
+    /*nodes = host1:port1,host2:port2*/
+    std::stringstream ss(m_ini["Redis"]["nodes"].as<std::string>());
+    for (std::string node; std::getline(ss, node, ',');) {
+      node.erase(
+          std::remove_if(node.begin(), node.end(),
+                         [](unsigned char c) { return std::isspace(c); }),
+          node.end());
+      auto pos = node.rfind(':');
+      if (pos == std::string::npos) {
+        continue;
+      }
+      Redis_nodes.emplace_back(
+          node.substr(0, pos),
+          static_cast<unsigned short>(std::stoul(node.substr(pos + 1))));
+    }
+    if (Redis_nodes.empty()) {
+      Redis_nodes.emplace_back(Redis_ip_addr, Redis_port);
+    }
+  }
+
+  void loadRedisTrackingInfo() {
+    RedisTrackingEnabled = m_ini["RedisTracking"]["enable"].as<bool>();
+    RedisTrackingCapacity = m_ini["RedisTracking"]["capacity"].as<int>();
+    RedisTrackingCheckInterval =
+        m_ini["RedisTracking"]["check_interval"].as<int>();
+
+    /*prefixes = prefix1,prefix2*/
+    std::stringstream ss(m_ini["RedisTracking"]["prefixes"].as<std::string>());
+    for (std::string prefix; std::getline(ss, prefix, ',');) {
+      prefix.erase(
+          std::remove_if(prefix.begin(), prefix.end(),
+                         [](unsigned char c) { return std::isspace(c); }),
+          prefix.end());
+      if (!prefix.empty()) {
+        RedisTrackingPrefixes.push_back(prefix);
+      }
+    }
+  }
+
+  void loadDistributedLockInfo() {
+    LockWaitTime = m_ini["DistributedLock"]["wait"].as<int>();
+    LockLeaseTime = m_ini["DistributedLock"]["lease"].as<int>();
+  }
+
+  void loadConnectionPoolInfo() {
+    PoolAcquireTimeout =
+        m_ini["ConnectionPool"]["acquire_timeout"].as<int>();
+    PoolStatisticsInterval =
+        m_ini["ConnectionPool"]["statistics_interval"].as<int>();
   }
 
   void loadGrpcServerInfo() {
@@ -63,6 +235,90 @@ private:
         m_ini["ChattingServer"]["send_queue_size"].as<int>();
     heart_beat_timeout =
         m_ini["ChattingServer"]["heart_beat_timeout"].as<int>();
+    GroupMemberCacheTTL =
+        m_ini["ChattingServer"]["group_member_cache_ttl"].as<int>();
+    RecentMessageCount =
+        m_ini["ChattingServer"]["recent_message_count"].as<int>();
+    RecentMessageTTL = m_ini["ChattingServer"]["recent_message_ttl"].as<int>();
+    ThreadIndexTTL = m_ini["ChattingServer"]["thread_index_ttl"].as<int>();
+    ReadCursorFlushInterval =
+        m_ini["ChattingServer"]["read_cursor_flush_interval"].as<int>();
+    ReadCursorBatchSize =
+        m_ini["ChattingServer"]["read_cursor_batch_size"].as<int>();
+    SyncPageSize = m_ini["ChattingServer"]["sync_page_size"].as<int>();
+    SyncFrameSize = m_ini["ChattingServer"]["sync_frame_size"].as<int>();
+    OfflineInboxCapacity =
+        m_ini["ChattingServer"]["offline_inbox_capacity"].as<int>();
+    OfflineInboxTTL = m_ini["ChattingServer"]["offline_inbox_ttl"].as<int>();
+  }
+
+  void loadUserSearchInfo() {
+    UserSearchScanBatchSize = m_ini["UserSearch"]["scan_batch_size"].as<int>();
+    UserSearchRefreshInterval =
+        m_ini["UserSearch"]["refresh_interval"].as<int>();
+    UserSearchPageSize = m_ini["UserSearch"]["page_size"].as<int>();
+    UserSearchMaxPageSize = m_ini["UserSearch"]["max_page_size"].as<int>();
+    UserSearchMaxTypos = m_ini["UserSearch"]["max_typos"].as<int>();
+  }
+
+  void loadChatSearchInfo() {
+    ChatSearchDirectory = m_ini["ChatSearch"]["index_dir"].as<std::string>();
+    ChatSearchScanBatchSize = m_ini["ChatSearch"]["scan_batch_size"].as<int>();
+    ChatSearchRefreshInterval =
+        m_ini["ChatSearch"]["refresh_interval"].as<int>();
+    ChatSearchTailLag = m_ini["ChatSearch"]["tail_lag"].as<int>();
+    ChatSearchFlushThreshold =
+        m_ini["ChatSearch"]["flush_threshold"].as<int>();
+    ChatSearchMaxSegments = m_ini["ChatSearch"]["max_segments"].as<int>();
+    ChatSearchMergeFactor = m_ini["ChatSearch"]["merge_factor"].as<int>();
+    ChatSearchMaxSegmentSize =
+        m_ini["ChatSearch"]["max_segment_size"].as<int>();
+    ChatSearchPageSize = m_ini["ChatSearch"]["page_size"].as<int>();
+    ChatSearchMaxPageSize = m_ini["ChatSearch"]["max_page_size"].as<int>();
+  }
+
+  void loadWriteBehindInfo() {
+    WriteBehindEnabled = m_ini["WriteBehind"]["enable"].as<bool>();
+    WriteBehindDirectory = m_ini["WriteBehind"]["wal_dir"].as<std::string>();
+    WriteBehindBatchSize = m_ini["WriteBehind"]["batch_size"].as<int>();
+    WriteBehindFsyncInterval = m_ini["WriteBehind"]["fsync_interval"].as<int>();
+    WriteBehindCommitInterval =
+        m_ini["WriteBehind"]["commit_interval"].as<int>();
+  }
+
+  void loadArchiveInfo() {
+    ArchiveEnabled = m_ini["Archive"]["enable"].as<bool>();
+    ArchiveDirectory = m_ini["Archive"]["archive_dir"].as<std::string>();
+    ArchiveAge = m_ini["Archive"]["archive_age"].as<int>();
+    ArchiveInterval = m_ini["Archive"]["archive_interval"].as<int>();
+    ArchiveBatchSize = m_ini["Archive"]["batch_size"].as<int>();
+    ArchiveBlockSize = m_ini["Archive"]["block_size"].as<int>();
+    ArchiveCompressionLevel = m_ini["Archive"]["compression_level"].as<int>();
+    ArchiveMaxThreadsPerRun =
+        m_ini["Archive"]["max_threads_per_run"].as<int>();
+    ArchiveMaxOpenSegments = m_ini["Archive"]["max_open_segments"].as<int>();
+    ArchiveRefreshInterval = m_ini["Archive"]["refresh_interval"].as<int>();
+  }
+
+  void loadFrameLimitInfo() {
+    FrameMaxLength = m_ini["FrameLimit"]["max_length"].as<int>();
+    FrameChunkSize = m_ini["FrameLimit"]["chunk_size"].as<int>();
+
+    /*every numeric key is the value of a ServiceType*/
+    for (auto &[key, value] : m_ini["FrameLimit"]) {
+      auto type = tools::string_to_value<std::size_t>(key);
+      if (type.has_value() &&
+          *type < static_cast<std::size_t>(ServiceType::SERVICE_UNKNOWN)) {
+        FrameLimits[static_cast<ServiceType>(*type)] = value.as<int>();
+      }
+    }
+  }
+
+  void loadCompressionInfo() {
+    CompressionEnabled = m_ini["Compression"]["enable"].as<bool>();
+    CompressionThreshold = m_ini["Compression"]["threshold"].as<int>();
+    CompressionLevel = m_ini["Compression"]["level"].as<int>();
+    GrpcCompressionEnabled = m_ini["Compression"]["grpc_gzip"].as<bool>();
   }
 
   void loadBalanceServiceInfo() {
@@ -79,6 +335,49 @@ private:
     MySQL_timeout = m_ini["MySQL"]["timeout"].as<unsigned long>();
   }
 
+  void loadMySQLShardInfo() {
+    MySQLShardBuckets = m_ini["MySQLShard"]["buckets"].as<int>();
+    MySQLShardRefreshInterval =
+        m_ini["MySQLShard"]["refresh_interval"].as<int>();
+    MySQLShardMigrateBatchSize =
+        m_ini["MySQLShard"]["migrate_batch_size"].as<int>();
+
+    /*[MySQLShard.name] sections*/
+    const std::string prefix = "MySQLShard.";
+    for (auto &[name, section] : m_ini) {
+      if (name.size() <= prefix.size() || name.rfind(prefix, 0)) {
+        continue;
+      }
+      MySQLShards[name.substr(prefix.size())] = MySQLShardInfo{
+          section["host"].as<std::string>(),
+          section["port"].as<std::string>(),
+          section["username"].as<std::string>(),
+          section["password"].as<std::string>(),
+          section["database"].as<std::string>()};
+    }
+  }
+
+  void loadMySQLReplicaInfo() {
+    MySQLReadYourWritesWindow =
+        m_ini["MySQLReplica"]["read_your_writes"].as<int>();
+
+    /*[MySQLReplica.name] sections, shard is "primary" when it is omitted*/
+    const std::string prefix = "MySQLReplica.";
+    for (auto &[name, section] : m_ini) {
+      if (name.size() <= prefix.size() || name.rfind(prefix, 0)) {
+        continue;
+      }
+      auto shard = section["shard"].as<std::string>();
+      MySQLReplicas[name.substr(prefix.size())] = MySQLReplicaInfo{
+          {section["host"].as<std::string>(),
+           section["port"].as<std::string>(),
+           section["username"].as<std::string>(),
+           section["password"].as<std::string>(),
+           section["database"].as<std::string>()},
+          shard.empty() ? "primary" : shard};
+    }
+  }
+
 private:
   ini::IniFile m_ini;
 };
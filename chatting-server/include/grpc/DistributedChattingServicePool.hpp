@@ -50,17 +50,27 @@ public:
     auto address = fmt::format("{}:{}", m_host, m_port);
     spdlog::info("Loading Peer Chatting Servers {}", address);
 
+    /*message batches between chatting servers are repetitive, gzip them*/
+    grpc::ChannelArguments args;
+    if (ServerConfig::get_instance()->GrpcCompressionEnabled) {
+      args.SetCompressionAlgorithm(GRPC_COMPRESS_GZIP);
+    }
+
     /*creating multiple stub*/
     for (std::size_t i = 0; i < m_queue_size; ++i) {
-      m_stub_queue.push(std::move(message::DistributedChattingService::NewStub(
-          grpc::CreateChannel(address, m_cred))));
+      add(std::move(message::DistributedChattingService::NewStub(
+          grpc::CreateCustomChannel(address, m_cred, args))));
     }
   }
 
   virtual ~DistributedChattingServicePool() = default;
 
 public:
-  auto acquire_stub() { return this->acquire(); }
+  /*requests are forwarded on the request path, never wait forever*/
+  auto acquire_stub() {
+    return this->acquire(std::chrono::milliseconds(
+        ServerConfig::get_instance()->PoolAcquireTimeout));
+  }
 
   void release_stub(
       std::unique_ptr<message::DistributedChattingService::Stub> stub) {
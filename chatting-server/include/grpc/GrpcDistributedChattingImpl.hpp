@@ -45,6 +45,13 @@ public:
                       const ::message::ChattingTextMsgRequest *request,
                       ::message::ChattingTextMsgResponse *response) override;
 
+  // transfer group chatting message from user A to group members on this
+  // server
+  ::grpc::Status SendGroupChattingTextMsg(
+      ::grpc::ServerContext *context,
+      const ::message::GroupChattingTextMsgRequest *request,
+      ::message::GroupChattingTextMsgResponse *response) override;
+
 private:
 };
 } // namespace grpc
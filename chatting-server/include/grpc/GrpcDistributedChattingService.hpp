@@ -1,6 +1,7 @@
 #pragma once
 #ifndef _GRPCDISTRIBUTEDCHATTINGSERVICE_HPP_
 #define _GRPCDISTRIBUTEDCHATTINGSERVICE_HPP_
+#include <functional>
 #include <grpc/DistributedChattingServicePool.hpp>
 #include <grpc/RegisterChattingServicePool.hpp>
 #include <network/def.hpp>
@@ -18,6 +19,14 @@ public:
   forceTerminateLoginedUser(const std::string &server_name,
                             const message::TerminationRequest &req);
 
+  /*
+   * send TerminationRequest without waiting for the response, callback is
+   * executed by a grpc thread once peer responsed or the call failed
+   */
+  void asyncForceTerminateLoginedUser(
+      const std::string &server_name, const message::TerminationRequest &req,
+      std::function<void(message::TerminationResponse)> callback);
+
   message::FriendResponse sendFriendRequest(const std::string &server_name,
                                             const message::FriendRequest &req);
   message::AuthoriseResponse
@@ -28,6 +37,10 @@ public:
   sendChattingTextMsg(const std::string &server_name,
                       const message::ChattingTextMsgRequest &req);
 
+  message::GroupChattingTextMsgResponse
+  sendGroupChattingTextMsg(const std::string &server_name,
+                           const message::GroupChattingTextMsgRequest &req);
+
 protected:
   void updateGrpcPeerLists();
 
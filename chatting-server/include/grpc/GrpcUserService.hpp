@@ -1,6 +1,8 @@
 #pragma once
 #ifndef GRPCUSERSERVICE_HPP_
 #define GRPCUSERSERVICE_HPP_
+#include <chrono>
+#include <config/ServerConfig.hpp>
 #include <grpc/UserServicePool.hpp>
 #include <grpcpp/client_context.h>
 #include <grpcpp/support/status.h>
@@ -21,7 +23,14 @@ struct gRPCGrpcUserService {
 
     connection::ConnectionRAII<stubpool::UserServicePool,
                                message::UserService::Stub>
-        raii;
+        raii(std::chrono::milliseconds(
+            ServerConfig::get_instance()->PoolAcquireTimeout));
+
+    /*every stub is busy, give up instead of blocking this request*/
+    if (!raii.is_active()) {
+      response.set_error(static_cast<int32_t>(ServiceStatus::GRPC_ERROR));
+      return response;
+    }
 
     grpc::Status status = raii->get()->LoginUser(&context, request, &response);
 
@@ -43,7 +52,14 @@ struct gRPCGrpcUserService {
 
     connection::ConnectionRAII<stubpool::UserServicePool,
                                message::UserService::Stub>
-        raii;
+        raii(std::chrono::milliseconds(
+            ServerConfig::get_instance()->PoolAcquireTimeout));
+
+    /*every stub is busy, give up instead of blocking this request*/
+    if (!raii.is_active()) {
+      response.set_error(static_cast<int32_t>(ServiceStatus::GRPC_ERROR));
+      return response;
+    }
 
     grpc::Status status = raii->get()->LogoutUser(&context, request, &response);
 
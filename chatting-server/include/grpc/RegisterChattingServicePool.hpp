@@ -37,7 +37,7 @@ class RegisterChattingServicePool
 
     /*creating multiple stub*/
     for (std::size_t i = 0; i < m_queue_size; ++i) {
-      m_stub_queue.push(std::move(message::ChattingRegisterService::NewStub(
+      add(std::move(message::ChattingRegisterService::NewStub(
           grpc::CreateChannel(address, m_cred))));
     }
   }
@@ -33,7 +33,7 @@ class UserServicePool
 
     /*creating multiple stub*/
     for (std::size_t i = 0; i < m_queue_size; ++i) {
-      m_stub_queue.push(std::move(
+      add(std::move(
           message::UserService::NewStub(grpc::CreateChannel(address, m_cred))));
     }
   }
@@ -0,0 +1,243 @@
+#pragma once
+#ifndef _REQUESTSCHEMA_HPP_
+#define _REQUESTSCHEMA_HPP_
+#include <charconv>
+#include <cstdint>
+#include <handler/RequestView.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tools/tools.hpp>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Compile-time schema of json requests and responses
+ * every message struct lists its fields once:
+ *
+ *   static constexpr auto fields = std::make_tuple(
+ *       schema::field("uuid", &MarkReadRequest::uuid), ...);
+ *
+ * decode() and encode() are expanded from this tuple, so handlers never
+ * check contains() or convert strings by hand
+ *
+ * 1. integers are carried as decimal strings(uuid, thread_id, msg_id...),
+ *    Encoding::NUMBER is used for real json numbers(error, msg_type...)
+ * 2. std::optional members may be missing, others are required
+ * 3. string_view members point into the parser of current thread, see
+ *    RequestView
+ */
+namespace schema {
+enum class Encoding : uint8_t { STRING, NUMBER };
+
+template <typename Class, typename Member> struct Field {
+  std::string_view name;
+  Member Class::*member;
+  Encoding encoding;
+};
+
+template <typename Class, typename Member>
+constexpr Field<Class, Member> field(std::string_view name,
+                                     Member Class::*member,
+                                     Encoding encoding = Encoding::STRING) {
+  return Field<Class, Member>{name, member, encoding};
+}
+
+namespace detail {
+template <typename T> struct is_optional : std::false_type {};
+template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename T> struct is_vector : std::false_type {};
+template <typename T> struct is_vector<std::vector<T>> : std::true_type {};
+
+template <typename T>
+constexpr bool is_integer_v = std::is_integral_v<T> && !std::is_same_v<T, bool>;
+
+template <typename T>
+bool decodeValue(const RequestView &view, std::string_view name,
+                 Encoding encoding, T &value);
+
+template <typename T> bool decodeObject(const RequestView &view, T &value) {
+  return std::apply(
+      [&](const auto &...fields) {
+        return (decodeValue(view, fields.name, fields.encoding,
+                            value.*(fields.member)) &&
+                ...);
+      },
+      T::fields);
+}
+
+template <typename T>
+bool decodeValue(const RequestView &view, std::string_view name,
+                 Encoding encoding, T &value) {
+  if constexpr (is_optional<T>::value) {
+    if (!view.contains(name)) {
+      value.reset();
+      return true;
+    }
+    return decodeValue(view, name, encoding, value.emplace());
+  } else if constexpr (std::is_same_v<T, std::string_view>) {
+    auto ret = view.getString(name);
+    return ret.has_value() ? (value = *ret, true) : false;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    auto ret = view.getString(name);
+    return ret.has_value() ? (value.assign(*ret), true) : false;
+  } else if constexpr (std::is_same_v<T, bool>) {
+    auto ret = view.getBool(name);
+    return ret.has_value() ? (value = *ret, true) : false;
+  } else if constexpr (is_integer_v<T>) {
+    std::optional<std::uint64_t> ret;
+    if (encoding == Encoding::STRING) {
+      auto str = view.getString(name);
+      ret = str.has_value() ? tools::string_to_value<std::uint64_t>(*str)
+                            : std::nullopt;
+    } else {
+      ret = view.getUInt(name);
+    }
+    return ret.has_value() ? (value = static_cast<T>(*ret), true) : false;
+  } else if constexpr (is_vector<T>::value) {
+    auto arr = view.getObjects(name);
+    if (!arr.has_value()) {
+      return false;
+    }
+    value.resize(arr->size());
+    for (std::size_t i = 0; i < arr->size(); ++i) {
+      if (!decodeObject((*arr)[i], value[i])) {
+        return false;
+      }
+    }
+    return true;
+  } else {
+    auto obj = view.getObject(name);
+    return obj.has_value() && decodeObject(*obj, value);
+  }
+}
+
+inline void encodeString(std::string &out, std::string_view str) {
+  static constexpr char hex[] = "0123456789abcdef";
+  out.push_back('"');
+  for (const char c : str) {
+    switch (c) {
+    case '"':
+      out.append("\\\"");
+      break;
+    case '\\':
+      out.append("\\\\");
+      break;
+    case '\n':
+      out.append("\\n");
+      break;
+    case '\r':
+      out.append("\\r");
+      break;
+    case '\t':
+      out.append("\\t");
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        out.append("\\u00");
+        out.push_back(hex[(c >> 4) & 0xF]);
+        out.push_back(hex[c & 0xF]);
+      } else {
+        out.push_back(c);
+      }
+    }
+  }
+  out.push_back('"');
+}
+
+template <typename T> void encodeObject(std::string &out, const T &value);
+
+template <typename T>
+void encodeValue(std::string &out, Encoding encoding, const T &value) {
+  if constexpr (std::is_same_v<T, std::string_view> ||
+                std::is_same_v<T, std::string>) {
+    encodeString(out, value);
+  } else if constexpr (std::is_same_v<T, bool>) {
+    out.append(value ? "true" : "false");
+  } else if constexpr (is_integer_v<T>) {
+    char buffer[24];
+    auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    if (encoding == Encoding::STRING) {
+      out.push_back('"');
+      out.append(buffer, res.ptr);
+      out.push_back('"');
+    } else {
+      out.append(buffer, res.ptr);
+    }
+  } else if constexpr (is_vector<T>::value) {
+    out.push_back('[');
+    for (std::size_t i = 0; i < value.size(); ++i) {
+      if (i) {
+        out.push_back(',');
+      }
+      encodeObject(out, value[i]);
+    }
+    out.push_back(']');
+  } else {
+    encodeObject(out, value);
+  }
+}
+
+template <typename T> void encodeObject(std::string &out, const T &value) {
+  bool first = true;
+  out.push_back('{');
+  std::apply(
+      [&](const auto &...fields) {
+        (
+            [&](const auto &field) {
+              const auto &member = value.*(field.member);
+              using Member = std::decay_t<decltype(member)>;
+
+              /*missing optional fields are not written*/
+              if constexpr (is_optional<Member>::value) {
+                if (!member.has_value()) {
+                  return;
+                }
+              }
+
+              if (!first) {
+                out.push_back(',');
+              }
+              first = false;
+              encodeString(out, field.name);
+              out.push_back(':');
+
+              if constexpr (is_optional<Member>::value) {
+                encodeValue(out, field.encoding, *member);
+              } else {
+                encodeValue(out, field.encoding, member);
+              }
+            }(fields),
+            ...);
+      },
+      T::fields);
+  out.push_back('}');
+}
+} // namespace detail
+
+/*std::nullopt when a required field is missing or has another type*/
+template <typename T>
+[[nodiscard]] std::optional<T> decode(const RequestView &view) {
+  T value{};
+  if (!detail::decodeObject(view, value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+/*serialize into out, out is not cleared so it could be reused*/
+template <typename T> void encode(std::string &out, const T &value) {
+  detail::encodeObject(out, value);
+}
+
+template <typename T> [[nodiscard]] std::string encode(const T &value) {
+  std::string out;
+  out.reserve(128);
+  detail::encodeObject(out, value);
+  return out;
+}
+} // namespace schema
+
+#endif //_REQUESTSCHEMA_HPP_
@@ -0,0 +1,42 @@
+#pragma once
+#ifndef _REQUESTVIEW_HPP_
+#define _REQUESTVIEW_HPP_
+#include <cstdint>
+#include <optional>
+#include <simdjson.h>
+#include <string_view>
+#include <vector>
+
+/*
+ * Read-only view of a json request parsed by simdjson
+ * 1. every thread owns one parser, its buffers are reused by every request
+ *    handled on this thread, so hot handlers do not allocate a json tree
+ * 2. strings are returned as string_view pointing into the parser, they are
+ *    valid until the next parse() on the same thread, copy them if they
+ *    should live longer
+ */
+class RequestView {
+  explicit RequestView(simdjson::dom::object obj) : m_obj(obj) {}
+
+public:
+  /*body must be a json object, otherwise std::nullopt*/
+  [[nodiscard]] static std::optional<RequestView> parse(std::string_view body);
+
+  bool contains(std::string_view key) const;
+
+  /*std::nullopt when key is missing or value has another type*/
+  std::optional<std::string_view> getString(std::string_view key) const;
+  std::optional<bool> getBool(std::string_view key) const;
+  std::optional<std::uint64_t> getUInt(std::string_view key) const;
+
+  std::optional<RequestView> getObject(std::string_view key) const;
+
+  /*all object items of an array, items of other types are skipped*/
+  std::optional<std::vector<RequestView>>
+  getObjects(std::string_view key) const;
+
+private:
+  simdjson::dom::object m_obj;
+};
+
+#endif //_REQUESTVIEW_HPP_
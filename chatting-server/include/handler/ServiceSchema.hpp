@@ -0,0 +1,145 @@
+#pragma once
+#ifndef _SERVICESCHEMA_HPP_
+#define _SERVICESCHEMA_HPP_
+#include <handler/RequestSchema.hpp>
+#include <network/def.hpp>
+
+/*
+ * Request and response messages of every typed ServiceType
+ * ServiceSchema<Type>::Request  json sent by client
+ * ServiceSchema<Type>::Response json sent back, by ServiceSchema<Type>::type
+ */
+namespace schema {
+
+/*ServiceType::SERVICE_HEARTBEAT_REQUEST*/
+struct HeartBeatRequest {
+  std::string_view uuid;
+
+  static constexpr auto fields =
+      std::make_tuple(field("uuid", &HeartBeatRequest::uuid));
+};
+
+struct HeartBeatResponse {
+  std::size_t error = 0;
+
+  static constexpr auto fields = std::make_tuple(
+      field("error", &HeartBeatResponse::error, Encoding::NUMBER));
+};
+
+/*ServiceType::SERVICE_SEARCHUSERNAME*/
+struct UserSearchRequest {
+  std::string_view username;        // prefix or misspelled name is allowed
+  std::optional<std::size_t> offset; // position of the first result
+  std::optional<std::size_t> limit;  // results of one page
+
+  static constexpr auto fields =
+      std::make_tuple(field("username", &UserSearchRequest::username),
+                      field("offset", &UserSearchRequest::offset),
+                      field("limit", &UserSearchRequest::limit));
+};
+
+/*ServiceType::SERVICE_MARKREADREQUEST*/
+struct MarkReadRequest {
+  std::size_t uuid = 0;
+  std::size_t thread_id = 0;
+  std::size_t msg_id = 0;
+
+  static constexpr auto fields =
+      std::make_tuple(field("uuid", &MarkReadRequest::uuid),
+                      field("thread_id", &MarkReadRequest::thread_id),
+                      field("msg_id", &MarkReadRequest::msg_id));
+};
+
+struct MarkReadResponse {
+  std::size_t error = 0;
+  std::size_t uuid = 0;
+  std::size_t thread_id = 0;
+  std::size_t msg_id = 0;
+
+  static constexpr auto fields = std::make_tuple(
+      field("error", &MarkReadResponse::error, Encoding::NUMBER),
+      field("uuid", &MarkReadResponse::uuid),
+      field("thread_id", &MarkReadResponse::thread_id),
+      field("msg_id", &MarkReadResponse::msg_id));
+};
+
+/*ServiceType::SERVICE_TEXTCHATMSGREQUEST*/
+struct TextChatMsgItem {
+  std::string_view unique_id;
+  std::optional<std::string_view> msg_sender;
+  std::optional<std::string_view> msg_receiver;
+  std::string_view msg_content;
+
+  static constexpr auto fields =
+      std::make_tuple(field("unique_id", &TextChatMsgItem::unique_id),
+                      field("msg_sender", &TextChatMsgItem::msg_sender),
+                      field("msg_receiver", &TextChatMsgItem::msg_receiver),
+                      field("msg_content", &TextChatMsgItem::msg_content));
+};
+
+struct TextChatMsgRequest {
+  std::optional<std::string_view> chat_type; // "GROUP" for group chat
+  std::string_view thread_id;
+  std::string_view text_sender;
+  std::optional<std::string_view> text_receiver; // private chat only
+  std::vector<TextChatMsgItem> text_msg;
+
+  static constexpr auto fields = std::make_tuple(
+      field("chat_type", &TextChatMsgRequest::chat_type),
+      field("thread_id", &TextChatMsgRequest::thread_id),
+      field("text_sender", &TextChatMsgRequest::text_sender),
+      field("text_receiver", &TextChatMsgRequest::text_receiver),
+      field("text_msg", &TextChatMsgRequest::text_msg));
+
+  bool isGroupChat() const { return chat_type == std::string_view("GROUP"); }
+};
+
+/*ServiceType::SERVICE_SEARCHCHATMSGREQUEST*/
+struct SearchChatMsgRequest {
+  std::size_t uuid = 0;
+  std::size_t thread_id = 0;
+  std::string_view keyword;
+  std::optional<std::size_t> offset; // position of the first result
+  std::optional<std::size_t> limit;  // results of one page
+
+  static constexpr auto fields =
+      std::make_tuple(field("uuid", &SearchChatMsgRequest::uuid),
+                      field("thread_id", &SearchChatMsgRequest::thread_id),
+                      field("keyword", &SearchChatMsgRequest::keyword),
+                      field("offset", &SearchChatMsgRequest::offset),
+                      field("limit", &SearchChatMsgRequest::limit));
+};
+
+template <ServiceType Type> struct ServiceSchema;
+
+template <> struct ServiceSchema<ServiceType::SERVICE_HEARTBEAT_REQUEST> {
+  using Request = HeartBeatRequest;
+  using Response = HeartBeatResponse;
+  static constexpr ServiceType type = ServiceType::SERVICE_HEARTBEAT_RESPONSE;
+};
+
+template <> struct ServiceSchema<ServiceType::SERVICE_SEARCHUSERNAME> {
+  using Request = UserSearchRequest;
+  static constexpr ServiceType type =
+      ServiceType::SERVICE_SEARCHUSERNAMERESPONSE;
+};
+
+template <> struct ServiceSchema<ServiceType::SERVICE_MARKREADREQUEST> {
+  using Request = MarkReadRequest;
+  using Response = MarkReadResponse;
+  static constexpr ServiceType type = ServiceType::SERVICE_MARKREADRESPONSE;
+};
+
+template <> struct ServiceSchema<ServiceType::SERVICE_TEXTCHATMSGREQUEST> {
+  using Request = TextChatMsgRequest;
+  static constexpr ServiceType type = ServiceType::SERVICE_TEXTCHATMSGRESPONSE;
+};
+
+template <> struct ServiceSchema<ServiceType::SERVICE_SEARCHCHATMSGREQUEST> {
+  using Request = SearchChatMsgRequest;
+  static constexpr ServiceType type =
+      ServiceType::SERVICE_SEARCHCHATMSGRESPONSE;
+};
+} // namespace schema
+
+#endif //_SERVICESCHEMA_HPP_
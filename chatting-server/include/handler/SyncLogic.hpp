@@ -5,11 +5,15 @@
 #include <boost/json/object.hpp>
 #include <boost/json/parse.hpp>
 #include <buffer/MsgNode.hpp>
+#include <handler/ServiceSchema.hpp>
+#include <array>
+#include <chrono>
 #include <memory>
 #include <network/def.hpp>
 #include <redis/RedisManager.hpp>
 #include <server/Session.hpp>
 #include <sql/MySQLConnectionPool.hpp>
+#include <type_traits>
 #include <unordered_map>
 #include <user/UserDef.hpp>
 #include <user/UserManager.hpp>
@@ -20,6 +24,10 @@ struct UserNameCard;
 struct UserFriendRequest;
 struct ChatThreadInfo;
 
+namespace message {
+class TerminationRequest;
+}
+
 class SyncLogic : public Singleton<SyncLogic> {
   friend class Singleton<SyncLogic>;
 
@@ -32,8 +40,13 @@ public:
   using SessionPtr = std::shared_ptr<Session>;
   using NodePtr = std::unique_ptr<RecvNode<std::string, ByteOrderConverter>>;
   using pair = std::pair<SessionPtr, NodePtr>;
-  using CallbackFunc =
-      std::function<void(ServiceType, std::shared_ptr<Session>, NodePtr)>;
+  using Handler = void (SyncLogic::*)(ServiceType, std::shared_ptr<Session>,
+                                      NodePtr);
+
+  /*indexed by ServiceType, nullptr for types which are not handled here*/
+  using HandlerTable =
+      std::array<Handler,
+                 static_cast<std::size_t>(ServiceType::SERVICE_UNKNOWN)>;
 
 public:
   ~SyncLogic();
@@ -44,9 +57,62 @@ protected:
   bool parseJson(std::shared_ptr<Session> session, NodePtr &recv,
                  boost::json::object &src_obj);
 
+  /*
+   * parse request of hot handlers without building a boost::json tree
+   * @param: type: response type used to report a broken request
+   */
+  std::optional<RequestView> parseRequest(std::shared_ptr<Session> session,
+                                          NodePtr &recv, ServiceType type);
+
+  /*decode request by its schema, broken request is reported to client*/
+  template <ServiceType Type>
+  std::optional<typename schema::ServiceSchema<Type>::Request>
+  decodeRequest(std::shared_ptr<Session> session, NodePtr &recv) {
+    constexpr ServiceType response = schema::ServiceSchema<Type>::type;
+
+    auto view = parseRequest(session, recv, response);
+    if (!view.has_value()) {
+      return std::nullopt;
+    }
+
+    auto ret = schema::decode<typename schema::ServiceSchema<Type>::Request>(
+        view.value());
+    if (!ret.has_value()) {
+      generateErrorMessage("Missing required fields", response,
+                           ServiceStatus::JSONPARSE_ERROR, session);
+    }
+    return ret;
+  }
+
+  template <ServiceType Type>
+  static void
+  sendResponse(std::shared_ptr<Session> session,
+               const typename schema::ServiceSchema<Type>::Response &response) {
+    session->sendMessage(schema::ServiceSchema<Type>::type,
+                         schema::encode(response), session);
+  }
+
   static void generateErrorMessage(const std::string &log, ServiceType type,
                                    ServiceStatus status, SessionPtr conn);
 
+  /*request path gives up waiting for a pooled connection after it*/
+  static std::chrono::milliseconds acquireTimeout();
+
+  /*false once pool exhaustion has been reported to client*/
+  template <typename RAII>
+  static bool checkAcquired(const RAII &raii, ServiceType type,
+                            SessionPtr conn) {
+    if (raii.is_active()) {
+      return true;
+    }
+    generateErrorMessage("Connection Pool Exhausted", type,
+                         std::is_same_v<RAII, RedisRAII>
+                             ? ServiceStatus::REDIS_UNKOWN_ERROR
+                             : ServiceStatus::MYSQL_INTERNAL_ERROR,
+                         conn);
+    return false;
+  }
+
   /*Execute Operations*/
   void handlingLogin(ServiceType srv_type, std::shared_ptr<Session> session,
                      NodePtr recv);
@@ -81,41 +147,83 @@ protected:
   void handlingTextChatMsg(ServiceType srv_type,
                            std::shared_ptr<Session> session, NodePtr recv);
 
+  /*
+   * Handling the user send chatting text msg to a group chat
+   * messages are persisted once, and delivered by one local loop plus one
+   * batched grpc call per remote chatting server
+   */
+  void handlingGroupTextChatMsg(std::shared_ptr<Session> session,
+                                const schema::TextChatMsgRequest &request);
+
   void handlingHeartBeat(ServiceType srv_type, std::shared_ptr<Session> session,
                          NodePtr recv);
 
+  /*
+   * delta sync after reconnect, return messages after client's high-water
+   * mark of every thread, recent message cache is used before MySQL
+   */
+  void handlingSyncChatMessages(ServiceType srv_type,
+                                std::shared_ptr<Session> session,
+                                NodePtr recv);
+
+  /*user has read messages of a thread until msg_id*/
+  void handlingMarkRead(ServiceType srv_type, std::shared_ptr<Session> session,
+                        NodePtr recv);
+
+  /*
+   * keyword search inside one thread, ranked message ids come from chat
+   * search index, messages are loaded from recent message cache or MySQL
+   */
+  void handlingSearchChatMessages(ServiceType srv_type,
+                                  std::shared_ptr<Session> session,
+                                  NodePtr recv);
+
 private:
   SyncLogic();
 
   /*SyncLogic Class Operations*/
   void shutdown();
   void processing();
-  void registerCallbacks();
   void execute(pair &&node);
 
   /*client enter current server*/
   void incrementConnection();
 
 private:
-  static std::optional<std::string>
-  checkCurrentUser([[maybe_unused]] RedisRAII &raii, const std::string &uuid);
-
-  /*store this user belonged server into redis*/
-  static bool labelCurrentUser([[maybe_unused]] RedisRAII &raii,
-                               const std::string &uuid);
-
-  /*store this user belonged session id into redis*/
-  static bool labelUserSessionID([[maybe_unused]] RedisRAII &raii,
-                                 const std::string &uuid,
-                                 const std::string &session_id);
+  /*
+   * store this user belonged server and session id into redis by one
+   * script, return the previous {server, session id}, std::nullopt inside
+   * if this user was offline
+   */
+  static std::optional<
+      std::pair<std::optional<std::string>, std::optional<std::string>>>
+  handoverCurrentUser([[maybe_unused]] RedisRAII &raii,
+                      const std::string &uuid, const std::string &session_id);
 
   static void updateRedisCache([[maybe_unused]] RedisRAII &raii,
                                const std::string &uuid,
                                std::shared_ptr<Session> session);
 
+  /*
+   * kick the replaced session on another server without waiting, failed
+   * kicks are retried later, peer only kicks that exact session, so a retry
+   * never hits a newer login
+   */
+  static void kickRemoteSession(const std::string &server,
+                                const message::TerminationRequest &req,
+                                const std::size_t attempt = 0);
+
   void kick_session(std::shared_ptr<Session> session);
   bool check_and_kick_existing_session(std::shared_ptr<Session> session);
 
+  /*
+   * push messages received while user was offline, messages are packed into
+   * as few frames as possible(bounded by sync_frame_size)
+   */
+  static void deliverOfflineMessages([[maybe_unused]] RedisRAII &raii,
+                                     const std::string &uuid,
+                                     std::shared_ptr<Session> session);
+
   /*
    * get user's basic info(name, age, sex, ...) from redis
    * 1. we are going to search for info inside redis first, if nothing found,
@@ -125,6 +233,14 @@ private:
   [[nodiscard]] static std::optional<std::unique_ptr<user::UserNameCard>>
   getUserBasicInfo(const std::string &key);
 
+  /*
+   * basic info of many users, one MGET for all of them, users missing in
+   * redis are loaded from mysql by one query and cached by one pipeline
+   * the result has the same order as uuids, nullptr if a user is not found
+   */
+  [[nodiscard]] static std::vector<std::unique_ptr<user::UserNameCard>>
+  getUserProfiles(const std::vector<std::string> &uuids);
+
   /*
    * get friend request list from the database
    * @param: startpos: get friend request from the index[startpos]
@@ -177,6 +293,21 @@ public:
   static std::string session_prefix;
 
 private:
+  /*
+   * KEYS[1] = uuid_{uuid}, KEYS[2] = session_{uuid}
+   * ARGV[1] = server, ARGV[2] = session id
+   */
+  static constexpr const char *handover_lua_script =
+      "local previous = {redis.call('get', KEYS[1]), "
+      "                  redis.call('get', KEYS[2])} "
+      "redis.call('set', KEYS[1], ARGV[1]) "
+      "redis.call('set', KEYS[2], ARGV[2]) "
+      "return previous";
+
+  /*remote kick attempts, delay doubles after every failure*/
+  static constexpr std::size_t max_kick_attempts = 5;
+  static constexpr std::chrono::milliseconds kick_retry_delay{200};
+
   std::atomic<bool> m_stop;
 
   /*working thread, handling commited request*/
@@ -189,8 +320,9 @@ private:
   /*user commit data to the queue*/
   std::queue<pair> m_queue;
 
-  /*callback list*/
-  std::unordered_map<ServiceType, CallbackFunc> m_callbacks;
+  /*handlers are bound at compile time*/
+  static constexpr HandlerTable makeHandlerTable();
+  static const HandlerTable handler_table;
 };
 
 #endif //_SYNCLOGIC_HPP_
@@ -0,0 +1,232 @@
+#pragma once
+#ifndef _ASYNCREDISCLIENT_HPP_
+#define _ASYNCREDISCLIENT_HPP_
+#include <atomic>
+#include <boost/asio.hpp>
+#include <chrono>
+#include <hiredis.h>
+#include <memory>
+#include <redis/RedisShardRing.hpp>
+#include <singleton/singleton.hpp>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*declaration*/
+struct redisAsyncContext;
+
+namespace redis {
+/*a copy of redisReply, it outlives the hiredis reply object*/
+struct AsyncReply {
+  int type = REDIS_REPLY_NIL;
+  long long integer = 0;
+  std::string str;
+  std::vector<AsyncReply> elements;
+
+  bool isError() const;
+  bool isNil() const;
+};
+
+/*
+ * One non-blocking connection, hiredis async context driven by the
+ * io_context thread which owns it
+ * 1. commands are written in the order they are submitted, replies come back
+ *    in the same order, so many requests are in flight on one connection
+ * 2. a command submitted while the connection is down fails at once with
+ *    boost::asio::error::not_connected, connection is re-established later
+ */
+class AsyncRedisConnection {
+  AsyncRedisConnection(const AsyncRedisConnection &) = delete;
+  AsyncRedisConnection &operator=(const AsyncRedisConnection &) = delete;
+
+public:
+  struct Completion {
+    virtual ~Completion() = default;
+    virtual void complete(const boost::system::error_code &ec,
+                          std::vector<AsyncReply> replies) = 0;
+  };
+
+  AsyncRedisConnection(boost::asio::io_context &ioc, const std::string &ip,
+                       const unsigned short port, const std::string &passwd,
+                       const std::chrono::seconds reconnect_interval);
+
+  ~AsyncRedisConnection();
+
+  boost::asio::io_context::executor_type get_executor() {
+    return m_ioc.get_executor();
+  }
+
+  /*thread safe, done is called once all replies arrived*/
+  void submit(std::vector<std::vector<std::string>> commands,
+              std::unique_ptr<Completion> done);
+
+  /*
+   * context is freed on the io_context thread, close waits for it, or frees
+   * it at once when io_context is stopped. replies not received yet are
+   * dropped
+   */
+  void close();
+
+private:
+  struct Batch;
+  struct Slot;
+
+  void connect();
+  void disconnected();
+
+  /*free context once, false if it was done by another thread*/
+  bool teardown();
+  void execute(std::vector<std::vector<std::string>> &commands,
+               std::unique_ptr<Completion> &done);
+
+  void watchRead();
+  void watchWrite();
+
+  /*hiredis event hooks, privdata is this connection*/
+  static void addRead(void *privdata);
+  static void delRead(void *privdata);
+  static void addWrite(void *privdata);
+  static void delWrite(void *privdata);
+  static void cleanup(void *privdata);
+
+  static void onConnect(const redisAsyncContext *ctx, int status);
+  static void onDisconnect(const redisAsyncContext *ctx, int status);
+  static void onAuth(redisAsyncContext *ctx, void *reply, void *privdata);
+  static void onReply(redisAsyncContext *ctx, void *reply, void *privdata);
+
+private:
+  boost::asio::io_context &m_ioc;
+  std::string m_ip;
+  unsigned short m_port;
+  std::string m_passwd;
+  std::chrono::seconds m_reconnect_interval;
+
+  /*only touched on m_ioc thread*/
+  redisAsyncContext *m_ctx;
+  std::unique_ptr<boost::asio::ip::tcp::socket> m_socket;
+  boost::asio::steady_timer m_timer;
+  bool m_stop;
+  bool m_want_read;
+  bool m_want_write;
+  bool m_reading;
+  bool m_writing;
+
+  /*waits of a freed context must not touch the new one*/
+  std::size_t m_generation;
+
+  std::atomic<bool> m_closed;
+};
+
+/*hand replies to the handler on its associated executor*/
+template <typename Handler, typename Result>
+class AsyncRedisCompletion final : public AsyncRedisConnection::Completion {
+  using executor_type = boost::asio::associated_executor_t<
+      Handler, boost::asio::io_context::executor_type>;
+
+public:
+  AsyncRedisCompletion(Handler handler,
+                       const boost::asio::io_context::executor_type &ex)
+      : m_handler(std::move(handler)),
+        m_work(boost::asio::get_associated_executor(m_handler, ex)) {}
+
+  void complete(const boost::system::error_code &ec,
+                std::vector<AsyncReply> replies) override {
+    auto executor = m_work.get_executor();
+    boost::asio::dispatch(
+        executor, [handler = std::move(m_handler), ec,
+                   replies = std::move(replies)]() mutable {
+          if constexpr (std::is_same_v<Result, AsyncReply>) {
+            handler(ec, replies.empty() ? AsyncReply{}
+                                        : std::move(replies.front()));
+          } else {
+            handler(ec, std::move(replies));
+          }
+        });
+    m_work.reset();
+  }
+
+private:
+  Handler m_handler;
+  boost::asio::executor_work_guard<executor_type> m_work;
+};
+
+/*
+ * Redis client which never parks a thread, connections are spread over the
+ * io_contexts of IOServicePool
+ * commands take an asio completion token, a callback, use_future, or
+ * use_awaitable once the project is built as C++20
+ * commands are sent to the node which owns their key, the same way as
+ * RedisContext does
+ */
+class AsyncRedisClient : public Singleton<AsyncRedisClient> {
+  friend class Singleton<AsyncRedisClient>;
+
+  AsyncRedisClient();
+
+public:
+  using reply_signature = void(boost::system::error_code, AsyncReply);
+  using pipeline_signature =
+      void(boost::system::error_code, std::vector<AsyncReply>);
+
+  ~AsyncRedisClient();
+
+  /*one command, e.g. {"HINCRBY", key, field, "1"}*/
+  template <typename CompletionToken>
+  auto asyncCommand(std::vector<std::string> command,
+                    CompletionToken &&token) {
+    return boost::asio::async_initiate<CompletionToken, reply_signature>(
+        [this](auto handler, std::vector<std::string> command) {
+          using handler_type = std::decay_t<decltype(handler)>;
+          std::vector<std::vector<std::string>> commands;
+          commands.push_back(std::move(command));
+          execute(std::move(commands),
+                  std::make_unique<
+                      AsyncRedisCompletion<handler_type, AsyncReply>>(
+                      std::move(handler), executor()));
+        },
+        token, std::move(command));
+  }
+
+  /*commands are sent together, replies have the same order as commands*/
+  template <typename CompletionToken>
+  auto asyncPipeline(std::vector<std::vector<std::string>> commands,
+                     CompletionToken &&token) {
+    return boost::asio::async_initiate<CompletionToken, pipeline_signature>(
+        [this](auto handler, std::vector<std::vector<std::string>> commands) {
+          using handler_type = std::decay_t<decltype(handler)>;
+          execute(std::move(commands),
+                  std::make_unique<AsyncRedisCompletion<
+                      handler_type, std::vector<AsyncReply>>>(
+                      std::move(handler), executor()));
+        },
+        token, std::move(commands));
+  }
+
+  /*close every connection, IOServicePool might be running or stopped*/
+  void shutdown();
+
+private:
+  struct Merge;
+
+  /*commands spanning nodes are split, replies are merged in order*/
+  void execute(std::vector<std::vector<std::string>> commands,
+               std::unique_ptr<AsyncRedisConnection::Completion> done);
+
+  AsyncRedisConnection &next(const std::size_t node);
+
+  /*where a handler without its own executor runs*/
+  boost::asio::io_context::executor_type executor();
+
+private:
+  static constexpr std::chrono::seconds reconnect_interval{1};
+
+  std::atomic<std::size_t> m_curr;
+  std::shared_ptr<const RedisShardRing> m_ring;
+
+  /*node -> its connections*/
+  std::vector<std::vector<std::unique_ptr<AsyncRedisConnection>>>
+      m_connections;
+};
+} // namespace redis
+
+#endif //_ASYNCREDISCLIENT_HPP_
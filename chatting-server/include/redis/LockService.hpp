@@ -0,0 +1,174 @@
+#pragma once
+#ifndef _LOCKSERVICE_HPP_
+#define _LOCKSERVICE_HPP_
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <redis/SubscriberGroup.hpp>
+#include <singleton/singleton.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace redis {
+class RedisContext;
+
+/*one acquisition of lock:[name]*/
+struct Lease {
+  std::string name;
+  std::string identifier;
+
+  /*increased by every acquisition of name, a newer holder has a larger one*/
+  std::uint64_t token;
+};
+
+/*
+ * Distributed lock on lock:[name] with leases
+ *
+ * 1. threads of this process queue up locally, only one of them competes
+ *    for lock:[name] on redis, no connection is held while waiting
+ * 2. a release publishes lock_released on the node of the lock, waiters are
+ *    woken up by it, the remaining ttl of the holder bounds a lost message
+ * 3. leases are renewed in background until they are released, so a slow
+ *    critical section does not lose its lock, a dead process loses it soon
+ * 4. lock:[name] stays compatible with RedisContext::acquire of other
+ *    servers, they only miss the release notification
+ */
+class LockService : public Singleton<LockService> {
+  friend class Singleton<LockService>;
+
+  LockService();
+
+public:
+  ~LockService();
+
+  std::optional<Lease> acquire(const std::string &name,
+                               const std::chrono::milliseconds wait,
+                               const std::chrono::milliseconds lease);
+
+  bool release(const Lease &lease);
+
+  /*lease is still held and nobody acquired name after it*/
+  bool validate(const Lease &lease);
+
+  void shutdown();
+
+private:
+  /*threads of this process which are interested in one name*/
+  struct Slot {
+    /*a thread is competing on redis or holding the lock*/
+    bool busy = false;
+    std::size_t users = 0;
+
+    /*increased every time a release of name is published*/
+    std::size_t released = 0;
+    std::condition_variable cv;
+  };
+
+  struct Held {
+    std::string key;
+    std::chrono::milliseconds lease;
+    std::chrono::steady_clock::time_point renew_at;
+  };
+
+  /*{acquired, fencing token when acquired, otherwise ttl of the holder}*/
+  std::optional<std::pair<bool, long long>>
+  attempt(const std::string &key, const std::string &identifier,
+          const std::chrono::milliseconds lease);
+
+  bool renew(const std::string &key, const std::string &identifier,
+             const std::chrono::milliseconds lease);
+
+  std::optional<std::vector<std::optional<std::string>>>
+  eval(const char *script, const std::vector<std::string> &keys,
+       const std::vector<std::string> &args);
+
+  /*m_mtx has to be locked*/
+  std::shared_ptr<Slot> attach(const std::string &name);
+  void detach(const std::string &name);
+
+  void renewer();
+  void subscriber(const std::size_t node);
+
+  static std::string lockKey(const std::string &name);
+
+  /*shares the hash tag of lock key, so scripts could update both*/
+  static std::string fenceKey(const std::string &key);
+
+private:
+  static constexpr const char *lock_prefix = "lock:";
+  static constexpr const char *released_channel = "lock_released";
+
+  /*retry interval when redis is unavailable or ttl is unknown*/
+  static constexpr std::chrono::milliseconds retry_interval{50};
+
+  /*
+   * KEYS[1] = lock key, KEYS[2] = fence key
+   * ARGV[1] = identifier, ARGV[2] = lease(ms)
+   */
+  static constexpr const char *acquire_lua_script =
+      "if redis.call('set', KEYS[1], ARGV[1], 'NX', 'PX', ARGV[2]) then "
+      "    return {1, redis.call('incr', KEYS[2])} "
+      "end "
+      "return {0, redis.call('pttl', KEYS[1])}";
+
+  /*KEYS[1] = lock key, ARGV[1] = identifier, ARGV[2] = channel*/
+  static constexpr const char *release_lua_script =
+      "if redis.call('get', KEYS[1]) == ARGV[1] then "
+      "    redis.call('del', KEYS[1]) "
+      "    redis.call('publish', ARGV[2], KEYS[1]) "
+      "    return {1} "
+      "end "
+      "return {0}";
+
+  /*KEYS[1] = lock key, ARGV[1] = identifier, ARGV[2] = lease(ms)*/
+  static constexpr const char *renew_lua_script =
+      "if redis.call('get', KEYS[1]) == ARGV[1] then "
+      "    return {redis.call('pexpire', KEYS[1], ARGV[2])} "
+      "end "
+      "return {0}";
+
+  /*
+   * KEYS[1] = lock key, KEYS[2] = fence key
+   * ARGV[1] = identifier, ARGV[2] = token
+   */
+  static constexpr const char *validate_lua_script =
+      "if redis.call('get', KEYS[1]) == ARGV[1] and "
+      "   redis.call('get', KEYS[2]) == ARGV[2] then "
+      "    return {1} "
+      "end "
+      "return {0}";
+
+  std::atomic<bool> m_stop;
+
+  /*
+   * dedicated connection, callers might hold a pooled one already and the
+   * pool blocks when it runs dry
+   */
+  std::mutex m_redis_mtx;
+  std::unique_ptr<RedisContext> m_redis;
+
+  /*identifier = prefix:counter, generated without a random generator*/
+  std::string m_prefix;
+  std::atomic<std::uint64_t> m_counter;
+
+  std::mutex m_mtx;
+  std::unordered_map</*name*/ std::string, std::shared_ptr<Slot>> m_slots;
+
+  std::mutex m_held_mtx;
+  std::condition_variable m_held_cv;
+  std::map</*identifier*/ std::string, Held> m_held;
+  std::thread m_renewer;
+
+  /*one subscriber for every node*/
+  SubscriberGroup m_subscribers;
+};
+} // namespace redis
+
+#endif //_LOCKSERVICE_HPP_
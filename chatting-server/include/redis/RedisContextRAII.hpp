@@ -2,18 +2,19 @@
 #ifndef _REDISCONTEXTRAII_HPP_
 #define _REDISCONTEXTRAII_HPP_
 #include <chrono>
+#include <memory>
+#include <redis/RedisShardRing.hpp>
 #include <string>
 #include <string_view>
 #include <tools/tools.hpp>
+#include <utility>
+#include <vector>
 
 namespace redis {
 class RedisConnectionPool;
 }
 
 namespace redis {
-
-enum class TimeUnit { Seconds, Milliseconds };
-
 class RedisContext {
   friend class RedisReply;
   friend class RedisConnectionPool;
@@ -29,8 +30,11 @@ public:
   ~RedisContext() = default;
   RedisContext() noexcept;
 
-  /*connect to redis automatically*/
-  RedisContext(const std::string &ip, unsigned short port,
+  /*
+   * connect to every node of ring automatically
+   * each command is sent to the node which owns its key
+   */
+  RedisContext(std::shared_ptr<const RedisShardRing> ring,
                const std::string &password) noexcept;
 
   /*RedisTools will shutdown connection automatically!*/
@@ -55,38 +59,138 @@ public:
   std::optional<std::string> getValueFromHash(const std::string &key,
                                               const std::string &field);
 
-  std::optional<std::string> acquire(const std::string &lockName,
-                                     const std::size_t waitTime,
-                                     const std::size_t EXPX,
-                                     TimeUnit unit = TimeUnit::Seconds);
-
-  bool release(const std::string &lockName, const std::string &identifer);
+  /*
+   * MGET key1 key2 ... keyN, one MGET for each node
+   * the result has the same order as keys, missing key will be std::nullopt
+   */
+  std::vector<std::optional<std::string>>
+  getValues(const std::vector<std::string> &keys);
+
+  /*SADD key member1 ... memberN*/
+  bool addToSet(const std::string &key,
+                const std::vector<std::string> &members);
+
+  /*SMEMBERS key, empty set or missing key will be std::nullopt*/
+  std::optional<std::vector<std::string>>
+  getSetMembers(const std::string &key);
+
+  bool setExpire(const std::string &key, const std::size_t seconds);
+
+  /*SET key value NX EX seconds, false if key already exists*/
+  bool setValueIfAbsent(const std::string &key, const std::string &value,
+                        const std::size_t seconds);
+
+  /*reset ttl of key, only if key still holds value*/
+  bool renewValueIfEqual(const std::string &key, const std::string &value,
+                         const std::size_t seconds);
+
+  /*delete key, only if key still holds value*/
+  bool delValueIfEqual(const std::string &key, const std::string &value);
+
+  /*
+   * send all commands with only one network round trip to each node
+   * commands of the same node keep their order
+   * return false if any of them failed
+   */
+  bool pipeline(const std::vector<std::vector<std::string>> &commands);
+
+  /*HGETALL key, empty or missing key will be std::nullopt*/
+  std::optional<std::vector<std::pair<std::string, std::string>>>
+  getHashAll(const std::string &key);
+
+  /*ZRANGE key start stop, empty or missing key will be std::nullopt*/
+  std::optional<std::vector<std::string>>
+  getSortedSetRange(const std::string &key, const long long start,
+                    const long long stop);
+
+  /*ZRANGEBYLEX key min max LIMIT offset count*/
+  std::optional<std::vector<std::string>>
+  getSortedSetRangeByLex(const std::string &key, const std::string &min,
+                         const std::string &max, const std::size_t offset,
+                         const std::size_t count);
+
+  /*
+   * EVAL script numkeys key1 ... keyN arg1 ... argN
+   * script runs on the node of key1, all keys must share one hash tag
+   * only array reply is accepted(empty array included), nil or any other
+   * reply will be std::nullopt
+   */
+  std::optional<std::vector<std::optional<std::string>>>
+  evalScript(const std::string &script, const std::vector<std::string> &keys,
+             const std::vector<std::string> &args);
+
+  /*PUBLISH channel message*/
+  bool publish(const std::string &channel, const std::string &message);
+
+  /*
+   * SUBSCRIBE channel, on the node which owns channel
+   * after subscribe, this context could ONLY be used to wait for messages
+   */
+  bool subscribe(const std::string &channel);
+
+  /*
+   * block until a published message arrives, return {channel, message}
+   * if connection is broken, isValid() will return false
+   */
+  std::optional<std::pair<std::string, std::string>> waitForMessage();
+
+  /*CLIENT ID, id of the connection to node*/
+  std::optional<long long> clientId(const std::size_t node);
+
+  /*
+   * CLIENT TRACKING on REDIRECT id BCAST PREFIX prefix1 ... PREFIX prefixN
+   * node notifies connection id about every change of keys under prefixes,
+   * tracking stops once this context is gone
+   */
+  bool enableTracking(const std::size_t node, const long long redirect,
+                      const std::vector<std::string> &prefixes);
+
+  /*
+   * block until a __redis__:invalidate message arrives on a subscribed
+   * context, empty keys means all keys are gone(FLUSHALL / FLUSHDB)
+   */
+  std::optional<std::vector<std::string>> waitForInvalidation();
+
+  /*
+   * shutdown sockets of every node, a thread blocked by waitForMessage() or
+   * waitForInvalidation() returns at once and finds this context invalid,
+   * it is the only member which could be called from another thread
+   */
+  void interrupt();
 
 private:
-  bool acquireLock(const std::string &lockName, const std::string &identifer,
-                   const std::size_t EXPX, TimeUnit unit);
-
-  bool releaseLock(const std::string &lockName, const std::string &identifer);
-
   std::optional<tools::RedisContextWrapper> operator->();
 
-  static constexpr const char *lock = "lock:";
+  /*following commands are sent to node*/
+  void use(const std::size_t node);
+
+  /*following commands are sent to the node which owns key*/
+  void route(std::string_view key);
 
-  // Lock Might be acquired by others, so when  KEYS[1]!=ARGV[1]
-  // then redis should not be released!
-  static constexpr const char *release_lock_lua_script =
+  static constexpr const char *del_lua_script =
       "if redis.call('get', KEYS[1]) == ARGV[1] then "
       "    return redis.call('del', KEYS[1]) "
       "else "
       "    return 0 "
       "end";
 
+  static constexpr const char *renew_lua_script =
+      "if redis.call('get', KEYS[1]) == ARGV[1] then "
+      "    return redis.call('expire', KEYS[1], ARGV[2]) "
+      "else "
+      "    return 0 "
+      "end";
+
 private:
   /*if check error failed, m_valid will be set to false*/
   bool m_valid;
 
-  /*redis context*/
-  tools::RedisSmartPtr<redisContext> m_redisContext;
+  /*node -> redis context*/
+  std::shared_ptr<const RedisShardRing> m_ring;
+  std::vector<tools::RedisSmartPtr<redisContext>> m_nodes;
+
+  /*node selected by use() or route()*/
+  redisContext *m_redisContext;
 
   /*last operation time*/
   std::chrono::steady_clock::time_point last_operation_time;
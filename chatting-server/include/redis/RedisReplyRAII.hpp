@@ -3,6 +3,7 @@
 #define _REDISREPLYRAII_HPP_
 #include <redis/RedisContextRAII.hpp>
 #include <tools/tools.hpp>
+#include <vector>
 
 namespace redis {
 class RedisReply {
@@ -20,19 +21,49 @@ public:
   bool redisCommand(RedisContext &context, const std::string &command,
                     Args &&...args) {
     m_redisReply.reset(reinterpret_cast<redisReply *>(
-        ::redisCommand(context.m_redisContext.get(), command.c_str(),
+        ::redisCommand(context.m_redisContext, command.c_str(),
                        std::forward<Args>(args)...)));
     return isSuccessful();
   }
 
+  /*
+   * execute a command whose arguments count is only known at runtime
+   * for example: MGET key1 key2 ... keyN, SADD key member1 ... memberN
+   */
+  bool redisCommandArgv(RedisContext &context,
+                        const std::vector<std::string> &args);
+
+  /*
+   * block until next reply arrives on this context(redisGetReply)
+   * only used by the connection which has already executed SUBSCRIBE
+   */
+  bool getReply(RedisContext &context);
+
+  /*
+   * queue a command into output buffer without waiting for reply
+   * replies should be fetched by getReply() in the same order
+   */
+  static bool appendCommandArgv(RedisContext &context,
+                                const std::vector<std::string> &args);
+
 public:
   std::optional<long long> getInterger() const;
   std::optional<int> getType() const;
   std::optional<std::string> getMessage() const;
 
+  /*REDIS_REPLY_NIL element inside an array will be std::nullopt*/
+  std::optional<std::vector<std::optional<std::string>>> getArray() const;
+
+  /*the same as getArray(), but for the array nested at index*/
+  std::optional<std::vector<std::optional<std::string>>>
+  getArray(const std::size_t index) const;
+
 private:
   bool isSuccessful() const;
 
+  static std::optional<std::vector<std::optional<std::string>>>
+  toArray(const redisReply *reply);
+
 private:
   tools::RedisSmartPtr<redisReply> m_redisReply;
 };
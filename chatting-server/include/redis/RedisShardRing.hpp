@@ -0,0 +1,55 @@
+#pragma once
+#ifndef _REDISSHARDRING_HPP_
+#define _REDISSHARDRING_HPP_
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace redis {
+/*host, port*/
+using RedisNode = std::pair<std::string, unsigned short>;
+
+/*
+ * Consistent hash ring of redis nodes, every server builds the same ring out
+ * of the same [Redis] nodes, so a key is always found on the same node
+ *
+ * 1. only the part inside {} is hashed when a key has one, keys which
+ *    should be updated by one script or transaction share a hash tag
+ *    e.g. read_cursor_{1001} and unread_{1001}
+ * 2. adding a node only moves the keys of its own arcs
+ */
+class RedisShardRing {
+public:
+  explicit RedisShardRing(const std::vector<RedisNode> &nodes);
+
+  const std::vector<RedisNode> &nodes() const { return m_nodes; }
+  std::size_t size() const { return m_nodes.size(); }
+
+  /*index of the node which owns key*/
+  std::size_t locate(std::string_view key) const;
+
+  /*node of a command, commands without a key go to the first node*/
+  std::size_t locate(const std::vector<std::string> &command) const;
+
+  /*the part of key which is hashed*/
+  static std::string_view routingKey(std::string_view key);
+
+private:
+  static std::uint64_t hash(std::string_view key);
+
+private:
+  static constexpr std::size_t virtual_nodes = 160;
+
+  std::vector<RedisNode> m_nodes;
+
+  /*point on ring -> node index, sorted by point*/
+  std::vector<std::pair<std::uint64_t, std::size_t>> m_ring;
+};
+
+/*wrap id as a hash tag, keys built on the same tag live on the same node*/
+inline std::string hashTag(const std::string &id) { return "{" + id + "}"; }
+} // namespace redis
+
+#endif //_REDISSHARDRING_HPP_
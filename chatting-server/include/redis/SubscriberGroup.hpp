@@ -0,0 +1,59 @@
+#pragma once
+#ifndef _SUBSCRIBERGROUP_HPP_
+#define _SUBSCRIBERGROUP_HPP_
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace redis {
+class RedisContext;
+
+/*
+ * Threads blocked on subscribed connections, e.g. one for every node
+ *
+ * 1. a thread attaches its RedisContext while it waits for messages
+ * 2. stop() interrupts every attached context and joins all threads, so
+ *    nothing captured by them is used after their owner is gone
+ */
+class SubscriberGroup {
+  SubscriberGroup(const SubscriberGroup &) = delete;
+  SubscriberGroup &operator=(const SubscriberGroup &) = delete;
+
+public:
+  SubscriberGroup();
+  ~SubscriberGroup();
+
+  /*body(index) runs on its own thread for every index < count*/
+  void start(const std::size_t count,
+             std::function<void(const std::size_t)> body);
+
+  bool stopped() const { return m_stop.load(); }
+
+  /*
+   * context is interrupted by stop() until it is detached, false if group is
+   * stopping already, detach it before it is destroyed
+   */
+  bool attach(RedisContext &context);
+  void detach(RedisContext &context);
+
+  /*wait before reconnecting, false once group is stopping*/
+  bool backoff(const std::chrono::milliseconds duration);
+
+  /*never call it from a thread of this group*/
+  void stop();
+
+private:
+  std::atomic<bool> m_stop;
+
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::vector<RedisContext *> m_attached;
+  std::vector<std::thread> m_threads;
+};
+} // namespace redis
+
+#endif //_SUBSCRIBERGROUP_HPP_
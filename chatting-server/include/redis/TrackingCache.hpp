@@ -0,0 +1,96 @@
+#pragma once
+#ifndef _TRACKINGCACHE_HPP_
+#define _TRACKINGCACHE_HPP_
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <redis/SubscriberGroup.hpp>
+#include <singleton/singleton.hpp>
+#include <string>
+#include <tbb/concurrent_hash_map.h>
+#include <vector>
+
+namespace redis {
+/*
+ * Process local copy of hot keys, e.g. user_info_[uuid] kept consistent by
+ * redis server assisted client side caching
+ *
+ * 1. every node runs CLIENT TRACKING in broadcast mode for [RedisTracking]
+ *    prefixes, invalidations are redirected to a subscriber connection
+ * 2. no matter which server modified a key, its local copy is dropped
+ * 3. if any subscriber connection is lost, or the tracking connection stops
+ *    answering ping, local copies are cleared and bypassed until tracking is
+ *    enabled again
+ * 4. uuid_[uuid] is cached by user::RoutingCache, it is never tracked here
+ */
+class TrackingCache : public Singleton<TrackingCache> {
+  friend class Singleton<TrackingCache>;
+
+  TrackingCache();
+
+public:
+  ~TrackingCache();
+
+  /*key is under a tracked prefix*/
+  bool tracked(const std::string &key) const;
+
+  std::optional<std::string> find(const std::string &key);
+
+  /*take it before reading redis, pass it to store()*/
+  std::size_t version() const { return m_version.load(); }
+
+  void store(const std::string &key, const std::string &value,
+             const std::size_t version);
+
+  /*
+   * this server modified key, drop local copy without waiting for
+   * invalidation, so it always reads its own writes
+   */
+  void drop(const std::string &key);
+
+  void shutdown();
+
+private:
+  void subscriber(const std::size_t node);
+
+private:
+  static constexpr const char *invalidate_channel = "__redis__:invalidate";
+  static constexpr const char *routing_prefix = "uuid_";
+
+  bool m_enabled;
+  std::vector<std::string> m_prefixes;
+
+  /*local copies are dropped once there are more keys than capacity*/
+  std::size_t m_capacity;
+
+  std::chrono::seconds m_check_interval;
+  std::size_t m_nodes;
+
+  /*number of nodes whose subscriber is working*/
+  std::atomic<std::size_t> m_subscribed;
+
+  /*
+   * increased on every invalidation, values read from redis before an
+   * invalidation are not allowed to be stored
+   */
+  std::atomic<std::size_t> m_version;
+
+  /*
+   * increased every time a subscriber reconnects, entries stored in the
+   * previous epoch might miss some invalidations, so they are ignored
+   */
+  std::atomic<std::size_t> m_epoch;
+
+  struct Entry {
+    std::string value;
+    std::size_t epoch;
+  };
+
+  tbb::concurrent_hash_map</*key*/ std::string, Entry> m_entries;
+
+  /*one subscriber for every node*/
+  SubscriberGroup m_subscribers;
+};
+} // namespace redis
+
+#endif //_TRACKINGCACHE_HPP_
@@ -4,6 +4,7 @@
 #include <boost/asio.hpp>
 #include <buffer/MsgNode.hpp>
 #include <memory>
+#include <mutex>
 #include <network/def.hpp>
 #include <redis/RedisManager.hpp>
 #include <service/ConnectionPool.hpp>
@@ -58,12 +59,25 @@ protected:
   void handle_header(std::shared_ptr<Session> session,
                      boost::system::error_code ec,
                      std::size_t bytes_transferred);
+  void handle_extended_header(std::shared_ptr<Session> session,
+                              boost::system::error_code ec,
+                              std::size_t bytes_transferred);
   void handle_msgbody(std::shared_ptr<Session> session,
                       boost::system::error_code ec,
                       std::size_t bytes_transferred);
 
   bool checkDeferredTermination();
 
+private:
+  /*validate a complete header and start reading message body*/
+  void read_msgbody(std::shared_ptr<Session> session);
+
+  /*read next header, always starts with a normal 4 bytes header*/
+  void read_header(std::shared_ptr<Session> session);
+
+  /*kick the writer if nobody is writing*/
+  void start_write(std::shared_ptr<Session> self);
+
 private:
   /*
    *  sub user connection counter for current server
@@ -91,6 +105,17 @@ private:
   /*store the current session id that this user belongs to*/
   static std::string session_prefix;
 
+  /*
+   * KEYS[1] = uuid_{uuid}, KEYS[2] = session_{uuid}, ARGV[1] = session id
+   * remove both keys, only if this session still owns the user
+   */
+  static constexpr const char *release_lua_script =
+      "if redis.call('get', KEYS[2]) == ARGV[1] then "
+      "    redis.call('del', KEYS[1], KEYS[2]) "
+      "    return {1} "
+      "end "
+      "return {0}";
+
   bool s_closed = false;
 
   enum class SessionState : uint8_t {
@@ -134,10 +159,25 @@ private:
   std::unique_ptr<Send> m_current_write_msg;
   tbb::concurrent_queue<SendPtr> m_concurrent_sent_queue;
 
-  /* the length of the header
-   * the max length of receiving buffer
+  /*fragments of one message must be queued without interleaving*/
+  std::mutex m_send_mtx;
+
+  /*
+   * client supports extended frames(negotiated at login), large messages are
+   * sent in fragments of FrameChunkSize
    */
-  static constexpr std::size_t MAX_LENGTH = 2048;
+  std::atomic<bool> m_extended_frame = false;
+
+  /*client could inflate frames with MSGNODE_FLAG_COMPRESSED(negotiated too)*/
+  std::atomic<bool> m_compression = false;
+
+  /*received fragments of the current message*/
+  uint16_t m_fragment_id = 0;
+  std::string m_fragments;
+
+  /*max body size of a normal frame*/
+  static constexpr std::size_t MAX_NORMAL_LENGTH =
+      UINT16_MAX - sizeof(uint16_t) - sizeof(uint16_t);
 };
 
 #endif
@@ -1,14 +1,21 @@
 #pragma once
 #ifndef _CONNECTIONPOOOL_HPP_
 #define _CONNECTIONPOOOL_HPP_
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <mutex>
 #include <optional>
 #include <queue>
 #include <singleton/singleton.hpp>
+#include <string>
+#include <tbb/concurrent_queue.h>
 #include <thread>
 #include <tools/tools.hpp>
+#include <vector>
 
 /*forward*/
 namespace mysql {
@@ -20,70 +27,280 @@ class RedisConnectionPool;
 }
 
 namespace connection {
-/*please pass your new pool as template parameter*/
+/*
+ * please pass your new pool as template parameter
+ *
+ * 1. every thread owns an affinity slot, the stub it released last is parked
+ *    there and taken back without touching any shared structure
+ * 2. other idle stubs stay in a lock-free MPMC queue, a thread whose slot
+ *    and queue are both empty steals from other slots
+ * 3. mutex & cv are only touched when nothing is idle and a thread has to
+ *    wait, released stubs skip affinity slots while anyone is waiting
+ */
 template <class WhichPool, typename _Type>
 class ConnectionPool : public Singleton<WhichPool> {
   friend class Singleton<WhichPool>;
 
+public:
+  /*wait[i]: waited for [2^(i-1), 2^i) microseconds, wait[0]: no wait*/
+  static constexpr std::size_t wait_buckets = 24;
+
+  /*utilisation[i]: i * 10% of stubs were in use once acquired*/
+  static constexpr std::size_t utilisation_buckets = 11;
+
+  struct Statistics {
+    std::array<std::uint64_t, wait_buckets> wait;
+    std::array<std::uint64_t, utilisation_buckets> utilisation;
+    std::uint64_t timeouts;
+
+    /*upper bound of the quantile of wait time in microseconds*/
+    std::uint64_t waitQuantile(const double quantile) const {
+      std::uint64_t total = 0;
+      for (const auto count : wait) {
+        total += count;
+      }
+
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < wait_buckets; ++i) {
+        seen += wait[i];
+        if (seen && seen >= quantile * total) {
+          return (std::uint64_t{1} << i) - 1;
+        }
+      }
+      return 0;
+    }
+
+    /*counted after before was taken, e.g. since the last report*/
+    Statistics since(const Statistics &before) const {
+      Statistics result;
+      for (std::size_t i = 0; i < wait_buckets; ++i) {
+        result.wait[i] = wait[i] - before.wait[i];
+      }
+      for (std::size_t i = 0; i < utilisation_buckets; ++i) {
+        result.utilisation[i] = utilisation[i] - before.utilisation[i];
+      }
+      result.timeouts = timeouts - before.timeouts;
+      return result;
+    }
+
+    /*"0%:n 10%:n ... 100%:n"*/
+    std::string utilisationHistogram() const {
+      std::string result;
+      for (std::size_t i = 0; i < utilisation_buckets; ++i) {
+        result += (i ? " " : "") + std::to_string(i * 10) +
+                  "%:" + std::to_string(utilisation[i]);
+      }
+      return result;
+    }
+  };
+
 protected:
   ConnectionPool()
-      : m_stop(false), m_queue_size(std::thread::hardware_concurrency() < 2
-                                        ? 2
-                                        : std::thread::hardware_concurrency()) {
-  }
+      : m_stop(false), m_outstanding(0), m_idle(0), m_waiters(0),
+        m_timeouts(0),
+        m_queue_size(std::thread::hardware_concurrency() < 2
+                         ? 2
+                         : std::thread::hardware_concurrency()),
+        m_slots(m_queue_size), m_wait{}, m_utilisation{} {}
 
 public:
   using stub = _Type;
   using stub_ptr = std::unique_ptr<_Type>;
 
-  virtual ~ConnectionPool() { shutdown(); }
+  virtual ~ConnectionPool() {
+    shutdown();
+
+    /*slots hold raw pointers, stubs released during shutdown are parked*/
+    for (auto &slot : m_slots) {
+      delete slot.stub.exchange(nullptr);
+    }
+  }
 
   void shutdown() {
     /*set stop flag to true*/
     m_stop = true;
-    m_cv.notify_all();
+    {
+      std::lock_guard<std::mutex> _lckg(m_mtx);
+      m_cv.notify_all();
+    }
 
-    std::lock_guard<std::mutex> _lckg(m_mtx);
-    while (!m_stub_queue.empty()) {
-      m_stub_queue.pop();
+    while (tryTake()) {
     }
   }
 
-  std::optional<stub_ptr> acquire() {
-    std::unique_lock<std::mutex> _lckg(m_mtx);
-    m_cv.wait(_lckg, [this]() { return !m_stub_queue.empty() || m_stop; });
+  /*wait until a stub is idle*/
+  std::optional<stub_ptr> acquire() { return take(std::nullopt); }
 
-    /*check m_stop flag*/
-    if (m_stop) {
-      return std::nullopt;
-    }
-    stub_ptr temp = std::move(m_stub_queue.front());
-    m_stub_queue.pop();
-    return temp;
+  /*give up once timeout is reached*/
+  std::optional<stub_ptr> acquire(const std::chrono::milliseconds timeout) {
+    return take(std::chrono::steady_clock::now() + timeout);
   }
 
   void release(stub_ptr stub) {
+    --m_outstanding;
     if (m_stop) {
       return;
     }
-    std::lock_guard<std::mutex> _lckg(m_mtx);
-    m_stub_queue.push(std::move(stub));
-    m_cv.notify_one();
+    put(std::move(stub));
+  }
+
+  /*stub is broken, it is dropped instead of being released*/
+  void discard(stub_ptr stub) {
+    --m_outstanding;
+    stub.reset();
+  }
+
+  /*stubs which are acquired and not released yet*/
+  std::size_t outstanding() const { return m_outstanding; }
+
+  Statistics statistics() const {
+    Statistics result;
+    for (std::size_t i = 0; i < wait_buckets; ++i) {
+      result.wait[i] = m_wait[i];
+    }
+    for (std::size_t i = 0; i < utilisation_buckets; ++i) {
+      result.utilisation[i] = m_utilisation[i];
+    }
+    result.timeouts = m_timeouts;
+    return result;
+  }
+
+protected:
+  /*add a newly created stub*/
+  void add(stub_ptr stub) { put(std::move(stub)); }
+
+  /*stubs which are not acquired*/
+  std::size_t idle() const { return m_idle; }
+
+private:
+  struct alignas(64) Slot {
+    std::atomic<_Type *> stub{nullptr};
+  };
+
+  /*every thread sticks to one slot, io_context threads get distinct ones*/
+  static std::size_t threadSlot() {
+    static std::atomic<std::size_t> threads{0};
+    thread_local const std::size_t slot = threads++;
+    return slot;
+  }
+
+  std::optional<stub_ptr>
+  take(std::optional<std::chrono::steady_clock::time_point> deadline) {
+    const auto start = std::chrono::steady_clock::now();
+
+    stub_ptr stub = tryTake();
+    if (!stub && !m_stop) {
+      std::unique_lock<std::mutex> _lckg(m_mtx);
+
+      /*put() checks m_waiters after publishing its stub*/
+      ++m_waiters;
+      auto ready = [this, &stub]() {
+        return m_stop || (stub = tryTake()) != nullptr;
+      };
+      if (deadline.has_value()) {
+        m_cv.wait_until(_lckg, deadline.value(), ready);
+      } else {
+        m_cv.wait(_lckg, ready);
+      }
+      --m_waiters;
+    }
+
+    /*check m_stop flag*/
+    if (m_stop || !stub) {
+      if (!m_stop) {
+        ++m_timeouts;
+      }
+      return std::nullopt;
+    }
+
+    ++m_outstanding;
+    record(start);
+    return stub;
+  }
+
+  stub_ptr tryTake() {
+    const auto self = threadSlot() % m_slots.size();
+
+    stub_ptr stub(m_slots[self].stub.exchange(nullptr));
+    if (!stub && !m_queue.try_pop(stub)) {
+      /*steal stubs parked by other threads*/
+      for (std::size_t i = 1; i < m_slots.size() && !stub; ++i) {
+        auto &slot = m_slots[(self + i) % m_slots.size()].stub;
+        if (slot.load(std::memory_order_relaxed) != nullptr) {
+          stub.reset(slot.exchange(nullptr));
+        }
+      }
+    }
+
+    if (stub) {
+      --m_idle;
+    }
+    return stub;
+  }
+
+  void put(stub_ptr stub) {
+    ++m_idle;
+
+    /*a waiter might run on another thread, hand stub over by the queue*/
+    auto &slot = m_slots[threadSlot() % m_slots.size()].stub;
+    _Type *expected = nullptr;
+    if (!m_waiters && slot.compare_exchange_strong(expected, stub.get())) {
+      stub.release();
+    } else {
+      m_queue.push(std::move(stub));
+    }
+
+    if (m_waiters) {
+      std::lock_guard<std::mutex> _lckg(m_mtx);
+      m_cv.notify_one();
+    }
+  }
+
+  void record(const std::chrono::steady_clock::time_point start) {
+    auto waited = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start)
+            .count());
+
+    std::size_t bucket = 0;
+    for (; waited && bucket + 1 < wait_buckets; waited >>= 1) {
+      ++bucket;
+    }
+    ++m_wait[bucket];
+
+    const std::size_t used = m_outstanding;
+    const std::size_t total = used + m_idle;
+    ++m_utilisation[total ? std::min(used, total) * 10 / total : 0];
   }
 
 protected:
   /*Stubpool stop flag*/
   std::atomic<bool> m_stop;
 
+  std::atomic<std::size_t> m_outstanding;
+
+private:
+  std::atomic<std::size_t> m_idle;
+  std::atomic<std::size_t> m_waiters;
+  std::atomic<std::uint64_t> m_timeouts;
+
+protected:
   /*Stub Ammount*/
   std::size_t m_queue_size;
 
-  /*queue control*/
+private:
+  /*thread -> the stub it released last*/
+  std::vector<Slot> m_slots;
+
+  /*idle stubs which are not parked in any slot*/
+  tbb::concurrent_queue<stub_ptr> m_queue;
+
+  /*only used when a thread has to wait*/
   std::mutex m_mtx;
   std::condition_variable m_cv;
 
-  /*stub queue*/
-  std::queue<stub_ptr> m_stub_queue;
+  std::array<std::atomic<std::uint64_t>, wait_buckets> m_wait;
+  std::array<std::atomic<std::uint64_t>, utilisation_buckets> m_utilisation;
 };
 
 template <typename WhichPool, typename _Type> struct ConnectionRAII {
@@ -98,7 +315,25 @@ template <typename WhichPool, typename _Type> struct ConnectionRAII {
   ConnectionRAII(ConnectionRAII &&) = default;
   ConnectionRAII &operator=(ConnectionRAII &&) = default;
 
-  ConnectionRAII() : status(true) { acquire(); }
+  ConnectionRAII() : ConnectionRAII(WhichPool::get_instance()) {}
+
+  /*request path never waits forever, check is_active() before using it*/
+  explicit ConnectionRAII(const std::chrono::milliseconds timeout)
+      : ConnectionRAII(WhichPool::get_instance(), timeout) {}
+
+  /*acquire from another instance of the same pool type, e.g. a MySQL shard*/
+  explicit ConnectionRAII(std::shared_ptr<WhichPool> pool)
+      : status(true), m_pool(std::move(pool)) {
+    acquire();
+  }
+
+  /*give up once timeout is reached, check is_active() before using it*/
+  ConnectionRAII(std::shared_ptr<WhichPool> pool,
+                 const std::chrono::milliseconds timeout)
+      : status(true), m_pool(std::move(pool)) {
+    acquire(timeout);
+  }
+
   virtual ~ConnectionRAII() { release(); }
   std::optional<wrapper> operator->() {
     if (is_active()) {
@@ -119,7 +354,16 @@ template <typename WhichPool, typename _Type> struct ConnectionRAII {
 protected:
   void acquire() {
     // valid resources retrieved!
-    if (auto optional = WhichPool::get_instance()->acquire(); optional) {
+    if (auto optional = m_pool->acquire(); optional) {
+      m_stub = std::move(optional.value());
+      return;
+    }
+
+    invalidate();
+  }
+
+  void acquire(const std::chrono::milliseconds timeout) {
+    if (auto optional = m_pool->acquire(timeout); optional) {
       m_stub = std::move(optional.value());
       return;
     }
@@ -130,7 +374,7 @@ protected:
   void release() {
     if (is_active()) {
 
-      WhichPool::get_instance()->release(std::move(m_stub));
+      m_pool->release(std::move(m_stub));
 
       /*Stub no longer active*/
       invalidate();
@@ -138,11 +382,20 @@ protected:
   }
 
 private:
+  /*stub is broken, pools drop it and create a new one*/
+  void discard() {
+    if (is_active()) {
+      m_pool->discard(std::move(m_stub));
+      invalidate();
+    }
+  }
+
   // Raii no longer needs to put this resources back to container!
   void invalidate() { status = false; }
 
 private:
   bool status; // load stub success flag
+  std::shared_ptr<WhichPool> m_pool;
   std::unique_ptr<_Type> m_stub;
 };
 } // namespace connection
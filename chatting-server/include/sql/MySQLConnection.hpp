@@ -63,9 +63,79 @@ enum class MySQLSelection : uint8_t {
   CREATE_PRIVATE_CHAT_BY_USER_PAIR, // insert user pair data into privatechat
                                     // table by thread_id
 
-  CREATE_MSG_HISTORY_BANK_TUPLE // create item inside sql history table
+  CREATE_MSG_HISTORY_BANK_TUPLE, // create item inside sql history table
+
+  GET_GROUP_MEMBERS, // get all member uuids of a group chat by thread_id
+
+  CREATE_MSG_HISTORY_BANK_TUPLE_WITH_ID, // message_id was generated by server,
+                                         // duplicated insert will be ignored
+
+  GET_USER_CHAT_THREADS_BY_ACTIVITY, // all chat threads of a user with their
+                                     // last activity time, for thread index
+
+  UPDATE_READ_CURSOR, // move read cursor forward, never backward
+  UPDATE_MSG_STATUS_READ, // mark received messages until read cursor as read
+  GET_READ_CURSORS,       // read cursors of a user, for rebuilding counters
+  GET_THREAD_UNREAD,      // count and newest id of messages after a cursor
+
+  GET_USER_SEARCH_ENTRIES, // uuid, username and nickname after a uuid
+
+  GET_MSG_HISTORY_AFTER, // messages of all threads in a message id range, for
+                         // building chat search index
+  GET_MSG_HISTORY_BY_ID, // one message of a thread by message_id
+  CHECK_THREAD_MEMBER,   // is user a member of private or group chat thread
+  CHECK_PRIVATE_CHAT_THREAD, // does private chat thread belong to user pair
+
+  GET_ARCHIVABLE_THREADS, // threads which own messages older than archive age
+  GET_ARCHIVABLE_MSG,     // old messages of a thread after the archived one
+  DELETE_ARCHIVED_MSG,    // remove messages which are already archived
+
+  GET_THREAD_LAST_ACTIVITY, // time of the newest message of a thread
+  CREATE_PRIVATE_CHAT_COPY, // place private chat on the shard of its thread
+  GET_PRIVATE_CHAT_AFTER,   // private chats in thread_id order, for migration
+  DELETE_MSG_HISTORY_BY_ID, // message which has been moved to another shard
+  CHECK_MSG_HISTORY_BY_ID,  // message exists, not a read selection, a replica
+                            // might not have received it yet
+
+  GET_USER_PROFILES // profiles of many users, uuids are passed as json array
 };
 
+/*
+ * statements which never modify data and could be sent to a replica,
+ * locking reads and anything not listed here are writes
+ */
+constexpr bool isReadSelection(const MySQLSelection select) {
+  switch (select) {
+  case MySQLSelection::HEART_BEAT:
+  case MySQLSelection::FIND_EXISTING_USER:
+  case MySQLSelection::USER_LOGIN_CHECK:
+  case MySQLSelection::USER_UUID_CHECK:
+  case MySQLSelection::USER_PROFILE:
+  case MySQLSelection::GET_USER_UUID:
+  case MySQLSelection::GET_FRIEND_REQUEST_LIST:
+  case MySQLSelection::GET_AUTH_FRIEND_LIST:
+  case MySQLSelection::GET_USER_CHAT_THREADS:
+  case MySQLSelection::GET_USER_CHAT_RECORDS:
+  case MySQLSelection::GET_GROUP_MEMBERS:
+  case MySQLSelection::GET_USER_CHAT_THREADS_BY_ACTIVITY:
+  case MySQLSelection::GET_READ_CURSORS:
+  case MySQLSelection::GET_THREAD_UNREAD:
+  case MySQLSelection::GET_USER_SEARCH_ENTRIES:
+  case MySQLSelection::GET_MSG_HISTORY_AFTER:
+  case MySQLSelection::GET_MSG_HISTORY_BY_ID:
+  case MySQLSelection::CHECK_THREAD_MEMBER:
+  case MySQLSelection::CHECK_PRIVATE_CHAT_THREAD:
+  case MySQLSelection::GET_ARCHIVABLE_THREADS:
+  case MySQLSelection::GET_ARCHIVABLE_MSG:
+  case MySQLSelection::GET_THREAD_LAST_ACTIVITY:
+  case MySQLSelection::GET_PRIVATE_CHAT_AFTER:
+  case MySQLSelection::GET_USER_PROFILES:
+    return true;
+  default:
+    return false;
+  }
+}
+
 class MySQLConnection {
   friend class MySQLConnectionPool;
   MySQLConnection(const MySQLConnection &) = delete;
@@ -96,6 +166,14 @@ public:
   std::optional<std::unique_ptr<user::UserNameCard>>
   getUserProfile(std::size_t uuid);
 
+  /*
+   * profiles of many users by one query, users who are not found are left
+   * out, the result is not in the order of uuids
+   */
+  [[nodiscard]]
+  std::optional<std::vector<std::unique_ptr<user::UserNameCard>>>
+  getUserProfiles(const std::vector<std::size_t> &uuids);
+
   /*create user friend request MySQLSelection::USER_FRIEND_REQUEST*/
   bool createFriendRequest(const std::size_t src_uuid,
                            const std::size_t dst_uuid,
@@ -138,6 +216,144 @@ public:
       std::vector<std::shared_ptr<chat::MsgInfo>> &info);
   bool createModifyChattingHistoryRecord(std::shared_ptr<chat::MsgInfo> &info);
 
+  /*
+   * Group chat messages are persisted exactly once no matter how many members
+   * the group has, all messages inside one batch share one transaction
+   */
+  bool createGroupChattingHistoryRecord(
+      std::vector<std::shared_ptr<chat::MsgInfo>> &info);
+
+  /*
+   * Write-behind mode: message_id and timestamp were assigned before, so all
+   * messages of one batch are stored by one transaction, replaying the same
+   * message twice is harmless. Messages whose thread_id does not belong to
+   * the (sender, receiver) pair are skipped.
+   */
+  bool createChattingHistoryRecordBatch(
+      const std::vector<std::shared_ptr<chat::MsgInfo>> &info);
+
+  /*get all member uuids of a group chat(GroupMember table)*/
+  [[nodiscard]]
+  std::optional<std::vector<std::string>>
+  getGroupMembers(const std::size_t thread_id);
+
+  /*
+   * all chat threads of a user and their last activity(unix timestamp in
+   * seconds), it is used to rebuild the thread index in redis
+   */
+  [[nodiscard]]
+  std::optional<std::vector<
+      std::pair<std::unique_ptr<chat::ChatThreadMeta>, std::size_t>>>
+  getUserChattingThreadsByActivity(const std::size_t self_uuid);
+
+  /*store coalesced read cursors of many users within one transaction*/
+  bool updateReadCursorBatch(const std::vector<chat::ReadCursor> &cursors);
+
+  /*
+   * mark private chat messages users received until their cursors as read,
+   * it runs on the shard which owns these threads
+   */
+  bool updateMessageStatusBatch(const std::vector<chat::ReadCursor> &cursors);
+
+  /*thread_id -> last read message_id of a user, stored in MySQL*/
+  [[nodiscard]]
+  std::optional<std::vector<std::pair<std::size_t, std::size_t>>>
+  getReadCursors(const std::size_t uuid);
+
+  /*
+   * {count, newest message_id} of messages which are sent to uuid by others
+   * after after_msg_id, it runs on the shard which owns thread_id
+   */
+  [[nodiscard]]
+  std::optional<std::pair<std::size_t, std::size_t>>
+  getThreadUnread(const std::size_t thread_id, const std::size_t after_msg_id,
+                  const std::size_t uuid);
+
+  /*
+   * users whose uuid is greater than after_uuid in uuid order, only uuid,
+   * username and nickname are filled, it is used to build the search index
+   */
+  [[nodiscard]]
+  std::optional<std::vector<std::unique_ptr<user::UserNameCard>>>
+  getUserSearchEntries(const std::size_t after_uuid,
+                       const std::size_t interval);
+
+  /*
+   * messages of all threads whose id is inside (after_msg_id, before_msg_id)
+   * in message id order, used to build the chat search index and to move
+   * threads to another shard
+   */
+  [[nodiscard]]
+  std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+  getChattingHistoryAfter(const std::size_t after_msg_id,
+                          const std::size_t before_msg_id,
+                          const std::size_t interval);
+
+  /*messages of a thread by their ids, missing messages are skipped*/
+  [[nodiscard]]
+  std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+  getChattingHistoryByIds(const std::size_t thread_id,
+                          const std::vector<std::size_t> &msg_ids);
+
+  /*user is one of the private chat pair or a member of the group*/
+  bool checkThreadMember(const std::size_t thread_id, const std::size_t uuid);
+
+  /*thread_id is the private chat of this user pair, in any order*/
+  bool checkPrivateChatThread(const std::size_t thread_id,
+                              const std::size_t user1_uuid,
+                              const std::size_t user2_uuid);
+
+  /*
+   * threads owning messages whose id is less than before_msg_id and which
+   * were created before before_time(unix timestamp)
+   */
+  [[nodiscard]]
+  std::optional<std::vector<std::size_t>>
+  getArchivableThreads(const std::size_t before_msg_id,
+                       const std::size_t before_time,
+                       const std::size_t interval);
+
+  /*old messages of a thread after after_msg_id in message id order*/
+  [[nodiscard]]
+  std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+  getArchivableMessages(const std::size_t thread_id,
+                        const std::size_t after_msg_id,
+                        const std::size_t before_msg_id,
+                        const std::size_t before_time,
+                        const std::size_t interval);
+
+  /*messages of a thread until msg_id(included) which are already archived*/
+  bool deleteArchivedMessages(const std::size_t thread_id,
+                              const std::size_t msg_id,
+                              const std::size_t before_time);
+
+  /*unix timestamp of the newest message of a thread on this shard*/
+  [[nodiscard]]
+  std::optional<std::size_t> getThreadLastActivity(const std::size_t thread_id);
+
+  /*
+   * private chats whose thread_id is greater than after_thread_id in
+   * thread_id order, used to move threads to another shard
+   */
+  [[nodiscard]]
+  std::optional<std::vector<std::unique_ptr<chat::ChatThreadMeta>>>
+  getPrivateChatsAfter(const std::size_t after_thread_id,
+                       const std::size_t interval);
+
+  /*copy rows of another shard as they are, existing rows are ignored*/
+  bool copyPrivateChats(
+      const std::vector<std::unique_ptr<chat::ChatThreadMeta>> &info);
+  bool copyChattingHistoryRecords(
+      const std::vector<std::unique_ptr<chat::MsgInfo>> &info);
+
+  /*delete messages which have been moved to another shard*/
+  bool deleteChattingHistoryRecords(const std::vector<std::size_t> &msg_ids);
+
+  /*message ids which are stored on this shard, missing ones are skipped*/
+  [[nodiscard]]
+  std::optional<std::vector<std::size_t>>
+  getExistingChattingHistoryIds(const std::vector<std::size_t> &msg_ids);
+
   [[nodiscard]]
   std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
   getChattingHistoryRecord(const std::size_t thread_id,
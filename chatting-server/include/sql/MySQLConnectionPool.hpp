@@ -12,10 +12,15 @@ class MySQLConnectionPool
   using context_ptr = std::unique_ptr<mysql::MySQLConnection>;
   friend class Singleton<MySQLConnectionPool>;
   friend class MySQLConnection;
+  friend class MySQLShardRouter;
+  friend class MySQLReplicaRouter;
 
 public:
   virtual ~MySQLConnectionPool();
 
+  /*replica only accepts read statements*/
+  bool isReplica() const { return m_replica; }
+
 protected:
   void registerSQLStatement();
   void roundRobinChecking();
@@ -26,7 +31,8 @@ private:
       std::size_t timeOut, const std::string &username,
       const std::string &password, const std::string &database,
       const std::string &host = "localhost",
-      const std::string &port = boost::mysql::default_port_string) noexcept;
+      const std::string &port = boost::mysql::default_port_string,
+      const bool replica = false) noexcept;
 
   void roundRobinCheckLowGranularity();
 
@@ -41,6 +47,7 @@ private:
   std::string m_database;
   std::string m_host;
   std::string m_port;
+  bool m_replica;
 
   /*round-robin timeout check(second)*/
   // std::mutex m_RRMutex;
@@ -0,0 +1,69 @@
+#pragma once
+#ifndef _MYSQLREPLICAROUTER_HPP_
+#define _MYSQLREPLICAROUTER_HPP_
+#include <chrono>
+#include <mutex>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLShardRouter.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mysql {
+/*
+ * Read-only queries are sent to replicas of the shard which owns the data
+ * [MySQLReplica.name] sections declare replicas and the shard they copy
+ *
+ * 1. the replica with the least outstanding requests serves the read
+ * 2. a user who wrote through this server within read_your_writes reads
+ *    from the shard itself, so replication lag never hides its own write
+ * 3. replica connections only run statements tagged by isReadSelection()
+ */
+class MySQLReplicaRouter : public Singleton<MySQLReplicaRouter> {
+  friend class Singleton<MySQLReplicaRouter>;
+
+  MySQLReplicaRouter();
+
+public:
+  using pool_ptr = MySQLShardRouter::pool_ptr;
+
+  ~MySQLReplicaRouter() = default;
+
+  /*pool for a read which does not depend on any recent write*/
+  pool_ptr read(const pool_ptr &owner) const;
+
+  /*pool for a read on behalf of uuid*/
+  pool_ptr read(const pool_ptr &owner, const std::size_t uuid);
+  pool_ptr read(const pool_ptr &owner, const std::string &uuid);
+
+  /*one read on behalf of many users, any recent writer keeps it on source*/
+  pool_ptr read(const pool_ptr &owner, const std::vector<std::size_t> &uuids);
+
+  /*reads of primary tables*/
+  pool_ptr read(const std::size_t uuid);
+  pool_ptr read(const std::string &uuid);
+
+  /*uuid changed data, its reads stay on the source for a while*/
+  void wrote(const std::size_t uuid);
+  void wrote(const std::string &uuid);
+
+private:
+  bool recentlyWrote(const std::size_t uuid);
+
+private:
+  /*expired writers are dropped once the table grows beyond this*/
+  static constexpr std::size_t min_prune_size = 4096;
+
+  std::chrono::milliseconds m_window;
+
+  /*source pool -> its replicas, never changes after construction*/
+  std::unordered_map<MySQLConnectionPool *, std::vector<pool_ptr>> m_replicas;
+
+  std::mutex m_mtx;
+  std::size_t m_prune_size;
+  std::unordered_map<std::size_t, std::chrono::steady_clock::time_point>
+      m_writers;
+};
+} // namespace mysql
+
+#endif //_MYSQLREPLICAROUTER_HPP_
@@ -0,0 +1,142 @@
+#pragma once
+#ifndef _MYSQLSHARDROUTER_HPP_
+#define _MYSQLSHARDROUTER_HPP_
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <redis/LockService.hpp>
+#include <redis/RedisManager.hpp>
+#include <set>
+#include <shared_mutex>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLConnectionPool.hpp>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mysql {
+/*
+ * Chat history is split across MySQL instances by thread_id
+ * thread_id % buckets selects a bucket, redis hash mysql_shard_map keeps the
+ * owner shard of every bucket, a missing bucket belongs to "primary"([MySQL])
+ *
+ * 1. ChatMsgHistoryBank rows of a thread live on its owner shard, together
+ *    with a copy of its PrivateChat row, so storing a private message is
+ *    still one local transaction
+ * 2. every other table, and the full PrivateChat(user pair lookup), stays on
+ *    primary, a connection of primary is always acquired before a shard one
+ * 3. a bucket is moved online by migrate(): copy rows, switch owner, wait
+ *    until every server reloaded the map, copy new rows again and delete them
+ *    from the old owner
+ */
+class MySQLShardRouter : public Singleton<MySQLShardRouter> {
+  friend class Singleton<MySQLShardRouter>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+
+  MySQLShardRouter();
+
+public:
+  using pool_ptr = std::shared_ptr<MySQLConnectionPool>;
+
+  ~MySQLShardRouter();
+
+  std::size_t getBucket(const std::size_t thread_id) const {
+    return thread_id % m_buckets;
+  }
+
+  /*pool of the shard which owns thread_id*/
+  pool_ptr route(const std::size_t thread_id) const;
+
+  /*invalid thread_id is routed to primary, any query on it finds nothing*/
+  pool_ptr route(const std::string &thread_id) const;
+
+  /*every shard once, primary comes first*/
+  std::vector<pool_ptr> getShards() const;
+
+  /*pool of a shard by name, nullptr if it is not configured*/
+  pool_ptr getShard(const std::string &name) const;
+
+  /*move one bucket to shard, it could be run while servers are online*/
+  bool migrate(const std::size_t bucket, const std::string &shard);
+
+  /*move every other bucket of shard from to shard to*/
+  bool split(const std::string &from, const std::string &to);
+
+  void shutdown();
+
+private:
+  /*load bucket owners from redis, owners stay untouched if it fails*/
+  bool reload();
+  void refresher();
+
+  std::string getOwner(const std::size_t bucket) const;
+
+  bool migrate(const std::vector<std::size_t> &buckets,
+               const std::string &shard);
+
+  /*
+   * owner -> buckets moving away from it, lease is validated before shard
+   * map or old owners are modified
+   */
+  bool move(const std::map<std::string, std::set<std::size_t>> &sources,
+            const std::string &shard, const redis::Lease &lease);
+
+  /*
+   * one scan of the whole table copies rows of every moving bucket, rows of
+   * other buckets are skipped, false if any query failed
+   */
+  bool copyPrivateChats(const pool_ptr &from, const pool_ptr &to,
+                        const std::set<std::size_t> &buckets);
+  bool copyMessages(const pool_ptr &from, const pool_ptr &to,
+                    const std::set<std::size_t> &buckets,
+                    std::size_t &watermark);
+
+  /*
+   * move messages until watermark(included) row by row, write-behind
+   * batches commit out of id order, so rows below watermark might appear
+   * on from after they were copied. every row is copied again and only
+   * deleted once it is found on to
+   */
+  bool drainMessages(const pool_ptr &from, const pool_ptr &to,
+                     const std::set<std::size_t> &buckets,
+                     const std::size_t watermark, const redis::Lease &lease);
+
+private:
+  static std::string primary_shard;
+  static std::string shard_map_key;
+  static std::string migration_lock;
+
+  /*
+   * seconds, renewed while migrating, the lock is given up soon in case
+   * migration tool crashed
+   */
+  static constexpr std::size_t migration_lock_ttl = 60;
+
+  std::atomic<bool> m_stop;
+  std::size_t m_buckets;
+  std::chrono::seconds m_refresh_interval;
+  std::size_t m_batch_size;
+
+  /*shard name -> pool, never changes after construction*/
+  std::unordered_map<std::string, pool_ptr> m_shards;
+
+  /*bucket -> owner shard*/
+  mutable std::shared_mutex m_map_mtx;
+  std::vector<std::string> m_owners;
+  std::vector<pool_ptr> m_routes;
+
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::thread m_refresher;
+};
+} // namespace mysql
+
+#endif //_MYSQLSHARDROUTER_HPP_
@@ -4,13 +4,23 @@
 #include <boost/uuid/uuid.hpp>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
+#include <algorithm>
 #include <charconv>
+#include <cstdint>
+#include <cstdio>
 #include <hiredis.h>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace tools {
 template <typename _Ty> class ResourcesWrapper {
 public:
@@ -69,6 +79,48 @@ static std::string userTokenGenerator() {
   return boost::uuids::to_string(uuid_gen);
 }
 
+/*7 bits per byte, high bit set means more bytes follow*/
+inline void putVarint(std::string &out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+/*pos is moved after the varint, false if input ends inside it*/
+inline bool getVarint(std::string_view in, std::size_t &pos,
+                      std::uint64_t &value) {
+  value = 0;
+  for (std::size_t shift = 0; pos < in.size() && shift < 64; shift += 7) {
+    const auto byte = static_cast<unsigned char>(in[pos++]);
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*flush written data of file to disk, 0 on success like fsync*/
+inline int syncFile(std::FILE *file) {
+#if defined(_WIN32)
+  return _commit(_fileno(file));
+#else
+  return fsync(fileno(file));
+#endif
+}
+
+/*
+ * decimal string padded with leading zeros, 20 digits hold any uint64_t,
+ * so padded ids sort the same way as numbers
+ */
+inline std::string zeroPadding(const std::uint64_t value,
+                               const std::size_t width = 20) {
+  auto str = std::to_string(value);
+  return std::string(width - std::min(width, str.size()), '0') + str;
+}
+
 } // namespace tools
 
 #endif // !_TOOLS_HPP_
@@ -0,0 +1,95 @@
+#pragma once
+#ifndef _ROUTINGCACHE_HPP_
+#define _ROUTINGCACHE_HPP_
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <redis/RedisManager.hpp>
+#include <redis/SubscriberGroup.hpp>
+#include <singleton/singleton.hpp>
+#include <string>
+#include <tbb/concurrent_hash_map.h>
+#include <unordered_map>
+#include <vector>
+
+namespace user {
+/*
+ * Local cache of uuid_[uuid] -> [WHICH SERVER] relation
+ * 1. search for uuid inside local cache
+ * 2. search for uuid_[uuid] inside redis and store it in local cache
+ *
+ * Every server publishes uuid to invalidate channel when uuid_{uuid} is
+ * modified(handoverCurrentUser, removeRedisCache), a dedicated subscriber
+ * connection drops the entry. If subscriber connection is lost, local cache
+ * is cleared and bypassed until it subscribes again.
+ */
+class RoutingCache : public Singleton<RoutingCache> {
+  friend class Singleton<RoutingCache>;
+
+  using RedisRAII = connection::ConnectionRAII<redis::RedisConnectionPool,
+                                               redis::RedisContext>;
+
+  RoutingCache();
+
+public:
+  ~RoutingCache();
+
+  /*which server this user belongs to*/
+  [[nodiscard]] std::optional<std::string>
+  getServer([[maybe_unused]] RedisRAII &raii, const std::string &uuid);
+
+  /*
+   * group users by the chatting server they belong to
+   * only local cache misses are fetched from redis by using one MGET
+   */
+  [[nodiscard]] std::unordered_map</*server*/ std::string,
+                                   /*uuids*/ std::vector<std::string>>
+  groupByServer([[maybe_unused]] RedisRAII &raii,
+                const std::vector<std::string> &uuids,
+                std::vector<std::string> &offline);
+
+  /*uuid_[uuid] has been modified, notify all servers(including itself)*/
+  void publishInvalidation([[maybe_unused]] RedisRAII &raii,
+                           const std::string &uuid);
+
+private:
+  void subscriber();
+  std::optional<std::string> find(const std::string &uuid);
+  void store(const std::string &uuid, const std::string &server,
+             const std::size_t version);
+
+private:
+  static std::string server_prefix;
+  static std::string invalidate_channel;
+
+  /*reconnect delay doubles after every failure, reset by a message*/
+  static constexpr std::chrono::milliseconds min_retry_interval{50};
+  static constexpr std::chrono::milliseconds max_retry_interval{5000};
+
+  /*local cache could only be trusted while subscriber is working*/
+  std::atomic<bool> m_subscribed;
+
+  /*
+   * increased on every invalidation, entries fetched from redis before an
+   * invalidation are not allowed to be stored
+   */
+  std::atomic<std::size_t> m_version;
+
+  /*
+   * increased every time subscriber reconnects, entries stored in the previous
+   * epoch might miss some invalidations, so they are ignored
+   */
+  std::atomic<std::size_t> m_epoch;
+
+  struct RouteEntry {
+    std::string server;
+    std::size_t epoch;
+  };
+
+  tbb::concurrent_hash_map</*uuid*/ std::string, RouteEntry> m_routes;
+
+  redis::SubscriberGroup m_subscriber;
+};
+} // namespace user
+
+#endif //_ROUTINGCACHE_HPP_
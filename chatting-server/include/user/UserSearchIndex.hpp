@@ -0,0 +1,116 @@
+#pragma once
+#ifndef _USERSEARCHINDEX_HPP_
+#define _USERSEARCHINDEX_HPP_
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <singleton/singleton.hpp>
+#include <sql/MySQLConnectionPool.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace user {
+/*
+ * In-memory index of usernames and nicknames
+ * 1. sorted term set answers prefix queries with one lower_bound
+ * 2. trigram postings collect candidates of typo-tolerant queries, which
+ *    are verified by edit distance afterwards
+ *
+ * Index is loaded from MySQL in uuid order when server starts, users
+ * registered later(by gateway-server) are picked up by a background thread
+ * which only loads uuids after the largest one already indexed
+ *
+ * Results are ranked: exact match, prefix match, fuzzy match, fuzzy prefix
+ * match, shorter names and smaller edit distance come first
+ */
+class UserSearchIndex : public Singleton<UserSearchIndex> {
+  friend class Singleton<UserSearchIndex>;
+
+  using MySQLRAII = connection::ConnectionRAII<mysql::MySQLConnectionPool,
+                                               mysql::MySQLConnection>;
+
+  UserSearchIndex();
+
+public:
+  struct SearchResult {
+    std::vector<std::size_t> uuids; // uuids of the requested page
+    std::size_t total = 0;          // matches of all pages
+  };
+
+  ~UserSearchIndex();
+
+  /*insert a new user or replace names of an existing one*/
+  void insert(const std::size_t uuid, std::string_view username,
+              std::string_view nickname);
+
+  /*ranked uuids in [offset, offset + limit)*/
+  [[nodiscard]] SearchResult search(std::string_view query,
+                                    const std::size_t offset,
+                                    const std::size_t limit) const;
+
+  void shutdown();
+
+private:
+  struct Entry {
+    std::string username; // lower case
+    std::string nickname; // lower case
+  };
+
+  struct Rank {
+    std::size_t tier;     // 0 = exact, 1 = prefix, 2 = fuzzy, 3 = fuzzy prefix
+    std::size_t distance; // extra chars of prefix match, or edit distance
+    std::size_t length;
+  };
+
+  /*load users after the largest indexed uuid, false if nothing loaded*/
+  bool loadNewUsers();
+  void refresher();
+
+  void eraseTerms(const std::size_t uuid, const Entry &entry);
+  void insertTerms(const std::size_t uuid, const Entry &entry);
+
+  static std::string toLower(std::string_view str);
+  static std::vector<std::string> trigrams(std::string_view term);
+
+  /*edit distance, or limit + 1 if it is larger than limit*/
+  static std::size_t editDistance(std::string_view lhs, std::string_view rhs,
+                                  const std::size_t limit);
+
+private:
+  /*prefix candidates are bounded, common prefix will not scan everyone*/
+  static constexpr std::size_t max_prefix_candidates = 1024;
+
+  /*trigrams of key broken by one typo at most*/
+  static constexpr std::size_t grams_per_typo = 4;
+
+  /*fuzzy candidates are bounded, common trigrams will not verify everyone*/
+  static constexpr std::size_t max_fuzzy_candidates = 1024;
+
+  std::atomic<bool> m_stop;
+  std::size_t m_batch_size;
+  std::size_t m_max_typos;
+  std::chrono::milliseconds m_refresh_interval;
+
+  mutable std::shared_mutex m_index_mtx;
+  std::size_t m_max_uuid = 0;
+  std::unordered_map<std::size_t, Entry> m_entries;
+
+  /*(term, uuid), both usernames and nicknames*/
+  std::set<std::pair<std::string, std::size_t>> m_terms;
+
+  /*trigram -> uuids*/
+  std::unordered_map<std::string, std::vector<std::size_t>> m_grams;
+
+  std::mutex m_mtx;
+  std::condition_variable m_cv;
+  std::thread m_refresher;
+};
+} // namespace user
+
+#endif //_USERSEARCHINDEX_HPP_
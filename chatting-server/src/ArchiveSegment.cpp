@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <chat/ArchiveSegment.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <spdlog/spdlog.h>
+#include <tools/tools.hpp>
+#include <zstd.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+constexpr std::size_t header_size = 8 + sizeof(std::uint64_t) * 3 +
+                                    sizeof(std::uint32_t) * 2;
+constexpr std::size_t index_entry_size =
+    sizeof(std::uint64_t) * 2 + sizeof(std::uint32_t) * 3;
+
+template <typename _Ty> void put(std::string &out, const _Ty value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(_Ty));
+}
+
+template <typename _Ty> _Ty take(const char *data) {
+  _Ty value;
+  std::memcpy(&value, data, sizeof(_Ty));
+  return value;
+}
+
+void putString(std::string &out, std::string_view str) {
+  tools::putVarint(out, str.size());
+  out.append(str);
+}
+
+bool getString(std::string_view in, std::size_t &pos, std::string &str) {
+  std::uint64_t length{};
+  if (!tools::getVarint(in, pos, length) || length > in.size() - pos) {
+    return false;
+  }
+  str.assign(in.substr(pos, length));
+  pos += length;
+  return true;
+}
+} // namespace
+
+chat::ArchiveSegment::~ArchiveSegment() {
+#if defined(_WIN32)
+  if (m_data != nullptr) {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping != nullptr) {
+    CloseHandle(m_mapping);
+  }
+  if (m_file != nullptr) {
+    CloseHandle(m_file);
+  }
+#else
+  if (m_data != nullptr) {
+    munmap(const_cast<char *>(m_data), m_size);
+  }
+#endif
+}
+
+std::shared_ptr<chat::ArchiveSegment>
+chat::ArchiveSegment::open(const std::string &path) {
+  std::shared_ptr<ArchiveSegment> segment(new ArchiveSegment);
+  if (!segment->map(path) || !segment->parse()) {
+    spdlog::warn("[Archive Segment]: Segment {} Is Broken!", path);
+    return nullptr;
+  }
+  return segment;
+}
+
+bool chat::ArchiveSegment::map(const std::string &path) {
+#if defined(_WIN32)
+  m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE) {
+    m_file = nullptr;
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size) || !size.QuadPart) {
+    return false;
+  }
+
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping == nullptr) {
+    return false;
+  }
+
+  m_data = static_cast<const char *>(
+      MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  m_size = static_cast<std::size_t>(size.QuadPart);
+  return m_data != nullptr;
+#else
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) || !st.st_size) {
+    ::close(fd);
+    return false;
+  }
+
+  /*mapping stays valid after the descriptor is closed*/
+  void *addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ,
+                    MAP_SHARED, fd, 0);
+  ::close(fd);
+
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+
+  m_data = static_cast<const char *>(addr);
+  m_size = static_cast<std::size_t>(st.st_size);
+  return true;
+#endif
+}
+
+bool chat::ArchiveSegment::parse() {
+  if (m_size < header_size + magic_length ||
+      std::memcmp(m_data, magic, magic_length) ||
+      std::memcmp(m_data + m_size - magic_length, magic, magic_length)) {
+    return false;
+  }
+
+  const char *ptr = m_data + magic_length;
+  m_thread_id = take<std::uint64_t>(ptr);
+  m_first_id = take<std::uint64_t>(ptr + 8);
+  m_last_id = take<std::uint64_t>(ptr + 16);
+  [[maybe_unused]] const auto count = take<std::uint32_t>(ptr + 24);
+  const auto block_count = take<std::uint32_t>(ptr + 28);
+
+  const std::size_t index_size = index_entry_size * block_count;
+  if (m_size < header_size + index_size + magic_length) {
+    return false;
+  }
+
+  const std::size_t index_offset = m_size - magic_length - index_size;
+  m_blocks.reserve(block_count);
+  for (std::size_t i = 0; i < block_count; ++i) {
+    const char *entry = m_data + index_offset + i * index_entry_size;
+
+    Block block;
+    block.first_id = take<std::uint64_t>(entry);
+    block.offset = take<std::uint64_t>(entry + 8);
+    block.compressed = take<std::uint32_t>(entry + 16);
+    block.raw = take<std::uint32_t>(entry + 20);
+    block.count = take<std::uint32_t>(entry + 24);
+
+    if (block.offset < header_size ||
+        block.offset + block.compressed > index_offset) {
+      return false;
+    }
+    m_blocks.push_back(block);
+  }
+  return true;
+}
+
+template <typename _Func>
+bool chat::ArchiveSegment::visit(const Block &block, _Func &&func) const {
+  std::string raw(block.raw, '\0');
+  const auto size = ZSTD_decompress(raw.data(), raw.size(),
+                                    m_data + block.offset, block.compressed);
+  if (ZSTD_isError(size) || size != block.raw) {
+    spdlog::error("[Archive Segment]: Thread ID = {} Decompress Block Failed!",
+                  m_thread_id);
+    return false;
+  }
+
+  const auto thread_id = std::to_string(m_thread_id);
+  std::size_t pos = 0;
+  for (std::uint32_t i = 0; i < block.count; ++i) {
+    std::uint64_t msg_id{}, status{}, type{};
+    std::string sender, receiver, timestamp, content;
+    if (!tools::getVarint(raw, pos, msg_id) ||
+        !tools::getVarint(raw, pos, status) ||
+        !tools::getVarint(raw, pos, type) || !getString(raw, pos, sender) ||
+        !getString(raw, pos, receiver) || !getString(raw, pos, timestamp) ||
+        !getString(raw, pos, content)) {
+      return false;
+    }
+
+    auto item = std::make_unique<chat::MsgInfo>(
+        thread_id, "", sender, receiver, content, status, timestamp,
+        static_cast<chat::MsgType>(type));
+    item->setMsgID(std::to_string(msg_id));
+
+    /*visitor returns false when it does not need more*/
+    if (!func(msg_id, std::move(item))) {
+      break;
+    }
+  }
+  return true;
+}
+
+void chat::ArchiveSegment::read(
+    const std::uint64_t msg_id, const std::size_t count,
+    std::vector<std::unique_ptr<chat::MsgInfo>> &out) const {
+
+  if (out.size() >= count || msg_id >= m_last_id) {
+    return;
+  }
+
+  /*the last block starting at or before msg_id might hold newer messages*/
+  auto it = std::upper_bound(
+      m_blocks.begin(), m_blocks.end(), msg_id,
+      [](const std::uint64_t id, const Block &block) {
+        return id < block.first_id;
+      });
+  if (it != m_blocks.begin()) {
+    --it;
+  }
+
+  for (; it != m_blocks.end() && out.size() < count; ++it) {
+    visit(*it, [msg_id, count, &out](const std::uint64_t id, auto &&item) {
+      if (id > msg_id) {
+        out.push_back(std::move(item));
+      }
+      return out.size() < count;
+    });
+  }
+}
+
+void chat::ArchiveSegment::find(
+    const std::set<std::uint64_t> &msg_ids,
+    std::vector<std::unique_ptr<chat::MsgInfo>> &out) const {
+
+  auto id = msg_ids.lower_bound(m_first_id);
+  while (id != msg_ids.end() && *id <= m_last_id) {
+    auto it = std::upper_bound(
+        m_blocks.begin(), m_blocks.end(), *id,
+        [](const std::uint64_t value, const Block &block) {
+          return value < block.first_id;
+        });
+    if (it == m_blocks.begin()) {
+      ++id;
+      continue;
+    }
+    --it;
+
+    /*all wanted ids inside this block are found by one decompression*/
+    const auto next = std::next(it);
+    const std::uint64_t end =
+        next == m_blocks.end() ? m_last_id + 1 : next->first_id;
+    visit(*it, [&msg_ids, &out](const std::uint64_t value, auto &&item) {
+      if (msg_ids.count(value)) {
+        out.push_back(std::move(item));
+      }
+      return true;
+    });
+    id = msg_ids.lower_bound(end);
+  }
+}
+
+void chat::ArchiveSegment::encode(std::string &out, const chat::MsgInfo &info) {
+  tools::putVarint(out, tools::string_to_value<std::uint64_t>(info.message_id)
+                     .value_or(0));
+  tools::putVarint(out, info.status);
+  tools::putVarint(out, static_cast<std::uint64_t>(info.msg_type));
+  putString(out, info.msg_sender);
+  putString(out, info.msg_receiver);
+  putString(out, info.timestamp);
+  putString(out, info.msg_content);
+}
+
+bool chat::ArchiveSegment::write(
+    const std::string &path, const std::uint64_t thread_id,
+    const std::vector<std::unique_ptr<chat::MsgInfo>> &messages,
+    const std::size_t block_size, const int level) {
+
+  if (messages.empty()) {
+    return false;
+  }
+
+  auto message_id = [](const chat::MsgInfo &info) {
+    return tools::string_to_value<std::uint64_t>(info.message_id).value_or(0);
+  };
+
+  std::string out(magic, magic_length);
+  put<std::uint64_t>(out, thread_id);
+  put<std::uint64_t>(out, message_id(*messages.front()));
+  put<std::uint64_t>(out, message_id(*messages.back()));
+  put<std::uint32_t>(out, static_cast<std::uint32_t>(messages.size()));
+  put<std::uint32_t>(
+      out, static_cast<std::uint32_t>((messages.size() + block_size - 1) /
+                                      block_size));
+
+  std::string index, raw, compressed;
+  for (std::size_t start = 0; start < messages.size(); start += block_size) {
+    const std::size_t end = std::min(messages.size(), start + block_size);
+
+    raw.clear();
+    for (std::size_t i = start; i < end; ++i) {
+      encode(raw, *messages[i]);
+    }
+
+    compressed.resize(ZSTD_compressBound(raw.size()));
+    const auto size = ZSTD_compress(compressed.data(), compressed.size(),
+                                    raw.data(), raw.size(), level);
+    if (ZSTD_isError(size)) {
+      spdlog::error("[Archive Segment]: Thread ID = {} Compress Failed, {}",
+                    thread_id, ZSTD_getErrorName(size));
+      return false;
+    }
+
+    put<std::uint64_t>(index, message_id(*messages[start]));
+    put<std::uint64_t>(index, out.size());
+    put<std::uint32_t>(index, static_cast<std::uint32_t>(size));
+    put<std::uint32_t>(index, static_cast<std::uint32_t>(raw.size()));
+    put<std::uint32_t>(index, static_cast<std::uint32_t>(end - start));
+    out.append(compressed.data(), size);
+  }
+
+  out.append(index);
+  out.append(magic, magic_length);
+
+  /*write to a temporary file first, a segment is either complete or absent*/
+  const auto tmp = path + ".tmp";
+  std::FILE *file = std::fopen(tmp.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  const bool success = std::fwrite(out.data(), 1, out.size(), file) ==
+                           out.size() &&
+                       !std::fflush(file) && !tools::syncFile(file);
+  std::fclose(file);
+
+  std::error_code ec;
+  if (success) {
+    std::filesystem::rename(tmp, path, ec);
+  }
+  if (!success || ec) {
+    std::filesystem::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
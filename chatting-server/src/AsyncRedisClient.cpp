@@ -0,0 +1,462 @@
+#include <algorithm>
+#include <async.h>
+#include <config/ServerConfig.hpp>
+#include <future>
+#include <mutex>
+#include <redis/AsyncRedisClient.hpp>
+#include <redis/RedisManager.hpp>
+#include <service/IOServicePool.hpp>
+#include <spdlog/spdlog.h>
+
+/*replies of one submit, the last reply completes it*/
+struct redis::AsyncRedisConnection::Batch {
+  std::vector<AsyncReply> replies;
+  std::size_t remaining = 0;
+  boost::system::error_code ec;
+  std::unique_ptr<Completion> done;
+};
+
+/*hiredis privdata of one command*/
+struct redis::AsyncRedisConnection::Slot {
+  std::shared_ptr<Batch> batch;
+  std::size_t index;
+};
+
+namespace {
+redis::AsyncReply copyReply(const redisReply *reply) {
+  redis::AsyncReply ret;
+  ret.type = reply->type;
+  ret.integer = reply->integer;
+  if (reply->str != nullptr) {
+    ret.str.assign(reply->str, reply->len);
+  }
+  if (reply->element != nullptr) {
+    ret.elements.reserve(reply->elements);
+    for (std::size_t i = 0; i < reply->elements; ++i) {
+      ret.elements.push_back(copyReply(reply->element[i]));
+    }
+  }
+  return ret;
+}
+} // namespace
+
+bool redis::AsyncReply::isError() const { return type == REDIS_REPLY_ERROR; }
+bool redis::AsyncReply::isNil() const { return type == REDIS_REPLY_NIL; }
+
+redis::AsyncRedisConnection::AsyncRedisConnection(
+    boost::asio::io_context &ioc, const std::string &ip,
+    const unsigned short port, const std::string &passwd,
+    const std::chrono::seconds reconnect_interval)
+    : m_ioc(ioc), m_ip(ip), m_port(port), m_passwd(passwd),
+      m_reconnect_interval(reconnect_interval), m_ctx(nullptr), m_timer(ioc),
+      m_stop(false), m_want_read(false), m_want_write(false),
+      m_reading(false), m_writing(false), m_generation(0), m_closed(false) {
+
+  boost::asio::post(m_ioc, [this]() { connect(); });
+}
+
+redis::AsyncRedisConnection::~AsyncRedisConnection() { close(); }
+
+void redis::AsyncRedisConnection::close() {
+  /*nothing else could touch m_ctx and m_timer now*/
+  if (m_ioc.stopped() || m_ioc.get_executor().running_in_this_thread()) {
+    teardown();
+    return;
+  }
+
+  auto done = std::make_shared<std::promise<void>>();
+  auto future = done->get_future();
+  boost::asio::post(m_ioc, [this, done]() {
+    teardown();
+    done->set_value();
+  });
+
+  while (future.wait_for(std::chrono::milliseconds(100)) !=
+         std::future_status::ready) {
+    /*io_context is stopped before it runs teardown*/
+    if (m_ioc.stopped() && teardown()) {
+      return;
+    }
+  }
+}
+
+bool redis::AsyncRedisConnection::teardown() {
+  if (m_closed.exchange(true)) {
+    return false;
+  }
+
+  m_stop = true;
+  m_timer.cancel();
+  if (m_ctx != nullptr) {
+    /*pending callbacks get a NULL reply, cleanup hook drops the socket*/
+    auto ctx = m_ctx;
+    m_ctx = nullptr;
+    redisAsyncFree(ctx);
+  }
+  return true;
+}
+
+void redis::AsyncRedisConnection::submit(
+    std::vector<std::vector<std::string>> commands,
+    std::unique_ptr<Completion> done) {
+  boost::asio::post(m_ioc, [this, commands = std::move(commands),
+                            done = std::move(done)]() mutable {
+    execute(commands, done);
+  });
+}
+
+void redis::AsyncRedisConnection::execute(
+    std::vector<std::vector<std::string>> &commands,
+    std::unique_ptr<Completion> &done) {
+
+  if (m_ctx == nullptr) {
+    done->complete(boost::asio::error::not_connected, {});
+    return;
+  }
+  if (commands.empty()) {
+    done->complete({}, {});
+    return;
+  }
+
+  auto batch = std::make_shared<Batch>();
+  batch->replies.resize(commands.size());
+  batch->remaining = commands.size();
+  batch->done = std::move(done);
+
+  std::vector<const char *> argv;
+  std::vector<std::size_t> argvlen;
+  for (std::size_t i = 0; i < commands.size(); ++i) {
+    argv.clear();
+    argvlen.clear();
+    for (const auto &arg : commands[i]) {
+      argv.push_back(arg.data());
+      argvlen.push_back(arg.size());
+    }
+
+    auto slot = new Slot{batch, i};
+
+    /*hiredis never calls back a command it refused*/
+    if (m_ctx == nullptr ||
+        redisAsyncCommandArgv(m_ctx, &AsyncRedisConnection::onReply, slot,
+                              static_cast<int>(argv.size()), argv.data(),
+                              argvlen.data()) != REDIS_OK) {
+      onReply(m_ctx, nullptr, slot);
+    }
+  }
+}
+
+void redis::AsyncRedisConnection::connect() {
+  if (m_stop) {
+    return;
+  }
+
+  auto ctx = redisAsyncConnect(m_ip.c_str(), m_port);
+  if (ctx == nullptr || ctx->err) {
+    spdlog::warn("[Async Redis]: Connect To {}:{} Failed, {}", m_ip, m_port,
+                 ctx != nullptr ? ctx->errstr : "out of memory");
+    if (ctx != nullptr) {
+      redisAsyncFree(ctx);
+    }
+    disconnected();
+    return;
+  }
+
+  boost::system::error_code ec;
+  auto socket = std::make_unique<boost::asio::ip::tcp::socket>(m_ioc);
+  socket->assign(boost::asio::ip::tcp::v4(), ctx->c.fd, ec);
+  if (ec) {
+    spdlog::warn("[Async Redis]: Assign Socket Failed, {}", ec.message());
+    redisAsyncFree(ctx);
+    disconnected();
+    return;
+  }
+
+  m_ctx = ctx;
+  m_socket = std::move(socket);
+  m_want_read = m_want_write = false;
+  m_reading = m_writing = false;
+
+  /*event hooks go first, setting connect callback starts a write watch*/
+  ctx->ev.data = this;
+  ctx->ev.addRead = &AsyncRedisConnection::addRead;
+  ctx->ev.delRead = &AsyncRedisConnection::delRead;
+  ctx->ev.addWrite = &AsyncRedisConnection::addWrite;
+  ctx->ev.delWrite = &AsyncRedisConnection::delWrite;
+  ctx->ev.cleanup = &AsyncRedisConnection::cleanup;
+  ctx->data = this;
+
+  redisAsyncSetConnectCallback(ctx, &AsyncRedisConnection::onConnect);
+  redisAsyncSetDisconnectCallback(ctx, &AsyncRedisConnection::onDisconnect);
+
+  /*commands are buffered until the connection is established*/
+  if (!m_passwd.empty()) {
+    const char *argv[] = {"AUTH", m_passwd.c_str()};
+    const std::size_t argvlen[] = {4, m_passwd.size()};
+    redisAsyncCommandArgv(ctx, &AsyncRedisConnection::onAuth, nullptr, 2, argv,
+                          argvlen);
+  }
+}
+
+void redis::AsyncRedisConnection::disconnected() {
+  m_ctx = nullptr;
+  if (m_stop) {
+    return;
+  }
+
+  m_timer.expires_after(m_reconnect_interval);
+  m_timer.async_wait([this](const boost::system::error_code &ec) {
+    if (!ec) {
+      connect();
+    }
+  });
+}
+
+void redis::AsyncRedisConnection::watchRead() {
+  if (m_reading || !m_want_read || !m_socket) {
+    return;
+  }
+
+  m_reading = true;
+  m_socket->async_wait(
+      boost::asio::ip::tcp::socket::wait_read,
+      [this, generation = m_generation](const boost::system::error_code &ec) {
+        if (generation != m_generation) {
+          return;
+        }
+        m_reading = false;
+        if (!ec && m_want_read) {
+          redisAsyncHandleRead(m_ctx);
+        }
+        if (generation == m_generation) {
+          watchRead();
+        }
+      });
+}
+
+void redis::AsyncRedisConnection::watchWrite() {
+  if (m_writing || !m_want_write || !m_socket) {
+    return;
+  }
+
+  m_writing = true;
+  m_socket->async_wait(
+      boost::asio::ip::tcp::socket::wait_write,
+      [this, generation = m_generation](const boost::system::error_code &ec) {
+        if (generation != m_generation) {
+          return;
+        }
+        m_writing = false;
+        if (!ec && m_want_write) {
+          redisAsyncHandleWrite(m_ctx);
+        }
+        if (generation == m_generation) {
+          watchWrite();
+        }
+      });
+}
+
+void redis::AsyncRedisConnection::addRead(void *privdata) {
+  auto conn = static_cast<AsyncRedisConnection *>(privdata);
+  conn->m_want_read = true;
+  conn->watchRead();
+}
+
+void redis::AsyncRedisConnection::delRead(void *privdata) {
+  static_cast<AsyncRedisConnection *>(privdata)->m_want_read = false;
+}
+
+void redis::AsyncRedisConnection::addWrite(void *privdata) {
+  auto conn = static_cast<AsyncRedisConnection *>(privdata);
+  conn->m_want_write = true;
+  conn->watchWrite();
+}
+
+void redis::AsyncRedisConnection::delWrite(void *privdata) {
+  static_cast<AsyncRedisConnection *>(privdata)->m_want_write = false;
+}
+
+void redis::AsyncRedisConnection::cleanup(void *privdata) {
+  auto conn = static_cast<AsyncRedisConnection *>(privdata);
+
+  /*hiredis closes the fd itself, outstanding waits are abandoned*/
+  ++conn->m_generation;
+  if (conn->m_socket) {
+    boost::system::error_code ec;
+    conn->m_socket->release(ec);
+    conn->m_socket.reset();
+  }
+  conn->m_want_read = conn->m_want_write = false;
+  conn->m_reading = conn->m_writing = false;
+}
+
+void redis::AsyncRedisConnection::onConnect(const redisAsyncContext *ctx,
+                                            int status) {
+  auto conn = static_cast<AsyncRedisConnection *>(ctx->data);
+  if (status == REDIS_OK) {
+    spdlog::info("[Async Redis]: Connected To {}:{}", conn->m_ip,
+                 conn->m_port);
+    return;
+  }
+
+  /*hiredis frees the context once this callback returns*/
+  spdlog::warn("[Async Redis]: Connect To {}:{} Failed, {}", conn->m_ip,
+               conn->m_port, ctx->errstr);
+  conn->disconnected();
+}
+
+void redis::AsyncRedisConnection::onDisconnect(const redisAsyncContext *ctx,
+                                               int status) {
+  auto conn = static_cast<AsyncRedisConnection *>(ctx->data);
+  if (status != REDIS_OK) {
+    spdlog::warn("[Async Redis]: Connection To {}:{} Lost, {}", conn->m_ip,
+                 conn->m_port, ctx->errstr);
+  }
+  conn->disconnected();
+}
+
+void redis::AsyncRedisConnection::onAuth(redisAsyncContext *ctx, void *reply,
+                                         void *privdata) {
+  auto r = static_cast<redisReply *>(reply);
+  if (r != nullptr && r->type == REDIS_REPLY_ERROR) {
+    spdlog::error("[Async Redis]: Authentication Failed, {}",
+                  std::string(r->str, r->len));
+  }
+}
+
+void redis::AsyncRedisConnection::onReply(redisAsyncContext *ctx, void *reply,
+                                          void *privdata) {
+  std::unique_ptr<Slot> slot(static_cast<Slot *>(privdata));
+  auto &batch = *slot->batch;
+
+  /*no reply means the command is lost along with the connection*/
+  if (reply == nullptr) {
+    batch.ec = boost::asio::error::not_connected;
+  } else {
+    batch.replies[slot->index] = copyReply(static_cast<redisReply *>(reply));
+  }
+
+  if (--batch.remaining == 0) {
+    batch.done->complete(batch.ec, std::move(batch.replies));
+  }
+}
+
+/*replies of a pipeline which was split over several nodes*/
+struct redis::AsyncRedisClient::Merge {
+  struct Part final : AsyncRedisConnection::Completion {
+    Part(std::shared_ptr<Merge> merge, std::vector<std::size_t> positions)
+        : merge(std::move(merge)), positions(std::move(positions)) {}
+
+    void complete(const boost::system::error_code &ec,
+                  std::vector<AsyncReply> replies) override {
+      /*parts complete on io_contexts of different nodes*/
+      std::unique_lock<std::mutex> _lckg(merge->mtx);
+      for (std::size_t i = 0; i < replies.size() && i < positions.size();
+           ++i) {
+        merge->replies[positions[i]] = std::move(replies[i]);
+      }
+      if (ec) {
+        merge->ec = ec;
+      }
+      if (--merge->remaining == 0) {
+        _lckg.unlock();
+        merge->done->complete(merge->ec, std::move(merge->replies));
+      }
+    }
+
+    std::shared_ptr<Merge> merge;
+    std::vector<std::size_t> positions;
+  };
+
+  std::mutex mtx;
+  std::vector<AsyncReply> replies;
+  std::size_t remaining = 0;
+  boost::system::error_code ec;
+  std::unique_ptr<AsyncRedisConnection::Completion> done;
+};
+
+redis::AsyncRedisClient::AsyncRedisClient()
+    : m_curr(0), m_ring(RedisConnectionPool::get_instance()->ring()) {
+
+  auto config = ServerConfig::get_instance();
+  const auto count =
+      std::max<std::size_t>(1, config->Redis_async_connections);
+
+  m_connections.resize(m_ring->size());
+  for (std::size_t node = 0; node < m_ring->size(); ++node) {
+    const auto &[ip, port] = m_ring->nodes()[node];
+    spdlog::info("[Async Redis]: Opening {} Connections To {}:{}", count, ip,
+                 port);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      m_connections[node].push_back(std::make_unique<AsyncRedisConnection>(
+          IOServicePool::get_instance()->getIOServiceContext(), ip, port,
+          config->Redis_passwd, reconnect_interval));
+    }
+  }
+}
+
+redis::AsyncRedisClient::~AsyncRedisClient() { shutdown(); }
+
+void redis::AsyncRedisClient::shutdown() {
+  for (auto &node : m_connections) {
+    for (auto &conn : node) {
+      conn->close();
+    }
+  }
+}
+
+void redis::AsyncRedisClient::execute(
+    std::vector<std::vector<std::string>> commands,
+    std::unique_ptr<AsyncRedisConnection::Completion> done) {
+
+  if (m_ring->size() < 2) {
+    next(0).submit(std::move(commands), std::move(done));
+    return;
+  }
+
+  /*node -> its commands and their positions in the pipeline*/
+  std::vector<std::vector<std::vector<std::string>>> parts(m_ring->size());
+  std::vector<std::vector<std::size_t>> positions(m_ring->size());
+  for (std::size_t i = 0; i < commands.size(); ++i) {
+    const auto node = m_ring->locate(commands[i]);
+    parts[node].push_back(std::move(commands[i]));
+    positions[node].push_back(i);
+  }
+
+  const auto used = static_cast<std::size_t>(
+      std::count_if(parts.begin(), parts.end(),
+                    [](const auto &part) { return !part.empty(); }));
+
+  if (used < 2) {
+    auto it = std::find_if(parts.begin(), parts.end(),
+                           [](const auto &part) { return !part.empty(); });
+    const auto node = it == parts.end() ? 0 : it - parts.begin();
+    next(node).submit(it == parts.end() ? std::move(commands) : std::move(*it),
+                      std::move(done));
+    return;
+  }
+
+  auto merge = std::make_shared<Merge>();
+  merge->replies.resize(commands.size());
+  merge->remaining = used;
+  merge->done = std::move(done);
+
+  for (std::size_t node = 0; node < parts.size(); ++node) {
+    if (parts[node].empty()) {
+      continue;
+    }
+    next(node).submit(std::move(parts[node]),
+                      std::make_unique<Merge::Part>(
+                          merge, std::move(positions[node])));
+  }
+}
+
+redis::AsyncRedisConnection &
+redis::AsyncRedisClient::next(const std::size_t node) {
+  auto &connections = m_connections[node];
+  return *connections[m_curr.fetch_add(1) % connections.size()];
+}
+
+boost::asio::io_context::executor_type redis::AsyncRedisClient::executor() {
+  return next(0).get_executor();
+}
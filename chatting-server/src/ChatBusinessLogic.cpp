@@ -1,128 +1,203 @@
+#include <chat/ChatSearchIndex.hpp>
+#include <chat/ChatThreadIndex.hpp>
+#include <chat/GroupMemberCache.hpp>
+#include <chat/OfflineInbox.hpp>
+#include <chat/ReadCursorManager.hpp>
+#include <chat/RecentMessageCache.hpp>
+#include <chat/WriteBehindCommitter.hpp>
 #include <grpc/GrpcDistributedChattingService.hpp>
 #include <grpc/GrpcRegisterChattingService.hpp>
 #include <grpc/GrpcUserService.hpp>
 #include <handler/SyncLogic.hpp>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <sql/MySQLShardRouter.hpp>
+#include <user/RoutingCache.hpp>
+#include <user/UserSearchIndex.hpp>
+#include <set>
+
+constexpr SyncLogic::HandlerTable SyncLogic::makeHandlerTable() {
+  HandlerTable table{};
 
-void SyncLogic::registerCallbacks() {
   /*
    * ServiceType::SERVICE_LOGINSERVER
    * Handling Login Request
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_LOGINSERVER,
-      std::bind(&SyncLogic::handlingLogin, this, std::placeholders::_1,
-                std::placeholders::_2, std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_LOGINSERVER)] =
+      &SyncLogic::handlingLogin;
 
   /*
    * ServiceType::SERVICE_LOGOUTSERVER
    * Handling Logout Request
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_LOGOUTSERVER,
-      std::bind(&SyncLogic::handlingLogout, this, std::placeholders::_1,
-                std::placeholders::_2, std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_LOGOUTSERVER)] =
+      &SyncLogic::handlingLogout;
 
   /*
    * ServiceType::SERVICE_SEARCHUSERNAME
    * Handling User Search Username
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_SEARCHUSERNAME,
-      std::bind(&SyncLogic::handlingUserSearch, this, std::placeholders::_1,
-                std::placeholders::_2, std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_SEARCHUSERNAME)] =
+      &SyncLogic::handlingUserSearch;
 
   /*
    * ServiceType::SERVICE_CREATENEWPRIVATECHAT
    * Handling User Create A Private Chat for thread_id
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_CREATENEWPRIVATECHAT,
-      std::bind(&SyncLogic::handlingCreateNewPrivateChat, this,
-                std::placeholders::_1, std::placeholders::_2,
-                std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_CREATENEWPRIVATECHAT)] =
+      &SyncLogic::handlingCreateNewPrivateChat;
 
   /*
    * ServiceType::SERVICE_PULLCHATTHREAD
    * Handling User Pull Chat Thread For indexing
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_PULLCHATTHREAD,
-      std::bind(&SyncLogic::handlingUserChatTheads, this, std::placeholders::_1,
-                std::placeholders::_2, std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_PULLCHATTHREAD)] =
+      &SyncLogic::handlingUserChatTheads;
 
   /*
    * ServiceType:: ServiceType::SERVICE_PULLCHATRECORD
    * Handling User Pull Chat Message By Thread_id and messsage_id
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_PULLCHATRECORD,
-      std::bind(&SyncLogic::handlingUserChatMessage, this,
-                std::placeholders::_1, std::placeholders::_2,
-                std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_PULLCHATRECORD)] =
+      &SyncLogic::handlingUserChatMessage;
 
   /*
    * ServiceType::FRIENDREQUEST_SRC
    * Handling the person who added other(dst) as a friend
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_FRIENDREQUESTSENDER,
-      std::bind(&SyncLogic::handlingFriendRequestCreator, this,
-                std::placeholders::_1, std::placeholders::_2,
-                std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_FRIENDREQUESTSENDER)] =
+      &SyncLogic::handlingFriendRequestCreator;
 
   /*
    * ServiceType::FRIENDREQUEST_DST
    * Handling the person was being added response to the person who init this
    * action
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_FRIENDREQUESTCONFIRM,
-      std::bind(&SyncLogic::handlingFriendRequestConfirm, this,
-                std::placeholders::_1, std::placeholders::_2,
-                std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_FRIENDREQUESTCONFIRM)] =
+      &SyncLogic::handlingFriendRequestConfirm;
 
   /*
    * ServiceType::SERVICE_TEXTCHATMSGREQUEST
    * Handling the user send chatting text msg to others
    */
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_TEXTCHATMSGREQUEST,
-      std::bind(&SyncLogic::handlingTextChatMsg, this, std::placeholders::_1,
-                std::placeholders::_2, std::placeholders::_3)));
-
-  m_callbacks.insert(std::pair<ServiceType, CallbackFunc>(
-      ServiceType::SERVICE_HEARTBEAT_REQUEST,
-      std::bind(&SyncLogic::handlingHeartBeat, this, std::placeholders::_1,
-                std::placeholders::_2, std::placeholders::_3)));
+  table[static_cast<std::size_t>(ServiceType::SERVICE_TEXTCHATMSGREQUEST)] =
+      &SyncLogic::handlingTextChatMsg;
+
+  table[static_cast<std::size_t>(ServiceType::SERVICE_HEARTBEAT_REQUEST)] =
+      &SyncLogic::handlingHeartBeat;
+
+  /*
+   * ServiceType::SERVICE_SYNCCHATMSGREQUEST
+   * Handling the user sync messages of all threads after reconnect
+   */
+  table[static_cast<std::size_t>(ServiceType::SERVICE_SYNCCHATMSGREQUEST)] =
+      &SyncLogic::handlingSyncChatMessages;
+
+  /*
+   * ServiceType::SERVICE_MARKREADREQUEST
+   * Handling the user read messages of a thread
+   */
+  table[static_cast<std::size_t>(ServiceType::SERVICE_MARKREADREQUEST)] =
+      &SyncLogic::handlingMarkRead;
+
+  /*
+   * ServiceType::SERVICE_SEARCHCHATMSGREQUEST
+   * Handling the user search messages of a thread by keyword
+   */
+  table[static_cast<std::size_t>(ServiceType::SERVICE_SEARCHCHATMSGREQUEST)] =
+      &SyncLogic::handlingSearchChatMessages;
+
+  return table;
 }
 
+const SyncLogic::HandlerTable SyncLogic::handler_table =
+    SyncLogic::makeHandlerTable();
+
 void SyncLogic::handlingHeartBeat(ServiceType srv_type,
                                   std::shared_ptr<Session> session,
                                   NodePtr recv) {
-  boost::json::object src_root;    /*store json from client*/
-  boost::json::object result_root; /*send processing result back to dst user*/
+  constexpr auto type = ServiceType::SERVICE_HEARTBEAT_REQUEST;
 
-  parseJson(session, recv, src_root);
+  if (!decodeRequest<type>(session, recv)) {
+    return;
+  }
 
-  std::string uuid = boost::json::value_to<std::string>(src_root["uuid"]);
+  /*send it back*/
+  schema::HeartBeatResponse response;
+  response.error = static_cast<std::size_t>(ServiceStatus::SERVICE_SUCCESS);
+  sendResponse<type>(session, response);
+}
 
-  result_root["error"] = static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS);
+void SyncLogic::handlingMarkRead(ServiceType srv_type,
+                                 std::shared_ptr<Session> session,
+                                 NodePtr recv) {
+  constexpr auto type = ServiceType::SERVICE_MARKREADREQUEST;
 
-  /*send it back*/
-  session->sendMessage(ServiceType::SERVICE_HEARTBEAT_RESPONSE,
-                       boost::json::serialize(result_root), session);
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_MARKREADRESPONSE, session)) {
+    return;
+  }
+
+  auto request = decodeRequest<type>(session, recv);
+  if (!request) {
+    return;
+  }
+
+  /*user could only move its own read cursor*/
+  if (session->s_uuid != std::to_string(request->uuid)) {
+    generateErrorMessage("UUID Does Not Belong To This Session",
+                         ServiceType::SERVICE_MARKREADRESPONSE,
+                         ServiceStatus::JSONPARSE_ERROR, session);
+    return;
+  }
+
+  /*never move cursors or clear counters of other threads*/
+  bool is_member = false;
+  {
+    MySQLRAII mysql(
+        mysql::MySQLReplicaRouter::get_instance()->read(session->s_uuid),
+        acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_MARKREADRESPONSE, session)) {
+      return;
+    }
+    is_member =
+        mysql->get()->checkThreadMember(request->thread_id, request->uuid);
+  }
+
+  if (!is_member) {
+    generateErrorMessage(
+        fmt::format("UUID = {} Is Not A Member Of Thread ID = {}",
+                    request->uuid, request->thread_id),
+        ServiceType::SERVICE_MARKREADRESPONSE,
+        ServiceStatus::CHATTHREAD_NOT_EXIST, session);
+    return;
+  }
+
+  /*cursor which is already after msg_id is not an error*/
+  chat::ReadCursorManager::get_instance()->markRead(
+      raii, request->uuid, request->thread_id, request->msg_id);
+
+  schema::MarkReadResponse response;
+  response.error = static_cast<std::size_t>(ServiceStatus::SERVICE_SUCCESS);
+  response.uuid = request->uuid;
+  response.thread_id = request->thread_id;
+  response.msg_id = request->msg_id;
+  sendResponse<type>(session, response);
 }
 
 void SyncLogic::handlingLogin(ServiceType srv_type,
                               std::shared_ptr<Session> session, NodePtr recv) {
 
-  RedisRAII raii;
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_LOGINRESPONSE, session)) {
+    return;
+  }
 
   boost::json::object src_obj;
   boost::json::object redis_root;
 
   boost::json::array friendreq;  // pending request
   boost::json::array authfriend; // friends that have already been added
+  boost::json::array unreadlist; // unread counter of every thread
 
   parseJson(session, recv, src_obj);
 
@@ -174,6 +249,21 @@ void SyncLogic::handlingLogin(ServiceType srv_type,
   /*bind uuid with a session*/
   session->setUUID(uuid);
 
+  /*client could receive and send fragmented extended frames*/
+  if (src_obj.contains("extended_frame") &&
+      src_obj["extended_frame"].is_bool() &&
+      src_obj["extended_frame"].as_bool()) {
+    session->m_extended_frame = true;
+  }
+
+  /*compression flag lives inside extended frame header*/
+  if (session->m_extended_frame && src_obj.contains("compression") &&
+      src_obj["compression"].is_string() &&
+      src_obj["compression"].as_string() == "deflate" &&
+      ServerConfig::get_instance()->CompressionEnabled) {
+    session->m_compression = true;
+  }
+
   /* add user uuid and session as a pair and store it inside usermanager */
   UserManager::get_instance()->createUserSession(uuid, session);
 
@@ -245,14 +335,33 @@ void SyncLogic::handlingLogin(ServiceType srv_type,
     }
   }
 
+  /*unread counters are maintained incrementally, no history scan*/
+  for (auto &item :
+       chat::ReadCursorManager::get_instance()->getUnreadInfo(raii, uuid)) {
+    boost::json::object obj;
+    obj["thread_id"] = item.thread_id;
+    obj["unread"] = item.unread;
+    obj["last_read_msg_id"] = item.last_read_msg_id;
+    unreadlist.push_back(std::move(obj));
+  }
+
   redis_root["error"] = response.error();
   redis_root["FriendRequestList"] = std::move(friendreq);
   redis_root["AuthFriendList"] = std::move(authfriend);
+  redis_root["UnreadList"] = std::move(unreadlist);
+  redis_root["extended_frame"] = session->m_extended_frame.load();
+  redis_root["frame_chunk_size"] = ServerConfig::get_instance()->FrameChunkSize;
+  redis_root["compression"] = session->m_compression ? "deflate" : "";
+  redis_root["compression_threshold"] =
+      ServerConfig::get_instance()->CompressionThreshold;
 
   /*send it back*/
   session->sendMessage(ServiceType::SERVICE_LOGINRESPONSE,
                        boost::json::serialize(redis_root), session);
 
+  /*messages sent to this user while it was offline*/
+  deliverOfflineMessages(raii, uuid, session);
+
   /*
    * add user connection counter for current server
    * 1. HGET not exist: Current Chatting server didn't setting up connection
@@ -265,7 +374,10 @@ void SyncLogic::handlingLogin(ServiceType srv_type,
 void SyncLogic::handlingLogout(ServiceType srv_type,
                                std::shared_ptr<Session> session, NodePtr recv) {
 
-  RedisRAII raii;
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_LOGOUTRESPONSE, session)) {
+    return;
+  }
 
   boost::json::object src_obj;
   boost::json::object result_root; /*send processing result back to src user*/
@@ -323,34 +435,51 @@ void SyncLogic::handlingLogout(ServiceType srv_type,
 void SyncLogic::handlingUserSearch(ServiceType srv_type,
                                    std::shared_ptr<Session> session,
                                    NodePtr recv) {
+  constexpr auto type = ServiceType::SERVICE_SEARCHUSERNAME;
 
-  /*connection pool RAII*/
-  MySQLRAII mysql;
-
-  boost::json::object src_obj;  /*store json from client*/
   boost::json::object dst_root; /*store json from client*/
+  boost::json::array users;     /*user cards of current page*/
 
-  parseJson(session, recv, src_obj);
-
-  // Parsing failed
-  if (!src_obj.contains("username")) {
-    generateErrorMessage("Failed to parse json data",
-                         ServiceType::SERVICE_SEARCHUSERNAMERESPONSE,
-                         ServiceStatus::LOGIN_UNSUCCESSFUL, session);
+  auto request = decodeRequest<type>(session, recv);
+  if (!request) {
     return;
   }
 
-  std::string username =
-      boost::json::value_to<std::string>(src_obj["username"]);
+  const std::size_t offset = request->offset.value_or(0);
+  const std::size_t limit =
+      std::clamp<std::size_t>(
+          request->limit.value_or(
+              ServerConfig::get_instance()->UserSearchPageSize),
+          1, ServerConfig::get_instance()->UserSearchMaxPageSize);
+
+  std::string username(request->username);
   spdlog::info("[{}] User {} Searching For User {} ",
                ServerConfig::get_instance()->GrpcServerName, session->s_uuid,
                username);
 
-  /*search username in mysql to get uuid*/
-  std::optional<std::size_t> uuid_op =
-      mysql->get()->getUUIDByUsername(username);
+  /*prefix and typo-tolerant search in memory*/
+  auto result =
+      user::UserSearchIndex::get_instance()->search(username, offset, limit);
 
-  if (!uuid_op.has_value()) {
+  /*user who registered just now might not be indexed yet*/
+  if (!result.total && !offset) {
+    MySQLRAII mysql(acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_SEARCHUSERNAMERESPONSE,
+                       session)) {
+      return;
+    }
+    std::optional<std::size_t> uuid_op =
+        mysql->get()->getUUIDByUsername(username);
+
+    if (uuid_op.has_value()) {
+      user::UserSearchIndex::get_instance()->insert(uuid_op.value(), username,
+                                                    "");
+      result.uuids.push_back(uuid_op.value());
+      result.total = 1;
+    }
+  }
+
+  if (!result.total) {
     spdlog::warn("[{}] {} Can not find a single user in MySQL and Redis",
                  ServerConfig::get_instance()->GrpcServerName, username);
 
@@ -360,26 +489,51 @@ void SyncLogic::handlingUserSearch(ServiceType srv_type,
     return;
   }
 
-  auto card_op = getUserBasicInfo(std::to_string(uuid_op.value()));
+  /*one page of users is hydrated together*/
+  std::vector<std::string> keys;
+  keys.reserve(result.uuids.size());
+  for (const auto uuid : result.uuids) {
+    keys.push_back(std::to_string(uuid));
+  }
+  auto cards = getUserProfiles(keys);
+
+  for (std::size_t i = 0; i < cards.size(); ++i) {
+    /*when user info not found!*/
+    if (!cards[i]) {
+      spdlog::warn("[{}] No {}'s Profile Found!",
+                   ServerConfig::get_instance()->GrpcServerName, keys[i]);
+      continue;
+    }
+
+    std::unique_ptr<user::UserNameCard> info = std::move(cards[i]);
+    boost::json::object obj;
+    obj["uuid"] = info->m_uuid;
+    obj["sex"] = static_cast<uint8_t>(info->m_sex);
+    obj["avator"] = info->m_avatorPath;
+    obj["username"] = info->m_username;
+    obj["nickname"] = info->m_nickname;
+    obj["description"] = info->m_description;
+    users.push_back(std::move(obj));
+  }
 
-  /*when user info not found!*/
-  if (!card_op.has_value()) {
-    spdlog::warn("[{}] No {}'s Profile Found!",
-                 ServerConfig::get_instance()->GrpcServerName, uuid_op.value());
+  if (users.empty() && !offset) {
     generateErrorMessage("No User Account Found",
                          ServiceType::SERVICE_SEARCHUSERNAMERESPONSE,
                          ServiceStatus::SEARCHING_USERNAME_NOT_FOUND, session);
     return;
   }
 
-  std::unique_ptr<user::UserNameCard> info = std::move(*card_op);
+  /*the best match is also placed on top level for old clients*/
+  if (!users.empty()) {
+    dst_root = users[0].as_object();
+  }
+
+  const std::size_t next_offset = offset + result.uuids.size();
   dst_root["error"] = static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS);
-  dst_root["uuid"] = info->m_uuid;
-  dst_root["sex"] = static_cast<uint8_t>(info->m_sex);
-  dst_root["avator"] = info->m_avatorPath;
-  dst_root["username"] = info->m_username;
-  dst_root["nickname"] = info->m_nickname;
-  dst_root["description"] = info->m_description;
+  dst_root["users"] = std::move(users);
+  dst_root["total"] = result.total;
+  dst_root["next_offset"] = std::to_string(next_offset);
+  dst_root["is_EOF"] = next_offset >= result.total;
 
   session->sendMessage(ServiceType::SERVICE_SEARCHUSERNAMERESPONSE,
                        boost::json::serialize(dst_root), session);
@@ -391,8 +545,16 @@ void SyncLogic::handlingFriendRequestCreator(ServiceType srv_type,
                                              NodePtr recv) {
 
   /*connection pool RAII*/
-  RedisRAII raii;
-  MySQLRAII mysql;
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_FRIENDSENDERRESPONSE,
+                     session)) {
+    return;
+  }
+  MySQLRAII mysql(acquireTimeout());
+  if (!checkAcquired(mysql, ServiceType::SERVICE_FRIENDSENDERRESPONSE,
+                     session)) {
+    return;
+  }
 
   boost::json::object src_root;    /*store json from client*/
   boost::json::object result_root; /*send processing result back to src user*/
@@ -451,12 +613,15 @@ void SyncLogic::handlingFriendRequestCreator(ServiceType srv_type,
   spdlog::info("[{} UUID = {}]:  Insert Friend Request Successful",
                ServerConfig::get_instance()->GrpcServerName, src_uuid);
 
+  mysql::MySQLReplicaRouter::get_instance()->wrote(src_uuid_value_op.value());
+  mysql::MySQLReplicaRouter::get_instance()->wrote(dst_uuid_value_op.value());
+
   /*
    * Search For User Belonged Server Cache in Redis
    * find key = server_prefix + dst_uuid in redis, GET
    */
   std::optional<std::string> server_op =
-      raii->get()->checkValue(server_prefix + dst_uuid);
+      user::RoutingCache::get_instance()->getServer(raii, dst_uuid);
 
   /*we cannot find it in Redis directly*/
   if (!server_op.has_value()) {
@@ -556,7 +721,12 @@ void SyncLogic::handlingUserChatTheads(ServiceType srv_type,
                                        std::shared_ptr<Session> session,
                                        NodePtr recv) {
 
-  MySQLRAII mysql;
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_PULLCHATTHREADRESPONSE,
+                     session)) {
+    return;
+  }
+
   boost::json::object src_obj;
   boost::json::object result_obj;
 
@@ -584,8 +754,9 @@ void SyncLogic::handlingUserChatTheads(ServiceType srv_type,
   bool is_complete{};         // is thread_id list acquire finished!
   std::string next_thread_id; // next_thread_id order is going to be acquired!
 
-  auto list_status = mysql->get()->getUserChattingThreadIdx(
-      std::stoi(uuid), std::stoi(thread_id),
+  /*most recently active threads come first*/
+  auto list_status = chat::ChatThreadIndex::get_instance()->getPage(
+      raii, std::stoull(uuid), std::stoull(thread_id),
       /*interval*/ 10, next_thread_id, is_complete);
 
   if (!list_status.has_value()) {
@@ -629,7 +800,6 @@ void SyncLogic::handlingUserChatTheads(ServiceType srv_type,
 void SyncLogic::handlingUserChatMessage(ServiceType srv_type,
                                         std::shared_ptr<Session> session,
                                         NodePtr recv) {
-  MySQLRAII mysql;
   boost::json::object src_root; /*store json from client*/
 
   boost::json::array result_arr;
@@ -647,20 +817,53 @@ void SyncLogic::handlingUserChatMessage(ServiceType srv_type,
   auto thread_id = boost::json::value_to<std::string>(src_root["thread_id"]);
   auto msg_id = boost::json::value_to<std::string>(src_root["msg_id"]);
 
-  if (!tools::string_to_value<std::size_t>(thread_id).has_value() ||
-      !tools::string_to_value<std::size_t>(msg_id).has_value()) {
+  auto thread_id_op = tools::string_to_value<std::size_t>(thread_id);
+  auto msg_id_op = tools::string_to_value<std::size_t>(msg_id);
+
+  if (!thread_id_op.has_value() || !msg_id_op.has_value()) {
     generateErrorMessage("Failed to cast uuid strings to size_t",
                          ServiceType::SERVICE_PULLCHATRECORDRESPONSE,
                          ServiceStatus::JSONPARSE_ERROR, session);
     return;
   }
 
+  /*message id is 64-bit, std::stoi would overflow*/
   std::string next_msg_id;
   bool is_complete{};
-  auto list = mysql->get()->getChattingHistoryRecord(
-      std::stoi(thread_id), std::stoi(msg_id),
+
+  /*newest pages are served by recent message cache without MySQL*/
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_PULLCHATRECORDRESPONSE,
+                     session)) {
+    return;
+  }
+  auto list = chat::RecentMessageCache::get_instance()->getPage(
+      raii, thread_id_op.value(), msg_id_op.value(),
       /*interval*/ 10, next_msg_id, is_complete);
 
+  if (list.has_value() && list->empty()) {
+    list = std::nullopt;
+  } else if (!list.has_value()) {
+    auto owner =
+        mysql::MySQLShardRouter::get_instance()->route(thread_id_op.value());
+    MySQLRAII mysql(
+        mysql::MySQLReplicaRouter::get_instance()->read(owner, session->s_uuid),
+        acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_PULLCHATRECORDRESPONSE,
+                       session)) {
+      return;
+    }
+    list = mysql->get()->getChattingHistoryRecord(
+        thread_id_op.value(), msg_id_op.value(),
+        /*interval*/ 10, next_msg_id, is_complete);
+
+    /*this page reaches the newest message, cache it for next reader*/
+    if (list.has_value() && is_complete) {
+      chat::RecentMessageCache::get_instance()->fill(
+          raii, thread_id_op.value(), msg_id_op.value(), list.value());
+    }
+  }
+
   if (!list.has_value()) {
     generateErrorMessage("Failed to cast uuid strings to size_t",
                          ServiceType::SERVICE_PULLCHATRECORDRESPONSE,
@@ -689,10 +892,321 @@ void SyncLogic::handlingUserChatMessage(ServiceType srv_type,
                        boost::json::serialize(result_root), session);
 }
 
+void SyncLogic::handlingSyncChatMessages(ServiceType srv_type,
+                                         std::shared_ptr<Session> session,
+                                         NodePtr recv) {
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_SYNCCHATMSGRESPONSE, session)) {
+    return;
+  }
+
+  boost::json::object src_root; /*store json from client*/
+
+  parseJson(session, recv, src_root);
+
+  // Parsing failed
+  if (!(src_root.contains("uuid") && src_root.contains("threads") &&
+        src_root["threads"].is_array())) {
+    generateErrorMessage("Failed to parse json data",
+                         ServiceType::SERVICE_SYNCCHATMSGRESPONSE,
+                         ServiceStatus::JSONPARSE_ERROR, session);
+    return;
+  }
+
+  auto uuid = boost::json::value_to<std::string>(src_root["uuid"]);
+  if (session->s_uuid != uuid) {
+    generateErrorMessage("UUID Does Not Belong To This Session",
+                         ServiceType::SERVICE_SYNCCHATMSGRESPONSE,
+                         ServiceStatus::JSONPARSE_ERROR, session);
+    return;
+  }
+
+  const std::size_t page = ServerConfig::get_instance()->SyncPageSize;
+  const std::size_t budget = ServerConfig::get_instance()->SyncFrameSize;
+
+  boost::json::array messages_arr; // messages of all threads in this frame
+  boost::json::array threads_arr;  // sync status of threads in this frame
+  std::size_t frame_size = 0;
+
+  /*send one frame, is_complete is set on the last one*/
+  auto flush = [&](const bool is_complete) {
+    boost::json::object result_root;
+    result_root["error"] =
+        static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS);
+    result_root["is_complete"] = is_complete;
+    result_root["chat_messages"] = std::move(messages_arr);
+    result_root["threads"] = std::move(threads_arr);
+    session->sendMessage(ServiceType::SERVICE_SYNCCHATMSGRESPONSE,
+                         boost::json::serialize(result_root), session);
+
+    messages_arr = boost::json::array{};
+    threads_arr = boost::json::array{};
+    frame_size = 0;
+  };
+
+  /*(thread_id, high-water mark) of every valid entry*/
+  std::vector<std::pair<std::size_t, std::size_t>> requested;
+  for (auto &item : src_root["threads"].as_array()) {
+    if (!item.is_object())
+      continue;
+
+    auto &obj = item.as_object();
+    if (!(obj.contains("thread_id") && obj.contains("msg_id")))
+      continue;
+
+    auto thread_id = boost::json::value_to<std::string>(obj["thread_id"]);
+    auto msg_id = boost::json::value_to<std::string>(obj["msg_id"]);
+
+    auto thread_id_op = tools::string_to_value<std::size_t>(thread_id);
+    auto msg_id_op =
+        msg_id.empty() ? std::optional<std::size_t>(0)
+                       : tools::string_to_value<std::size_t>(msg_id);
+
+    if (!thread_id_op.has_value() || !msg_id_op.has_value())
+      continue;
+
+    requested.emplace_back(thread_id_op.value(), msg_id_op.value());
+  }
+
+  /*recent message cache knows nothing about membership, check it first*/
+  {
+    auto uuid_op = tools::string_to_value<std::size_t>(uuid);
+    MySQLRAII mysql(mysql::MySQLReplicaRouter::get_instance()->read(uuid),
+                    acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_SYNCCHATMSGRESPONSE,
+                       session)) {
+      return;
+    }
+    for (const auto &[thread, after] : requested) {
+      if (!uuid_op.has_value() ||
+          !mysql->get()->checkThreadMember(thread, uuid_op.value())) {
+        generateErrorMessage(
+            fmt::format("UUID = {} Is Not A Member Of Thread ID = {}", uuid,
+                        thread),
+            ServiceType::SERVICE_SYNCCHATMSGRESPONSE,
+            ServiceStatus::CHATTHREAD_NOT_EXIST, session);
+        return;
+      }
+    }
+  }
+
+  for (const auto &[thread, after] : requested) {
+    const auto thread_id = std::to_string(thread);
+
+    std::string next_msg_id = std::to_string(after);
+    bool is_complete = true;
+
+    /*threads without new messages are answered by redis*/
+    auto list = chat::RecentMessageCache::get_instance()->getPage(
+        raii, thread, after, page, next_msg_id, is_complete);
+
+    if (!list.has_value()) {
+      auto owner = mysql::MySQLShardRouter::get_instance()->route(thread);
+      MySQLRAII mysql(
+          mysql::MySQLReplicaRouter::get_instance()->read(owner, uuid),
+          acquireTimeout());
+
+      /*pool is exhausted, client syncs this thread again from after*/
+      if (!mysql.is_active()) {
+        next_msg_id = std::to_string(after);
+        is_complete = false;
+      } else {
+        list = mysql->get()->getChattingHistoryRecord(
+            thread, after, page, next_msg_id, is_complete);
+      }
+
+      if (list.has_value() && is_complete) {
+        chat::RecentMessageCache::get_instance()->fill(raii, thread, after,
+                                                       list.value());
+      }
+    }
+
+    if (!list.has_value()) {
+      list.emplace();
+    }
+
+    for (const auto &msg : list.value()) {
+      boost::json::object msg_obj;
+      msg_obj["msg_sender"] = msg->msg_sender;
+      msg_obj["msg_receiver"] = msg->msg_receiver;
+      msg_obj["msg_type"] = static_cast<uint32_t>(msg->msg_type);
+      msg_obj["thread_id"] = thread_id;
+      msg_obj["status"] = static_cast<uint32_t>(msg->status);
+      msg_obj["msg_id"] = msg->message_id;
+      msg_obj["msg_content"] = msg->msg_content;
+      msg_obj["timestamp"] = msg->timestamp;
+
+      /*start a new frame before this one grows beyond budget*/
+      const auto size = boost::json::serialize(msg_obj).size();
+      if (frame_size && frame_size + size > budget) {
+        flush(false);
+      }
+
+      frame_size += size;
+      messages_arr.push_back(std::move(msg_obj));
+    }
+
+    /*
+     * client continues from next_msg_id with another sync request if this
+     * thread still has more than one page
+     */
+    boost::json::object thread_obj;
+    thread_obj["thread_id"] = thread_id;
+    thread_obj["next_msg_id"] = next_msg_id;
+    thread_obj["is_complete"] = is_complete;
+    frame_size += boost::json::serialize(thread_obj).size();
+    threads_arr.push_back(std::move(thread_obj));
+  }
+
+  flush(true);
+}
+
+void SyncLogic::handlingSearchChatMessages(ServiceType srv_type,
+                                           std::shared_ptr<Session> session,
+                                           NodePtr recv) {
+  constexpr auto type = ServiceType::SERVICE_SEARCHCHATMSGREQUEST;
+
+  auto request = decodeRequest<type>(session, recv);
+  if (!request) {
+    return;
+  }
+
+  if (session->s_uuid != std::to_string(request->uuid)) {
+    generateErrorMessage("UUID Does Not Belong To This Session",
+                         ServiceType::SERVICE_SEARCHCHATMSGRESPONSE,
+                         ServiceStatus::JSONPARSE_ERROR, session);
+    return;
+  }
+
+  const std::size_t offset = request->offset.value_or(0);
+  const std::size_t limit = std::clamp<std::size_t>(
+      request->limit.value_or(ServerConfig::get_instance()->ChatSearchPageSize),
+      1, ServerConfig::get_instance()->ChatSearchMaxPageSize);
+
+  /*index knows nothing about membership, never leak other threads*/
+  bool is_member = false;
+  {
+    MySQLRAII mysql(
+        mysql::MySQLReplicaRouter::get_instance()->read(session->s_uuid),
+        acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_SEARCHCHATMSGRESPONSE,
+                       session)) {
+      return;
+    }
+    is_member =
+        mysql->get()->checkThreadMember(request->thread_id, request->uuid);
+  }
+
+  if (!is_member) {
+    generateErrorMessage(
+        fmt::format("UUID = {} Is Not A Member Of Thread ID = {}",
+                    request->uuid, request->thread_id),
+        ServiceType::SERVICE_SEARCHCHATMSGRESPONSE,
+        ServiceStatus::CHATTHREAD_NOT_EXIST, session);
+    return;
+  }
+
+  const std::string thread_id = std::to_string(request->thread_id);
+  auto result = chat::ChatSearchIndex::get_instance()->search(
+      request->thread_id, request->keyword, offset, limit);
+
+  const std::vector<std::size_t> msg_ids(result.msg_ids.begin(),
+                                         result.msg_ids.end());
+
+  /*hit messages are usually recent ones, try recent message cache first*/
+  std::unordered_map<std::string, std::unique_ptr<chat::MsgInfo>> found;
+  {
+    RedisRAII raii(acquireTimeout());
+    if (!checkAcquired(raii, ServiceType::SERVICE_SEARCHCHATMSGRESPONSE,
+                       session)) {
+      return;
+    }
+    for (auto &item : chat::RecentMessageCache::get_instance()->getMessages(
+             raii, request->thread_id, msg_ids)) {
+      found[item->message_id] = std::move(item);
+    }
+  }
+
+  std::vector<std::size_t> missing;
+  std::copy_if(msg_ids.begin(), msg_ids.end(), std::back_inserter(missing),
+               [&found](const std::size_t msg_id) {
+                 return !found.count(std::to_string(msg_id));
+               });
+
+  if (!missing.empty()) {
+    MySQLRAII mysql(
+        mysql::MySQLReplicaRouter::get_instance()->read(
+            mysql::MySQLShardRouter::get_instance()->route(request->thread_id),
+            session->s_uuid),
+        acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_SEARCHCHATMSGRESPONSE,
+                       session)) {
+      return;
+    }
+    auto list =
+        mysql->get()->getChattingHistoryByIds(request->thread_id, missing);
+    if (!list.has_value()) {
+      generateErrorMessage("DataBase Operation Failed!",
+                           ServiceType::SERVICE_SEARCHCHATMSGRESPONSE,
+                           ServiceStatus::MYSQL_INTERNAL_ERROR, session);
+      return;
+    }
+    for (auto &item : *list) {
+      found[item->message_id] = std::move(item);
+    }
+  }
+
+  /*keep the ranking order*/
+  boost::json::array result_arr;
+  for (const auto msg_id : msg_ids) {
+    auto it = found.find(std::to_string(msg_id));
+    if (it == found.end()) {
+      continue;
+    }
+
+    const auto &item = it->second;
+    boost::json::object obj;
+    obj["msg_sender"] = item->msg_sender;
+    obj["msg_receiver"] = item->msg_receiver;
+    obj["msg_type"] = static_cast<uint32_t>(item->msg_type);
+    obj["thread_id"] = thread_id;
+    obj["status"] = static_cast<uint32_t>(item->status);
+    obj["msg_id"] = item->message_id;
+    obj["msg_content"] = item->msg_content;
+    obj["timestamp"] = item->timestamp;
+    result_arr.push_back(std::move(obj));
+  }
+
+  const std::size_t next_offset = offset + msg_ids.size();
+
+  boost::json::object result_root;
+  result_root["error"] = static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS);
+  result_root["thread_id"] = thread_id;
+  result_root["keyword"] = std::string(request->keyword);
+  result_root["total"] = result.total;
+  result_root["next_offset"] = std::to_string(next_offset);
+  result_root["is_EOF"] = next_offset >= result.total;
+  result_root["chat_messages"] = std::move(result_arr);
+  session->sendMessage(ServiceType::SERVICE_SEARCHCHATMSGRESPONSE,
+                       boost::json::serialize(result_root), session);
+}
+
 void SyncLogic::handlingCreateNewPrivateChat(ServiceType srv_type,
                                              std::shared_ptr<Session> session,
                                              NodePtr recv) {
-  MySQLRAII mysql;
+  MySQLRAII mysql(acquireTimeout());
+  if (!checkAcquired(mysql, ServiceType::SERVICE_CREATENEWPRIVATECHAT_RESPONSE,
+                     session)) {
+    return;
+  }
+
+  /*thread index is updated once the thread is created*/
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_CREATENEWPRIVATECHAT_RESPONSE,
+                     session)) {
+    return;
+  }
+
   boost::json::object src_root;    /*store json from client*/
   boost::json::object result_root; /*send processing result back to src user*/
 
@@ -733,6 +1247,20 @@ void SyncLogic::handlingCreateNewPrivateChat(ServiceType srv_type,
     return;
   }
 
+  mysql::MySQLReplicaRouter::get_instance()->wrote(my_uuid);
+  mysql::MySQLReplicaRouter::get_instance()->wrote(friend_uuid);
+
+  /*new thread appears in both users' thread list at once*/
+  {
+    const auto self = tools::string_to_value<std::size_t>(my_uuid);
+    const auto peer = tools::string_to_value<std::size_t>(friend_uuid);
+    chat::ChatThreadIndex::get_instance()->touch(
+        raii, {my_uuid, friend_uuid},
+        chat::ChatThreadMeta::createPrivateChat(
+            *status, std::to_string(std::min(*self, *peer)),
+            std::to_string(std::max(*self, *peer))));
+  }
+
   result_root["my_uuid"] = my_uuid;
   result_root["friend_uuid"] = friend_uuid;
   result_root["thread_id"] = *status;
@@ -766,8 +1294,16 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
   };
 
   /*connection pool RAII*/
-  RedisRAII raii;
-  MySQLRAII mysql;
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_FRIENDCONFIRMRESPONSE,
+                     session)) {
+    return;
+  }
+  MySQLRAII mysql(acquireTimeout());
+  if (!checkAcquired(mysql, ServiceType::SERVICE_FRIENDCONFIRMRESPONSE,
+                     session)) {
+    return;
+  }
 
   boost::json::object src_root;    /*store json from client*/
   boost::json::object result_root; /*send processing result back to src user*/
@@ -819,6 +1355,9 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
     return;
   }
 
+  mysql::MySQLReplicaRouter::get_instance()->wrote(src_uuid);
+  mysql::MySQLReplicaRouter::get_instance()->wrote(dst_uuid);
+
   /*
    * Response SERVICE_SUCCESS to the authenticator
    * Current session should receive a successful response first
@@ -835,8 +1374,10 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
                ServerConfig::get_instance()->GrpcServerName, src_uuid,
                dst_uuid);
 
-  /*We have to get src user info(src_uuid) on current server */
-  auto src_info = getUserBasicInfo(src_uuid);
+  /*both sides are notified, load their profiles together*/
+  auto cards = getUserProfiles({src_uuid, dst_uuid});
+  auto &src_info = cards[0];
+  auto &dst_info = cards[1];
   if (!src_info) {
     generateErrorMessage("User profile not found (src)",
                          ServiceType::SERVICE_FRIENDING_ON_BIDDIRECTIONAL,
@@ -870,7 +1411,7 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
 
   // Notify current user (authenticator) with friend's profile
   auto json =
-      generate_json(thread_id, src_uuid, message_arr, std::move(*src_info));
+      generate_json(thread_id, src_uuid, message_arr, std::move(src_info));
   session->sendMessage(ServiceType::SERVICE_FRIENDING_ON_BIDDIRECTIONAL,
                        boost::json::serialize(json), session);
 
@@ -878,7 +1419,8 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
    * Search For User Belonged Server Cache in Redis
    * find key = server_prefix + src_uuid in redis, GET
    */
-  auto server_op = raii->get()->checkValue(server_prefix + src_uuid);
+  auto server_op =
+      user::RoutingCache::get_instance()->getServer(raii, src_uuid);
 
   /*we cannot find it in Redis directly*/
   if (!server_op.has_value()) {
@@ -887,9 +1429,6 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
     return;
   }
 
-  /*We have to get dst user info(dst_uuid) on current server */
-  auto dst_info = getUserBasicInfo(dst_uuid);
-
   /*Is target user(src_uuid) and current user(dst_uuid) on the same server*/
   if (server_op.value() == ServerConfig::get_instance()->GrpcServerName) {
     /*try to find this target user on current chatting-server*/
@@ -901,7 +1440,7 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
       return;
     }
 
-    if (!dst_info.has_value()) {
+    if (!dst_info) {
       generateErrorMessage("User profile not found (dst)",
                            ServiceType::SERVICE_FRIENDING_ON_BIDDIRECTIONAL,
                            ServiceStatus::FRIENDING_TARGET_USER_NOT_FOUND,
@@ -910,7 +1449,7 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
     }
 
     boost::json::object root =
-        generate_json(thread_id, dst_uuid, message_arr, std::move(*dst_info));
+        generate_json(thread_id, dst_uuid, message_arr, std::move(dst_info));
     /*propagate the message to dst user*/
     (*session_op)
         ->sendMessage(ServiceType::SERVICE_FRIENDING_ON_BIDDIRECTIONAL,
@@ -927,11 +1466,11 @@ void SyncLogic::handlingFriendRequestConfirm(ServiceType srv_type,
      * by using grpc protocol
      */
 
-    if (!dst_info.has_value()) {
+    if (!dst_info) {
       return;
     }
 
-    std::unique_ptr<user::UserNameCard> namecard = std::move(*dst_info);
+    std::unique_ptr<user::UserNameCard> namecard = std::move(dst_info);
 
     message::FriendRequest *user_info = grpc_request.add_user_info();
     user_info->set_dst_uuid(std::stoi(dst_uuid));
@@ -971,33 +1510,38 @@ void SyncLogic::handlingTextChatMsg(ServiceType srv_type,
                                     std::shared_ptr<Session> session,
                                     NodePtr recv) {
 
-  /*connection pool RAII*/
-  RedisRAII raii;
-  MySQLRAII mysql;
+  /*views are valid until next request is parsed on this thread*/
+  auto request =
+      decodeRequest<ServiceType::SERVICE_TEXTCHATMSGREQUEST>(session, recv);
+  if (!request) {
+    return;
+  }
 
-  boost::json::object src_root; /*store json from client*/
+  /*group chat has no single receiver, delegate it to the fan-out engine*/
+  if (request->isGroupChat()) {
+    handlingGroupTextChatMsg(session, *request);
+    return;
+  }
 
-  parseJson(session, recv, src_root);
+  /*connection pool RAII*/
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_TEXTCHATMSGRESPONSE, session)) {
+    return;
+  }
 
   std::vector<std::shared_ptr<chat::MsgInfo>> updated_msg;
 
   // Parsing failed
-  if (!(src_root.contains("text_sender") &&
-        src_root.contains("text_receiver") && src_root.contains("text_msg") &&
-        src_root.contains("thread_id"))) {
+  if (!request->text_receiver) {
     generateErrorMessage("Missing required fields",
                          ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
                          ServiceStatus::JSONPARSE_ERROR, session);
     return;
   }
 
-  auto thread_id = boost::json::value_to<std::string>(src_root["thread_id"]);
-  auto sender_uuid =
-      boost::json::value_to<std::string>(src_root["text_sender"]);
-  auto receiver_uuid =
-      boost::json::value_to<std::string>(src_root["text_receiver"]);
-
-  const auto msg_array = src_root["text_msg"];
+  std::string thread_id(request->thread_id);
+  std::string sender_uuid(request->text_sender);
+  std::string receiver_uuid(*request->text_receiver);
 
   if (!tools::string_to_value<std::size_t>(sender_uuid).has_value() ||
       !tools::string_to_value<std::size_t>(receiver_uuid).has_value()) {
@@ -1008,49 +1552,95 @@ void SyncLogic::handlingTextChatMsg(ServiceType srv_type,
     return;
   }
 
-  // RAII
-  {
-    if (!src_root["text_msg"].is_array()) {
-      generateErrorMessage("Missing required fields",
-                           ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
-                           ServiceStatus::LOGIN_UNSUCCESSFUL, session);
-      return;
+  updated_msg.reserve(request->text_msg.size());
+  for (const auto &item : request->text_msg) {
+    updated_msg.push_back(std::make_shared<chat::TextMsgInfo>(
+        thread_id, std::string(item.unique_id),
+        std::string(item.msg_sender.value_or("")),
+        std::string(item.msg_receiver.value_or("")),
+        std::string(item.msg_content)));
+  }
+
+  /*
+   * write-behind mode: message ids are assigned and messages are appended to
+   * local WAL, MySQL is updated by background committer later
+   */
+  bool persisted = false;
+  if (chat::WriteBehindCommitter::get_instance()->isEnabled()) {
+    /*
+     * committer skips messages of a wrong thread, they have to be rejected
+     * before they are acked, delivered and cached
+     */
+    const auto thread = tools::string_to_value<std::size_t>(thread_id);
+    std::set<std::pair<std::size_t, std::size_t>> pairs;
+    for (const auto &item : updated_msg) {
+      auto sender = tools::string_to_value<std::size_t>(item->msg_sender);
+      auto receiver = tools::string_to_value<std::size_t>(item->msg_receiver);
+      pairs.emplace(sender.value_or(0), receiver.value_or(0));
     }
 
-    auto arr = src_root["text_msg"].as_array();
-    for (auto &item : arr) {
-      if (!item.is_object())
-        continue;
+    /*MySQL is only queried the first time a thread is seen*/
+    bool owned = thread.has_value();
+    for (const auto &[sender, receiver] : pairs) {
+      owned = owned &&
+              chat::WriteBehindCommitter::get_instance()
+                  ->checkPrivateChatThread(*thread, sender, receiver);
+    }
 
-      auto obj = item.as_object();
+    if (!owned) {
+      generateErrorMessage("Chat Thread Does Not Belong To Users",
+                           ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
+                           ServiceStatus::CHATTHREAD_NOT_EXIST, session);
+      return;
+    }
 
-      updated_msg.push_back(std::make_shared<chat::TextMsgInfo>(
-          thread_id, boost::json::value_to<std::string>(obj["unique_id"]),
-          boost::json::value_to<std::string>(obj["msg_sender"]),
-          boost::json::value_to<std::string>(obj["msg_receiver"]),
-          boost::json::value_to<std::string>(obj["msg_content"])));
+    persisted =
+        chat::WriteBehindCommitter::get_instance()->submit(updated_msg);
+  } else {
+    MySQLRAII mysql(mysql::MySQLShardRouter::get_instance()->route(thread_id),
+                    acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
+                       session)) {
+      return;
+    }
+    persisted = mysql->get()->createModifyChattingHistoryRecord(updated_msg);
+    if (persisted) {
+      mysql::MySQLReplicaRouter::get_instance()->wrote(sender_uuid);
+      mysql::MySQLReplicaRouter::get_instance()->wrote(receiver_uuid);
     }
   }
 
-  if (!mysql->get()->createModifyChattingHistoryRecord(updated_msg)) {
+  if (!persisted) {
     generateErrorMessage("DataBase Operation Failed!",
                          ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
                          ServiceStatus::MYSQL_INTERNAL_ERROR, session);
     return;
   }
 
-  // Query which server the receiver belongs to
-  auto server_op = raii->get()->checkValue(server_prefix + receiver_uuid);
-  if (!server_op) {
-    generateErrorMessage(
-        fmt::format("[{}] Cannot Find Receiver {}'s Server Info In  Redis",
-                    ServerConfig::get_instance()->GrpcServerName,
-                    receiver_uuid),
-        ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
-        ServiceStatus::REDIS_UNKOWN_ERROR, session);
-    return;
+  /*keep the newest messages of this thread hot*/
+  chat::RecentMessageCache::get_instance()->append(raii, updated_msg);
+
+  /*searchable at once, without waiting for MySQL tailing*/
+  chat::ChatSearchIndex::get_instance()->index(updated_msg);
+
+  /*move this thread to the top of both users' thread list*/
+  {
+    const auto sender = tools::string_to_value<std::size_t>(sender_uuid);
+    const auto receiver = tools::string_to_value<std::size_t>(receiver_uuid);
+    chat::ChatThreadIndex::get_instance()->touch(
+        raii, {sender_uuid, receiver_uuid},
+        chat::ChatThreadMeta::createPrivateChat(
+            thread_id, std::to_string(std::min(*sender, *receiver)),
+            std::to_string(std::max(*sender, *receiver))));
   }
 
+  chat::ReadCursorManager::get_instance()->addUnread(
+      raii, thread_id, {receiver_uuid}, updated_msg);
+
+  // Query which server the receiver belongs to
+  auto server_op =
+      user::RoutingCache::get_instance()->getServer(raii, receiver_uuid);
+
   // Inter-server
   boost::json::array updated_arr;
 
@@ -1116,6 +1706,14 @@ void SyncLogic::handlingTextChatMsg(ServiceType srv_type,
   session->sendMessage(ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
                        boost::json::serialize(result_root), session);
 
+  /*receiver is offline, keep messages until it logins again*/
+  if (!server_op) {
+    spdlog::info("[{}] Receiver {} Is Offline, Store Messages In Inbox",
+                 ServerConfig::get_instance()->GrpcServerName, receiver_uuid);
+    chat::OfflineInbox::get_instance()->push(raii, receiver_uuid, updated_msg);
+    return;
+  }
+
   /*Is target user and msg text sender on the same server*/
   if (server_op.value() == ServerConfig::get_instance()->GrpcServerName) {
 
@@ -1123,10 +1721,8 @@ void SyncLogic::handlingTextChatMsg(ServiceType srv_type,
     auto receiver_session =
         UserManager::get_instance()->getSession(receiver_uuid);
     if (!receiver_session.has_value()) {
-      generateErrorMessage("Receiver Session Not Found",
-                           ServiceType::SERVICE_FRIENDSENDERRESPONSE,
-                           ServiceStatus::FRIENDING_TARGET_USER_NOT_FOUND,
-                           session);
+      chat::OfflineInbox::get_instance()->push(raii, receiver_uuid,
+                                               updated_msg);
       return;
     }
 
@@ -1155,6 +1751,9 @@ void SyncLogic::handlingTextChatMsg(ServiceType srv_type,
         "[gRPC {}]: Failed to forward message from {} to {} (server: {})",
         ServerConfig::get_instance()->GrpcServerName, sender_uuid,
         receiver_uuid, *server_op);
+
+    /*routing info is stale or remote server is gone*/
+    chat::OfflineInbox::get_instance()->push(raii, receiver_uuid, updated_msg);
     return;
   }
 
@@ -1163,3 +1762,239 @@ void SyncLogic::handlingTextChatMsg(ServiceType srv_type,
       ServerConfig::get_instance()->GrpcServerName, sender_uuid, receiver_uuid,
       *server_op);
 }
+
+/*
+ * Handling the user send chatting text msg to a group chat
+ * 1. resolve group members from GroupMemberCache
+ * 2. persist every message only once
+ * 3. group all receivers by their chatting server with one MGET
+ * 4. one local loop + one batched grpc call per remote chatting server
+ */
+void SyncLogic::handlingGroupTextChatMsg(
+    std::shared_ptr<Session> session,
+    const schema::TextChatMsgRequest &request) {
+
+  std::vector<std::shared_ptr<chat::MsgInfo>> updated_msg;
+
+  std::string thread_id(request.thread_id);
+  std::string sender_uuid(request.text_sender);
+
+  if (!tools::string_to_value<std::size_t>(sender_uuid).has_value() ||
+      !tools::string_to_value<std::size_t>(thread_id).has_value()) {
+
+    generateErrorMessage("Invalid UUID format",
+                         ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
+                         ServiceStatus::JSONPARSE_ERROR, session);
+    return;
+  }
+
+  /*only group members are allowed to send message to this group*/
+  auto members_op =
+      chat::GroupMemberCache::get_instance()->getMembers(thread_id);
+  if (!members_op.has_value() ||
+      !chat::GroupMemberCache::get_instance()->isMember(*members_op,
+                                                        sender_uuid)) {
+    generateErrorMessage(
+        fmt::format("UUID = {} Is Not A Member Of Group Thread ID = {}",
+                    sender_uuid, thread_id),
+        ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
+        ServiceStatus::CHATTHREAD_NOT_EXIST, session);
+    return;
+  }
+
+  updated_msg.reserve(request.text_msg.size());
+  for (const auto &item : request.text_msg) {
+    updated_msg.push_back(std::make_shared<chat::TextMsgInfo>(
+        thread_id, std::string(item.unique_id), sender_uuid,
+        /*group message has no single receiver, the same as MySQL*/ "0",
+        std::string(item.msg_content)));
+  }
+
+  /*
+   * caches are updated right after messages are persisted, so redis is
+   * acquired first, nothing is stored if either pool is exhausted
+   */
+  RedisRAII raii(acquireTimeout());
+  if (!checkAcquired(raii, ServiceType::SERVICE_TEXTCHATMSGRESPONSE, session)) {
+    return;
+  }
+
+  /*persist every message once, no matter how many members this group has*/
+  {
+    MySQLRAII mysql(mysql::MySQLShardRouter::get_instance()->route(thread_id),
+                    acquireTimeout());
+    if (!checkAcquired(mysql, ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
+                       session)) {
+      return;
+    }
+    if (!mysql->get()->createGroupChattingHistoryRecord(updated_msg)) {
+      generateErrorMessage("DataBase Operation Failed!",
+                           ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
+                           ServiceStatus::MYSQL_INTERNAL_ERROR, session);
+      return;
+    }
+  }
+
+  mysql::MySQLReplicaRouter::get_instance()->wrote(sender_uuid);
+
+  chat::ChatSearchIndex::get_instance()->index(updated_msg);
+
+  /*keep the newest messages of this thread hot*/
+  {
+    chat::RecentMessageCache::get_instance()->append(raii, updated_msg);
+
+    /*move this thread to the top of every member's thread list*/
+    chat::ChatThreadIndex::get_instance()->touch(
+        raii, **members_op, chat::ChatThreadMeta::createGroupChat(thread_id));
+
+    /*sender has read its own messages*/
+    std::vector<std::string> readers;
+    readers.reserve((*members_op)->size());
+    std::copy_if((*members_op)->begin(), (*members_op)->end(),
+                 std::back_inserter(readers),
+                 [&sender_uuid](const std::string &uuid) {
+                   return uuid != sender_uuid;
+                 });
+    chat::ReadCursorManager::get_instance()->addUnread(raii, thread_id,
+                                                      readers, updated_msg);
+  }
+
+  // Inter-server
+  boost::json::array updated_arr;
+
+  // Unique_id <-> msg_id mapping relation
+  boost::json::array mapping_arr;
+
+  // Cross-server: shared by all remote chatting servers
+  message::GroupChattingTextMsgRequest grpc_req;
+  grpc_req.set_src_uuid(sender_uuid);
+  grpc_req.set_thread_id(thread_id);
+
+  for (auto &item : updated_msg) {
+    boost::json::object obj;
+    boost::json::object mapping;
+
+    message::ChattingHistoryData *data_item = grpc_req.add_lists();
+    data_item->set_msg_type(static_cast<uint32_t>(item->msg_type));
+    data_item->set_msg_status(item->status);
+    data_item->set_msg_sender(item->msg_sender);
+    data_item->set_msg_receiver(item->msg_receiver);
+    data_item->set_msg_id(item->message_id);
+    data_item->set_thread_id(item->thread_id);
+    data_item->set_unique_id(item->unique_id);
+    data_item->set_msg_content(item->msg_content);
+
+    obj["msg_type"] = static_cast<uint32_t>(item->msg_type);
+    obj["msg_status"] = static_cast<uint32_t>(item->status);
+    obj["msg_sender"] = item->msg_sender;
+    obj["msg_receiver"] = item->msg_receiver;
+    obj["msg_id"] = item->message_id;
+    obj["thread_id"] = thread_id;
+    obj["unique_id"] = item->unique_id;
+    obj["msg_content"] = item->msg_content;
+
+    mapping["thread_id"] = thread_id;
+    mapping["unique_id"] = item->unique_id;
+    mapping["msg_id"] = item->message_id;
+
+    updated_arr.push_back(std::move(obj));
+    mapping_arr.push_back(std::move(mapping));
+  }
+
+  /*
+   * Response SERVICE_SUCCESS to the text msg sender
+   * Current session should receive a successful response first
+   */
+  boost::json::object result_root; // reponse status to sender
+  result_root["error"] =
+      static_cast<std::size_t>(ServiceStatus::SERVICE_SUCCESS);
+  result_root["chat_type"] = std::string("GROUP");
+  result_root["text_sender"] = sender_uuid;
+  result_root["text_receiver"] = thread_id;
+  result_root["verified_msg"] = mapping_arr;
+
+  session->sendMessage(ServiceType::SERVICE_TEXTCHATMSGRESPONSE,
+                       boost::json::serialize(result_root), session);
+
+  /*every member except the sender is a receiver*/
+  std::vector<std::string> receivers;
+  receivers.reserve((*members_op)->size());
+  std::copy_if((*members_op)->begin(), (*members_op)->end(),
+               std::back_inserter(receivers),
+               [&sender_uuid](const std::string &uuid) {
+                 return uuid != sender_uuid;
+               });
+
+  if (receivers.empty()) {
+    return;
+  }
+
+  /*local routing cache first, the rest of receivers share one MGET*/
+  std::vector<std::string> offline;
+  std::unordered_map<std::string, std::vector<std::string>> servers;
+  servers = user::RoutingCache::get_instance()->groupByServer(
+      raii, receivers, offline);
+
+  /*every local receiver gets the same packet, serialize it only once*/
+  boost::json::object dst_root;
+  dst_root["error"] = static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS);
+  dst_root["chat_type"] = std::string("GROUP");
+  dst_root["thread_id"] = thread_id;
+  dst_root["text_sender"] = sender_uuid;
+  dst_root["text_receiver"] = thread_id;
+  dst_root["text_msg"] = std::move(updated_arr);
+  const std::string payload = boost::json::serialize(dst_root);
+
+  for (auto &[server, uuids] : servers) {
+
+    /*Is target user and msg text sender on the same server*/
+    if (server == ServerConfig::get_instance()->GrpcServerName) {
+      for (const auto &uuid : uuids) {
+        auto receiver_session = UserManager::get_instance()->getSession(uuid);
+        if (!receiver_session.has_value()) {
+          offline.push_back(uuid);
+          continue;
+        }
+
+        /*propagate the message to dst user*/
+        (*receiver_session)
+            ->sendMessage(ServiceType::SERVICE_TEXTCHATMSGICOMINGREQUEST,
+                          payload, *receiver_session);
+      }
+      continue;
+    }
+
+    /*one batched grpc call for all receivers located on this server*/
+    message::GroupChattingTextMsgRequest server_req = grpc_req;
+    for (const auto &uuid : uuids) {
+      server_req.add_dst_uuids(uuid);
+    }
+
+    auto response =
+        gRPCDistributedChattingService::get_instance()->sendGroupChattingTextMsg(
+            server, server_req);
+
+    if (response.error() !=
+        static_cast<std::size_t>(ServiceStatus::SERVICE_SUCCESS)) {
+      spdlog::warn("[gRPC {}]: Failed to forward group message from {} to {} "
+                   "members of thread {} (server: {})",
+                   ServerConfig::get_instance()->GrpcServerName, sender_uuid,
+                   uuids.size(), thread_id, server);
+      offline.insert(offline.end(), uuids.begin(), uuids.end());
+      continue;
+    }
+
+    offline.insert(offline.end(), response.offline_uuids().begin(),
+                   response.offline_uuids().end());
+  }
+
+  /*offline members receive these messages once they login again*/
+  if (!offline.empty()) {
+    chat::OfflineInbox::get_instance()->push(raii, offline, updated_msg);
+  }
+
+  spdlog::info("[{}]: Group Thread ID = {} Message From {} Delivered To {} "
+               "Servers, {} Members Offline",
+               ServerConfig::get_instance()->GrpcServerName, thread_id,
+               sender_uuid, servers.size(), offline.size());
+}
@@ -0,0 +1,646 @@
+#include <algorithm>
+#include <chat/ChatSearchIndex.hpp>
+#include <chat/MessageIdGenerator.hpp>
+#include <chat/MessageTokenizer.hpp>
+#include <cmath>
+#include <config/ServerConfig.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLShardRouter.hpp>
+#include <tools/tools.hpp>
+#include <unordered_map>
+
+chat::ChatSearchIndex::ChatSearchIndex()
+    : m_stop(false), m_dir(ServerConfig::get_instance()->ChatSearchDirectory),
+      m_batch_size(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ChatSearchScanBatchSize)),
+      m_flush_threshold(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ChatSearchFlushThreshold)),
+      m_max_segments(std::max<std::size_t>(
+          2, ServerConfig::get_instance()->ChatSearchMaxSegments)),
+      m_merge_factor(std::max<std::size_t>(
+          2, ServerConfig::get_instance()->ChatSearchMergeFactor)),
+      m_max_segment_bytes(
+          ServerConfig::get_instance()->ChatSearchMaxSegmentSize << 20),
+      m_refresh_interval(
+          ServerConfig::get_instance()->ChatSearchRefreshInterval),
+      m_tail_lag(ServerConfig::get_instance()->ChatSearchTailLag),
+      m_flush_requested(false) {
+
+  loadSegments();
+
+  spdlog::info("[{}] Chat Search Index Loaded {} Segments, Watermark = {}",
+               ServerConfig::get_instance()->GrpcServerName,
+               m_segments.size(), m_watermark);
+
+  /*catching up with MySQL might take a while, do not block startup*/
+  m_worker = std::thread([this]() { worker(); });
+}
+
+chat::ChatSearchIndex::~ChatSearchIndex() { shutdown(); }
+
+void chat::ChatSearchIndex::shutdown() {
+  if (m_stop.exchange(true)) {
+    return;
+  }
+
+  m_cv.notify_all();
+  if (m_worker.joinable()) {
+    m_worker.join();
+  }
+
+  /*postings in memory could be rebuilt from MySQL, flush saves the work*/
+  flush();
+}
+
+void chat::ChatSearchIndex::index(
+    const std::vector<std::shared_ptr<chat::MsgInfo>> &info) {
+  bool full = false;
+  {
+    std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+    for (const auto &item : info) {
+      if (!item->isVerified) {
+        continue;
+      }
+      auto thread_id = tools::string_to_value<std::uint64_t>(item->thread_id);
+      auto msg_id = tools::string_to_value<std::uint64_t>(item->message_id);
+      if (!thread_id.has_value() || !msg_id.has_value()) {
+        continue;
+      }
+      add(*thread_id, *msg_id, item->msg_content);
+    }
+    full = m_memory_postings >= m_flush_threshold;
+  }
+
+  if (full && !m_flush_requested.exchange(true)) {
+    m_cv.notify_one();
+  }
+}
+
+void chat::ChatSearchIndex::add(const std::uint64_t thread_id,
+                                const std::uint64_t msg_id,
+                                std::string_view content) {
+  std::map<std::string, std::uint32_t> terms;
+  for (auto &term : MessageTokenizer::tokenize(content)) {
+    ++terms[std::move(term)];
+  }
+
+  for (auto &[term, tf] : terms) {
+    auto &list = m_memory[TermKey(thread_id, term)];
+
+    /*messages arrive in id order mostly, append is the common case*/
+    if (list.empty() || list.back().msg_id < msg_id) {
+      list.push_back(Posting{msg_id, tf});
+    } else {
+      auto it = std::lower_bound(list.begin(), list.end(), msg_id,
+                                 [](const Posting &p, const std::uint64_t id) {
+                                   return p.msg_id < id;
+                                 });
+      if (it != list.end() && it->msg_id == msg_id) {
+        continue;
+      }
+      list.insert(it, Posting{msg_id, tf});
+    }
+    ++m_memory_postings;
+  }
+}
+
+chat::ChatSearchIndex::PostingList
+chat::ChatSearchIndex::collect(const TermKey &key) const {
+  PostingList ret;
+  for (const auto &segment : m_segments) {
+    auto it = segment->terms.find(key);
+    if (it != segment->terms.end()) {
+      mergePostings(ret, decodePostings(*segment, it->second.first,
+                                        it->second.second));
+    }
+  }
+
+  for (const PostingMap *map : {m_frozen.get(), &m_memory}) {
+    if (map == nullptr) {
+      continue;
+    }
+    if (auto it = map->find(key); it != map->end()) {
+      mergePostings(ret, it->second);
+    }
+  }
+  return ret;
+}
+
+chat::ChatSearchIndex::SearchResult
+chat::ChatSearchIndex::search(const std::uint64_t thread_id,
+                              std::string_view keyword,
+                              const std::size_t offset,
+                              const std::size_t limit) const {
+  SearchResult ret;
+
+  auto tokens = MessageTokenizer::tokenize(keyword);
+  std::sort(tokens.begin(), tokens.end());
+  tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+  if (tokens.empty()) {
+    return ret;
+  }
+
+  std::vector<PostingList> lists;
+  lists.reserve(tokens.size());
+  {
+    std::shared_lock<std::shared_mutex> _lckg(m_index_mtx);
+    for (const auto &token : tokens) {
+      lists.push_back(collect(TermKey(thread_id, token)));
+
+      /*every term is required*/
+      if (lists.back().empty()) {
+        return ret;
+      }
+    }
+  }
+
+  /*intersect from the rarest term, candidates only shrink*/
+  std::sort(lists.begin(), lists.end(),
+            [](const auto &lhs, const auto &rhs) {
+              return lhs.size() < rhs.size();
+            });
+
+  const double max_df = static_cast<double>(lists.back().size());
+  auto weight = [max_df](const PostingList &list, const std::uint32_t tf) {
+    /*rare terms count more, repeated terms saturate*/
+    const double idf = std::log(1.0 + max_df / list.size());
+    return idf * tf / (tf + 1.0);
+  };
+
+  std::unordered_map<std::uint64_t, double> scores;
+  for (const auto &posting : lists.front()) {
+    scores.emplace(posting.msg_id, weight(lists.front(), posting.tf));
+  }
+
+  for (std::size_t i = 1; i < lists.size() && !scores.empty(); ++i) {
+    std::unordered_map<std::uint64_t, double> next;
+    for (const auto &posting : lists[i]) {
+      if (auto it = scores.find(posting.msg_id); it != scores.end()) {
+        next.emplace(posting.msg_id,
+                     it->second + weight(lists[i], posting.tf));
+      }
+    }
+    scores = std::move(next);
+  }
+
+  std::vector<std::pair<double, std::uint64_t>> ranked;
+  ranked.reserve(scores.size());
+  for (const auto &[msg_id, score] : scores) {
+    ranked.emplace_back(score, msg_id);
+  }
+  std::sort(ranked.begin(), ranked.end(), [](const auto &lhs, const auto &rhs) {
+    return lhs.first != rhs.first ? lhs.first > rhs.first
+                                  : lhs.second > rhs.second;
+  });
+
+  ret.total = ranked.size();
+  for (std::size_t i = offset; i < ranked.size() && i - offset < limit; ++i) {
+    ret.msg_ids.push_back(ranked[i].second);
+  }
+  return ret;
+}
+
+bool chat::ChatSearchIndex::loadNewMessages() {
+  std::uint64_t after{};
+  {
+    std::shared_lock<std::shared_mutex> _lckg(m_index_mtx);
+    after = m_watermark;
+  }
+
+  const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  const std::uint64_t before = MessageIdGenerator::lowerBound(
+      static_cast<std::uint64_t>(now - m_tail_lag.count()));
+
+  if (before <= after) {
+    return false;
+  }
+
+  /*
+   * every shard returns its first batch in id order, the first batch of the
+   * merged result is complete, the rest is fetched again next round
+   */
+  std::vector<std::unique_ptr<chat::MsgInfo>> list;
+  auto shards = mysql::MySQLShardRouter::get_instance()->getShards();
+  for (const auto &pool : shards) {
+    MySQLRAII mysql(pool);
+    auto part =
+        mysql->get()->getChattingHistoryAfter(after, before, m_batch_size);
+    if (!part.has_value()) {
+      return false;
+    }
+    std::move(part->begin(), part->end(), std::back_inserter(list));
+  }
+
+  auto id_of = [](const std::unique_ptr<chat::MsgInfo> &item) {
+    return tools::string_to_value<std::uint64_t>(item->message_id)
+        .value_or(0);
+  };
+  std::sort(list.begin(), list.end(),
+            [&id_of](const auto &lhs, const auto &rhs) {
+              return id_of(lhs) < id_of(rhs);
+            });
+  if (list.size() > m_batch_size) {
+    list.resize(m_batch_size);
+  }
+
+  if (list.empty()) {
+    return false;
+  }
+
+  {
+    std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+    std::uint64_t watermark = m_watermark;
+    for (const auto &item : list) {
+      auto thread_id = tools::string_to_value<std::uint64_t>(item->thread_id);
+      auto msg_id = tools::string_to_value<std::uint64_t>(item->message_id);
+      if (!thread_id.has_value() || !msg_id.has_value()) {
+        continue;
+      }
+      add(*thread_id, *msg_id, item->msg_content);
+      watermark = std::max(watermark, *msg_id);
+    }
+    m_watermark = watermark;
+  }
+
+  /*a full batch means there might be more*/
+  return list.size() >= m_batch_size;
+}
+
+void chat::ChatSearchIndex::worker() {
+  auto maintain = [this]() {
+    bool full{}, crowded{};
+    {
+      std::shared_lock<std::shared_mutex> _lckg(m_index_mtx);
+      full = m_memory_postings >= m_flush_threshold;
+    }
+    m_flush_requested = false;
+    if (full) {
+      flush();
+    }
+    {
+      std::shared_lock<std::shared_mutex> _lckg(m_index_mtx);
+      crowded = m_segments.size() > m_max_segments;
+    }
+    if (crowded) {
+      merge();
+    }
+  };
+
+  while (!m_stop) {
+    /*memory is flushed during a long catch up as well*/
+    while (!m_stop && loadNewMessages()) {
+      maintain();
+    }
+    maintain();
+
+    std::unique_lock<std::mutex> _lckg(m_mtx);
+    m_cv.wait_for(_lckg, m_refresh_interval, [this]() {
+      return m_stop.load() || m_flush_requested.load();
+    });
+  }
+}
+
+bool chat::ChatSearchIndex::flush() {
+  std::uint64_t id{}, watermark{};
+  std::shared_ptr<const PostingMap> frozen;
+  {
+    std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+    if (m_memory.empty()) {
+      return true;
+    }
+
+    /*writers continue with an empty map, frozen postings stay searchable*/
+    frozen = std::make_shared<const PostingMap>(std::move(m_memory));
+    m_memory = PostingMap{};
+    m_memory_postings = 0;
+    m_frozen = frozen;
+    id = m_next_segment++;
+    watermark = m_watermark;
+  }
+
+  const auto path = segmentPath(id);
+  std::optional<Segment> segment;
+  if (writeSegment(path, *frozen, watermark)) {
+    segment = readSegment(path);
+  }
+
+  std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+  if (!segment.has_value()) {
+    /*keep postings in memory, they will be flushed next time*/
+    for (const auto &[key, list] : *frozen) {
+      mergePostings(m_memory[key], list);
+      m_memory_postings += list.size();
+    }
+    m_frozen.reset();
+
+    spdlog::error("[{}] Chat Search Index Flush Segment {} Failed!",
+                  ServerConfig::get_instance()->GrpcServerName, path);
+    return false;
+  }
+
+  segment->id = id;
+  m_segments.push_back(std::make_shared<const Segment>(std::move(*segment)));
+  m_frozen.reset();
+  return true;
+}
+
+bool chat::ChatSearchIndex::merge() {
+  std::vector<SegmentPtr> candidates;
+  std::uint64_t id{};
+  {
+    std::shared_lock<std::shared_mutex> _lckg(m_index_mtx);
+    candidates = m_segments;
+  }
+
+  /*
+   * size-tiered, the smallest segments are merged first, so a posting is
+   * rewritten once per size tier instead of on every merge
+   */
+  std::sort(candidates.begin(), candidates.end(),
+            [](const SegmentPtr &lhs, const SegmentPtr &rhs) {
+              return lhs->data.size() < rhs->data.size();
+            });
+
+  std::vector<SegmentPtr> sources;
+  std::size_t bytes = 0;
+  for (const auto &segment : candidates) {
+    if (sources.size() >= m_merge_factor ||
+        bytes + segment->data.size() > m_max_segment_bytes) {
+      break;
+    }
+    bytes += segment->data.size();
+    sources.push_back(segment);
+  }
+
+  /*every segment is large enough already*/
+  if (sources.size() < 2) {
+    return true;
+  }
+
+  PostingMap merged;
+  std::uint64_t watermark = 0;
+  for (const auto &segment : sources) {
+    watermark = std::max(watermark, segment->watermark);
+    for (const auto &[key, location] : segment->terms) {
+      mergePostings(merged[key], decodePostings(*segment, location.first,
+                                                location.second));
+    }
+  }
+
+  {
+    std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+    id = m_next_segment++;
+  }
+
+  const auto path = segmentPath(id);
+  std::optional<Segment> segment;
+  if (writeSegment(path, merged, watermark)) {
+    segment = readSegment(path);
+  }
+
+  if (!segment.has_value()) {
+    spdlog::error("[{}] Chat Search Index Merge Segments Into {} Failed!",
+                  ServerConfig::get_instance()->GrpcServerName, path);
+    return false;
+  }
+  segment->id = id;
+
+  {
+    /*only this thread removes segments, every source is still there*/
+    std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+    m_segments.erase(std::remove_if(m_segments.begin(), m_segments.end(),
+                                    [&sources](const SegmentPtr &segment) {
+                                      return std::find(sources.begin(),
+                                                       sources.end(),
+                                                       segment) !=
+                                             sources.end();
+                                    }),
+                     m_segments.end());
+    m_segments.push_back(std::make_shared<const Segment>(std::move(*segment)));
+  }
+
+  std::error_code ec;
+  for (const auto &source : sources) {
+    std::filesystem::remove(source->path, ec);
+  }
+
+  spdlog::info("[{}] Chat Search Index Merged {} Segments Into {}",
+               ServerConfig::get_instance()->GrpcServerName, sources.size(),
+               path);
+  return true;
+}
+
+void chat::ChatSearchIndex::loadSegments() {
+  std::error_code ec;
+  std::filesystem::create_directories(m_dir, ec);
+
+  std::vector<std::pair<std::uint64_t, std::string>> files;
+  for (const auto &entry : std::filesystem::directory_iterator(m_dir, ec)) {
+    const auto name = entry.path().filename().string();
+
+    /*segment which was not completely written*/
+    if (entry.path().extension() == ".tmp") {
+      std::filesystem::remove(entry.path(), ec);
+      continue;
+    }
+
+    if (name.rfind("segment_", 0) || entry.path().extension() != ".idx") {
+      continue;
+    }
+
+    auto id = tools::string_to_value<std::uint64_t>(
+        entry.path().stem().string().substr(std::strlen("segment_")));
+    if (id.has_value()) {
+      files.emplace_back(*id, entry.path().string());
+    }
+  }
+  std::sort(files.begin(), files.end());
+
+  bool corrupted = false;
+  for (const auto &[id, path] : files) {
+    auto segment = readSegment(path);
+    m_next_segment = std::max(m_next_segment, id + 1);
+
+    if (!segment.has_value()) {
+      spdlog::warn("[{}] Chat Search Index Drop Corrupted Segment {}",
+                   ServerConfig::get_instance()->GrpcServerName, path);
+      std::filesystem::remove(path, ec);
+      corrupted = true;
+      continue;
+    }
+
+    segment->id = id;
+    m_watermark = std::max(m_watermark, segment->watermark);
+    m_segments.push_back(std::make_shared<const Segment>(std::move(*segment)));
+  }
+
+  /*
+   * messages of the lost segment are unknown, rebuild from the beginning,
+   * postings which are already inside other segments are deduplicated
+   */
+  if (corrupted) {
+    m_watermark = 0;
+  }
+}
+
+std::string chat::ChatSearchIndex::segmentPath(const std::uint64_t id) const {
+  return (std::filesystem::path(m_dir) /
+          ("segment_" + tools::zeroPadding(id) + ".idx"))
+      .string();
+}
+
+bool chat::ChatSearchIndex::writeSegment(const std::string &path,
+                                         const PostingMap &postings,
+                                         const std::uint64_t watermark) {
+  std::string out(magic);
+  tools::putVarint(out, watermark);
+  tools::putVarint(out, postings.size());
+
+  std::string buffer;
+  for (const auto &[key, list] : postings) {
+    tools::putVarint(out, key.first);
+    tools::putVarint(out, key.second.size());
+    out.append(key.second);
+    tools::putVarint(out, list.size());
+
+    /*ids of one thread are close to each other, deltas are small*/
+    buffer.clear();
+    std::uint64_t last = 0;
+    for (const auto &posting : list) {
+      tools::putVarint(buffer, posting.msg_id - last);
+      tools::putVarint(buffer, posting.tf);
+      last = posting.msg_id;
+    }
+    tools::putVarint(out, buffer.size());
+    out.append(buffer);
+  }
+
+  /*write to a temporary file first, a segment is either complete or absent*/
+  const auto tmp = path + ".tmp";
+  std::FILE *file = std::fopen(tmp.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+
+  const bool success = std::fwrite(out.data(), 1, out.size(), file) ==
+                           out.size() &&
+                       !std::fflush(file) && !tools::syncFile(file);
+  std::fclose(file);
+
+  std::error_code ec;
+  if (success) {
+    std::filesystem::rename(tmp, path, ec);
+  }
+  if (!success || ec) {
+    std::filesystem::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+std::optional<chat::ChatSearchIndex::Segment>
+chat::ChatSearchIndex::readSegment(const std::string &path) {
+  Segment segment;
+  segment.path = path;
+
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    return std::nullopt;
+  }
+  segment.data.assign(std::istreambuf_iterator<char>(in),
+                      std::istreambuf_iterator<char>());
+
+  std::string_view data(segment.data);
+  const std::size_t magic_length = std::strlen(magic);
+  if (data.substr(0, magic_length) != magic) {
+    return std::nullopt;
+  }
+
+  std::size_t pos = magic_length;
+  std::uint64_t count{};
+  if (!tools::getVarint(data, pos, segment.watermark) ||
+      !tools::getVarint(data, pos, count)) {
+    return std::nullopt;
+  }
+
+  for (std::uint64_t i = 0; i < count; ++i) {
+    std::uint64_t thread_id{}, length{}, postings{}, bytes{};
+    if (!tools::getVarint(data, pos, thread_id) ||
+        !tools::getVarint(data, pos, length) || length > data.size() - pos) {
+      return std::nullopt;
+    }
+
+    std::string term(data.substr(pos, length));
+    pos += length;
+
+    if (!tools::getVarint(data, pos, postings) ||
+        !tools::getVarint(data, pos, bytes) || bytes > data.size() - pos) {
+      return std::nullopt;
+    }
+
+    segment.terms.emplace(TermKey(thread_id, std::move(term)),
+                          std::make_pair(pos, postings));
+    pos += bytes;
+  }
+
+  /*trailing garbage means the file is not what we wrote*/
+  if (pos != data.size()) {
+    return std::nullopt;
+  }
+  return segment;
+}
+
+chat::ChatSearchIndex::PostingList
+chat::ChatSearchIndex::decodePostings(const Segment &segment,
+                                      const std::size_t offset,
+                                      const std::size_t count) {
+  PostingList ret;
+  ret.reserve(count);
+
+  std::size_t pos = offset;
+  std::uint64_t last = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    std::uint64_t delta{}, tf{};
+    if (!tools::getVarint(segment.data, pos, delta) ||
+        !tools::getVarint(segment.data, pos, tf)) {
+      break;
+    }
+    last += delta;
+    ret.push_back(Posting{last, static_cast<std::uint32_t>(tf)});
+  }
+  return ret;
+}
+
+void chat::ChatSearchIndex::mergePostings(PostingList &dst,
+                                          const PostingList &src) {
+  if (src.empty()) {
+    return;
+  }
+  if (dst.empty() || dst.back().msg_id < src.front().msg_id) {
+    dst.insert(dst.end(), src.begin(), src.end());
+    return;
+  }
+
+  PostingList merged;
+  merged.reserve(dst.size() + src.size());
+  auto lhs = dst.cbegin();
+  auto rhs = src.cbegin();
+  while (lhs != dst.end() || rhs != src.end()) {
+    if (rhs == src.end() || (lhs != dst.end() && lhs->msg_id < rhs->msg_id)) {
+      merged.push_back(*lhs++);
+    } else if (lhs == dst.end() || rhs->msg_id < lhs->msg_id) {
+      merged.push_back(*rhs++);
+    } else {
+      merged.push_back(*lhs++);
+      ++rhs;
+    }
+  }
+  dst = std::move(merged);
+}
@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <chat/ChatThreadIndex.hpp>
+#include <chrono>
+#include <config/ServerConfig.hpp>
+#include <redis/AsyncRedisClient.hpp>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <sql/MySQLShardRouter.hpp>
+#include <tools/tools.hpp>
+
+/*chat threads of a user ordered by activity*/
+std::string chat::ChatThreadIndex::index_prefix = "user_threads_";
+
+/*thread_id -> thread type and participants*/
+std::string chat::ChatThreadIndex::meta_prefix = "user_threads_meta_";
+
+chat::ChatThreadIndex::ChatThreadIndex()
+    : m_ttl(ServerConfig::get_instance()->ThreadIndexTTL) {}
+
+std::size_t chat::ChatThreadIndex::currentMilliseconds() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string chat::ChatThreadIndex::encode(const chat::ChatThreadMeta &meta) {
+  if (meta.isGroupChat()) {
+    return "GROUP";
+  }
+  return "PRIVATE:" + meta._user_one.value_or("") + ":" +
+         meta._user_two.value_or("");
+}
+
+std::optional<std::unique_ptr<chat::ChatThreadMeta>>
+chat::ChatThreadIndex::decode(const std::string &thread_id,
+                              const std::string &meta) {
+  if (meta == "GROUP") {
+    return std::make_unique<chat::ChatThreadMeta>(thread_id,
+                                                  chat::UserChatType::GROUP);
+  }
+
+  /*PRIVATE:user1:user2*/
+  auto first = meta.find(':');
+  auto second = meta.find(':', first + 1);
+  if (meta.compare(0, first, "PRIVATE") || first == std::string::npos ||
+      second == std::string::npos) {
+    return std::nullopt;
+  }
+
+  return std::make_unique<chat::ChatThreadMeta>(
+      thread_id, chat::UserChatType::PRIVATE,
+      meta.substr(first + 1, second - first - 1), meta.substr(second + 1));
+}
+
+void chat::ChatThreadIndex::touch([[maybe_unused]] RedisRAII &raii,
+                                  const std::vector<std::string> &uuids,
+                                  const chat::ChatThreadMeta &meta) {
+
+  const auto score = std::to_string(currentMilliseconds());
+  const auto value = encode(meta);
+
+  /*all participants are updated within one round trip*/
+  std::vector<std::vector<std::string>> commands;
+  commands.reserve(uuids.size());
+  for (const auto &uuid : uuids) {
+    const auto tag = redis::hashTag(uuid);
+    commands.push_back({"EVAL", touch_lua_script, "2", index_prefix + tag,
+                        meta_prefix + tag, score, meta._thread_id, value});
+  }
+
+  /*sender does not wait for redis, the index is not on its reply path*/
+  redis::AsyncRedisClient::get_instance()->asyncPipeline(
+      std::move(commands),
+      [thread_id = meta._thread_id](
+          const boost::system::error_code &ec,
+          const std::vector<redis::AsyncReply> &replies) {
+        auto failed = std::any_of(replies.begin(), replies.end(),
+                                  [](const auto &r) { return r.isError(); });
+        if (ec || failed) {
+          spdlog::warn("[{}] Thread ID = {} Update Chat Thread Index Failed!",
+                       ServerConfig::get_instance()->GrpcServerName,
+                       thread_id);
+        }
+      });
+}
+
+std::optional<std::vector<chat::ChatThreadIndex::Entry>>
+chat::ChatThreadIndex::rebuild([[maybe_unused]] RedisRAII &raii,
+                               const std::size_t uuid) {
+
+  std::optional<std::vector<
+      std::pair<std::unique_ptr<chat::ChatThreadMeta>, std::size_t>>>
+      threads;
+  {
+    MySQLRAII mysql(mysql::MySQLReplicaRouter::get_instance()->read(uuid));
+    threads = mysql->get()->getUserChattingThreadsByActivity(uuid);
+  }
+  if (!threads.has_value()) {
+    return std::nullopt;
+  }
+
+  /*messages of a sharded thread are not on primary, ask its owner*/
+  auto router = mysql::MySQLShardRouter::get_instance();
+  const auto primary = mysql::MySQLConnectionPool::get_instance();
+
+  std::vector<Entry> entries;
+  entries.reserve(threads->size());
+  for (auto &[meta, last_active] : threads.value()) {
+    if (auto pool = router->route(meta->_thread_id); pool != primary) {
+      auto thread_id = tools::string_to_value<std::size_t>(meta->_thread_id);
+      MySQLRAII shard(pool);
+      auto activity = shard->get()->getThreadLastActivity(*thread_id);
+      last_active = std::max(last_active, activity.value_or(0));
+    }
+    entries.push_back(
+        Entry{meta->_thread_id, encode(*meta), last_active * 1000});
+  }
+
+  /*the same order as ZREVRANGE*/
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry &lhs, const Entry &rhs) {
+              return lhs.score != rhs.score ? lhs.score > rhs.score
+                                            : lhs.thread_id > rhs.thread_id;
+            });
+
+  const auto index = index_prefix + redis::hashTag(std::to_string(uuid));
+  const auto meta = meta_prefix + redis::hashTag(std::to_string(uuid));
+
+  std::vector<std::string> zadd{"ZADD", index, "0", sentinel};
+  std::vector<std::string> hset{"HSET", meta};
+  for (const auto &entry : entries) {
+    zadd.push_back(std::to_string(entry.score));
+    zadd.push_back(entry.thread_id);
+    hset.push_back(entry.thread_id);
+    hset.push_back(entry.meta);
+  }
+
+  /*meta must be ready before index becomes visible*/
+  std::vector<std::vector<std::string>> commands{{"DEL", index, meta}};
+  if (!entries.empty()) {
+    commands.push_back(std::move(hset));
+  }
+  commands.push_back(std::move(zadd));
+  commands.push_back({"EXPIRE", index, std::to_string(m_ttl)});
+  commands.push_back({"EXPIRE", meta, std::to_string(m_ttl)});
+
+  if (!raii->get()->pipeline(commands)) {
+    raii->get()->delPair(index);
+    spdlog::warn("[{}] UUID = {} Rebuild Chat Thread Index Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, uuid);
+  }
+  return entries;
+}
+
+std::optional<std::vector<std::unique_ptr<chat::ChatThreadMeta>>>
+chat::ChatThreadIndex::getPage([[maybe_unused]] RedisRAII &raii,
+                               const std::size_t uuid,
+                               const std::size_t cur_thread_id,
+                               const std::size_t interval,
+                               std::string &next_thread_id, bool &is_EOF) {
+
+  const auto cursor = std::to_string(cur_thread_id);
+  std::vector<std::unique_ptr<chat::ChatThreadMeta>> list;
+
+  /*interval + 1 to find out whether it is the end*/
+  auto reply = raii->get()->evalScript(
+      page_lua_script,
+      {index_prefix + redis::hashTag(std::to_string(uuid)),
+       meta_prefix + redis::hashTag(std::to_string(uuid))},
+      {cursor, std::to_string(interval + 1), std::to_string(m_ttl)});
+
+  if (reply.has_value()) {
+    for (std::size_t i = 0; i + 1 < reply->size(); i += 2) {
+      if (!(*reply)[i].has_value() || !(*reply)[i + 1].has_value()) {
+        continue;
+      }
+      auto item = decode((*reply)[i].value(), (*reply)[i + 1].value());
+      if (item.has_value()) {
+        list.push_back(std::move(item.value()));
+      }
+    }
+  } else {
+    /*cold index, page is cut from MySQL result directly*/
+    auto entries = rebuild(raii, uuid);
+    if (!entries.has_value()) {
+      return std::nullopt;
+    }
+
+    auto it = entries->begin();
+    if (cur_thread_id) {
+      it = std::find_if(entries->begin(), entries->end(),
+                        [&cursor](const Entry &entry) {
+                          return entry.thread_id == cursor;
+                        });
+      if (it != entries->end()) {
+        ++it;
+      }
+    }
+
+    for (; it != entries->end() && list.size() <= interval; ++it) {
+      auto item = decode(it->thread_id, it->meta);
+      if (item.has_value()) {
+        list.push_back(std::move(item.value()));
+      }
+    }
+  }
+
+  is_EOF = list.size() <= interval;
+  if (!is_EOF) {
+    list.pop_back();
+  }
+
+  next_thread_id = list.empty() ? cursor : list.back()->_thread_id;
+  return list;
+}
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chat/GroupMemberCache.hpp>
+#include <config/ServerConfig.hpp>
+#include <spdlog/spdlog.h>
+#include <tools/tools.hpp>
+
+/*store group members in redis set*/
+std::string chat::GroupMemberCache::group_prefix = "group_member_";
+
+chat::GroupMemberCache::GroupMemberCache()
+    : m_ttl(ServerConfig::get_instance()->GroupMemberCacheTTL) {}
+
+std::optional<chat::GroupMemberCache::MemberList>
+chat::GroupMemberCache::getMembers(const std::string &thread_id) {
+  {
+    decltype(m_groups)::const_accessor accessor;
+    if (m_groups.find(accessor, thread_id) &&
+        accessor->second.expire > std::chrono::steady_clock::now()) {
+      return accessor->second.members;
+    }
+  }
+
+  /*local cache miss or expired, try redis first and then mysql*/
+  auto members = loadFromRedis(thread_id);
+  if (!members.has_value()) {
+    members = loadFromMySQL(thread_id);
+  }
+
+  if (!members.has_value()) {
+    return std::nullopt;
+  }
+
+  store(thread_id, *members);
+  return members;
+}
+
+bool chat::GroupMemberCache::isMember(const MemberList &members,
+                                      const std::string &uuid) const {
+  return members && std::binary_search(members->begin(), members->end(), uuid);
+}
+
+void chat::GroupMemberCache::invalidate(const std::string &thread_id) {
+  m_groups.erase(thread_id);
+
+  RedisRAII raii;
+  raii->get()->delPair(group_prefix + thread_id);
+}
+
+std::optional<chat::GroupMemberCache::MemberList>
+chat::GroupMemberCache::loadFromRedis(const std::string &thread_id) {
+  RedisRAII raii;
+
+  auto members_op = raii->get()->getSetMembers(group_prefix + thread_id);
+  if (!members_op.has_value() || members_op->empty()) {
+    return std::nullopt;
+  }
+
+  auto members = std::move(members_op.value());
+  std::sort(members.begin(), members.end());
+  return std::make_shared<const std::vector<std::string>>(std::move(members));
+}
+
+std::optional<chat::GroupMemberCache::MemberList>
+chat::GroupMemberCache::loadFromMySQL(const std::string &thread_id) {
+  auto thread_id_op = tools::string_to_value<std::size_t>(thread_id);
+  if (!thread_id_op.has_value()) {
+    spdlog::warn("Casting string typed key to std::size_t!");
+    return std::nullopt;
+  }
+
+  std::optional<std::vector<std::string>> members_op;
+  {
+    MySQLRAII mysql;
+    members_op = mysql->get()->getGroupMembers(thread_id_op.value());
+  }
+
+  if (!members_op.has_value() || members_op->empty()) {
+    spdlog::warn("[{}] Group Thread ID = {} Has No Member!",
+                 ServerConfig::get_instance()->GrpcServerName, thread_id);
+    return std::nullopt;
+  }
+
+  auto members = std::move(members_op.value());
+  std::sort(members.begin(), members.end());
+
+  /*write data into redis as cache, other chatting servers could share it*/
+  RedisRAII raii;
+  const auto key = group_prefix + thread_id;
+  if (!raii->get()->addToSet(key, members) ||
+      !raii->get()->setExpire(key, m_ttl)) {
+    spdlog::warn("[{}] Group Thread ID = {} Write Members To Redis Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, thread_id);
+  }
+
+  return std::make_shared<const std::vector<std::string>>(std::move(members));
+}
+
+void chat::GroupMemberCache::store(const std::string &thread_id,
+                                   MemberList members) {
+  decltype(m_groups)::accessor accessor;
+  m_groups.insert(accessor, thread_id);
+  accessor->second.members = std::move(members);
+  accessor->second.expire =
+      std::chrono::steady_clock::now() + std::chrono::seconds(m_ttl);
+}
@@ -23,7 +23,13 @@ grpc::GrpcDistributedChattingImpl::~GrpcDistributedChattingImpl() {}
   response->set_kick_uuid(request->kick_uuid());
   response->set_error(static_cast<int32_t>(ServiceStatus::SERVICE_SUCCESS));
 
-  if (auto opt = UserManager::get_instance()->getSession(uuid_str); opt) {
+  /*
+   * user might have logined on this server again after kick request was
+   * sent, only the session which has been replaced is kicked
+   */
+  if (auto opt = UserManager::get_instance()->getSession(uuid_str);
+      opt && (request->kick_session_id().empty() ||
+              (*opt)->get_session_id() == request->kick_session_id())) {
     auto &session = *opt;
     session->sendOfflineMessage();
     session->terminateAndRemoveFromServer(uuid_str, session->get_session_id());
@@ -231,3 +237,58 @@ grpc::GrpcDistributedChattingImpl::~GrpcDistributedChattingImpl() {}
   }
   return grpc::Status::OK;
 }
+
+// transfer group chatting message from user A to group members on this server
+::grpc::Status grpc::GrpcDistributedChattingImpl::SendGroupChattingTextMsg(
+    ::grpc::ServerContext *context,
+    const ::message::GroupChattingTextMsgRequest *request,
+    ::message::GroupChattingTextMsgResponse *response) {
+
+  boost::json::array msg_array; /*try to parse grpc repeated array*/
+  boost::json::object dst_root; /*try to do message forwarding to members*/
+
+  auto &msg_lists = request->lists();
+  std::for_each(msg_lists.begin(), msg_lists.end(),
+                [&msg_array](decltype(*msg_lists.begin()) &item) {
+                  boost::json::object msg;
+                  msg["thread_id"] = item.thread_id();
+                  msg["msg_sender"] = item.msg_sender();
+                  msg["msg_receiver"] = item.msg_receiver();
+                  msg["msg_id"] = item.msg_id();
+                  msg["unique_id"] = item.unique_id();
+                  msg["msg_content"] = item.msg_content();
+                  msg_array.push_back(std::move(msg));
+                });
+
+  dst_root["error"] = static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS);
+  dst_root["chat_type"] = std::string("GROUP");
+  dst_root["thread_id"] = request->thread_id();
+  dst_root["text_sender"] = request->src_uuid();
+  dst_root["text_receiver"] = request->thread_id();
+  dst_root["text_msg"] = std::move(msg_array);
+
+  /*every member receives the same packet, serialize it only once*/
+  const std::string payload = boost::json::serialize(dst_root);
+
+  for (const auto &uuid : request->dst_uuids()) {
+    auto session_op = UserManager::get_instance()->getSession(uuid);
+    if (!session_op.has_value()) {
+      response->add_offline_uuids(uuid);
+      continue;
+    }
+    (*session_op)
+        ->sendMessage(ServiceType::SERVICE_TEXTCHATMSGICOMINGREQUEST, payload,
+                      *session_op);
+  }
+
+  if (response->offline_uuids_size()) {
+    spdlog::warn("[GRPC {} Service]: {} Group Members Of Thread ID = {} Not "
+                 "Found On This Server!",
+                 ServerConfig::get_instance()->GrpcServerName,
+                 response->offline_uuids_size(), request->thread_id());
+  }
+
+  response->set_thread_id(request->thread_id());
+  response->set_error(static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS));
+  return grpc::Status::OK;
+}
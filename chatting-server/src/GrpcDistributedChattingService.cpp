@@ -102,6 +102,67 @@ gRPCDistributedChattingService::forceTerminateLoginedUser(
   return response;
 }
 
+void gRPCDistributedChattingService::asyncForceTerminateLoginedUser(
+    const std::string &server_name, const message::TerminationRequest &req,
+    std::function<void(message::TerminationResponse)> callback) {
+
+  /*everything has to stay alive until the call finishes*/
+  struct Call {
+    grpc::ClientContext context;
+    message::TerminationRequest request;
+    message::TerminationResponse response;
+    std::shared_ptr<stubpool::DistributedChattingServicePool> pool;
+    std::unique_ptr<message::DistributedChattingService::Stub> stub;
+  };
+
+  message::TerminationResponse failed;
+  failed.set_error(static_cast<int32_t>(ServiceStatus::GRPC_ERROR));
+  failed.set_kick_uuid(req.kick_uuid());
+
+  /*get the connection pool of this server*/
+  auto server_op = getTargetChattingServer(server_name);
+  // server not found
+  if (!server_op.has_value()) {
+    spdlog::warn("[GRPC {} Service]: GRPC {} Not Found",
+                 ServerConfig::get_instance()->GrpcServerName, server_name);
+    callback(std::move(failed));
+    return;
+  }
+
+  /*get one connection stub from connection pool*/
+  auto stub_op = server_op.value()->acquire_stub();
+
+  // connection stub not found
+  if (!stub_op.has_value()) {
+    spdlog::warn("[GRPC {} Service]: Connection Stub Parse Error!",
+                 ServerConfig::get_instance()->GrpcServerName);
+    callback(std::move(failed));
+    return;
+  }
+
+  auto call = std::make_shared<Call>();
+  call->request = req;
+  call->pool = server_op.value();
+  call->stub = std::move(stub_op.value());
+  call->response.set_error(
+      static_cast<int32_t>(ServiceStatus::SERVICE_SUCCESS));
+  call->response.set_kick_uuid(req.kick_uuid());
+
+  call->stub->async()->ForceTerminateLoginedUser(
+      &call->context, &call->request, &call->response,
+      [call, callback = std::move(callback)](grpc::Status status) {
+        /*return this stub back*/
+        call->pool->release_stub(std::move(call->stub));
+
+        /*error occured*/
+        if (!status.ok()) {
+          call->response.set_error(
+              static_cast<int32_t>(ServiceStatus::GRPC_ERROR));
+        }
+        callback(std::move(call->response));
+      });
+}
+
 message::FriendResponse gRPCDistributedChattingService::sendFriendRequest(
     const std::string &server_name, const message::FriendRequest &req) {
   grpc::ClientContext context;
@@ -231,3 +292,49 @@ gRPCDistributedChattingService::sendChattingTextMsg(
 
   return response;
 }
+
+message::GroupChattingTextMsgResponse
+gRPCDistributedChattingService::sendGroupChattingTextMsg(
+    const std::string &server_name,
+    const message::GroupChattingTextMsgRequest &req) {
+  grpc::ClientContext context;
+  message::GroupChattingTextMsgResponse response;
+
+  response.set_error(static_cast<int32_t>(ServiceStatus::SERVICE_SUCCESS));
+  response.set_thread_id(req.thread_id());
+
+  /*get the connection pool of this server*/
+  auto server_op = getTargetChattingServer(server_name);
+
+  // server not found
+  if (!server_op.has_value()) {
+    spdlog::warn("[GRPC {} Service]: GRPC {} Not Found",
+                 ServerConfig::get_instance()->GrpcServerName, server_name);
+    response.set_error(static_cast<int32_t>(ServiceStatus::GRPC_ERROR));
+    return response;
+  }
+
+  /*get one connection stub from connection pool*/
+  auto stub_op = server_op.value()->acquire_stub();
+
+  // connection stub not found
+  if (!stub_op.has_value()) {
+    spdlog::warn("[GRPC {} Service]: Connection Stub Parse Error!",
+                 ServerConfig::get_instance()->GrpcServerName);
+    response.set_error(static_cast<int32_t>(ServiceStatus::GRPC_ERROR));
+    return response;
+  }
+
+  grpc::Status status =
+      stub_op.value().get()->SendGroupChattingTextMsg(&context, req, &response);
+
+  /*return this stub back*/
+  server_op.value()->release_stub(std::move(stub_op.value()));
+
+  ///*error occured*/
+  if (!status.ok()) {
+    response.set_error(static_cast<int32_t>(ServiceStatus::GRPC_ERROR));
+  }
+
+  return response;
+}
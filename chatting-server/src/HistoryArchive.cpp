@@ -0,0 +1,420 @@
+#include <algorithm>
+#include <chat/HistoryArchive.hpp>
+#include <chat/MessageIdGenerator.hpp>
+#include <config/ServerConfig.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <redis/LockService.hpp>
+#include <set>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLShardRouter.hpp>
+#include <tools/tools.hpp>
+
+/*only one chatting server archives messages at a time*/
+std::string chat::HistoryArchive::archiver_lock = "history_archiver";
+
+/*server_name -> token inside [dir]/.readers/[server_name]*/
+std::string chat::HistoryArchive::readers_key = "history_archive_readers";
+
+chat::HistoryArchive::HistoryArchive()
+    : m_stop(false), m_enabled(ServerConfig::get_instance()->ArchiveEnabled),
+      m_dir(ServerConfig::get_instance()->ArchiveDirectory),
+      m_age(ServerConfig::get_instance()->ArchiveAge),
+      m_interval(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ArchiveInterval)),
+      m_refresh_interval(ServerConfig::get_instance()->ArchiveRefreshInterval),
+      m_batch_size(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ArchiveBatchSize)),
+      m_block_size(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ArchiveBlockSize)),
+      m_level(ServerConfig::get_instance()->ArchiveCompressionLevel),
+      m_max_threads(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ArchiveMaxThreadsPerRun)),
+      m_max_open(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ArchiveMaxOpenSegments)),
+      m_token(tools::userTokenGenerator()) {
+
+  std::error_code ec;
+  std::filesystem::create_directories(m_dir, ec);
+
+  /*archiver refuses to run until this server is registered*/
+  if (!registerReader()) {
+    spdlog::error("[{}] Register Archive Reader Inside {} Failed!",
+                  ServerConfig::get_instance()->GrpcServerName, m_dir);
+  }
+
+  /*every server reads archive, only enabled ones move messages into it*/
+  if (m_enabled) {
+    m_archiver = std::thread([this]() { archiver(); });
+  }
+}
+
+chat::HistoryArchive::~HistoryArchive() { shutdown(); }
+
+void chat::HistoryArchive::shutdown() {
+  if (m_stop.exchange(true)) {
+    return;
+  }
+
+  m_cv.notify_all();
+  if (m_archiver.joinable()) {
+    m_archiver.join();
+  }
+}
+
+std::string
+chat::HistoryArchive::threadDir(const std::uint64_t thread_id) const {
+  return (std::filesystem::path(m_dir) / std::to_string(thread_id)).string();
+}
+
+std::string
+chat::HistoryArchive::readerPath(const std::string &server) const {
+  return (std::filesystem::path(m_dir) / ".readers" / server).string();
+}
+
+bool chat::HistoryArchive::registerReader() {
+  const auto &server = ServerConfig::get_instance()->GrpcServerName;
+  const auto path = readerPath(server);
+
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(path).parent_path(), ec);
+
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool success =
+      std::fwrite(m_token.data(), 1, m_token.size(), file) == m_token.size() &&
+      !std::fflush(file) && !tools::syncFile(file);
+  std::fclose(file);
+
+  if (!success) {
+    return false;
+  }
+
+  RedisRAII raii;
+  return raii->get()->setValue2Hash(readers_key, server, m_token);
+}
+
+bool chat::HistoryArchive::isShared() {
+  std::optional<std::vector<std::pair<std::string, std::string>>> readers;
+  {
+    RedisRAII raii;
+    readers = raii->get()->getHashAll(readers_key);
+  }
+
+  /*this server registered itself, an empty hash means redis failed*/
+  if (!readers.has_value()) {
+    return false;
+  }
+
+  for (const auto &[server, token] : *readers) {
+    std::ifstream in(readerPath(server), std::ios::binary);
+    const std::string found((std::istreambuf_iterator<char>(in)),
+                            std::istreambuf_iterator<char>());
+    if (found != token) {
+      spdlog::error("[{}] Archive Directory {} Is Not Shared With {}, "
+                    "Archiving Is Suspended!",
+                    ServerConfig::get_instance()->GrpcServerName, m_dir,
+                    server);
+      return false;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<const chat::HistoryArchive::Listing>
+chat::HistoryArchive::list(const std::uint64_t thread_id, const bool reload) {
+  const auto now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> _lckg(m_listing_mtx);
+    auto it = m_listings.find(thread_id);
+    if (!reload && it != m_listings.end() &&
+        now - it->second->loaded < m_refresh_interval) {
+      return it->second;
+    }
+  }
+
+  auto listing = std::make_shared<Listing>();
+  listing->loaded = now;
+
+  /*thread without any archived message has no directory*/
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator(threadDir(thread_id), ec)) {
+    if (entry.path().extension() != ".arc") {
+      continue;
+    }
+
+    /*segment_[first]_[last]*/
+    const auto stem = entry.path().stem().string();
+    const auto split = stem.rfind('_');
+    if (stem.rfind("segment_", 0) || split == std::string::npos) {
+      continue;
+    }
+
+    auto first = tools::string_to_value<std::uint64_t>(
+        std::string_view(stem).substr(8, split - 8));
+    auto last = tools::string_to_value<std::uint64_t>(
+        std::string_view(stem).substr(split + 1));
+    if (!first.has_value() || !last.has_value()) {
+      continue;
+    }
+
+    listing->segments.push_back(SegmentInfo{
+        *first, *last, entry.path().string(), entry.last_write_time(ec)});
+  }
+
+  std::sort(listing->segments.begin(), listing->segments.end(),
+            [](const SegmentInfo &lhs, const SegmentInfo &rhs) {
+              return lhs.first_id < rhs.first_id;
+            });
+
+  std::lock_guard<std::mutex> _lckg(m_listing_mtx);
+  if (m_listings.size() >= max_listings) {
+    m_listings.clear();
+  }
+  m_listings[thread_id] = listing;
+  return listing;
+}
+
+std::shared_ptr<chat::ArchiveSegment>
+chat::HistoryArchive::open(const SegmentInfo &info) {
+  {
+    std::lock_guard<std::mutex> _lckg(m_segment_mtx);
+    if (auto it = m_segments.find(info.path); it != m_segments.end()) {
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+      return it->second->second;
+    }
+  }
+
+  auto segment = ArchiveSegment::open(info.path);
+  if (!segment) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> _lckg(m_segment_mtx);
+  if (auto it = m_segments.find(info.path); it != m_segments.end()) {
+    return it->second->second;
+  }
+
+  /*readers still holding an evicted segment keep it mapped*/
+  m_lru.emplace_front(info.path, segment);
+  m_segments[info.path] = m_lru.begin();
+  while (m_lru.size() > m_max_open) {
+    m_segments.erase(m_lru.back().first);
+    m_lru.pop_back();
+  }
+  return segment;
+}
+
+std::uint64_t
+chat::HistoryArchive::getArchivedUntil(const std::uint64_t thread_id) {
+  auto listing = list(thread_id);
+  return listing->segments.empty() ? 0 : listing->segments.back().last_id;
+}
+
+std::vector<std::unique_ptr<chat::MsgInfo>>
+chat::HistoryArchive::getPage(const std::uint64_t thread_id,
+                              const std::uint64_t msg_id,
+                              const std::size_t count) {
+  std::vector<std::unique_ptr<chat::MsgInfo>> result;
+
+  auto listing = list(thread_id);
+  for (const auto &info : listing->segments) {
+    if (result.size() >= count) {
+      break;
+    }
+    if (info.last_id <= msg_id) {
+      continue;
+    }
+
+    auto segment = open(info);
+
+    /*skipping a broken segment would return a page with a hole*/
+    if (!segment) {
+      break;
+    }
+    segment->read(msg_id, count, result);
+  }
+  return result;
+}
+
+std::vector<std::unique_ptr<chat::MsgInfo>>
+chat::HistoryArchive::getMessages(const std::uint64_t thread_id,
+                                  const std::vector<std::size_t> &msg_ids) {
+  std::vector<std::unique_ptr<chat::MsgInfo>> result;
+  if (msg_ids.empty()) {
+    return result;
+  }
+
+  const std::set<std::uint64_t> wanted(msg_ids.begin(), msg_ids.end());
+  auto listing = list(thread_id);
+  for (const auto &info : listing->segments) {
+    auto it = wanted.lower_bound(info.first_id);
+    if (it == wanted.end() || *it > info.last_id) {
+      continue;
+    }
+    if (auto segment = open(info); segment) {
+      segment->find(wanted, result);
+    }
+  }
+  return result;
+}
+
+void chat::HistoryArchive::archiver() {
+  while (!m_stop) {
+    {
+      std::unique_lock<std::mutex> _lckg(m_mtx);
+      if (m_cv.wait_for(_lckg, m_interval,
+                        [this]() { return m_stop.load(); })) {
+        break;
+      }
+    }
+
+    auto lease = redis::LockService::get_instance()->acquire(
+        archiver_lock, std::chrono::milliseconds(10),
+        std::chrono::duration_cast<std::chrono::milliseconds>(m_interval));
+
+    /*another chatting server is archiving*/
+    if (!lease.has_value()) {
+      continue;
+    }
+
+    /*rows deleted from MySQL must stay readable for every server*/
+    if (!isShared()) {
+      redis::LockService::get_instance()->release(lease.value());
+      continue;
+    }
+
+    for (const auto &pool :
+         mysql::MySQLShardRouter::get_instance()->getShards()) {
+      MySQLRAII mysql(pool);
+      while (!m_stop && archiveRound(pool, mysql, lease.value())) {
+      }
+    }
+
+    redis::LockService::get_instance()->release(lease.value());
+  }
+}
+
+bool chat::HistoryArchive::archiveRound(
+    const mysql::MySQLShardRouter::pool_ptr &pool, MySQLRAII &mysql,
+    const redis::Lease &lease) {
+  const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  const auto cutoff_ms = static_cast<std::uint64_t>(
+      now - std::chrono::duration_cast<std::chrono::milliseconds>(m_age)
+                .count());
+
+  /*
+   * message id carries its creation time, so the primary key finds old rows,
+   * created_at covers ids which were generated by MySQL
+   */
+  const auto cutoff_id = MessageIdGenerator::lowerBound(cutoff_ms);
+  const auto cutoff_time = cutoff_ms / 1000;
+
+  auto threads =
+      mysql->get()->getArchivableThreads(cutoff_id, cutoff_time, m_max_threads);
+  if (!threads.has_value() || threads->empty()) {
+    return false;
+  }
+
+  bool progress = false;
+  for (const auto thread_id : *threads) {
+    if (m_stop) {
+      break;
+    }
+
+    /*leftovers of a moving bucket are deleted by the migration*/
+    if (mysql::MySQLShardRouter::get_instance()->route(thread_id) != pool) {
+      continue;
+    }
+    progress |=
+        archiveThread(mysql, lease, thread_id, cutoff_id, cutoff_time);
+  }
+  return progress;
+}
+
+bool chat::HistoryArchive::archiveThread(MySQLRAII &mysql,
+                                         const redis::Lease &lease,
+                                         const std::uint64_t thread_id,
+                                         const std::uint64_t cutoff_id,
+                                         const std::uint64_t cutoff_time) {
+  auto listing = list(thread_id, /*reload = */ true);
+
+  /*
+   * rows of a segment are deleted once every server has reloaded its
+   * listing, a reader with a stale listing still finds them in MySQL
+   */
+  const auto grace = std::filesystem::file_time_type::clock::now() -
+                     2 * m_refresh_interval;
+  std::uint64_t deletable = 0;
+  for (const auto &info : listing->segments) {
+    if (info.written > grace) {
+      break;
+    }
+    deletable = info.last_id;
+  }
+
+  /*another archiver took over once the lease was lost, stop writing*/
+  if (!redis::LockService::get_instance()->validate(lease)) {
+    spdlog::warn("[{}] Archiver Lost Its Lease, Stop Archiving!",
+                 ServerConfig::get_instance()->GrpcServerName);
+    return false;
+  }
+
+  if (deletable &&
+      !mysql->get()->deleteArchivedMessages(thread_id, deletable,
+                                            cutoff_time)) {
+    return false;
+  }
+
+  const std::uint64_t until =
+      listing->segments.empty() ? 0 : listing->segments.back().last_id;
+
+  auto messages = mysql->get()->getArchivableMessages(
+      thread_id, until, cutoff_id, cutoff_time, m_batch_size);
+  if (!messages.has_value() || messages->empty()) {
+    return false;
+  }
+
+  const auto first = tools::string_to_value<std::uint64_t>(
+      messages->front()->message_id);
+  const auto last =
+      tools::string_to_value<std::uint64_t>(messages->back()->message_id);
+  if (!first.has_value() || !last.has_value()) {
+    return false;
+  }
+
+  if (!redis::LockService::get_instance()->validate(lease)) {
+    return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(threadDir(thread_id), ec);
+
+  const auto path = (std::filesystem::path(threadDir(thread_id)) /
+                     ("segment_" + tools::zeroPadding(*first) + "_" +
+                      tools::zeroPadding(*last) + ".arc"))
+                        .string();
+
+  if (!ArchiveSegment::write(path, thread_id, *messages, m_block_size,
+                             m_level)) {
+    spdlog::error("[{}] Archive Thread ID = {} Write Segment {} Failed!",
+                  ServerConfig::get_instance()->GrpcServerName, thread_id,
+                  path);
+    return false;
+  }
+
+  /*readers on this server see the new segment at once*/
+  list(thread_id, /*reload = */ true);
+
+  spdlog::info("[{}] Archive Thread ID = {} Moved {} Messages Into {}",
+               ServerConfig::get_instance()->GrpcServerName, thread_id,
+               messages->size(), path);
+  return true;
+}
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <config/ServerConfig.hpp>
+#include <redis/LockService.hpp>
+#include <redis/RedisManager.hpp>
+#include <spdlog/spdlog.h>
+#include <tools/tools.hpp>
+
+redis::LockService::LockService()
+    : m_stop(false),
+      m_prefix(ServerConfig::get_instance()->GrpcServerName + ":" +
+               tools::userTokenGenerator()),
+      m_counter(0) {
+
+  m_renewer = std::thread([this]() { renewer(); });
+
+  m_subscribers.start(RedisConnectionPool::get_instance()->ring()->size(),
+                      [this](const std::size_t node) { subscriber(node); });
+}
+
+redis::LockService::~LockService() { shutdown(); }
+
+void redis::LockService::shutdown() {
+  if (m_stop.exchange(true)) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> _lckg(m_mtx);
+    for (auto &[name, slot] : m_slots) {
+      slot->cv.notify_all();
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> _lckg(m_held_mtx);
+    m_held_cv.notify_all();
+  }
+  if (m_renewer.joinable()) {
+    m_renewer.join();
+  }
+
+  m_subscribers.stop();
+}
+
+std::optional<redis::Lease>
+redis::LockService::acquire(const std::string &name,
+                            const std::chrono::milliseconds wait,
+                            const std::chrono::milliseconds lease) {
+
+  if (name.empty() || lease.count() <= 0) {
+    return std::nullopt;
+  }
+
+  const auto deadline = std::chrono::steady_clock::now() + wait;
+  const auto key = lockKey(name);
+
+  std::unique_lock<std::mutex> _lckg(m_mtx);
+  auto slot = attach(name);
+
+  /*only one thread of this process competes on redis*/
+  if (!slot->cv.wait_until(_lckg, deadline, [this, &slot]() {
+        return !slot->busy || m_stop.load();
+      }) ||
+      m_stop) {
+    detach(name);
+    return std::nullopt;
+  }
+  slot->busy = true;
+
+  const auto identifier = m_prefix + ":" + std::to_string(++m_counter);
+
+  while (!m_stop) {
+    const auto released = slot->released;
+
+    _lckg.unlock();
+    auto status = attempt(key, identifier, lease);
+    _lckg.lock();
+
+    if (status.has_value() && status->first) {
+      std::lock_guard<std::mutex> _held(m_held_mtx);
+      m_held[identifier] = Held{key, lease,
+                                std::chrono::steady_clock::now() + lease / 3};
+      m_held_cv.notify_one();
+      return Lease{name, identifier,
+                   static_cast<std::uint64_t>(status->second)};
+    }
+
+    /*holder's lease runs out by itself if its release is never published*/
+    auto wake = std::chrono::steady_clock::now() + retry_interval;
+    if (status.has_value() && status->second > 0) {
+      wake = std::chrono::steady_clock::now() +
+             std::chrono::milliseconds(status->second);
+    } else if (status.has_value() && status->second == -2) {
+      /*released between SET and PTTL, retry at once*/
+      wake = std::chrono::steady_clock::now();
+    }
+
+    if (std::chrono::steady_clock::now() >= deadline) {
+      break;
+    }
+    slot->cv.wait_until(_lckg, std::min(wake, deadline),
+                        [this, &slot, released]() {
+                          return slot->released != released || m_stop.load();
+                        });
+  }
+
+  spdlog::warn("[{}] Acquire Distributed-Lock {} Timeout!",
+               ServerConfig::get_instance()->GrpcServerName, key);
+
+  slot->busy = false;
+  slot->cv.notify_all();
+  detach(name);
+  return std::nullopt;
+}
+
+bool redis::LockService::release(const Lease &lease) {
+  const auto key = lockKey(lease.name);
+
+  {
+    std::lock_guard<std::mutex> _lckg(m_held_mtx);
+    m_held.erase(lease.identifier);
+  }
+
+  auto status =
+      eval(release_lua_script, {key}, {lease.identifier, released_channel});
+
+  /*next local waiter competes on redis*/
+  {
+    std::lock_guard<std::mutex> _lckg(m_mtx);
+    if (auto it = m_slots.find(lease.name); it != m_slots.end()) {
+      it->second->busy = false;
+      it->second->cv.notify_all();
+      detach(lease.name);
+    }
+  }
+
+  if (!status.has_value() || status->empty() || status->front() != "1") {
+    spdlog::warn("[{}] Distributed-Lock {} Was Lost Before Release!",
+                 ServerConfig::get_instance()->GrpcServerName, key);
+    return false;
+  }
+  return true;
+}
+
+bool redis::LockService::validate(const Lease &lease) {
+  const auto key = lockKey(lease.name);
+
+  auto status = eval(validate_lua_script, {key, fenceKey(key)},
+                     {lease.identifier, std::to_string(lease.token)});
+  return status.has_value() && !status->empty() && status->front() == "1";
+}
+
+std::optional<std::pair<bool, long long>>
+redis::LockService::attempt(const std::string &key,
+                            const std::string &identifier,
+                            const std::chrono::milliseconds lease) {
+
+  auto status = eval(acquire_lua_script, {key, fenceKey(key)},
+                     {identifier, std::to_string(lease.count())});
+
+  if (!status.has_value() || status->size() != 2 ||
+      !status->at(0).has_value() || !status->at(1).has_value()) {
+    return std::nullopt;
+  }
+
+  auto value = tools::string_to_value<long long>(status->at(1).value());
+  if (!value.has_value()) {
+    return std::nullopt;
+  }
+  return std::make_pair(status->at(0).value() == "1", value.value());
+}
+
+bool redis::LockService::renew(const std::string &key,
+                               const std::string &identifier,
+                               const std::chrono::milliseconds lease) {
+
+  auto status = eval(renew_lua_script, {key},
+                     {identifier, std::to_string(lease.count())});
+  return status.has_value() && !status->empty() && status->front() == "1";
+}
+
+std::optional<std::vector<std::optional<std::string>>>
+redis::LockService::eval(const char *script,
+                         const std::vector<std::string> &keys,
+                         const std::vector<std::string> &args) {
+
+  std::lock_guard<std::mutex> _lckg(m_redis_mtx);
+  if (!m_redis) {
+    m_redis = std::make_unique<RedisContext>(
+        RedisConnectionPool::get_instance()->ring(),
+        ServerConfig::get_instance()->Redis_passwd);
+  }
+
+  auto status = m_redis->isValid()
+                    ? m_redis->evalScript(script, keys, args)
+                    : std::nullopt;
+
+  /*every script returns an array, connection is broken, reconnect next time*/
+  if (!status.has_value()) {
+    m_redis.reset();
+  }
+  return status;
+}
+
+std::shared_ptr<redis::LockService::Slot>
+redis::LockService::attach(const std::string &name) {
+  auto &slot = m_slots[name];
+  if (!slot) {
+    slot = std::make_shared<Slot>();
+  }
+  ++slot->users;
+  return slot;
+}
+
+void redis::LockService::detach(const std::string &name) {
+  auto it = m_slots.find(name);
+  if (it != m_slots.end() && !--it->second->users) {
+    m_slots.erase(it);
+  }
+}
+
+void redis::LockService::renewer() {
+  std::unique_lock<std::mutex> _lckg(m_held_mtx);
+  while (!m_stop) {
+    auto wake = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    for (const auto &[identifier, held] : m_held) {
+      wake = std::min(wake, held.renew_at);
+    }
+
+    m_held_cv.wait_until(_lckg, wake);
+    if (m_stop) {
+      break;
+    }
+
+    std::vector<std::pair<std::string, Held>> due;
+    const auto now = std::chrono::steady_clock::now();
+    for (const auto &[identifier, held] : m_held) {
+      if (held.renew_at <= now) {
+        due.emplace_back(identifier, held);
+      }
+    }
+
+    /*renew without blocking acquire and release*/
+    _lckg.unlock();
+    for (auto &[identifier, held] : due) {
+      held.renew_at = renew(held.key, identifier, held.lease)
+                          ? std::chrono::steady_clock::now() + held.lease / 3
+                          : std::chrono::steady_clock::time_point::max();
+    }
+    _lckg.lock();
+
+    for (const auto &[identifier, held] : due) {
+      auto it = m_held.find(identifier);
+      if (it == m_held.end()) {
+        continue;
+      }
+      if (held.renew_at == std::chrono::steady_clock::time_point::max()) {
+        spdlog::warn("[{}] Distributed-Lock {} Lease Lost!",
+                     ServerConfig::get_instance()->GrpcServerName, held.key);
+        m_held.erase(it);
+        continue;
+      }
+      it->second.renew_at = held.renew_at;
+    }
+  }
+}
+
+void redis::LockService::subscriber(const std::size_t node) {
+  const auto &address =
+      RedisConnectionPool::get_instance()->ring()->nodes().at(node);
+
+  /*a release is published on the node which owns the lock*/
+  auto ring = std::make_shared<const RedisShardRing>(
+      std::vector<RedisNode>{address});
+
+  const auto prefix = std::string(lock_prefix);
+
+  while (!m_subscribers.stopped()) {
+    RedisContext context(ring, ServerConfig::get_instance()->Redis_passwd);
+    if (!m_subscribers.attach(context)) {
+      break;
+    }
+
+    if (!context.isValid() || !context.subscribe(released_channel)) {
+      m_subscribers.detach(context);
+      spdlog::warn("[{}] Subscribe Distributed-Lock Releases On Redis {}:{} "
+                   "Failed, Retrying...",
+                   ServerConfig::get_instance()->GrpcServerName,
+                   address.first, address.second);
+      m_subscribers.backoff(std::chrono::seconds(1));
+      continue;
+    }
+
+    while (!m_subscribers.stopped() && context.isValid()) {
+      auto message = context.waitForMessage();
+      if (!message.has_value() ||
+          message->second.compare(0, prefix.size(), prefix)) {
+        continue;
+      }
+
+      std::lock_guard<std::mutex> _lckg(m_mtx);
+      auto it = m_slots.find(message->second.substr(prefix.size()));
+      if (it != m_slots.end()) {
+        ++it->second->released;
+        it->second->cv.notify_all();
+      }
+    }
+
+    m_subscribers.detach(context);
+    m_subscribers.backoff(retry_interval);
+  }
+}
+
+std::string redis::LockService::lockKey(const std::string &name) {
+  return std::string(lock_prefix) + name;
+}
+
+std::string redis::LockService::fenceKey(const std::string &key) {
+  return "lock_fence:" +
+         hashTag(std::string(RedisShardRing::routingKey(key)));
+}
@@ -0,0 +1,162 @@
+#include <chat/MessageIdGenerator.hpp>
+#include <chrono>
+#include <config/ServerConfig.hpp>
+#include <functional>
+#include <spdlog/spdlog.h>
+#include <tools/tools.hpp>
+
+/*redis key of leased node id*/
+std::string chat::MessageIdGenerator::node_prefix = "message_node_";
+
+chat::MessageIdGenerator::MessageIdGenerator()
+    : m_identifier(ServerConfig::get_instance()->GrpcServerName + ":" +
+                   tools::userTokenGenerator()),
+      m_node(0), m_expire(0), m_state(0), m_borrowing(false), m_stop(false) {
+
+  RedisRAII raii;
+  if (!leaseNode(raii)) {
+    spdlog::critical("[{}] No Message Node ID Available In Redis!",
+                     ServerConfig::get_instance()->GrpcServerName);
+    std::abort();
+  }
+
+  m_renewer = std::thread([this]() { renewer(); });
+}
+
+chat::MessageIdGenerator::~MessageIdGenerator() { shutdown(); }
+
+void chat::MessageIdGenerator::shutdown() {
+  if (m_stop.exchange(true)) {
+    return;
+  }
+
+  if (m_renewer.joinable()) {
+    m_renewer.join();
+  }
+
+  RedisRAII raii;
+  raii->get()->delValueIfEqual(node_prefix + std::to_string(m_node.load()),
+                               m_identifier);
+}
+
+std::uint64_t chat::MessageIdGenerator::currentMilliseconds() {
+  return static_cast<std::uint64_t>(
+             std::chrono::duration_cast<std::chrono::milliseconds>(
+                 std::chrono::system_clock::now().time_since_epoch())
+                 .count()) -
+         epoch;
+}
+
+std::uint64_t
+chat::MessageIdGenerator::lowerBound(const std::uint64_t unix_ms) {
+  return unix_ms > epoch ? (unix_ms - epoch) << (node_bits + sequence_bits)
+                         : 0;
+}
+
+void chat::MessageIdGenerator::leased(
+    const std::chrono::steady_clock::time_point &sent) {
+  m_expire = (sent + std::chrono::seconds(lease_ttl) - lease_margin)
+                 .time_since_epoch()
+                 .count();
+}
+
+std::optional<std::uint64_t> chat::MessageIdGenerator::next() {
+  /*another server might own this node id already, ids could collide*/
+  if (std::chrono::steady_clock::now().time_since_epoch().count() >=
+      m_expire.load()) {
+    return std::nullopt;
+  }
+
+  const auto now = currentMilliseconds();
+
+  auto prev = m_state.load(std::memory_order_relaxed);
+  std::uint64_t state{};
+
+  do {
+    const auto last = prev >> sequence_bits;
+    const auto sequence = prev & max_sequence;
+
+    if (now > last) {
+      state = now << sequence_bits;
+    } else if (sequence < max_sequence) {
+      /*same millisecond, or clock moved backwards*/
+      state = prev + 1;
+    } else {
+      /*sequence exhausted, borrow next millisecond*/
+      state = (last + 1) << sequence_bits;
+    }
+  } while (!m_state.compare_exchange_weak(prev, state,
+                                          std::memory_order_relaxed));
+
+  const auto timestamp = state >> sequence_bits;
+  if (timestamp > now + max_borrow) {
+    if (!m_borrowing.exchange(true)) {
+      spdlog::warn("[{}] Message ID Generator Is {}ms Ahead Of System Clock, "
+                   "Clock Moved Backwards?",
+                   ServerConfig::get_instance()->GrpcServerName,
+                   timestamp - now);
+    }
+  } else if (m_borrowing.load(std::memory_order_relaxed)) {
+    m_borrowing = false;
+  }
+
+  return (timestamp << (node_bits + sequence_bits)) |
+         (m_node.load(std::memory_order_relaxed) << sequence_bits) |
+         (state & max_sequence);
+}
+
+bool chat::MessageIdGenerator::leaseNode([[maybe_unused]] RedisRAII &raii) {
+  /*start from a server-specific position, servers rarely compete*/
+  const auto start = std::hash<std::string>{}(
+                         ServerConfig::get_instance()->GrpcServerName) &
+                     max_node;
+
+  for (std::uint64_t i = 0; i <= max_node; ++i) {
+    const auto node = (start + i) & max_node;
+    const auto sent = std::chrono::steady_clock::now();
+    if (raii->get()->setValueIfAbsent(node_prefix + std::to_string(node),
+                                      m_identifier, lease_ttl)) {
+      m_node = node;
+      leased(sent);
+      spdlog::info("[{}] Message Node ID = {} Leased Successfully",
+                   ServerConfig::get_instance()->GrpcServerName, node);
+      return true;
+    }
+  }
+  return false;
+}
+
+void chat::MessageIdGenerator::renewer() {
+  std::size_t counter{0};
+
+  while (!m_stop) {
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    if (++counter < lease_ttl / 3) {
+      continue;
+    }
+
+    /*retry every second until it is renewed or leased again*/
+    RedisRAII raii;
+    const auto sent = std::chrono::steady_clock::now();
+    if (raii->get()->renewValueIfEqual(node_prefix + std::to_string(m_node.load()),
+                                       m_identifier, lease_ttl)) {
+      leased(sent);
+      counter = 0;
+      continue;
+    }
+
+    /*
+     * lease expired and might be owned by another server now, switch to a new
+     * node id before generating ids again
+     */
+    spdlog::warn("[{}] Message Node ID = {} Lease Lost, Leasing A New One",
+                 ServerConfig::get_instance()->GrpcServerName, m_node.load());
+
+    if (leaseNode(raii)) {
+      counter = 0;
+    } else {
+      spdlog::error("[{}] No Message Node ID Available In Redis!",
+                    ServerConfig::get_instance()->GrpcServerName);
+    }
+  }
+}
@@ -0,0 +1,134 @@
+#include <chat/MessageTokenizer.hpp>
+
+namespace {
+enum class CharClass { SEPARATOR, WORD, CJK };
+
+constexpr char32_t invalid_char = 0xFFFD;
+
+/*decode one utf-8 sequence at pos, return its length in bytes*/
+std::size_t decode(std::string_view text, const std::size_t pos,
+                   char32_t &cp) {
+  const auto lead = static_cast<unsigned char>(text[pos]);
+  const std::size_t length = lead < 0x80           ? 1
+                             : (lead >> 5) == 0x06 ? 2
+                             : (lead >> 4) == 0x0E ? 3
+                             : (lead >> 3) == 0x1E ? 4
+                                                   : 0;
+
+  if (!length || pos + length > text.size()) {
+    cp = invalid_char;
+    return 1;
+  }
+
+  if (length == 1) {
+    cp = lead;
+    return 1;
+  }
+
+  cp = lead & (0x7F >> length);
+  for (std::size_t i = 1; i < length; ++i) {
+    const auto byte = static_cast<unsigned char>(text[pos + i]);
+    if ((byte & 0xC0) != 0x80) {
+      cp = invalid_char;
+      return 1;
+    }
+    cp = (cp << 6) | (byte & 0x3F);
+  }
+  return length;
+}
+
+bool isAsciiAlnum(const char32_t cp) {
+  return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') ||
+         (cp >= 'A' && cp <= 'Z');
+}
+
+CharClass classify(const char32_t cp) {
+  if (cp < 0x80) {
+    return isAsciiAlnum(cp) ? CharClass::WORD : CharClass::SEPARATOR;
+  }
+
+  if ((cp >= 0x3040 && cp <= 0x30FF) ||  // hiragana and katakana
+      (cp >= 0x3400 && cp <= 0x4DBF) ||  // CJK extension A
+      (cp >= 0x4E00 && cp <= 0x9FFF) ||  // CJK unified ideographs
+      (cp >= 0xAC00 && cp <= 0xD7AF) ||  // hangul syllables
+      (cp >= 0xF900 && cp <= 0xFAFF) ||  // CJK compatibility ideographs
+      (cp >= 0x20000 && cp <= 0x2FA1F)) { // CJK extension B and later
+    return CharClass::CJK;
+  }
+
+  if ((cp >= 0x80 && cp <= 0xBF) ||    // latin-1 punctuation and symbols
+      cp == 0xD7 || cp == 0xF7 ||      // multiplication and division sign
+      (cp >= 0x2000 && cp <= 0x2BFF) || // general punctuation, symbols
+      (cp >= 0x3000 && cp <= 0x303F) || // CJK punctuation
+      (cp >= 0xFE30 && cp <= 0xFE4F) || // CJK compatibility forms
+      (cp >= 0xFF00 && cp <= 0xFF0F) || // fullwidth punctuation
+      (cp >= 0xFF1A && cp <= 0xFF20) || (cp >= 0xFF3B && cp <= 0xFF40) ||
+      (cp >= 0xFF5B && cp <= 0xFF65) || cp >= 0x1F000 || // emoji
+      cp == invalid_char) {
+    return CharClass::SEPARATOR;
+  }
+  return CharClass::WORD;
+}
+
+/*fullwidth digits and letters are typed by CJK input methods*/
+char32_t foldFullwidth(const char32_t cp) {
+  if (cp >= 0xFF10 && cp <= 0xFF5A && isAsciiAlnum(cp - 0xFEE0)) {
+    return cp - 0xFEE0;
+  }
+  return cp;
+}
+} // namespace
+
+std::vector<std::string>
+chat::MessageTokenizer::tokenize(std::string_view text) {
+  std::vector<std::string> ret;
+  std::string word;
+  std::vector<std::string_view> run; // characters of current CJK run
+
+  auto flushWord = [&ret, &word]() {
+    if (!word.empty() && word.size() <= max_term_length) {
+      ret.push_back(word);
+    }
+    word.clear();
+  };
+
+  auto flushRun = [&ret, &run]() {
+    for (std::size_t i = 0; i < run.size(); ++i) {
+      ret.emplace_back(run[i]);
+      if (i + 1 < run.size()) {
+        ret.push_back(std::string(run[i]).append(run[i + 1]));
+      }
+    }
+    run.clear();
+  };
+
+  for (std::size_t pos = 0; pos < text.size();) {
+    char32_t cp{};
+    const std::size_t length = decode(text, pos, cp);
+
+    switch (classify(cp)) {
+    case CharClass::WORD:
+      flushRun();
+      if (cp = foldFullwidth(cp); cp < 0x80) {
+        word.push_back(static_cast<char>(
+            cp >= 'A' && cp <= 'Z' ? cp - 'A' + 'a' : cp));
+      } else {
+        word.append(text.substr(pos, length));
+      }
+      break;
+    case CharClass::CJK:
+      flushWord();
+      run.push_back(text.substr(pos, length));
+      break;
+    default:
+      flushWord();
+      flushRun();
+      break;
+    }
+    pos += length;
+  }
+
+  flushWord();
+  flushRun();
+  return ret;
+}
@@ -1,12 +1,18 @@
+#include <algorithm>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/mysql/common_server_errc.hpp>
+#include <boost/mysql/error_with_diagnostics.hpp>
 #include <boost/mysql/handshake_params.hpp>
 #include <boost/mysql/results.hpp>
 #include <boost/mysql/row_view.hpp>
 #include <boost/mysql/statement.hpp>
+#include <chat/HistoryArchive.hpp>
+#include <chat/MessageIdGenerator.hpp>
 #include <service/IOServicePool.hpp>
 #include <spdlog/fmt/fmt.h>
 #include <spdlog/spdlog.h>
 #include <sql/MySQLConnectionPool.hpp>
+#include <sql/MySQLShardRouter.hpp>
 #include <tools/magic_enum.hpp>
 #include <tools/tools.hpp>
 
@@ -124,6 +130,15 @@ mysql::MySQLConnection::executeCommandOrThrow(MySQLSelection select,
   boost::mysql::results result;
   std::string key = m_delegator.get()->m_sql[select];
 
+  /*a write on replica would break replication, refuse it before sending*/
+  if (m_delegator->isReplica() && !isReadSelection(select)) {
+    spdlog::error("Write Statement {} Is Not Allowed On MySQL Replica!", key);
+    throw boost::mysql::error_with_diagnostics(
+        boost::mysql::make_error_code(
+            boost::mysql::common_server_errc::er_option_prevents_statement),
+        boost::mysql::diagnostics());
+  }
+
   if (select != MySQLSelection::HEART_BEAT) {
     spdlog::info("Executing MySQL Query: {}", key);
   }
@@ -165,24 +180,47 @@ bool mysql::MySQLConnection::checkAccountAvailability(std::string_view username,
 /*get user profile*/
 std::optional<std::unique_ptr<user::UserNameCard>>
 mysql::MySQLConnection::getUserProfile(std::size_t uuid) {
-  /*get user name by uuid*/
-  std::optional<std::string> usr_op = getUsernameByUUID(uuid);
-  if (!usr_op.has_value()) {
+  /*username and profile are joined by one query*/
+  auto list = getUserProfiles({uuid});
+  if (!list.has_value() || list->empty()) {
     return std::nullopt;
   }
+  return std::move(list->front());
+}
 
-  /*get other user profile*/
-  auto res = executeCommand(MySQLSelection::USER_PROFILE, uuid);
-  if (!res.has_value()) {
-    return std::nullopt;
+std::optional<std::vector<std::unique_ptr<user::UserNameCard>>>
+mysql::MySQLConnection::getUserProfiles(const std::vector<std::size_t> &uuids) {
+  std::vector<std::unique_ptr<user::UserNameCard>> list;
+  if (uuids.empty()) {
+    return list;
   }
 
-  boost::mysql::results result = res.value();
-  boost::mysql::row_view row = *result.rows().begin();
-  return std::make_unique<user::UserNameCard>(
-      std::to_string(row.at(0).as_int64()), row.at(1).as_string(),
-      usr_op.value(), row.at(2).as_string(), row.at(3).as_string(),
-      static_cast<user::Sex>(row.at(4).as_int64()));
+  std::string ids = "[";
+  for (const auto uuid : uuids) {
+    ids += (ids.size() > 1 ? "," : "") + std::to_string(uuid);
+  }
+  ids += "]";
+
+  try {
+    /*nothing found is not an error*/
+    auto res = executeCommandOrThrow(MySQLSelection::GET_USER_PROFILES, ids);
+
+    list.reserve(res.rows().size());
+    for (const auto &row : res.rows()) {
+      list.push_back(std::make_unique<user::UserNameCard>(
+          std::to_string(row.at(0).as_int64()), row.at(1).as_string(),
+          row.at(2).as_string(), row.at(3).as_string(), row.at(4).as_string(),
+          static_cast<user::Sex>(row.at(5).as_int64())));
+    }
+    return list;
+
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("{0}:{1} Operation failed with error code: {2} Server "
+                  "diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return std::nullopt;
 }
 
 bool mysql::MySQLConnection::createFriendRequest(const std::size_t src_uuid,
@@ -322,7 +360,7 @@ mysql::MySQLConnection::getUserChattingThreadIdx(
     const std::size_t interval, std::string &next_thread_id, bool &is_EOF) {
   /*init*/
   is_EOF = true;
-  next_thread_id = cur_thread_id;
+  next_thread_id = std::to_string(cur_thread_id);
 
   if (!checkUUID(self_uuid)) {
     spdlog::warn("Invalid Dst UUID!");
@@ -331,7 +369,8 @@ mysql::MySQLConnection::getUserChattingThreadIdx(
 
   [[maybe_unused]] auto res =
       executeCommand(MySQLSelection::GET_USER_CHAT_THREADS, self_uuid,
-                     self_uuid, cur_thread_id, self_uuid, cur_thread_id,
+                     cur_thread_id, self_uuid, cur_thread_id, self_uuid,
+                     cur_thread_id,
                      /*we need to test EOF*/ interval + 1);
 
   /*after execute sql query => no value*/
@@ -469,20 +508,36 @@ mysql::MySQLConnection::createNewPrivateChat(const std::size_t user1_uuid,
 
   try {
     TransactionGuard transaction_guard(*this);
+    std::string thread_id;
     if (auto existing = checkPrivateChatExistance(user_one, user_two);
         existing) {
-      transaction_guard.commit();
-      return existing.value();
-    }
-
-    auto res = executeCommandOrThrow(
-        MySQLSelection::CREATE_PRIVATE_GLOBAL_THREAD_INDEX, "PRIVATE");
-    std::string thread_id = std::to_string(res.last_insert_id());
-
-    executeCommandOrThrow(MySQLSelection::CREATE_PRIVATE_CHAT_BY_USER_PAIR,
-                          thread_id, user_one, user_two);
+      thread_id = existing.value();
+    } else {
+      auto res = executeCommandOrThrow(
+          MySQLSelection::CREATE_PRIVATE_GLOBAL_THREAD_INDEX, "PRIVATE");
+      thread_id = std::to_string(res.last_insert_id());
 
+      executeCommandOrThrow(MySQLSelection::CREATE_PRIVATE_CHAT_BY_USER_PAIR,
+                            thread_id, user_one, user_two);
+    }
     transaction_guard.commit();
+
+    /*
+     * messages are stored on the shard of thread_id, they are checked
+     * against its own copy of this private chat, it is placed every time in
+     * case the last try failed halfway
+     */
+    auto shard = MySQLShardRouter::get_instance()->route(thread_id);
+    if (shard.get() != m_delegator.get()) {
+      connection::ConnectionRAII<MySQLConnectionPool, MySQLConnection> raii(
+          shard);
+      if (!raii.is_active()) {
+        return std::nullopt;
+      }
+      raii->get()->executeCommandOrThrow(
+          MySQLSelection::CREATE_PRIVATE_CHAT_COPY, thread_id, user_one,
+          user_two);
+    }
     return thread_id;
   } catch (const boost::mysql::error_with_diagnostics &err) {
     spdlog::error("createPrivateChat failed: {0}:{1} Operation failed with "
@@ -519,13 +574,10 @@ bool mysql::MySQLConnection::createModifyChattingHistoryRecord(
   const std::size_t user_one = std::min(user1_uuid, user2_uuid);
   const std::size_t user_two = std::max(user1_uuid, user2_uuid);
 
-  auto res1 = executeCommand(MySQLSelection::USER_UUID_CHECK, user1_uuid);
-  auto res2 = executeCommand(MySQLSelection::USER_UUID_CHECK, user2_uuid);
-
-  // Not user uuid found!
-  if (!res1.has_value() || !res2.has_value())
-    return false;
-
+  /*
+   * this connection belongs to the shard of thread_id, Authentication is only
+   * on primary, a private chat of this pair already means both users exist
+   */
   try {
     TransactionGuard transaction_guard(*this);
     boost::mysql::results flag = executeCommandOrThrow(
@@ -534,8 +586,14 @@ bool mysql::MySQLConnection::createModifyChattingHistoryRecord(
     if (!is_rows_afftected(flag))
       return false; // No Relavant Info Found Here! ROLLBACK
 
+    /*message id is generated by chatting server, not AUTO_INCREMENT*/
+    const auto message_id = chat::MessageIdGenerator::get_instance()->next();
+    if (!message_id.has_value())
+      return false; // ROLLBACK
+
     /*Store Request->Confirmer Init Chat Info In ChatMsgHistoryBank*/
     flag = executeCommandOrThrow(MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE,
+                                 /*message_id = */ *message_id,
                                  /*thread_id = */ info->thread_id,
                                  /*message_status = */ 0,
                                  /*message_sender= */ user1_uuid,
@@ -545,12 +603,9 @@ bool mysql::MySQLConnection::createModifyChattingHistoryRecord(
     if (!flag.affected_rows())
       return false; // No Relavant Info Found Here! ROLLBACK
 
-    // get id from ChatMsgHistoryBank
-    std::string message_id = std::to_string(flag.last_insert_id());
-
     transaction_guard.commit();
 
-    info->setMsgID(message_id);
+    info->setMsgID(std::to_string(*message_id));
     return true;
   } catch (const boost::mysql::error_with_diagnostics &err) {
     spdlog::error("createPrivateChat failed: {0}:{1} Operation failed with "
@@ -562,6 +617,579 @@ bool mysql::MySQLConnection::createModifyChattingHistoryRecord(
   }
 }
 
+bool mysql::MySQLConnection::createGroupChattingHistoryRecord(
+    std::vector<std::shared_ptr<chat::MsgInfo>> &info) {
+
+  if (info.empty())
+    return true;
+
+  try {
+    TransactionGuard transaction_guard(*this);
+
+    std::vector<std::string> message_ids;
+    message_ids.reserve(info.size());
+
+    for (auto &item : info) {
+      auto sender_op = tools::string_to_value<std::size_t>(item->msg_sender);
+      if (!sender_op.has_value())
+        return false; // ROLLBACK
+
+      const auto message_id = chat::MessageIdGenerator::get_instance()->next();
+      if (!message_id.has_value())
+        return false; // ROLLBACK
+
+      /*group message do not have a single receiver, so message_receiver = 0*/
+      auto flag =
+          executeCommandOrThrow(MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE,
+                                /*message_id = */ *message_id,
+                                /*thread_id = */ item->thread_id,
+                                /*message_status = */ 0,
+                                /*message_sender= */ sender_op.value(),
+                                /*message_receiver= */ 0,
+                                /*message_content = */ item->msg_content);
+
+      if (!flag.affected_rows())
+        return false; // ROLLBACK
+
+      message_ids.push_back(std::to_string(*message_id));
+    }
+
+    transaction_guard.commit();
+
+    /*only mark messages as verified after the whole batch is committed*/
+    for (std::size_t i = 0; i < info.size(); ++i) {
+      info[i]->setMsgID(message_ids[i]);
+    }
+    return true;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("createGroupChattingHistoryRecord failed: {0}:{1} Operation "
+                  "failed with error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+
+    return false;
+  }
+}
+
+bool mysql::MySQLConnection::createChattingHistoryRecordBatch(
+    const std::vector<std::shared_ptr<chat::MsgInfo>> &info) {
+
+  if (info.empty())
+    return true;
+
+  try {
+    TransactionGuard transaction_guard(*this);
+
+    /*(user_one, user_two) -> thread_id, check every pair only once*/
+    std::map<std::pair<std::size_t, std::size_t>, std::optional<std::size_t>>
+        threads;
+
+    for (const auto &item : info) {
+      auto message_id_op = tools::string_to_value<std::size_t>(item->message_id);
+      auto thread_id_op = tools::string_to_value<std::size_t>(item->thread_id);
+      auto sender_op = tools::string_to_value<std::size_t>(item->msg_sender);
+      auto receiver_op = tools::string_to_value<std::size_t>(item->msg_receiver);
+      auto timestamp_op = tools::string_to_value<std::size_t>(item->timestamp);
+
+      if (!message_id_op.has_value() || !thread_id_op.has_value() ||
+          !sender_op.has_value() || !receiver_op.has_value() ||
+          !timestamp_op.has_value() || *sender_op == *receiver_op) {
+        spdlog::warn("createChattingHistoryRecordBatch: Invalid Message {} "
+                     "Skipped!",
+                     item->message_id);
+        continue;
+      }
+
+      const auto key = std::make_pair(std::min(*sender_op, *receiver_op),
+                                      std::max(*sender_op, *receiver_op));
+
+      auto it = threads.find(key);
+      if (it == threads.end()) {
+        boost::mysql::results flag =
+            executeCommandOrThrow(MySQLSelection::CHECK_PRIVATE_CHAT_WITH_LOCK,
+                                  key.first, key.second);
+
+        std::optional<std::size_t> thread_id;
+        if (flag.rows().begin() != flag.rows().end()) {
+          thread_id = flag.rows().begin()->at(0).as_uint64();
+        }
+        it = threads.emplace(key, thread_id).first;
+      }
+
+      if (it->second != thread_id_op) {
+        spdlog::warn("createChattingHistoryRecordBatch: Message {} Thread ID "
+                     "= {} Does Not Belong To UUID {} and {}, Skipped!",
+                     item->message_id, item->thread_id, item->msg_sender,
+                     item->msg_receiver);
+        continue;
+      }
+
+      executeCommandOrThrow(
+          MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE_WITH_ID,
+          /*message_id = */ *message_id_op,
+          /*thread_id = */ *thread_id_op,
+          /*message_status = */ item->status,
+          /*message_sender= */ *sender_op,
+          /*message_receiver= */ *receiver_op,
+          /*created_at = */ *timestamp_op,
+          /*updated_at = */ *timestamp_op,
+          /*message_content = */ item->msg_content);
+    }
+
+    transaction_guard.commit();
+    return true;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("createChattingHistoryRecordBatch failed: {0}:{1} Operation "
+                  "failed with error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+
+    return false;
+  }
+}
+
+std::optional<std::vector<std::string>>
+mysql::MySQLConnection::getGroupMembers(const std::size_t thread_id) {
+  auto res = executeCommand(MySQLSelection::GET_GROUP_MEMBERS, thread_id);
+  if (!res.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::string> members;
+  members.reserve(res->rows().size());
+  for (const auto &tuple : res->rows()) {
+    members.push_back(std::to_string(tuple.at(0).as_uint64())); // user_uuid
+  }
+  return members;
+}
+
+std::optional<std::vector<std::unique_ptr<user::UserNameCard>>>
+mysql::MySQLConnection::getUserSearchEntries(const std::size_t after_uuid,
+                                             const std::size_t interval) {
+  auto res = executeCommand(MySQLSelection::GET_USER_SEARCH_ENTRIES,
+                            after_uuid, interval);
+  if (!res.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::unique_ptr<user::UserNameCard>> list;
+  list.reserve(res->rows().size());
+  for (const auto &tuple : res->rows()) {
+    list.push_back(std::make_unique<user::UserNameCard>(
+        std::to_string(tuple.at(0).as_int64()), /*uuid*/
+        "",                                     /*avator*/
+        tuple.at(1).as_string(),                /*user name*/
+        tuple.at(2).as_string(),                /*nickname*/
+        "",                                     /*description*/
+        user::Sex::Unkown));
+  }
+  return list;
+}
+
+std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+mysql::MySQLConnection::getChattingHistoryAfter(const std::size_t after_msg_id,
+                                                const std::size_t before_msg_id,
+                                                const std::size_t interval) {
+  /*an empty list means there is nothing left, std::nullopt is an error*/
+  try {
+    auto res = executeCommandOrThrow(MySQLSelection::GET_MSG_HISTORY_AFTER,
+                                     after_msg_id, before_msg_id, interval);
+
+    std::vector<std::unique_ptr<chat::MsgInfo>> list;
+    list.reserve(res.rows().size());
+    for (const auto &tuple : res.rows()) {
+      auto item = std::make_unique<chat::TextMsgInfo>(
+          std::to_string(tuple.at(1).as_uint64()), /*thread_id*/
+          std::to_string(tuple.at(3).as_uint64()), /*message_sender*/
+          std::to_string(tuple.at(4).as_uint64()), /*message_receiver*/
+          tuple.at(6).as_string(),                 /*message_content*/
+          static_cast<std::size_t>(tuple.at(2).as_int64()),
+          std::to_string(tuple.at(5).as_uint64())); /*created_at*/
+      item->setMsgID(std::to_string(tuple.at(0).as_uint64()));
+      list.push_back(std::move(item));
+    }
+    return list;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("getChattingHistoryAfter failed: {0}:{1} Operation failed "
+                  "with error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return std::nullopt;
+}
+
+std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+mysql::MySQLConnection::getChattingHistoryByIds(
+    const std::size_t thread_id, const std::vector<std::size_t> &msg_ids) {
+
+  /*old messages might have been moved into archive segments*/
+  auto archive = chat::HistoryArchive::get_instance();
+  const auto archived_until = archive->getArchivedUntil(thread_id);
+
+  std::vector<std::size_t> archived;
+  for (const auto msg_id : msg_ids) {
+    if (msg_id <= archived_until) {
+      archived.push_back(msg_id);
+    }
+  }
+
+  std::vector<std::unique_ptr<chat::MsgInfo>> list =
+      archive->getMessages(thread_id, archived);
+  list.reserve(msg_ids.size());
+
+  /*one page is small, every lookup is a primary key access*/
+  for (const auto msg_id : msg_ids) {
+    if (msg_id <= archived_until) {
+      continue;
+    }
+
+    auto res = executeCommand(MySQLSelection::GET_MSG_HISTORY_BY_ID,
+                              thread_id, msg_id);
+    if (!res.has_value()) {
+      return std::nullopt;
+    }
+
+    for (const auto &tuple : res->rows()) {
+      auto item = std::make_unique<chat::TextMsgInfo>(
+          std::to_string(thread_id),
+          std::to_string(tuple.at(2).as_uint64()), /*message_sender*/
+          std::to_string(tuple.at(3).as_uint64()), /*message_receiver*/
+          tuple.at(5).as_string(),                 /*message_content*/
+          static_cast<std::size_t>(tuple.at(1).as_int64()),
+          std::to_string(tuple.at(4).as_uint64())); /*created_at*/
+      item->setMsgID(std::to_string(tuple.at(0).as_uint64()));
+      list.push_back(std::move(item));
+    }
+  }
+  return list;
+}
+
+bool mysql::MySQLConnection::checkThreadMember(const std::size_t thread_id,
+                                               const std::size_t uuid) {
+  auto res = executeCommand(MySQLSelection::CHECK_THREAD_MEMBER, thread_id,
+                            uuid, uuid, thread_id, uuid);
+  return res.has_value() && !res->rows().empty();
+}
+
+bool mysql::MySQLConnection::checkPrivateChatThread(
+    const std::size_t thread_id, const std::size_t user1_uuid,
+    const std::size_t user2_uuid) {
+  auto res = executeCommand(MySQLSelection::CHECK_PRIVATE_CHAT_THREAD,
+                            thread_id, std::min(user1_uuid, user2_uuid),
+                            std::max(user1_uuid, user2_uuid));
+  return res.has_value() && !res->rows().empty();
+}
+
+std::optional<std::vector<std::size_t>>
+mysql::MySQLConnection::getArchivableThreads(const std::size_t before_msg_id,
+                                             const std::size_t before_time,
+                                             const std::size_t interval) {
+  auto res = executeCommand(MySQLSelection::GET_ARCHIVABLE_THREADS,
+                            before_msg_id, before_time, interval);
+  if (!res.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::size_t> threads;
+  threads.reserve(res->rows().size());
+  for (const auto &tuple : res->rows()) {
+    threads.push_back(tuple.at(0).as_uint64()); // thread_id
+  }
+  return threads;
+}
+
+std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+mysql::MySQLConnection::getArchivableMessages(const std::size_t thread_id,
+                                              const std::size_t after_msg_id,
+                                              const std::size_t before_msg_id,
+                                              const std::size_t before_time,
+                                              const std::size_t interval) {
+  auto res =
+      executeCommand(MySQLSelection::GET_ARCHIVABLE_MSG, thread_id,
+                     after_msg_id, before_msg_id, before_time, interval);
+  if (!res.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::unique_ptr<chat::MsgInfo>> list;
+  list.reserve(res->rows().size());
+  for (const auto &tuple : res->rows()) {
+    auto item = std::make_unique<chat::TextMsgInfo>(
+        std::to_string(thread_id),
+        std::to_string(tuple.at(2).as_uint64()), /*message_sender*/
+        std::to_string(tuple.at(3).as_uint64()), /*message_receiver*/
+        tuple.at(5).as_string(),                 /*message_content*/
+        static_cast<std::size_t>(tuple.at(1).as_int64()),
+        std::to_string(tuple.at(4).as_uint64())); /*created_at*/
+    item->setMsgID(std::to_string(tuple.at(0).as_uint64()));
+    list.push_back(std::move(item));
+  }
+  return list;
+}
+
+bool mysql::MySQLConnection::deleteArchivedMessages(
+    const std::size_t thread_id, const std::size_t msg_id,
+    const std::size_t before_time) {
+  return executeCommand(MySQLSelection::DELETE_ARCHIVED_MSG, thread_id, msg_id,
+                        before_time)
+      .has_value();
+}
+
+std::optional<std::size_t>
+mysql::MySQLConnection::getThreadLastActivity(const std::size_t thread_id) {
+  auto res =
+      executeCommand(MySQLSelection::GET_THREAD_LAST_ACTIVITY, thread_id);
+
+  /*MAX() of a thread without messages is NULL*/
+  if (!res.has_value() || res->rows().begin()->at(0).is_null()) {
+    return std::nullopt;
+  }
+  return res->rows().begin()->at(0).as_uint64();
+}
+
+std::optional<std::vector<std::unique_ptr<chat::ChatThreadMeta>>>
+mysql::MySQLConnection::getPrivateChatsAfter(const std::size_t after_thread_id,
+                                             const std::size_t interval) {
+  /*an empty list means there is nothing left, std::nullopt is an error*/
+  try {
+    auto res = executeCommandOrThrow(MySQLSelection::GET_PRIVATE_CHAT_AFTER,
+                                     after_thread_id, interval);
+
+    std::vector<std::unique_ptr<chat::ChatThreadMeta>> list;
+    list.reserve(res.rows().size());
+    for (const auto &tuple : res.rows()) {
+      list.push_back(std::make_unique<chat::ChatThreadMeta>(
+          std::to_string(tuple.at(0).as_uint64()), // thread_id
+          chat::UserChatType::PRIVATE,
+          std::to_string(tuple.at(1).as_uint64()),   // user1_uuid
+          std::to_string(tuple.at(2).as_uint64()))); // user2_uuid
+    }
+    return list;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("getPrivateChatsAfter failed: {0}:{1} Operation failed with "
+                  "error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return std::nullopt;
+}
+
+bool mysql::MySQLConnection::copyPrivateChats(
+    const std::vector<std::unique_ptr<chat::ChatThreadMeta>> &info) {
+
+  if (info.empty())
+    return true;
+
+  try {
+    TransactionGuard transaction_guard(*this);
+    for (const auto &item : info) {
+      executeCommandOrThrow(MySQLSelection::CREATE_PRIVATE_CHAT_COPY,
+                            item->_thread_id, item->_user_one.value_or("0"),
+                            item->_user_two.value_or("0"));
+    }
+    transaction_guard.commit();
+    return true;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("copyPrivateChats failed: {0}:{1} Operation failed with "
+                  "error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return false;
+}
+
+bool mysql::MySQLConnection::copyChattingHistoryRecords(
+    const std::vector<std::unique_ptr<chat::MsgInfo>> &info) {
+
+  if (info.empty())
+    return true;
+
+  try {
+    TransactionGuard transaction_guard(*this);
+    for (const auto &item : info) {
+      executeCommandOrThrow(
+          MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE_WITH_ID,
+          /*message_id = */ item->message_id,
+          /*thread_id = */ item->thread_id,
+          /*message_status = */ item->status,
+          /*message_sender= */ item->msg_sender,
+          /*message_receiver= */ item->msg_receiver,
+          /*created_at = */ item->timestamp,
+          /*updated_at = */ item->timestamp,
+          /*message_content = */ item->msg_content);
+    }
+    transaction_guard.commit();
+    return true;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("copyChattingHistoryRecords failed: {0}:{1} Operation "
+                  "failed with error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return false;
+}
+
+bool mysql::MySQLConnection::deleteChattingHistoryRecords(
+    const std::vector<std::size_t> &msg_ids) {
+
+  if (msg_ids.empty())
+    return true;
+
+  try {
+    TransactionGuard transaction_guard(*this);
+    for (const auto msg_id : msg_ids) {
+      executeCommandOrThrow(MySQLSelection::DELETE_MSG_HISTORY_BY_ID, msg_id);
+    }
+    transaction_guard.commit();
+    return true;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("deleteChattingHistoryRecords failed: {0}:{1} Operation "
+                  "failed with error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return false;
+}
+
+std::optional<std::vector<std::size_t>>
+mysql::MySQLConnection::getExistingChattingHistoryIds(
+    const std::vector<std::size_t> &msg_ids) {
+
+  std::vector<std::size_t> existing;
+  existing.reserve(msg_ids.size());
+  for (const auto msg_id : msg_ids) {
+    auto res = executeCommand(MySQLSelection::CHECK_MSG_HISTORY_BY_ID, msg_id);
+    if (!res.has_value()) {
+      return std::nullopt;
+    }
+    if (!res->rows().empty()) {
+      existing.push_back(msg_id);
+    }
+  }
+  return existing;
+}
+
+bool mysql::MySQLConnection::updateReadCursorBatch(
+    const std::vector<chat::ReadCursor> &cursors) {
+
+  if (cursors.empty())
+    return true;
+
+  try {
+    TransactionGuard transaction_guard(*this);
+
+    for (const auto &cursor : cursors) {
+      executeCommandOrThrow(MySQLSelection::UPDATE_READ_CURSOR, cursor.uuid,
+                            cursor.thread_id, cursor.message_id);
+    }
+
+    transaction_guard.commit();
+    return true;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("updateReadCursorBatch failed: {0}:{1} Operation failed with "
+                  "error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return false;
+}
+
+bool mysql::MySQLConnection::updateMessageStatusBatch(
+    const std::vector<chat::ReadCursor> &cursors) {
+
+  if (cursors.empty())
+    return true;
+
+  try {
+    TransactionGuard transaction_guard(*this);
+
+    /*range update on search_thread_message index*/
+    for (const auto &cursor : cursors) {
+      executeCommandOrThrow(MySQLSelection::UPDATE_MSG_STATUS_READ,
+                            cursor.thread_id, cursor.uuid, cursor.message_id);
+    }
+
+    transaction_guard.commit();
+    return true;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("updateMessageStatusBatch failed: {0}:{1} Operation failed "
+                  "with error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return false;
+}
+
+std::optional<std::vector<std::pair<std::size_t, std::size_t>>>
+mysql::MySQLConnection::getReadCursors(const std::size_t uuid) {
+  auto res = executeCommand(MySQLSelection::GET_READ_CURSORS, uuid);
+  if (!res.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> cursors;
+  cursors.reserve(res->rows().size());
+  for (const auto &tuple : res->rows()) {
+    cursors.emplace_back(tuple.at(0).as_uint64(),  // thread_id
+                         tuple.at(1).as_uint64()); // last_read_message_id
+  }
+  return cursors;
+}
+
+std::optional<std::pair<std::size_t, std::size_t>>
+mysql::MySQLConnection::getThreadUnread(const std::size_t thread_id,
+                                        const std::size_t after_msg_id,
+                                        const std::size_t uuid) {
+  auto res = executeCommand(MySQLSelection::GET_THREAD_UNREAD, thread_id,
+                            after_msg_id, uuid);
+  if (!res.has_value() || res->rows().empty()) {
+    return std::nullopt;
+  }
+  return std::make_pair(res->rows().begin()->at(0).as_uint64(),  // count
+                        res->rows().begin()->at(1).as_uint64()); // newest
+}
+
+std::optional<
+    std::vector<std::pair<std::unique_ptr<chat::ChatThreadMeta>, std::size_t>>>
+mysql::MySQLConnection::getUserChattingThreadsByActivity(
+    const std::size_t self_uuid) {
+  try {
+    auto res = executeCommandOrThrow(
+        MySQLSelection::GET_USER_CHAT_THREADS_BY_ACTIVITY, self_uuid, self_uuid,
+        self_uuid);
+
+    std::vector<std::pair<std::unique_ptr<chat::ChatThreadMeta>, std::size_t>>
+        list;
+    list.reserve(res.rows().size());
+
+    for (const auto &tuple : res.rows()) {
+      auto thread_id = std::to_string(tuple.at(0).as_uint64()); // thread_id
+      std::string type = tuple.at(3).as_string();               // type
+      auto last_active = tuple.at(4).as_uint64();               // activity
+
+      if (type == "GROUP") {
+        list.emplace_back(std::make_unique<chat::ChatThreadMeta>(
+                              thread_id, chat::UserChatType::GROUP),
+                          last_active);
+      } else {
+        list.emplace_back(
+            std::make_unique<chat::ChatThreadMeta>(
+                thread_id, chat::UserChatType::PRIVATE,
+                std::to_string(tuple.at(1).as_uint64()),  // user1_uuid
+                std::to_string(tuple.at(2).as_uint64())), // user2_uuid
+            last_active);
+      }
+    }
+    return list;
+  } catch (const boost::mysql::error_with_diagnostics &err) {
+    spdlog::error("getUserChattingThreadsByActivity failed: {0}:{1} Operation "
+                  "failed with error code: {2} Server diagnostics: {3}",
+                  __FILE__, __LINE__, std::to_string(err.code().value()),
+                  err.get_diagnostics().server_message().data());
+  }
+  return std::nullopt;
+}
+
 std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
 mysql::MySQLConnection::getChattingHistoryRecord(const std::size_t thread_id,
                                                  const std::size_t msg_id,
@@ -570,29 +1198,49 @@ mysql::MySQLConnection::getChattingHistoryRecord(const std::size_t thread_id,
                                                  bool &is_EOF) {
   try {
     is_EOF = true;
-    next_msg_id = msg_id;
+    next_msg_id = std::to_string(msg_id);
+
+    /*
+     * messages before archived_until live in archive segments, MySQL only
+     * serves the rest of the page after them
+     */
+    auto archive = chat::HistoryArchive::get_instance();
+    const std::size_t archived_until = archive->getArchivedUntil(thread_id);
 
     std::vector<std::unique_ptr<chat::MsgInfo>> result;
+    if (msg_id < archived_until) {
+      result = archive->getPage(thread_id, msg_id, interval + 1);
+    }
 
-    auto flags = executeCommandOrThrow(MySQLSelection::GET_USER_CHAT_RECORDS,
-                                       thread_id, msg_id, interval + 1);
+    if (result.size() > interval) {
+      is_EOF = false;
+      result.pop_back();
+      if (!result.empty()) {
+        next_msg_id = result.back()->message_id;
+      }
+      return result;
+    }
 
-    if (!flags.affected_rows())
-      return std::nullopt;
-    if (flags.rows().empty())
+    auto flags = executeCommandOrThrow(
+        MySQLSelection::GET_USER_CHAT_RECORDS, thread_id,
+        std::max(msg_id, archived_until), interval + 1 - result.size());
+
+    if (result.empty() && flags.rows().empty())
       return std::nullopt;
 
     for (const auto &tuple : flags.rows()) {
-      auto messag_id = tuple.at(0).as_string(); // message_id
+      auto message_id = tuple.at(0).as_uint64(); // message_id
       auto status = tuple.at(1).as_int64();     // message_status
       auto sender = tuple.at(2).as_string();    // message_sender
       auto receiver = tuple.at(3).as_string();  // message_receiver
       [[maybe_unused]] auto timestamp = tuple.at(4).as_string();
       auto content = tuple.at(5).as_string(); // message_content
 
-      result.push_back(std::make_unique<chat::TextMsgInfo>(
+      auto item = std::make_unique<chat::TextMsgInfo>(
           std::to_string(thread_id), sender, receiver, content, status,
-          timestamp));
+          timestamp);
+      item->setMsgID(std::to_string(message_id));
+      result.push_back(std::move(item));
     }
 
     // if current list size is more than interval(interval + 1)
@@ -711,7 +1359,13 @@ mysql::MySQLConnection::execFriendConfirmationTransaction(
       return std::nullopt; // No Relavant Info Found Here! ROLLBACK
 
     /*Store Request->Confirmer Init Chat Info In ChatMsgHistoryBank*/
+    auto generated = chat::MessageIdGenerator::get_instance()->next();
+    if (!generated.has_value())
+      return std::nullopt; // ROLLBACK
+
+    message_id = std::to_string(*generated);
     flag = executeCommandOrThrow(MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE,
+                                 /*message_id = */ message_id,
                                  /*thread_id = */ thread_id,
                                  /*message_status = */ 0,
                                  /*message_sender= */ requester_uuid,
@@ -721,15 +1375,18 @@ mysql::MySQLConnection::execFriendConfirmationTransaction(
     if (!flag.affected_rows())
       return std::nullopt; // No Relavant Info Found Here! ROLLBACK
 
-    message_id.clear();
-    message_id = std::to_string(flag.last_insert_id());
-
     res.push_back(std::make_shared<chat::FriendingConfirmInfo>(
         chat::MsgType::TEXT, thread_id, message_id, requester, confimer,
         req_message));
 
     /*Store  Confirmer->Request Init Chat Info In ChatMsgHistoryBank*/
+    generated = chat::MessageIdGenerator::get_instance()->next();
+    if (!generated.has_value())
+      return std::nullopt; // ROLLBACK
+
+    message_id = std::to_string(*generated);
     flag = executeCommandOrThrow(MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE,
+                                 /*message_id = */ message_id,
                                  /*thread_id = */ thread_id,
                                  /*message_status = */ 0,
                                  /*message_sender= */ confirmer_uuid,
@@ -739,9 +1396,6 @@ mysql::MySQLConnection::execFriendConfirmationTransaction(
     if (!flag.affected_rows())
       return std::nullopt; // No Relavant Info Found Here! ROLLBACK
 
-    message_id.clear();
-    message_id = std::to_string(flag.last_insert_id());
-
     /*COMMIT TRANSACTION!*/
     transaction_guard.commit();
 
@@ -18,9 +18,10 @@ mysql::MySQLConnectionPool::MySQLConnectionPool() noexcept
 mysql::MySQLConnectionPool::MySQLConnectionPool(
     std::size_t timeOut, const std::string &username,
     const std::string &password, const std::string &database,
-    const std::string &host, const std::string &port) noexcept
+    const std::string &host, const std::string &port,
+    const bool replica) noexcept
     : m_timeout(timeOut), m_username(username), m_password(password),
-      m_database(database), m_host(host), m_port(port) {
+      m_database(database), m_host(host), m_port(port), m_replica(replica) {
 
   registerSQLStatement();
 
@@ -91,6 +92,26 @@ void mysql::MySQLConnectionPool::registerSQLStatement() {
                          fmt::format("SELECT * FROM UserProfile WHERE {} = ?",
                                      std::string("uuid"))));
 
+  /*
+   * a prepared statement could not take a list, JSON_TABLE turns one json
+   * array into rows, every uuid is still a primary key lookup
+   */
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_USER_PROFILES,
+      fmt::format("SELECT p.{0}, p.{1}, a.{2}, p.{3}, p.{4}, p.{5} "
+                  "FROM JSON_TABLE(?, '$[*]' COLUMNS({0} INT PATH '$')) AS ids "
+                  "JOIN {6} AS a ON a.{0} = ids.{0} "
+                  "JOIN {7} AS p ON p.{0} = ids.{0}",
+                  std::string("uuid"),                       // {0}
+                  std::string("avatar"),                     // {1}
+                  std::string("username"),                   // {2}
+                  std::string("nickname"),                   // {3}
+                  std::string("description"),                // {4}
+                  std::string("sex"),                        // {5}
+                  std::string("chatting.Authentication"),    // {6}
+                  std::string("chatting.UserProfile")        // {7}
+                  )));
+
   m_sql.insert(
       std::pair(MySQLSelection::GET_USER_UUID,
                 fmt::format("SELECT uuid FROM Authentication WHERE {} = ?",
@@ -191,7 +212,11 @@ void mysql::MySQLConnectionPool::registerSQLStatement() {
                 fmt::format("WITH all_threads AS ("
                             "SELECT {0}, {1}, {2}, {6} AS {3} "
                             "FROM {8} "
-                            "WHERE ({1} = ? OR {2} = ?) AND {8}.{0} > ? "
+                            "WHERE {1} = ? AND {8}.{0} > ? "
+                            "UNION ALL "
+                            "SELECT {0}, {1}, {2}, {6} AS {3} "
+                            "FROM {8} "
+                            "WHERE {2} = ? AND {8}.{0} > ? "
                             "UNION ALL "
                             "SELECT {0}, {9} AS {1}, {9} AS {2}, {7} AS {3} "
                             "FROM {10} "
@@ -248,9 +273,250 @@ void mysql::MySQLConnectionPool::registerSQLStatement() {
 
   m_sql.insert(std::pair(
       MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE,
-      fmt::format("INSERT INTO {} ({}, {}, {}, {}, {}, {}, {}) "
-                  " VALUES (?, ?, ?, ?, NOW(), NOW(), ?);",
-                  std::string("ChatMsgHistoryBank"), std::string("thread_id"),
+      fmt::format("INSERT INTO {} ({}, {}, {}, {}, {}, {}, {}, {}) "
+                  " VALUES (?, ?, ?, ?, ?, NOW(), NOW(), ?);",
+                  std::string("ChatMsgHistoryBank"),
+                  std::string("message_id"), std::string("thread_id"),
+                  std::string("message_status"), std::string("message_sender"),
+                  std::string("message_receiver"), std::string("created_at"),
+                  std::string("updated_at"), std::string("message_content"))));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_USER_SEARCH_ENTRIES,
+      fmt::format("SELECT A.{0}, A.{1}, COALESCE(P.{2}, '') "
+                  "FROM {3} AS A LEFT JOIN {4} AS P ON P.{0} = A.{0} "
+                  "WHERE A.{0} > ? ORDER BY A.{0} ASC LIMIT ?;",
+                  std::string("uuid"),           // {0}
+                  std::string("username"),       // {1}
+                  std::string("nickname"),       // {2}
+                  std::string("Authentication"), // {3}
+                  std::string("UserProfile")     // {4}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_MSG_HISTORY_AFTER,
+      fmt::format("SELECT {0}, {1}, {2}, {3}, {4}, "
+                  "CAST(UNIX_TIMESTAMP({5}) AS UNSIGNED), {6} FROM {7} "
+                  "WHERE {0} > ? AND {0} < ? ORDER BY {0} ASC LIMIT ?;",
+                  std::string("message_id"),                  // {0}
+                  std::string("thread_id"),                   // {1}
+                  std::string("message_status"),              // {2}
+                  std::string("message_sender"),              // {3}
+                  std::string("message_receiver"),            // {4}
+                  std::string("created_at"),                  // {5}
+                  std::string("message_content"),             // {6}
+                  std::string("chatting.ChatMsgHistoryBank")  // {7}
+                  )));
+
+  /*created_at is returned as unix timestamp, same as write-behind mode*/
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_MSG_HISTORY_BY_ID,
+      fmt::format("SELECT {0}, {1}, {2}, {3}, "
+                  "CAST(UNIX_TIMESTAMP({4}) AS UNSIGNED), {5} "
+                  "FROM {6} WHERE {7} = ? AND {0} = ?;",
+                  std::string("message_id"),                  // {0}
+                  std::string("message_status"),              // {1}
+                  std::string("message_sender"),              // {2}
+                  std::string("message_receiver"),            // {3}
+                  std::string("created_at"),                  // {4}
+                  std::string("message_content"),             // {5}
+                  std::string("chatting.ChatMsgHistoryBank"), // {6}
+                  std::string("thread_id")                    // {7}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::CHECK_THREAD_MEMBER,
+      fmt::format("SELECT 1 FROM {0} WHERE {2} = ? AND ({3} = ? OR {4} = ?) "
+                  "UNION ALL "
+                  "SELECT 1 FROM {1} WHERE {2} = ? AND {5} = ? LIMIT 1;",
+                  std::string("chatting.PrivateChat"), // {0}
+                  std::string("chatting.GroupMember"), // {1}
+                  std::string("thread_id"),            // {2}
+                  std::string("user1_uuid"),           // {3}
+                  std::string("user2_uuid"),           // {4}
+                  std::string("user_uuid")             // {5}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::CHECK_PRIVATE_CHAT_THREAD,
+      fmt::format("SELECT 1 FROM {0} WHERE {1} = ? AND {2} = ? AND {3} = ? "
+                  "LIMIT 1;",
+                  std::string("chatting.PrivateChat"), // {0}
+                  std::string("thread_id"),            // {1}
+                  std::string("user1_uuid"),           // {2}
+                  std::string("user2_uuid")            // {3}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_ARCHIVABLE_THREADS,
+      fmt::format("SELECT DISTINCT {0} FROM {1} "
+                  "WHERE {2} < ? AND {3} < FROM_UNIXTIME(?) LIMIT ?;",
+                  std::string("thread_id"),                   // {0}
+                  std::string("chatting.ChatMsgHistoryBank"), // {1}
+                  std::string("message_id"),                  // {2}
+                  std::string("created_at")                   // {3}
+                  )));
+
+  /*created_at is stored as unix timestamp inside archive segments*/
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_ARCHIVABLE_MSG,
+      fmt::format("SELECT {0}, {1}, {2}, {3}, "
+                  "CAST(UNIX_TIMESTAMP({4}) AS UNSIGNED), {5} "
+                  "FROM {6} WHERE {7} = ? AND {0} > ? AND {0} < ? "
+                  "AND {4} < FROM_UNIXTIME(?) ORDER BY {0} ASC LIMIT ?;",
+                  std::string("message_id"),                  // {0}
+                  std::string("message_status"),              // {1}
+                  std::string("message_sender"),              // {2}
+                  std::string("message_receiver"),            // {3}
+                  std::string("created_at"),                  // {4}
+                  std::string("message_content"),             // {5}
+                  std::string("chatting.ChatMsgHistoryBank"), // {6}
+                  std::string("thread_id")                    // {7}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_THREAD_LAST_ACTIVITY,
+      fmt::format("SELECT CAST(UNIX_TIMESTAMP(MAX({0})) AS UNSIGNED) "
+                  "FROM {1} WHERE {2} = ?;",
+                  std::string("created_at"),                  // {0}
+                  std::string("chatting.ChatMsgHistoryBank"), // {1}
+                  std::string("thread_id")                    // {2}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::CREATE_PRIVATE_CHAT_COPY,
+      fmt::format("INSERT IGNORE INTO {0} ({1}, {2}, {3}, {4}) "
+                  "VALUES (?, ?, ?, NOW());",
+                  std::string("chatting.PrivateChat"), // {0}
+                  std::string("thread_id"),            // {1}
+                  std::string("user1_uuid"),           // {2}
+                  std::string("user2_uuid"),           // {3}
+                  std::string("created_at")            // {4}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_PRIVATE_CHAT_AFTER,
+      fmt::format("SELECT {0}, {1}, {2} FROM {3} "
+                  "WHERE {0} > ? ORDER BY {0} ASC LIMIT ?;",
+                  std::string("thread_id"),           // {0}
+                  std::string("user1_uuid"),          // {1}
+                  std::string("user2_uuid"),          // {2}
+                  std::string("chatting.PrivateChat") // {3}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::DELETE_MSG_HISTORY_BY_ID,
+      fmt::format("DELETE FROM {0} WHERE {1} = ?;",
+                  std::string("chatting.ChatMsgHistoryBank"), // {0}
+                  std::string("message_id")                   // {1}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::CHECK_MSG_HISTORY_BY_ID,
+      fmt::format("SELECT 1 FROM {0} WHERE {1} = ? LIMIT 1;",
+                  std::string("chatting.ChatMsgHistoryBank"), // {0}
+                  std::string("message_id")                   // {1}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::DELETE_ARCHIVED_MSG,
+      fmt::format("DELETE FROM {0} WHERE {1} = ? AND {2} <= ? "
+                  "AND {3} < FROM_UNIXTIME(?);",
+                  std::string("chatting.ChatMsgHistoryBank"), // {0}
+                  std::string("thread_id"),                   // {1}
+                  std::string("message_id"),                  // {2}
+                  std::string("created_at")                   // {3}
+                  )));
+
+  m_sql.insert(std::pair(MySQLSelection::GET_GROUP_MEMBERS,
+                         fmt::format("SELECT {0} FROM {1} WHERE {2} = ?;",
+                                     std::string("user_uuid"),   // {0}
+                                     std::string("GroupMember"), // {1}
+                                     std::string("thread_id")    // {2}
+                                     )));
+
+  /*
+   * every thread of a user with its last activity(unix timestamp), the last
+   * message time is found by search_thread_created index
+   */
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_USER_CHAT_THREADS_BY_ACTIVITY,
+      fmt::format("SELECT t.{0}, t.{1}, t.{2}, t.{3}, "
+                  "CAST(COALESCE((SELECT UNIX_TIMESTAMP(MAX(m.{5})) "
+                  "FROM {10} m WHERE m.{0} = t.{0}), "
+                  "UNIX_TIMESTAMP(t.{5})) AS UNSIGNED) "
+                  "FROM ("
+                  "SELECT {0}, {1}, {2}, {6} AS {3}, {5} FROM {8} "
+                  "WHERE {1} = ? "
+                  "UNION ALL "
+                  "SELECT {0}, {1}, {2}, {6} AS {3}, {5} FROM {8} "
+                  "WHERE {2} = ? "
+                  "UNION ALL "
+                  "SELECT {0}, NULL AS {1}, NULL AS {2}, {7} AS {3}, "
+                  "joined_date AS {5} FROM {9} "
+                  "WHERE {4} = ?"
+                  ") AS t;",
+                  std::string("thread_id"),                   // {0}
+                  std::string("user1_uuid"),                  // {1}
+                  std::string("user2_uuid"),                  // {2}
+                  std::string("type"),                        // {3}
+                  std::string("user_uuid"),                   // {4}
+                  std::string("created_at"),                  // {5}
+                  std::string("'PRIVATE'"),                   // {6}
+                  std::string("'GROUP'"),                     // {7}
+                  std::string("chatting.PrivateChat"),        // {8}
+                  std::string("chatting.GroupMember"),        // {9}
+                  std::string("chatting.ChatMsgHistoryBank")  // {10}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::UPDATE_READ_CURSOR,
+      fmt::format("INSERT INTO {0} ({1}, {2}, {3}) VALUES (?, ?, ?) "
+                  "ON DUPLICATE KEY UPDATE {3} = GREATEST({3}, VALUES({3}));",
+                  std::string("ChatReadCursor"),      // {0}
+                  std::string("user_uuid"),           // {1}
+                  std::string("thread_id"),           // {2}
+                  std::string("last_read_message_id") // {3}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::UPDATE_MSG_STATUS_READ,
+      fmt::format("UPDATE {0} SET {1} = 1 "
+                  "WHERE {2} = ? AND {3} = ? AND {4} <= ? AND {1} = 0;",
+                  std::string("ChatMsgHistoryBank"), // {0}
+                  std::string("message_status"),     // {1}
+                  std::string("thread_id"),          // {2}
+                  std::string("message_receiver"),   // {3}
+                  std::string("message_id")          // {4}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_READ_CURSORS,
+      fmt::format("SELECT {0}, {1} FROM {2} WHERE {3} = ?;",
+                  std::string("thread_id"),            // {0}
+                  std::string("last_read_message_id"), // {1}
+                  std::string("ChatReadCursor"),       // {2}
+                  std::string("user_uuid")             // {3}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::GET_THREAD_UNREAD,
+      fmt::format("SELECT CAST(COUNT(*) AS UNSIGNED), "
+                  "CAST(COALESCE(MAX({0}), 0) AS UNSIGNED) FROM {1} "
+                  "WHERE {2} = ? AND {0} > ? AND {3} <> ?;",
+                  std::string("message_id"),         // {0}
+                  std::string("ChatMsgHistoryBank"), // {1}
+                  std::string("thread_id"),          // {2}
+                  std::string("message_sender")      // {3}
+                  )));
+
+  m_sql.insert(std::pair(
+      MySQLSelection::CREATE_MSG_HISTORY_BANK_TUPLE_WITH_ID,
+      fmt::format("INSERT IGNORE INTO {} ({}, {}, {}, {}, {}, {}, {}, {}) "
+                  " VALUES (?, ?, ?, ?, ?, FROM_UNIXTIME(?), FROM_UNIXTIME(?), "
+                  "?);",
+                  std::string("ChatMsgHistoryBank"),
+                  std::string("message_id"), std::string("thread_id"),
                   std::string("message_status"), std::string("message_sender"),
                   std::string("message_receiver"), std::string("created_at"),
                   std::string("updated_at"), std::string("message_content"))));
@@ -278,19 +544,13 @@ void mysql::MySQLConnectionPool::roundRobinCheckLowGranularity() {
 
   // get target queue size first, we need to know how many stubs are instead the
   // queue
-  {
-    std::lock_guard<std::mutex> _lckg(m_mtx);
-    expectedStubs = m_stub_queue.size();
-  }
+  expectedStubs = idle();
 
   for (; !expectedStubs && currentStubs < expectedStubs; currentStubs++) {
 
-    {
-      // sometimes. m_stub_queue might be empty;
-      std::lock_guard<std::mutex> _lckg(m_mtx);
-      if (m_stub_queue.empty()) {
-        break;
-      }
+    // sometimes. pool might be empty;
+    if (!idle()) {
+      break;
     }
 
     // get stub from the queue
@@ -319,8 +579,8 @@ void mysql::MySQLConnectionPool::roundRobinCheckLowGranularity() {
       spdlog::warn("[MySQL DataBase]: Error = {} Restarting Connection...",
                    e.what());
 
-      // disable RAII feature to return this item back to the pool
-      instance.invalidate();
+      // drop this item instead of returning it back to the pool
+      instance.discard();
 
       fail_count++; // record failed time!
     }
@@ -348,10 +608,7 @@ bool mysql::MySQLConnectionPool::connector(const std::string &username,
         username, password, database, host, port, this);
     new_item->last_operation_time = currentTimeStamp;
 
-    {
-      std::lock_guard<std::mutex> _lckg(m_mtx);
-      m_stub_queue.push(std::move(new_item));
-    }
+    add(std::move(new_item));
 
     return true;
   } catch (const std::exception &e) {
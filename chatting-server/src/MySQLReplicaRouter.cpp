@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <config/ServerConfig.hpp>
+#include <iterator>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <tools/tools.hpp>
+
+mysql::MySQLReplicaRouter::MySQLReplicaRouter()
+    : m_window(ServerConfig::get_instance()->MySQLReadYourWritesWindow),
+      m_prune_size(min_prune_size) {
+
+  for (const auto &[name, info] : ServerConfig::get_instance()->MySQLReplicas) {
+    auto source = MySQLShardRouter::get_instance()->getShard(info.shard);
+    if (!source) {
+      spdlog::warn("[MySQL Replica]: Replica {} Copies Unknown Shard {}, "
+                   "Skipped!",
+                   name, info.shard);
+      continue;
+    }
+
+    spdlog::info("[MySQL Replica]: Connecting to Replica {} Of Shard {} ip: "
+                 "{}, port: {}, database: {}",
+                 name, info.shard, info.host, info.port, info.database);
+
+    m_replicas[source.get()].push_back(pool_ptr(new MySQLConnectionPool(
+        ServerConfig::get_instance()->MySQL_timeout, info.username,
+        info.passwd, info.database, info.host, info.port,
+        /*replica = */ true)));
+  }
+}
+
+mysql::MySQLReplicaRouter::pool_ptr
+mysql::MySQLReplicaRouter::read(const pool_ptr &owner) const {
+  auto it = m_replicas.find(owner.get());
+  if (it == m_replicas.end()) {
+    return owner;
+  }
+
+  /*the first one wins a tie, idle replicas are all equal*/
+  const pool_ptr *target = &it->second.front();
+  for (const auto &replica : it->second) {
+    if (replica->outstanding() < (*target)->outstanding()) {
+      target = &replica;
+    }
+  }
+  return *target;
+}
+
+mysql::MySQLReplicaRouter::pool_ptr
+mysql::MySQLReplicaRouter::read(const pool_ptr &owner,
+                                const std::size_t uuid) {
+  if (!m_replicas.count(owner.get()) || recentlyWrote(uuid)) {
+    return owner;
+  }
+  return read(owner);
+}
+
+mysql::MySQLReplicaRouter::pool_ptr
+mysql::MySQLReplicaRouter::read(const pool_ptr &owner,
+                                const std::string &uuid) {
+  /*nobody knows what an invalid uuid wrote, source is always right*/
+  auto uuid_op = tools::string_to_value<std::size_t>(uuid);
+  if (!uuid_op.has_value()) {
+    return owner;
+  }
+  return read(owner, uuid_op.value());
+}
+
+mysql::MySQLReplicaRouter::pool_ptr
+mysql::MySQLReplicaRouter::read(const pool_ptr &owner,
+                                const std::vector<std::size_t> &uuids) {
+  if (!m_replicas.count(owner.get())) {
+    return owner;
+  }
+  for (const auto uuid : uuids) {
+    if (recentlyWrote(uuid)) {
+      return owner;
+    }
+  }
+  return read(owner);
+}
+
+mysql::MySQLReplicaRouter::pool_ptr
+mysql::MySQLReplicaRouter::read(const std::size_t uuid) {
+  return read(MySQLConnectionPool::get_instance(), uuid);
+}
+
+mysql::MySQLReplicaRouter::pool_ptr
+mysql::MySQLReplicaRouter::read(const std::string &uuid) {
+  return read(MySQLConnectionPool::get_instance(), uuid);
+}
+
+void mysql::MySQLReplicaRouter::wrote(const std::size_t uuid) {
+  if (m_replicas.empty()) {
+    return;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+  m_writers[uuid] = now + m_window;
+
+  if (m_writers.size() < m_prune_size) {
+    return;
+  }
+
+  for (auto it = m_writers.begin(); it != m_writers.end();) {
+    it = it->second <= now ? m_writers.erase(it) : std::next(it);
+  }
+  m_prune_size = std::max(min_prune_size, m_writers.size() * 2);
+}
+
+void mysql::MySQLReplicaRouter::wrote(const std::string &uuid) {
+  if (auto uuid_op = tools::string_to_value<std::size_t>(uuid); uuid_op) {
+    wrote(uuid_op.value());
+  }
+}
+
+bool mysql::MySQLReplicaRouter::recentlyWrote(const std::size_t uuid) {
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+  auto it = m_writers.find(uuid);
+  return it != m_writers.end() &&
+         it->second > std::chrono::steady_clock::now();
+}
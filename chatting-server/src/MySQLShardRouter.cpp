@@ -0,0 +1,476 @@
+#include <algorithm>
+#include <config/ServerConfig.hpp>
+#include <limits>
+#include <map>
+#include <redis/LockService.hpp>
+#include <set>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLShardRouter.hpp>
+#include <tools/tools.hpp>
+
+/*[MySQL] section is the primary shard*/
+std::string mysql::MySQLShardRouter::primary_shard = "primary";
+
+/*bucket -> shard name*/
+std::string mysql::MySQLShardRouter::shard_map_key = "mysql_shard_map";
+
+/*only one migration runs at a time*/
+std::string mysql::MySQLShardRouter::migration_lock = "mysql_shard_migration";
+
+mysql::MySQLShardRouter::MySQLShardRouter()
+    : m_stop(false), m_buckets(std::max<std::size_t>(
+                         1, ServerConfig::get_instance()->MySQLShardBuckets)),
+      m_refresh_interval(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->MySQLShardRefreshInterval)),
+      m_batch_size(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->MySQLShardMigrateBatchSize)) {
+
+  m_shards[primary_shard] = MySQLConnectionPool::get_instance();
+
+  for (const auto &[name, info] : ServerConfig::get_instance()->MySQLShards) {
+    if (name == primary_shard) {
+      spdlog::warn("[MySQL Shard]: Shard Name {} Is Reserved For [MySQL], "
+                   "Skipped!",
+                   name);
+      continue;
+    }
+
+    spdlog::info("[MySQL Shard]: Connecting to Shard {} ip: {}, port: {}, "
+                 "database: {}",
+                 name, info.host, info.port, info.database);
+
+    m_shards[name] = pool_ptr(new MySQLConnectionPool(
+        ServerConfig::get_instance()->MySQL_timeout, info.username,
+        info.passwd, info.database, info.host, info.port));
+  }
+
+  /*every bucket belongs to primary until redis says otherwise*/
+  m_owners.assign(m_buckets, primary_shard);
+  m_routes.assign(m_buckets, m_shards[primary_shard]);
+  reload();
+
+  m_refresher = std::thread([this]() { refresher(); });
+}
+
+mysql::MySQLShardRouter::~MySQLShardRouter() { shutdown(); }
+
+void mysql::MySQLShardRouter::shutdown() {
+  if (m_stop.exchange(true)) {
+    return;
+  }
+
+  m_cv.notify_all();
+  if (m_refresher.joinable()) {
+    m_refresher.join();
+  }
+}
+
+void mysql::MySQLShardRouter::refresher() {
+  while (!m_stop) {
+    {
+      std::unique_lock<std::mutex> _lckg(m_mtx);
+      if (m_cv.wait_for(_lckg, m_refresh_interval,
+                        [this]() { return m_stop.load(); })) {
+        break;
+      }
+    }
+    reload();
+  }
+}
+
+bool mysql::MySQLShardRouter::reload() {
+  std::optional<std::vector<std::pair<std::string, std::string>>> fields;
+  {
+    RedisRAII raii;
+    fields = raii->get()->getHashAll(shard_map_key);
+
+    /*redis is not available, a missing map means nothing has been moved*/
+    if (!fields.has_value() && raii->get()->existKey(shard_map_key)) {
+      return false;
+    }
+  }
+
+  std::vector<std::string> owners(m_buckets, primary_shard);
+  std::vector<pool_ptr> routes(m_buckets, m_shards.at(primary_shard));
+  for (const auto &[field, shard] :
+       fields.value_or(std::vector<std::pair<std::string, std::string>>{})) {
+    auto bucket = tools::string_to_value<std::size_t>(field);
+    if (!bucket.has_value() || *bucket >= m_buckets) {
+      continue;
+    }
+
+    /*routing this bucket anywhere else would lose its messages*/
+    auto it = m_shards.find(shard);
+    if (it == m_shards.end()) {
+      spdlog::error("[MySQL Shard]: Bucket {} Belongs To Unknown Shard {}, "
+                    "Shard Map Is Not Updated!",
+                    *bucket, shard);
+      return false;
+    }
+    owners[*bucket] = shard;
+    routes[*bucket] = it->second;
+  }
+
+  std::unique_lock<std::shared_mutex> _lckg(m_map_mtx);
+  m_owners.swap(owners);
+  m_routes.swap(routes);
+  return true;
+}
+
+mysql::MySQLShardRouter::pool_ptr
+mysql::MySQLShardRouter::route(const std::size_t thread_id) const {
+  std::shared_lock<std::shared_mutex> _lckg(m_map_mtx);
+  return m_routes[getBucket(thread_id)];
+}
+
+mysql::MySQLShardRouter::pool_ptr
+mysql::MySQLShardRouter::route(const std::string &thread_id) const {
+  auto thread_id_op = tools::string_to_value<std::size_t>(thread_id);
+  if (!thread_id_op.has_value()) {
+    return m_shards.at(primary_shard);
+  }
+  return route(thread_id_op.value());
+}
+
+mysql::MySQLShardRouter::pool_ptr
+mysql::MySQLShardRouter::getShard(const std::string &name) const {
+  auto it = m_shards.find(name);
+  return it == m_shards.end() ? nullptr : it->second;
+}
+
+std::vector<mysql::MySQLShardRouter::pool_ptr>
+mysql::MySQLShardRouter::getShards() const {
+  std::vector<pool_ptr> shards{m_shards.at(primary_shard)};
+  for (const auto &[name, pool] : m_shards) {
+    if (name != primary_shard) {
+      shards.push_back(pool);
+    }
+  }
+  return shards;
+}
+
+std::string mysql::MySQLShardRouter::getOwner(const std::size_t bucket) const {
+  std::shared_lock<std::shared_mutex> _lckg(m_map_mtx);
+  return m_owners[bucket];
+}
+
+bool mysql::MySQLShardRouter::migrate(const std::size_t bucket,
+                                      const std::string &shard) {
+  if (bucket >= m_buckets) {
+    spdlog::error("[MySQL Shard]: Bucket {} Is Out Of Range [0, {})", bucket,
+                  m_buckets);
+    return false;
+  }
+  return migrate(std::vector<std::size_t>{bucket}, shard);
+}
+
+bool mysql::MySQLShardRouter::split(const std::string &from,
+                                    const std::string &to) {
+  if (!m_shards.count(from)) {
+    spdlog::error("[MySQL Shard]: Unknown Shard {}!", from);
+    return false;
+  }
+
+  if (!reload()) {
+    spdlog::error("[MySQL Shard]: Load Shard Map Failed!");
+    return false;
+  }
+
+  std::vector<std::size_t> owned;
+  for (std::size_t bucket = 0; bucket < m_buckets; ++bucket) {
+    if (getOwner(bucket) == from) {
+      owned.push_back(bucket);
+    }
+  }
+
+  /*keep every other bucket, the rest moves to the new shard*/
+  std::vector<std::size_t> moving;
+  for (std::size_t i = 1; i < owned.size(); i += 2) {
+    moving.push_back(owned[i]);
+  }
+  return migrate(moving, to);
+}
+
+bool mysql::MySQLShardRouter::migrate(const std::vector<std::size_t> &buckets,
+                                      const std::string &shard) {
+  auto target = m_shards.find(shard);
+  if (target == m_shards.end()) {
+    spdlog::error("[MySQL Shard]: Unknown Shard {}!", shard);
+    return false;
+  }
+
+  auto lease = redis::LockService::get_instance()->acquire(
+      migration_lock, std::chrono::seconds(1),
+      std::chrono::seconds(migration_lock_ttl));
+
+  if (!lease.has_value()) {
+    spdlog::error("[MySQL Shard]: Another Migration Is Running!");
+    return false;
+  }
+
+  /*
+   * owner -> buckets moving away from it, map has to be fresh, otherwise
+   * rows would be copied from a wrong shard
+   */
+  std::map<std::string, std::set<std::size_t>> sources;
+  const bool loaded = reload();
+  if (loaded) {
+    for (const auto bucket : buckets) {
+      if (auto owner = getOwner(bucket); owner != shard) {
+        sources[owner].insert(bucket);
+      }
+    }
+  }
+
+  const bool status = loaded && move(sources, shard, lease.value());
+
+  redis::LockService::get_instance()->release(lease.value());
+  return status;
+}
+
+bool mysql::MySQLShardRouter::move(
+    const std::map<std::string, std::set<std::size_t>> &sources,
+    const std::string &shard, const redis::Lease &lease) {
+
+  if (sources.empty()) {
+    spdlog::info("[MySQL Shard]: Nothing To Move To Shard {}", shard);
+    return true;
+  }
+
+  const auto &to = m_shards.at(shard);
+
+  /*1. bulk copy while old owners are still serving those buckets*/
+  std::map<std::string, std::size_t> watermarks;
+  for (const auto &[owner, buckets] : sources) {
+    spdlog::info("[MySQL Shard]: Copying {} Buckets From {} To {}",
+                 buckets.size(), owner, shard);
+
+    auto &watermark = watermarks[owner];
+    if (!copyPrivateChats(m_shards.at(owner), to, buckets) ||
+        !copyMessages(m_shards.at(owner), to, buckets, watermark)) {
+      return false;
+    }
+  }
+
+  /*another migration might have started once the lease was lost*/
+  auto locks = redis::LockService::get_instance();
+  if (!locks->validate(lease)) {
+    spdlog::error("[MySQL Shard]: Migration Lease Lost, Nothing Moved!");
+    return false;
+  }
+
+  /*2. switch owners, new messages go to the new shard after next reload*/
+  std::vector<std::vector<std::string>> commands;
+  for (const auto &[owner, buckets] : sources) {
+    for (const auto bucket : buckets) {
+      commands.push_back(
+          {"HSET", shard_map_key, std::to_string(bucket), shard});
+    }
+  }
+
+  {
+    RedisRAII raii;
+    if (!raii->get()->pipeline(commands)) {
+      spdlog::error("[MySQL Shard]: Update Shard Map Failed, Nothing Moved!");
+      return false;
+    }
+  }
+  reload();
+
+  spdlog::info("[MySQL Shard]: Waiting {}s For Every Server To Reload Shard "
+               "Map",
+               2 * m_refresh_interval.count());
+  std::this_thread::sleep_for(2 * m_refresh_interval);
+
+  /*3. rows written to old owners before they noticed, then remove them*/
+  for (const auto &[owner, buckets] : sources) {
+    auto &watermark = watermarks[owner];
+    if (!copyPrivateChats(m_shards.at(owner), to, buckets) ||
+        !copyMessages(m_shards.at(owner), to, buckets, watermark) ||
+        !drainMessages(m_shards.at(owner), to, buckets, watermark, lease)) {
+      spdlog::error("[MySQL Shard]: Buckets Already Belong To {}, But Some "
+                    "Messages Are Left On {}, Please Move Them Back And "
+                    "Try Again!",
+                    shard, owner);
+      return false;
+    }
+  }
+
+  spdlog::info("[MySQL Shard]: Buckets Moved To Shard {} Successfully",
+               shard);
+  return true;
+}
+
+bool mysql::MySQLShardRouter::copyPrivateChats(
+    const pool_ptr &from, const pool_ptr &to,
+    const std::set<std::size_t> &buckets) {
+
+  /*private chats are immutable, copy them all again is harmless*/
+  std::size_t after = 0;
+  while (true) {
+    std::optional<std::vector<std::unique_ptr<chat::ChatThreadMeta>>> list;
+    {
+      MySQLRAII mysql(from);
+      list = mysql->get()->getPrivateChatsAfter(after, m_batch_size);
+    }
+
+    if (!list.has_value()) {
+      return false;
+    }
+    if (list->empty()) {
+      return true;
+    }
+
+    const std::size_t count = list->size();
+    after = tools::string_to_value<std::size_t>(list->back()->_thread_id)
+                .value_or(std::numeric_limits<std::size_t>::max());
+
+    list->erase(std::remove_if(list->begin(), list->end(),
+                               [this, &buckets](const auto &item) {
+                                 auto thread_id =
+                                     tools::string_to_value<std::size_t>(
+                                         item->_thread_id);
+                                 return !thread_id.has_value() ||
+                                        !buckets.count(getBucket(*thread_id));
+                               }),
+                list->end());
+
+    {
+      MySQLRAII mysql(to);
+      if (!mysql->get()->copyPrivateChats(*list)) {
+        return false;
+      }
+    }
+
+    if (count < m_batch_size) {
+      return true;
+    }
+  }
+}
+
+bool mysql::MySQLShardRouter::copyMessages(const pool_ptr &from,
+                                           const pool_ptr &to,
+                                           const std::set<std::size_t> &buckets,
+                                           std::size_t &watermark) {
+  while (true) {
+    std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>> list;
+    {
+      MySQLRAII mysql(from);
+      list = mysql->get()->getChattingHistoryAfter(
+          watermark, std::numeric_limits<std::size_t>::max(), m_batch_size);
+    }
+
+    if (!list.has_value()) {
+      return false;
+    }
+    if (list->empty()) {
+      return true;
+    }
+
+    const std::size_t count = list->size();
+    const auto last =
+        tools::string_to_value<std::size_t>(list->back()->message_id);
+    if (!last.has_value()) {
+      return false;
+    }
+
+    list->erase(std::remove_if(list->begin(), list->end(),
+                               [this, &buckets](const auto &item) {
+                                 auto thread_id =
+                                     tools::string_to_value<std::size_t>(
+                                         item->thread_id);
+                                 return !thread_id.has_value() ||
+                                        !buckets.count(getBucket(*thread_id));
+                               }),
+                list->end());
+
+    {
+      MySQLRAII mysql(to);
+      if (!mysql->get()->copyChattingHistoryRecords(*list)) {
+        return false;
+      }
+    }
+
+    /*only move forward when this batch is stored*/
+    watermark = last.value();
+    if (count < m_batch_size) {
+      return true;
+    }
+  }
+}
+
+bool mysql::MySQLShardRouter::drainMessages(
+    const pool_ptr &from, const pool_ptr &to,
+    const std::set<std::size_t> &buckets, const std::size_t watermark,
+    const redis::Lease &lease) {
+
+  std::size_t after = 0;
+  while (after < watermark) {
+    std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>> list;
+    {
+      MySQLRAII mysql(from);
+      list = mysql->get()->getChattingHistoryAfter(after, watermark + 1,
+                                                   m_batch_size);
+    }
+
+    if (!list.has_value()) {
+      return false;
+    }
+    if (list->empty()) {
+      return true;
+    }
+
+    const std::size_t count = list->size();
+    std::vector<std::unique_ptr<chat::MsgInfo>> moving;
+    std::vector<std::size_t> ids;
+    for (auto &item : *list) {
+      auto thread_id = tools::string_to_value<std::size_t>(item->thread_id);
+      auto msg_id = tools::string_to_value<std::size_t>(item->message_id);
+      if (!msg_id.has_value()) {
+        return false;
+      }
+
+      after = *msg_id;
+      if (thread_id.has_value() && buckets.count(getBucket(*thread_id))) {
+        ids.push_back(*msg_id);
+        moving.push_back(std::move(item));
+      }
+    }
+
+    /*duplicated inserts are ignored, only rows found on to are deleted*/
+    std::optional<std::vector<std::size_t>> moved;
+    {
+      MySQLRAII mysql(to);
+      if (mysql->get()->copyChattingHistoryRecords(moving)) {
+        moved = mysql->get()->getExistingChattingHistoryIds(ids);
+      }
+    }
+    if (!moved.has_value()) {
+      return false;
+    }
+
+    if (!redis::LockService::get_instance()->validate(lease)) {
+      spdlog::error("[MySQL Shard]: Migration Lease Lost, Stop Deleting!");
+      return false;
+    }
+
+    {
+      MySQLRAII mysql(from);
+      if (!mysql->get()->deleteChattingHistoryRecords(moved.value())) {
+        return false;
+      }
+    }
+
+    if (moved->size() != ids.size()) {
+      spdlog::warn("[MySQL Shard]: {} Messages Are Not Found On Target "
+                   "Shard, They Are Kept!",
+                   ids.size() - moved->size());
+      return false;
+    }
+
+    if (count < m_batch_size) {
+      return true;
+    }
+  }
+  return true;
+}
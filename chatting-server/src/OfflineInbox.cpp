@@ -0,0 +1,92 @@
+#include <boost/json.hpp>
+#include <chat/OfflineInbox.hpp>
+#include <config/ServerConfig.hpp>
+#include <spdlog/spdlog.h>
+
+/*undelivered messages of an offline user*/
+std::string chat::OfflineInbox::inbox_prefix = "offline_inbox_";
+
+/*last delivered entry of offline_inbox_{uuid}*/
+std::string chat::OfflineInbox::cursor_prefix = "offline_cursor_";
+
+chat::OfflineInbox::OfflineInbox()
+    : m_capacity(ServerConfig::get_instance()->OfflineInboxCapacity),
+      m_ttl(ServerConfig::get_instance()->OfflineInboxTTL) {}
+
+std::string chat::OfflineInbox::encode(const chat::MsgInfo &info) {
+  boost::json::object obj;
+  obj["msg_type"] = static_cast<uint32_t>(info.msg_type);
+  obj["msg_status"] = info.status;
+  obj["msg_sender"] = info.msg_sender;
+  obj["msg_receiver"] = info.msg_receiver;
+  obj["msg_id"] = info.message_id;
+  obj["thread_id"] = info.thread_id;
+  obj["unique_id"] = info.unique_id;
+  obj["msg_content"] = info.msg_content;
+  return boost::json::serialize(obj);
+}
+
+void chat::OfflineInbox::push(
+    [[maybe_unused]] RedisRAII &raii, const std::string &uuid,
+    const std::vector<std::shared_ptr<chat::MsgInfo>> &info) {
+  push(raii, std::vector<std::string>{uuid}, info);
+}
+
+void chat::OfflineInbox::push(
+    [[maybe_unused]] RedisRAII &raii, const std::vector<std::string> &uuids,
+    const std::vector<std::shared_ptr<chat::MsgInfo>> &info) {
+
+  std::vector<std::string> encoded;
+  encoded.reserve(info.size());
+  for (const auto &item : info) {
+    if (item->isVerified) {
+      encoded.push_back(encode(*item));
+    }
+  }
+
+  if (uuids.empty() || encoded.empty()) {
+    return;
+  }
+
+  std::vector<std::vector<std::string>> commands;
+  commands.reserve(uuids.size() * (encoded.size() + 1));
+
+  for (const auto &uuid : uuids) {
+    const auto key = inbox_prefix + redis::hashTag(uuid);
+    for (const auto &msg : encoded) {
+      commands.push_back({"XADD", key, "MAXLEN", "~",
+                          std::to_string(m_capacity), "*", "msg", msg});
+    }
+    commands.push_back({"EXPIRE", key, std::to_string(m_ttl)});
+  }
+
+  if (!raii->get()->pipeline(commands)) {
+    spdlog::warn("[{}] {} Users Store Offline Messages Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, uuids.size());
+  }
+}
+
+std::vector<std::string>
+chat::OfflineInbox::drain([[maybe_unused]] RedisRAII &raii,
+                          const std::string &uuid) {
+
+  const auto tag = redis::hashTag(uuid);
+  auto res = raii->get()->evalScript(
+      drain_lua_script, {inbox_prefix + tag, cursor_prefix + tag},
+      {std::to_string(m_capacity), std::to_string(m_ttl)});
+
+  if (!res.has_value()) {
+    spdlog::warn("[{}] UUID = {} Drain Offline Inbox Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, uuid);
+    return {};
+  }
+
+  std::vector<std::string> messages;
+  messages.reserve(res->size());
+  for (auto &item : *res) {
+    if (item.has_value()) {
+      messages.push_back(std::move(*item));
+    }
+  }
+  return messages;
+}
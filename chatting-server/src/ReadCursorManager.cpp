@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <chat/ReadCursorManager.hpp>
+#include <config/ServerConfig.hpp>
+#include <map>
+#include <redis/AsyncRedisClient.hpp>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <sql/MySQLShardRouter.hpp>
+#include <tools/tools.hpp>
+#include <unordered_map>
+
+/*thread_id -> last read message_id*/
+std::string chat::ReadCursorManager::cursor_prefix = "read_cursor_";
+
+/*thread_id -> unread message count*/
+std::string chat::ReadCursorManager::unread_prefix = "unread_";
+
+/*thread_id -> newest message_id counted by unread counter*/
+std::string chat::ReadCursorManager::head_prefix = "unread_head_";
+
+/*field of unread_head_, counters of this user were rebuilt from MySQL*/
+std::string chat::ReadCursorManager::built_field = "_built";
+
+chat::ReadCursorManager::ReadCursorManager()
+    : m_stop(false),
+      m_batch_size(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->ReadCursorBatchSize)),
+      m_flush_interval(ServerConfig::get_instance()->ReadCursorFlushInterval) {
+  m_flusher = std::thread([this]() { flusher(); });
+}
+
+chat::ReadCursorManager::~ReadCursorManager() { shutdown(); }
+
+void chat::ReadCursorManager::addUnread(
+    [[maybe_unused]] RedisRAII &raii, const std::string &thread_id,
+    const std::vector<std::string> &receivers,
+    const std::vector<std::shared_ptr<MsgInfo>> &messages) {
+
+  std::vector<std::string> msg_ids;
+  msg_ids.reserve(messages.size());
+  for (const auto &item : messages) {
+    if (item->isVerified) {
+      msg_ids.push_back(item->message_id);
+    }
+  }
+
+  if (receivers.empty() || msg_ids.empty()) {
+    return;
+  }
+
+  std::vector<std::vector<std::string>> commands;
+  commands.reserve(receivers.size());
+  for (const auto &uuid : receivers) {
+    const auto tag = redis::hashTag(uuid);
+    std::vector<std::string> command{"EVAL", add_unread_lua_script, "3",
+                                     unread_prefix + tag, head_prefix + tag,
+                                     cursor_prefix + tag, thread_id};
+    command.insert(command.end(), msg_ids.begin(), msg_ids.end());
+    commands.push_back(std::move(command));
+  }
+
+  redis::AsyncRedisClient::get_instance()->asyncPipeline(
+      std::move(commands),
+      [thread_id](const boost::system::error_code &ec,
+                  const std::vector<redis::AsyncReply> &replies) {
+        auto failed = std::any_of(replies.begin(), replies.end(),
+                                  [](const auto &r) { return r.isError(); });
+        if (ec || failed) {
+          spdlog::warn("[{}] Thread ID = {} Update Unread Counter Failed!",
+                       ServerConfig::get_instance()->GrpcServerName,
+                       thread_id);
+        }
+      });
+}
+
+bool chat::ReadCursorManager::markRead([[maybe_unused]] RedisRAII &raii,
+                                       const std::size_t uuid,
+                                       const std::size_t thread_id,
+                                       const std::size_t msg_id) {
+
+  auto reply = raii->get()->evalScript(
+      mark_read_lua_script,
+      {cursor_prefix + redis::hashTag(std::to_string(uuid)),
+       unread_prefix + redis::hashTag(std::to_string(uuid)),
+       head_prefix + redis::hashTag(std::to_string(uuid))},
+      {std::to_string(thread_id), std::to_string(msg_id)});
+
+  if (!reply.has_value() || reply->empty()) {
+    return false;
+  }
+
+  bool full{};
+  {
+    /*only the newest cursor of this (user, thread) will be flushed*/
+    std::lock_guard<std::mutex> _lckg(m_mtx);
+    auto &cursor = m_pending[std::make_pair(uuid, thread_id)];
+    cursor = std::max(cursor, msg_id);
+    full = m_pending.size() >= m_batch_size;
+  }
+
+  if (full) {
+    m_cv.notify_one();
+  }
+  return true;
+}
+
+std::vector<chat::ReadCursorManager::UnreadInfo>
+chat::ReadCursorManager::getUnreadInfo([[maybe_unused]] RedisRAII &raii,
+                                       const std::string &uuid) {
+
+  std::unordered_map<std::string, UnreadInfo> threads;
+
+  /*redis lost counters of this user, or it never received any message*/
+  if (!raii->get()->existKey(head_prefix + redis::hashTag(uuid))) {
+    rebuild(raii, uuid);
+  }
+
+  auto counters = raii->get()->getHashAll(unread_prefix + redis::hashTag(uuid));
+  for (auto &[thread_id, value] :
+       counters.value_or(std::vector<std::pair<std::string, std::string>>{})) {
+    auto &info = threads[thread_id];
+    info.thread_id = thread_id;
+    info.unread = tools::string_to_value<std::size_t>(value).value_or(0);
+  }
+
+  auto cursors = raii->get()->getHashAll(cursor_prefix + redis::hashTag(uuid));
+  for (auto &[thread_id, value] :
+       cursors.value_or(std::vector<std::pair<std::string, std::string>>{})) {
+    auto &info = threads[thread_id];
+    info.thread_id = thread_id;
+    info.last_read_msg_id = value;
+  }
+
+  std::vector<UnreadInfo> result;
+  result.reserve(threads.size());
+  for (auto &[_, info] : threads) {
+    result.push_back(std::move(info));
+  }
+  return result;
+}
+
+void chat::ReadCursorManager::rebuild([[maybe_unused]] RedisRAII &raii,
+                                      const std::string &uuid) {
+
+  auto uuid_op = tools::string_to_value<std::size_t>(uuid);
+  if (!uuid_op.has_value()) {
+    return;
+  }
+
+  std::optional<std::vector<std::pair<std::size_t, std::size_t>>> cursors;
+  std::optional<std::vector<
+      std::pair<std::unique_ptr<chat::ChatThreadMeta>, std::size_t>>>
+      threads;
+  {
+    MySQLRAII mysql(mysql::MySQLReplicaRouter::get_instance()->read(uuid));
+    cursors = mysql->get()->getReadCursors(*uuid_op);
+    threads = mysql->get()->getUserChattingThreadsByActivity(*uuid_op);
+  }
+
+  if (!cursors.has_value() || !threads.has_value()) {
+    spdlog::warn("[{}] UUID = {} Rebuild Unread Counters Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, uuid);
+    return;
+  }
+
+  std::unordered_map<std::size_t, std::size_t> last_read(cursors->begin(),
+                                                         cursors->end());
+
+  /*cursors buffered in redis are newer than MySQL, keep them*/
+  const auto tag = redis::hashTag(uuid);
+  std::vector<std::vector<std::string>> commands;
+  for (const auto &[thread_id, msg_id] : cursors.value()) {
+    commands.push_back({"HSETNX", cursor_prefix + tag,
+                        std::to_string(thread_id), std::to_string(msg_id)});
+  }
+
+  /*messages of a thread are counted on the shard which owns it*/
+  for (const auto &[meta, last_active] : threads.value()) {
+    auto thread_id = tools::string_to_value<std::size_t>(meta->_thread_id);
+    if (!thread_id.has_value()) {
+      continue;
+    }
+
+    std::optional<std::pair<std::size_t, std::size_t>> unread;
+    {
+      MySQLRAII mysql(mysql::MySQLReplicaRouter::get_instance()->read(
+          mysql::MySQLShardRouter::get_instance()->route(*thread_id), uuid));
+      unread = mysql->get()->getThreadUnread(*thread_id, last_read[*thread_id],
+                                             *uuid_op);
+    }
+
+    if (!unread.has_value() || !unread->first) {
+      continue;
+    }
+    commands.push_back({"HSET", unread_prefix + tag, meta->_thread_id,
+                        std::to_string(unread->first)});
+    commands.push_back({"HSET", head_prefix + tag, meta->_thread_id,
+                        std::to_string(unread->second)});
+  }
+
+  /*threads without unread messages leave head empty, mark it as rebuilt*/
+  commands.push_back({"HSET", head_prefix + tag, built_field, "1"});
+
+  if (!raii->get()->pipeline(commands)) {
+    spdlog::warn("[{}] UUID = {} Store Rebuilt Unread Counters Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, uuid);
+  }
+}
+
+void chat::ReadCursorManager::shutdown() {
+  if (m_stop.exchange(true)) {
+    return;
+  }
+
+  m_cv.notify_all();
+  if (m_flusher.joinable()) {
+    m_flusher.join();
+  }
+}
+
+void chat::ReadCursorManager::flusher() {
+  std::chrono::milliseconds backoff = m_flush_interval;
+
+  while (true) {
+    std::map<std::pair<std::size_t, std::size_t>, std::size_t> batch;
+    {
+      std::unique_lock<std::mutex> _lckg(m_mtx);
+
+      /*wait for a full batch, or flush whatever we have after interval*/
+      m_cv.wait_for(_lckg, m_flush_interval, [this]() {
+        return m_stop || m_pending.size() >= m_batch_size;
+      });
+
+      if (m_pending.empty()) {
+        if (m_stop) {
+          break;
+        }
+        continue;
+      }
+      batch.swap(m_pending);
+    }
+
+    std::vector<chat::ReadCursor> cursors;
+    cursors.reserve(batch.size());
+    for (const auto &[key, message_id] : batch) {
+      cursors.push_back(chat::ReadCursor{key.first, key.second, message_id});
+    }
+
+    bool status = false;
+    {
+      MySQLRAII mysql;
+      status =
+          mysql.is_active() && mysql->get()->updateReadCursorBatch(cursors);
+    }
+
+    /*message status lives beside the messages, on the owner shard*/
+    if (status) {
+      std::map<mysql::MySQLShardRouter::pool_ptr,
+               std::vector<chat::ReadCursor>>
+          shards;
+      for (const auto &cursor : cursors) {
+        shards[mysql::MySQLShardRouter::get_instance()->route(
+                   cursor.thread_id)]
+            .push_back(cursor);
+      }
+
+      for (const auto &[pool, items] : shards) {
+        MySQLRAII mysql(pool);
+        if (!mysql.is_active() ||
+            !mysql->get()->updateMessageStatusBatch(items)) {
+          status = false;
+          break;
+        }
+      }
+    }
+
+    if (status) {
+      for (const auto &cursor : cursors) {
+        mysql::MySQLReplicaRouter::get_instance()->wrote(cursor.uuid);
+      }
+      backoff = m_flush_interval;
+      continue;
+    }
+
+    /*put them back, newer cursors arrived meanwhile win*/
+    {
+      std::lock_guard<std::mutex> _lckg(m_mtx);
+      for (const auto &[key, message_id] : batch) {
+        auto &cursor = m_pending[key];
+        cursor = std::max(cursor, message_id);
+      }
+    }
+
+    if (m_stop) {
+      spdlog::warn("[{}] {} Read Cursors Are Not Stored In MySQL!",
+                   ServerConfig::get_instance()->GrpcServerName, batch.size());
+      break;
+    }
+
+    std::this_thread::sleep_for(backoff);
+    backoff = std::min(backoff * 2, std::chrono::milliseconds(5000));
+  }
+}
@@ -0,0 +1,258 @@
+#include <algorithm>
+#include <boost/json.hpp>
+#include <chat/RecentMessageCache.hpp>
+#include <config/ServerConfig.hpp>
+#include <set>
+#include <spdlog/spdlog.h>
+#include <tools/tools.hpp>
+
+/*store newest messages of a thread in redis sorted set*/
+std::string chat::RecentMessageCache::recent_prefix = "thread_recent_";
+
+chat::RecentMessageCache::RecentMessageCache()
+    : m_capacity(ServerConfig::get_instance()->RecentMessageCount),
+      m_ttl(ServerConfig::get_instance()->RecentMessageTTL), m_hits(0),
+      m_misses(0) {}
+
+std::string chat::RecentMessageCache::padding(const std::size_t msg_id) {
+  return tools::zeroPadding(msg_id, id_width);
+}
+
+std::string chat::RecentMessageCache::encode(const chat::MsgInfo &info) {
+  boost::json::object obj;
+  obj["msg_type"] = static_cast<uint32_t>(info.msg_type);
+  obj["msg_status"] = info.status;
+  obj["msg_sender"] = info.msg_sender;
+  obj["msg_receiver"] = info.msg_receiver;
+  obj["msg_content"] = info.msg_content;
+  obj["timestamp"] = info.timestamp;
+
+  auto msg_id = tools::string_to_value<std::size_t>(info.message_id);
+  return padding(msg_id.value_or(0)) + ":" + boost::json::serialize(obj);
+}
+
+std::optional<std::unique_ptr<chat::MsgInfo>>
+chat::RecentMessageCache::decode(const std::string &member) {
+  /*sentinel member(beginning of the thread) carries no message*/
+  if (member.size() <= id_width + 1 || member[id_width] != ':') {
+    return std::nullopt;
+  }
+
+  auto msg_id = tools::string_to_value<std::size_t>(
+      std::string_view(member.data(), id_width));
+  if (!msg_id.has_value()) {
+    return std::nullopt;
+  }
+
+  try {
+    auto obj = boost::json::parse(std::string_view(member).substr(id_width + 1))
+                   .as_object();
+
+    auto item = std::make_unique<chat::MsgInfo>(
+        "", "", boost::json::value_to<std::string>(obj["msg_sender"]),
+        boost::json::value_to<std::string>(obj["msg_receiver"]),
+        boost::json::value_to<std::string>(obj["msg_content"]),
+        boost::json::value_to<std::size_t>(obj["msg_status"]),
+        boost::json::value_to<std::string>(obj["timestamp"]),
+        static_cast<chat::MsgType>(
+            boost::json::value_to<uint32_t>(obj["msg_type"])));
+
+    item->setMsgID(std::to_string(msg_id.value()));
+    return item;
+  } catch (const std::exception &e) {
+    spdlog::warn("[Recent Message Cache]: Invalid Cache Member, Error = {}",
+                 e.what());
+  }
+  return std::nullopt;
+}
+
+void chat::RecentMessageCache::append(
+    [[maybe_unused]] RedisRAII &raii,
+    const std::vector<std::shared_ptr<chat::MsgInfo>> &info) {
+
+  /*messages inside one request always belong to the same thread*/
+  std::vector<std::string> members;
+  std::string thread_id;
+
+  for (const auto &item : info) {
+    if (!item->isVerified) {
+      continue;
+    }
+    thread_id = item->thread_id;
+    members.push_back(encode(*item));
+  }
+
+  if (!members.empty()) {
+    store(raii, thread_id, members);
+  }
+}
+
+void chat::RecentMessageCache::fill(
+    [[maybe_unused]] RedisRAII &raii, const std::size_t thread_id,
+    const std::size_t msg_id,
+    const std::vector<std::unique_ptr<chat::MsgInfo>> &messages) {
+
+  std::vector<std::string> members;
+  members.reserve(messages.size() + 1);
+
+  /*
+   * sentinel member without message, everything after msg_id is cached
+   * msg_id = 0 means cache holds the whole thread
+   */
+  members.push_back(padding(msg_id) + ":");
+
+  for (const auto &item : messages) {
+    members.push_back(encode(*item));
+  }
+
+  if (!members.empty()) {
+    store(raii, std::to_string(thread_id), members);
+  }
+}
+
+void chat::RecentMessageCache::store(RedisRAII &raii,
+                                     const std::string &thread_id,
+                                     const std::vector<std::string> &members) {
+  const auto key = recent_prefix + thread_id;
+
+  std::vector<std::string> zadd{"ZADD", key};
+  zadd.reserve(members.size() * 2 + 2);
+  for (const auto &member : members) {
+    zadd.emplace_back("0");
+    zadd.push_back(member);
+  }
+
+  /*keep newest N messages only, and refresh thread activity*/
+  if (!raii->get()->pipeline(
+          {zadd,
+           {"ZREMRANGEBYRANK", key, "0",
+            std::to_string(-static_cast<long long>(m_capacity) - 1)},
+           {"EXPIRE", key, std::to_string(m_ttl)}})) {
+
+    /*cache might miss some messages now, drop it*/
+    raii->get()->delPair(key);
+    spdlog::warn("[{}] Thread ID = {} Update Recent Message Cache Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, thread_id);
+  }
+}
+
+std::optional<std::vector<std::unique_ptr<chat::MsgInfo>>>
+chat::RecentMessageCache::getPage([[maybe_unused]] RedisRAII &raii,
+                                  const std::size_t thread_id,
+                                  const std::size_t msg_id,
+                                  const std::size_t interval,
+                                  std::string &next_msg_id, bool &is_EOF) {
+
+  const auto key = recent_prefix + std::to_string(thread_id);
+
+  /*the oldest message inside cache*/
+  auto oldest = raii->get()->getSortedSetRange(key, 0, 0);
+  if (!oldest.has_value() || oldest->empty()) {
+    record(false);
+    return std::nullopt;
+  }
+
+  auto oldest_id = tools::string_to_value<std::size_t>(
+      std::string_view(oldest->front()).substr(0, id_width));
+
+  /*
+   * everything after the oldest member is cached, so do messages after
+   * msg_id only if msg_id is not before the oldest member
+   */
+  if (!oldest_id.has_value() || msg_id < oldest_id.value()) {
+    record(false);
+    return std::nullopt;
+  }
+
+  /*
+   * interval + 1 to find out whether it is the end, doubled because the
+   * same message might be cached by both writer and reader
+   */
+  const std::size_t limit = (interval + 1) * 2;
+  auto members = raii->get()
+                     ->getSortedSetRangeByLex(key, "[" + padding(msg_id + 1),
+                                              "+", 0, limit)
+                     .value_or(std::vector<std::string>{});
+
+  std::vector<std::unique_ptr<chat::MsgInfo>> result;
+  for (const auto &member : members) {
+    auto item = decode(member);
+    if (!item.has_value()) {
+      continue;
+    }
+
+    if (!result.empty() &&
+        result.back()->message_id == item.value()->message_id) {
+      continue;
+    }
+
+    item.value()->thread_id = std::to_string(thread_id);
+    result.push_back(std::move(item.value()));
+  }
+
+  is_EOF = result.size() <= interval && members.size() < limit;
+  if (result.size() > interval) {
+    result.resize(interval);
+  }
+
+  next_msg_id =
+      result.empty() ? std::to_string(msg_id) : result.back()->message_id;
+
+  raii->get()->setExpire(key, m_ttl);
+  record(true);
+  return result;
+}
+
+std::vector<std::unique_ptr<chat::MsgInfo>>
+chat::RecentMessageCache::getMessages([[maybe_unused]] RedisRAII &raii,
+                                      const std::size_t thread_id,
+                                      const std::vector<std::size_t> &msg_ids) {
+  std::vector<std::unique_ptr<chat::MsgInfo>> result;
+  if (msg_ids.empty()) {
+    return result;
+  }
+
+  const auto [min, max] = std::minmax_element(msg_ids.begin(), msg_ids.end());
+  const std::set<std::size_t> wanted(msg_ids.begin(), msg_ids.end());
+
+  /*
+   * one range read covers the whole page, ';' comes right after ':' so
+   * every member of the largest id is included
+   */
+  const auto key = recent_prefix + std::to_string(thread_id);
+  auto members = raii->get()
+                     ->getSortedSetRangeByLex(key, "[" + padding(*min),
+                                              "(" + padding(*max) + ";", 0,
+                                              m_capacity * 2)
+                     .value_or(std::vector<std::string>{});
+
+  for (const auto &member : members) {
+    auto item = decode(member);
+    if (!item.has_value() ||
+        !wanted.count(std::stoull(item.value()->message_id))) {
+      continue;
+    }
+
+    if (!result.empty() &&
+        result.back()->message_id == item.value()->message_id) {
+      continue;
+    }
+
+    item.value()->thread_id = std::to_string(thread_id);
+    result.push_back(std::move(item.value()));
+  }
+  return result;
+}
+
+void chat::RecentMessageCache::record(const bool hit) {
+  const auto hits = hit ? ++m_hits : m_hits.load();
+  const auto misses = hit ? m_misses.load() : ++m_misses;
+
+  /*report hit rate every 1024 requests*/
+  if (!((hits + misses) & 1023)) {
+    spdlog::info("[{}] Recent Message Cache: {} Hits, {} Misses, Hit Rate "
+                 "{:.2f}%",
+                 ServerConfig::get_instance()->GrpcServerName, hits, misses,
+                 100.0 * hits / (hits + misses));
+  }
+}
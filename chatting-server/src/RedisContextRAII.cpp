@@ -1,23 +1,46 @@
 #include <chrono>
 #include <redis/RedisContextRAII.hpp>
 #include <redis/RedisReplyRAII.hpp>
+#include <redis/TrackingCache.hpp>
 #include <spdlog/spdlog.h>
 
+#if defined(_WIN32)
+#include <winsock2.h>
+#define redis_shutdown(fd) ::shutdown(fd, SD_BOTH)
+#else
+#include <sys/socket.h>
+#define redis_shutdown(fd) ::shutdown(fd, SHUT_RDWR)
+#endif
+
 redis::RedisContext::RedisContext() noexcept
     : m_valid(false), m_redisContext(nullptr) {}
 
-redis::RedisContext::RedisContext(const std::string &ip, unsigned short port,
+redis::RedisContext::RedisContext(std::shared_ptr<const RedisShardRing> ring,
                                   const std::string &password) noexcept
-    : m_valid(false), m_redisContext(redisConnect(ip.c_str(), port)) {
+    : m_valid(false), m_ring(std::move(ring)), m_redisContext(nullptr) {
+
+  for (const auto &[ip, port] : m_ring->nodes()) {
+    m_nodes.emplace_back(redisConnect(ip.c_str(), port));
+  }
+
   /*error occured*/
   if (!checkError()) {
-    m_redisContext.reset();
+    m_nodes.clear();
   } else {
     checkAuth(password);
-    spdlog::info("[Redis]: Connection to Redis Server Successful!");
+    spdlog::info("[Redis]: Connection to {} Redis Node(s) Successful!",
+                 m_nodes.size());
   }
 }
 
+void redis::RedisContext::use(const std::size_t node) {
+  m_redisContext = node < m_nodes.size() ? m_nodes[node].get() : nullptr;
+}
+
+void redis::RedisContext::route(std::string_view key) {
+  use(m_ring ? m_ring->locate(key) : 0);
+}
+
 bool redis::RedisContext::isValid() { return m_valid; }
 
 bool redis::RedisContext::setValue(const std::string &key,
@@ -26,9 +49,11 @@ bool redis::RedisContext::setValue(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("SET %s %s"),
                                               key.c_str(), value.c_str());
+  TrackingCache::get_instance()->drop(key);
   if (status) {
     spdlog::info(
         "[Redis]: Execute command [ SET key = {0}, value = {1}] successfully!",
@@ -45,11 +70,13 @@ bool redis::RedisContext::setValue2Hash(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status =
       m_replyDelegate->redisCommand(*this, std::string("HSET %s %s %s"),
                                     key.c_str(), field.c_str(), value.c_str());
+  TrackingCache::get_instance()->drop(key);
 
   if (status) {
     spdlog::info(
@@ -67,10 +94,12 @@ bool redis::RedisContext::delValueFromHash(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("HDEL %s %s"),
                                               key.c_str(), field.c_str());
+  TrackingCache::get_instance()->drop(key);
 
   if (status) {
     spdlog::info("[Redis]: Execute command [ HDEL key = {0}, field = {1}] "
@@ -88,6 +117,7 @@ bool redis::RedisContext::leftPush(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("LPUSH %s %s"),
@@ -107,6 +137,7 @@ bool redis::RedisContext::rightPush(const std::string &key,
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("RPUSH %s %s"),
@@ -125,10 +156,12 @@ bool redis::RedisContext::delPair(const std::string &key) {
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status =
       m_replyDelegate->redisCommand(*this, std::string("DEL %s"), key.c_str());
+  TrackingCache::get_instance()->drop(key);
   if (status) {
     spdlog::info("[Redis]: Execute command [ DEL key = {} ]successfully!",
                  key.c_str());
@@ -142,33 +175,41 @@ bool redis::RedisContext::existKey(const std::string &key) {
   if (key.empty()) {
     return false;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   auto status = m_replyDelegate->redisCommand(*this, std::string("exists %s"),
                                               key.c_str());
-  if (status) {
-    spdlog::info("[Redis]:Execute command [ exists key = {}] successfully!",
-                 key.c_str());
-    return true;
+  if (!status) {
+    return false;
   }
-  return false;
+
+  /*EXISTS replies 0 for a missing key, which is still a successful reply*/
+  spdlog::info("[Redis]:Execute command [ exists key = {}] successfully!",
+               key.c_str());
+  return m_replyDelegate->getInterger().value_or(0) > 0;
 }
 
 bool redis::RedisContext::heartBeat() {
-  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
-  if (!m_replyDelegate->redisCommand(*this, std::string("PING"))) {
-    return false;
-  }
+  /*a broken node breaks the whole context*/
+  for (std::size_t node = 0; node < m_nodes.size(); ++node) {
+    use(node);
+    std::unique_ptr<RedisReply> m_replyDelegate =
+        std::make_unique<RedisReply>();
+    if (!m_replyDelegate->redisCommand(*this, std::string("PING"))) {
+      return false;
+    }
 
-  if (m_replyDelegate->getType().has_value() &&
-      m_replyDelegate->getType().value() != REDIS_REPLY_STRING) {
-    return false;
-  }
-  if (m_replyDelegate->getMessage() == "PONG") {
-    spdlog::info("[Redis]: Execute command [ PING ] successfully!");
-    return true;
+    if (m_replyDelegate->getType().has_value() &&
+        m_replyDelegate->getType().value() != REDIS_REPLY_STRING) {
+      return false;
+    }
+    if (m_replyDelegate->getMessage() != "PONG") {
+      return false;
+    }
   }
-  return false;
+  spdlog::info("[Redis]: Execute command [ PING ] successfully!");
+  return !m_nodes.empty();
 }
 
 std::optional<std::string>
@@ -177,6 +218,15 @@ redis::RedisContext::checkValue(const std::string &key) {
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
+
+  /*hot keys are served from local copy*/
+  auto cache = TrackingCache::get_instance();
+  const bool tracked = cache->tracked(key);
+  if (auto value = tracked ? cache->find(key) : std::nullopt; value) {
+    return value;
+  }
+  const auto version = cache->version();
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("GET %s"),
@@ -189,7 +239,12 @@ redis::RedisContext::checkValue(const std::string &key) {
   }
   spdlog::info("[Redis]: Execute command [ GET key = %s ] successfully!",
                key.c_str());
-  return m_replyDelegate->getMessage();
+
+  auto value = m_replyDelegate->getMessage();
+  if (tracked && value.has_value()) {
+    cache->store(key, value.value(), version);
+  }
+  return value;
 }
 
 std::optional<std::string>
@@ -198,6 +253,7 @@ redis::RedisContext::leftPop(const std::string &key) {
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("LPOP %s"),
@@ -222,6 +278,7 @@ redis::RedisContext::rightPop(const std::string &key) {
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("RPOP %s"),
@@ -244,6 +301,7 @@ redis::RedisContext::getValueFromHash(const std::string &key,
   if (key.empty()) {
     return std::nullopt;
   }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
   if (!m_replyDelegate->redisCommand(*this, std::string("HGET %s %s"),
@@ -261,118 +319,505 @@ redis::RedisContext::getValueFromHash(const std::string &key,
   return m_replyDelegate->getMessage();
 }
 
-std::optional<std::string>
-redis::RedisContext::acquire(const std::string &lockName,
-                             const std::size_t waitTime, const std::size_t EXPX,
-                             TimeUnit unit) {
+std::vector<std::optional<std::string>>
+redis::RedisContext::getValues(const std::vector<std::string> &keys) {
 
-  if (lockName.empty()) {
-    return std::nullopt;
+  if (keys.empty()) {
+    return {};
+  }
+  if (m_nodes.empty()) {
+    return std::vector<std::optional<std::string>>(keys.size(), std::nullopt);
   }
 
-  auto identifer = tools::userTokenGenerator();
+  /*hot keys are served from local copy, node -> positions of the others*/
+  auto cache = TrackingCache::get_instance();
+  const auto version = cache->version();
+  std::vector<std::optional<std::string>> values(keys.size(), std::nullopt);
+  std::vector<std::vector<std::size_t>> positions(m_nodes.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (cache->tracked(keys[i]) && (values[i] = cache->find(keys[i]))) {
+      continue;
+    }
+    positions[m_ring->locate(keys[i])].push_back(i);
+  }
 
-  // Add additional lock name format
-  std::string full_lock_name = std::string(lock) + lockName;
+  for (std::size_t node = 0; node < positions.size(); ++node) {
+    if (positions[node].empty()) {
+      continue;
+    }
 
-  // Calculate Redis Wait Time According to TimeUnit
-  auto startTime = std::chrono::high_resolution_clock::now();
-  auto endTime = std::chrono::high_resolution_clock::now();
-  if (unit == TimeUnit::Seconds) {
-    endTime = startTime + std::chrono::seconds(waitTime);
-  } else if (unit == TimeUnit::Milliseconds) {
-    endTime = startTime + std::chrono::milliseconds(waitTime);
-  } else {
-    spdlog::error("[REDIS]: Time Unit Error!");
-    return std::nullopt;
-  }
+    std::vector<std::string> args;
+    args.reserve(positions[node].size() + 1);
+    args.emplace_back("MGET");
+    for (const auto pos : positions[node]) {
+      args.push_back(keys[pos]);
+    }
+
+    use(node);
+    std::unique_ptr<RedisReply> m_replyDelegate =
+        std::make_unique<RedisReply>();
+    if (!m_replyDelegate->redisCommandArgv(*this, args)) {
+      continue;
+    }
 
-  while (std::chrono::high_resolution_clock::now() < endTime) {
-    if (acquireLock(full_lock_name, identifer, EXPX, unit)) {
-      return identifer;
+    auto arr = m_replyDelegate->getArray();
+    if (!arr.has_value() || arr->size() != positions[node].size()) {
+      continue;
+    }
+    for (std::size_t i = 0; i < arr->size(); ++i) {
+      const auto pos = positions[node][i];
+      if ((*arr)[i].has_value() && cache->tracked(keys[pos])) {
+        cache->store(keys[pos], (*arr)[i].value(), version);
+      }
+      values[pos] = std::move((*arr)[i]);
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(1));
   }
 
-  return std::nullopt;
+  spdlog::info("[Redis]: Execute command [ MGET {} keys ] successfully!",
+               keys.size());
+  return values;
 }
 
-bool redis::RedisContext::acquireLock(const std::string &lockName,
-                                      const std::string &identifer,
-                                      const std::size_t EXPX, TimeUnit unit) {
+bool redis::RedisContext::addToSet(const std::string &key,
+                                   const std::vector<std::string> &members) {
 
-  if (lockName.empty() || identifer.empty()) {
+  if (key.empty() || members.empty()) {
     return false;
   }
+  route(key);
 
-  std::string inputSchema;
-  inputSchema.clear();
-  if (unit == TimeUnit::Seconds) {
-    inputSchema = std::string("SET %s %s NX EX %d");
-  } else if (unit == TimeUnit::Milliseconds) {
-    inputSchema = std::string("SET %s %s NX PX %d");
-  } else {
-    spdlog::error("[REDIS]: Time Unit Error!");
-    return false;
+  std::vector<std::string> args;
+  args.reserve(members.size() + 2);
+  args.emplace_back("SADD");
+  args.emplace_back(key);
+  args.insert(args.end(), members.begin(), members.end());
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (m_replyDelegate->redisCommandArgv(*this, args)) {
+    spdlog::info("[Redis]: Execute command [ SADD key = {0}, {1} members ] "
+                 "successfully!",
+                 key.c_str(), members.size());
+    return true;
   }
+  return false;
+}
+
+std::optional<std::vector<std::string>>
+redis::RedisContext::getSetMembers(const std::string &key) {
+
+  if (key.empty()) {
+    return std::nullopt;
+  }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (!m_replyDelegate->redisCommand(*this, std::string("SMEMBERS %s"),
+                                     key.c_str())) {
+    return std::nullopt;
+  }
 
-  auto status = m_replyDelegate->redisCommand(
-      *this, inputSchema, lockName.c_str(), identifer.c_str(), EXPX);
+  auto arr = m_replyDelegate->getArray();
+  if (!arr.has_value()) {
+    return std::nullopt;
+  }
 
+  std::vector<std::string> members;
+  members.reserve(arr->size());
+  for (auto &item : arr.value()) {
+    if (item.has_value()) {
+      members.push_back(std::move(item.value()));
+    }
+  }
+
+  spdlog::info("[Redis]: Execute command [ SMEMBERS key = {} ] successfully!",
+               key.c_str());
+  return members;
+}
+
+bool redis::RedisContext::setExpire(const std::string &key,
+                                    const std::size_t seconds) {
+
+  if (key.empty()) {
+    return false;
+  }
+  route(key);
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  auto status = m_replyDelegate->redisCommand(
+      *this, std::string("EXPIRE %s %d"), key.c_str(),
+      static_cast<int>(seconds));
   if (status) {
-    spdlog::info("Execute command [ SET key = {0}, value = {1}, timeout = {2}] "
+    spdlog::info("[Redis]: Execute command [ EXPIRE key = {0}, {1}s ] "
                  "successfully!",
-                 lockName.c_str(), identifer.c_str(), EXPX);
+                 key.c_str(), seconds);
     return true;
   }
   return false;
 }
 
-bool redis::RedisContext::release(const std::string &lockName,
-                                  const std::string &identifer) {
-  if (lockName.empty() || identifer.empty()) {
+bool redis::RedisContext::setValueIfAbsent(const std::string &key,
+                                           const std::string &value,
+                                           const std::size_t seconds) {
+
+  if (key.empty()) {
     return false;
   }
+  route(key);
 
-  // Add additional lock name format
-  std::string full_lock_name = std::string(lock) + lockName;
-  return releaseLock(full_lock_name, identifer);
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (m_replyDelegate->redisCommandArgv(
+          *this, {"SET", key, value, "NX", "EX", std::to_string(seconds)})) {
+    TrackingCache::get_instance()->drop(key);
+    spdlog::info("[Redis]: Execute command [ SET key = {0}, value = {1} NX EX "
+                 "{2} ] successfully!",
+                 key.c_str(), value.c_str(), seconds);
+    return true;
+  }
+  return false;
 }
 
-bool redis::RedisContext::releaseLock(const std::string &lockName,
-                                      const std::string &identifer) {
+bool redis::RedisContext::renewValueIfEqual(const std::string &key,
+                                            const std::string &value,
+                                            const std::size_t seconds) {
+
+  if (key.empty()) {
+    return false;
+  }
+  route(key);
 
   std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (!m_replyDelegate->redisCommandArgv(*this,
+                                         {"EVAL", renew_lua_script, "1", key,
+                                          value, std::to_string(seconds)})) {
+    return false;
+  }
 
-  // Use EVAL to execute lua script
-  // param 1: lua script itself
-  // param 2: key
-  // param 3: value
-  auto status = m_replyDelegate->redisCommand(
-      *this, "EVAL %s 1 %s %s", release_lock_lua_script, lockName.c_str(),
-      identifer.c_str());
+  /*lua script returns 0 when key is owned by others*/
+  auto res = m_replyDelegate->getInterger();
+  return res.has_value() && res.value() == 1;
+}
 
-  if (status) {
-    spdlog::info("Execute Lua Script [ EVAL {0} 1 {1} {2}] successfully!",
-                 release_lock_lua_script, lockName.c_str(), identifer.c_str());
+bool redis::RedisContext::delValueIfEqual(const std::string &key,
+                                          const std::string &value) {
+  if (key.empty() || value.empty()) {
+    return false;
+  }
+  route(key);
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  auto status = m_replyDelegate->redisCommandArgv(
+      *this, {"EVAL", del_lua_script, "1", key, value});
+  TrackingCache::get_instance()->drop(key);
+  return status;
+}
+
+bool redis::RedisContext::pipeline(
+    const std::vector<std::vector<std::string>> &commands) {
+
+  if (commands.empty()) {
+    return true;
+  }
+  if (m_nodes.empty()) {
+    return false;
+  }
+
+  /*node -> number of commands appended, all nodes work at the same time*/
+  std::vector<std::size_t> appended(m_nodes.size(), 0);
+  bool status = true;
+  for (const auto &command : commands) {
+    const auto node = m_ring->locate(command);
+    use(node);
+    if (!RedisReply::appendCommandArgv(*this, command)) {
+      status = false;
+      break;
+    }
+    ++appended[node];
+  }
+
+  /*every reply must be consumed, otherwise they will mess up next command*/
+  for (std::size_t node = 0; node < appended.size(); ++node) {
+    use(node);
+    for (std::size_t i = 0; i < appended[node]; ++i) {
+      std::unique_ptr<RedisReply> m_replyDelegate =
+          std::make_unique<RedisReply>();
+      if (!m_replyDelegate->getReply(*this)) {
+        status = false;
+        if (!m_replyDelegate->getType().has_value()) {
+          /*connection broken, no more replies from this node*/
+          break;
+        }
+      }
+    }
+  }
+
+  for (const auto &command : commands) {
+    if (command.size() > 1) {
+      TrackingCache::get_instance()->drop(command[1]);
+    }
+  }
+
+  spdlog::info("[Redis]: Execute pipeline [ {} commands ] {}!",
+               commands.size(), status ? "successfully" : "with error");
+  return status;
+}
+
+std::optional<std::vector<std::pair<std::string, std::string>>>
+redis::RedisContext::getHashAll(const std::string &key) {
+  if (key.empty()) {
+    return std::nullopt;
+  }
+  route(key);
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (!m_replyDelegate->redisCommandArgv(*this, {"HGETALL", key})) {
+    return std::nullopt;
+  }
+
+  auto arr = m_replyDelegate->getArray();
+  if (!arr.has_value()) {
+    return std::nullopt;
+  }
+
+  /*field1, value1, field2, value2 ...*/
+  std::vector<std::pair<std::string, std::string>> fields;
+  fields.reserve(arr->size() / 2);
+  for (std::size_t i = 0; i + 1 < arr->size(); i += 2) {
+    if ((*arr)[i].has_value() && (*arr)[i + 1].has_value()) {
+      fields.emplace_back(std::move((*arr)[i].value()),
+                          std::move((*arr)[i + 1].value()));
+    }
+  }
+  return fields;
+}
+
+std::optional<std::vector<std::string>>
+redis::RedisContext::getSortedSetRange(const std::string &key,
+                                       const long long start,
+                                       const long long stop) {
+  if (key.empty()) {
+    return std::nullopt;
+  }
+  route(key);
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (!m_replyDelegate->redisCommandArgv(
+          *this,
+          {"ZRANGE", key, std::to_string(start), std::to_string(stop)})) {
+    return std::nullopt;
+  }
+
+  auto arr = m_replyDelegate->getArray();
+  if (!arr.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::string> members;
+  members.reserve(arr->size());
+  for (auto &item : arr.value()) {
+    if (item.has_value()) {
+      members.push_back(std::move(item.value()));
+    }
+  }
+  return members;
+}
+
+std::optional<std::vector<std::string>>
+redis::RedisContext::getSortedSetRangeByLex(const std::string &key,
+                                            const std::string &min,
+                                            const std::string &max,
+                                            const std::size_t offset,
+                                            const std::size_t count) {
+  if (key.empty()) {
+    return std::nullopt;
+  }
+  route(key);
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (!m_replyDelegate->redisCommandArgv(
+          *this, {"ZRANGEBYLEX", key, min, max, "LIMIT",
+                  std::to_string(offset), std::to_string(count)})) {
+    return std::nullopt;
+  }
+
+  auto arr = m_replyDelegate->getArray();
+  if (!arr.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<std::string> members;
+  members.reserve(arr->size());
+  for (auto &item : arr.value()) {
+    if (item.has_value()) {
+      members.push_back(std::move(item.value()));
+    }
+  }
+  return members;
+}
+
+std::optional<std::vector<std::optional<std::string>>>
+redis::RedisContext::evalScript(const std::string &script,
+                                const std::vector<std::string> &keys,
+                                const std::vector<std::string> &args) {
+  route(keys.empty() ? std::string_view{} : std::string_view{keys.front()});
+
+  std::vector<std::string> argv{"EVAL", script, std::to_string(keys.size())};
+  argv.reserve(argv.size() + keys.size() + args.size());
+  argv.insert(argv.end(), keys.begin(), keys.end());
+  argv.insert(argv.end(), args.begin(), args.end());
+
+  /*empty array is regarded as failure by isSuccessful, check type instead*/
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  m_replyDelegate->redisCommandArgv(*this, argv);
+  for (const auto &key : keys) {
+    TrackingCache::get_instance()->drop(key);
+  }
+  return m_replyDelegate->getArray();
+}
+
+bool redis::RedisContext::publish(const std::string &channel,
+                                  const std::string &message) {
+
+  if (channel.empty()) {
+    return false;
+  }
+  route(channel);
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  return m_replyDelegate->redisCommandArgv(*this,
+                                           {"PUBLISH", channel, message});
+}
+
+bool redis::RedisContext::subscribe(const std::string &channel) {
+
+  if (channel.empty()) {
+    return false;
+  }
+  route(channel);
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (m_replyDelegate->redisCommand(*this, std::string("SUBSCRIBE %s"),
+                                    channel.c_str())) {
+    spdlog::info("[Redis]: Execute command [ SUBSCRIBE channel = {} ] "
+                 "successfully!",
+                 channel.c_str());
     return true;
   }
   return false;
 }
 
+std::optional<std::pair<std::string, std::string>>
+redis::RedisContext::waitForMessage() {
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (!m_replyDelegate->getReply(*this)) {
+    /*
+     * connection broken, this context should not be used anymore, only an
+     * error reply keeps it, otherwise waiting on it again would spin
+     */
+    if (m_redisContext == nullptr || m_redisContext->err ||
+        !m_replyDelegate->getType().has_value()) {
+      m_valid = false;
+    }
+    return std::nullopt;
+  }
+
+  /*["message", channel, payload]*/
+  auto arr = m_replyDelegate->getArray();
+  if (!arr.has_value() || arr->size() != 3 || !arr->at(0).has_value() ||
+      arr->at(0).value() != "message" || !arr->at(1).has_value() ||
+      !arr->at(2).has_value()) {
+    return std::nullopt;
+  }
+
+  return std::make_pair(std::move(arr->at(1).value()),
+                        std::move(arr->at(2).value()));
+}
+
+std::optional<long long>
+redis::RedisContext::clientId(const std::size_t node) {
+  use(node);
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (!m_replyDelegate->redisCommandArgv(*this, {"CLIENT", "ID"})) {
+    return std::nullopt;
+  }
+  return m_replyDelegate->getInterger();
+}
+
+bool redis::RedisContext::enableTracking(
+    const std::size_t node, const long long redirect,
+    const std::vector<std::string> &prefixes) {
+
+  std::vector<std::string> args{"CLIENT", "TRACKING", "on", "REDIRECT",
+                                std::to_string(redirect), "BCAST"};
+  for (const auto &prefix : prefixes) {
+    args.emplace_back("PREFIX");
+    args.push_back(prefix);
+  }
+
+  use(node);
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  if (m_replyDelegate->redisCommandArgv(*this, args)) {
+    spdlog::info("[Redis]: Execute command [ CLIENT TRACKING REDIRECT {} ] "
+                 "successfully!",
+                 redirect);
+    return true;
+  }
+  return false;
+}
+
+std::optional<std::vector<std::string>>
+redis::RedisContext::waitForInvalidation() {
+
+  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
+  m_replyDelegate->getReply(*this);
+  if (m_redisContext == nullptr || m_redisContext->err) {
+    m_valid = false;
+    return std::nullopt;
+  }
+
+  /*["message", "__redis__:invalidate", [key1 ... keyN] or nil]*/
+  auto arr = m_replyDelegate->getArray();
+  if (!arr.has_value() || arr->size() != 3 || !arr->at(0).has_value() ||
+      arr->at(0).value() != "message") {
+    return std::nullopt;
+  }
+
+  std::vector<std::string> keys;
+  for (auto &key : m_replyDelegate->getArray(2).value_or(
+           std::vector<std::optional<std::string>>{})) {
+    if (key.has_value()) {
+      keys.push_back(std::move(key.value()));
+    }
+  }
+  return keys;
+}
+
+void redis::RedisContext::interrupt() {
+  for (const auto &node : m_nodes) {
+    if (node && node->fd != REDIS_INVALID_FD) {
+      redis_shutdown(node->fd);
+    }
+  }
+}
+
 bool redis::RedisContext::checkError() {
-  if (m_redisContext.get() == nullptr) {
+  if (m_nodes.empty()) {
     spdlog::error("Connection to Redis server failed! No instance!");
     return m_valid; // false;
   }
 
-  /*error occured*/
-  if (m_redisContext->err) {
-    spdlog::error("Connection to Redis server failed! error code {}",
-                  m_redisContext->errstr);
-    return m_valid;
+  for (const auto &node : m_nodes) {
+    if (node.get() == nullptr) {
+      spdlog::error("Connection to Redis server failed! No instance!");
+      return m_valid; // false;
+    }
+
+    /*error occured*/
+    if (node->err) {
+      spdlog::error("Connection to Redis server failed! error code {}",
+                    node->errstr);
+      return m_valid;
+    }
   }
 
   m_valid = true;
@@ -380,18 +825,21 @@ bool redis::RedisContext::checkError() {
 }
 
 bool redis::RedisContext::checkAuth(std::string_view sv) {
-  std::unique_ptr<RedisReply> m_replyDelegate = std::make_unique<RedisReply>();
-  auto status =
-      m_replyDelegate->redisCommand(*this, std::string("AUTH %s"), sv.data());
-  if (status) {
-    // spdlog::info("Excute command  [ AUTH ] successfully!");
+  bool status = !m_nodes.empty();
+  for (std::size_t node = 0; node < m_nodes.size(); ++node) {
+    use(node);
+    std::unique_ptr<RedisReply> m_replyDelegate =
+        std::make_unique<RedisReply>();
+    status = m_replyDelegate->redisCommand(*this, std::string("AUTH %s"),
+                                           sv.data()) &&
+             status;
   }
   return status;
 }
 
 std::optional<tools::RedisContextWrapper> redis::RedisContext::operator->() {
   if (isValid()) {
-    return tools::RedisContextWrapper(m_redisContext.get());
+    return tools::RedisContextWrapper(m_redisContext);
   }
   return std::nullopt;
 }
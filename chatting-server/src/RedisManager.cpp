@@ -6,22 +6,25 @@
 
 redis::RedisConnectionPool::RedisConnectionPool() noexcept
     : RedisConnectionPool(ServerConfig::get_instance()->Redis_timeout,
-                          ServerConfig::get_instance()->Redis_ip_addr,
-                          ServerConfig::get_instance()->Redis_passwd,
-                          ServerConfig::get_instance()->Redis_port) {
-  spdlog::info("[Redis Connector]: Connecting to Redis Server: {0}, port: {1}",
-               ServerConfig::get_instance()->Redis_ip_addr.c_str(),
-               ServerConfig::get_instance()->Redis_port);
-}
+                          ServerConfig::get_instance()->Redis_nodes,
+                          ServerConfig::get_instance()->Redis_passwd) {}
 
 redis::RedisConnectionPool::RedisConnectionPool(
-    const std::size_t _timeout, const std::string &_ip,
-    const std::string &_passwd, const unsigned short _port) noexcept
+    const std::size_t _timeout, const std::vector<RedisNode> &_nodes,
+    const std::string &_passwd) noexcept
+
+    : m_passwd(_passwd),
+      m_ring(std::make_shared<const RedisShardRing>(_nodes)),
+      m_timeout(_timeout) {
 
-    : m_timeout(_timeout), m_ip(_ip), m_passwd(_passwd), m_port(_port) {
+  for (const auto &[ip, port] : _nodes) {
+    spdlog::info(
+        "[Redis Connector]: Connecting to Redis Server: {0}, port: {1}", ip,
+        port);
+  }
 
   for (std::size_t i = 0; i < m_queue_size; ++i) {
-    [[maybe_unused]] auto status = connector(m_ip, m_passwd, m_port);
+    [[maybe_unused]] auto status = connector();
   }
 
   m_RRThread = std::thread([this]() {
@@ -54,19 +57,13 @@ void redis::RedisConnectionPool::roundRobinChecking() {
 
   // get target queue size first, we need to know how many stubs are instead the
   // queue
-  {
-    std::lock_guard<std::mutex> _lckg(m_mtx);
-    expectedStubs = m_stub_queue.size();
-  }
+  expectedStubs = idle();
 
   for (; !expectedStubs && currentStubs < expectedStubs; currentStubs++) {
 
-    {
-      // sometimes. m_stub_queue might be empty;
-      std::lock_guard<std::mutex> _lckg(m_mtx);
-      if (m_stub_queue.empty()) {
-        break;
-      }
+    // sometimes. pool might be empty;
+    if (!idle()) {
+      break;
     }
 
     // get stub from the queue
@@ -92,8 +89,8 @@ void redis::RedisConnectionPool::roundRobinChecking() {
       spdlog::warn("[Redis DataBase]: Error = {} Restarting Connection...",
                    e.what());
 
-      // disable RAII feature to return this item back to the pool
-      instance.invalidate();
+      // drop this item instead of returning it back to the pool
+      instance.discard();
 
       fail_count++; // record failed time!
     }
@@ -101,21 +98,19 @@ void redis::RedisConnectionPool::roundRobinChecking() {
 
   // handle failed events, and try to reconnect
   while (fail_count > 0) {
-    if (!connector(m_ip, m_passwd, m_port)) [[unlikely]] {
+    if (!connector()) [[unlikely]] {
       return;
     }
     fail_count--;
   }
 }
 
-bool redis::RedisConnectionPool::connector(const std::string &_ip,
-                                           const std::string &_passwd,
-                                           const unsigned short _port) {
+bool redis::RedisConnectionPool::connector() {
 
   auto currentTimeStamp = std::chrono::steady_clock::now();
 
   try {
-    auto new_item = std::make_unique<redis::RedisContext>(_ip, _port, _passwd);
+    auto new_item = std::make_unique<redis::RedisContext>(m_ring, m_passwd);
     new_item->last_operation_time = currentTimeStamp;
 
     // We have to do auth, to check whether password is correct or not!
@@ -124,10 +119,7 @@ bool redis::RedisConnectionPool::connector(const std::string &_ip,
       throw std::runtime_error("Redis Auth Failed!");
     }
 
-    {
-      std::lock_guard<std::mutex> _lckg(m_mtx);
-      m_stub_queue.push(std::move(new_item));
-    }
+    add(std::move(new_item));
     return true;
   } catch (const std::exception &e) {
     spdlog::warn("[Redis Connector]: Error = {}", e.what());
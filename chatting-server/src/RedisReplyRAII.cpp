@@ -35,6 +35,54 @@ bool redis::RedisReply::isSuccessful() const {
   }
 }
 
+bool redis::RedisReply::redisCommandArgv(
+    RedisContext &context, const std::vector<std::string> &args) {
+  std::vector<const char *> argv;
+  std::vector<std::size_t> argvlen;
+  argv.reserve(args.size());
+  argvlen.reserve(args.size());
+
+  for (const auto &arg : args) {
+    argv.push_back(arg.data());
+    argvlen.push_back(arg.size());
+  }
+
+  m_redisReply.reset(reinterpret_cast<redisReply *>(::redisCommandArgv(
+      context.m_redisContext, static_cast<int>(argv.size()),
+      argv.data(), argvlen.data())));
+  return isSuccessful();
+}
+
+bool redis::RedisReply::appendCommandArgv(
+    RedisContext &context, const std::vector<std::string> &args) {
+  std::vector<const char *> argv;
+  std::vector<std::size_t> argvlen;
+  argv.reserve(args.size());
+  argvlen.reserve(args.size());
+
+  for (const auto &arg : args) {
+    argv.push_back(arg.data());
+    argvlen.push_back(arg.size());
+  }
+
+  return ::redisAppendCommandArgv(context.m_redisContext,
+                                  static_cast<int>(argv.size()), argv.data(),
+                                  argvlen.data()) == REDIS_OK;
+}
+
+bool redis::RedisReply::getReply(RedisContext &context) {
+  void *reply = nullptr;
+  if (::redisGetReply(context.m_redisContext, &reply) != REDIS_OK) {
+    if (reply != nullptr) {
+      freeReplyObject(reply);
+    }
+    m_redisReply.reset();
+    return false;
+  }
+  m_redisReply.reset(reinterpret_cast<redisReply *>(reply));
+  return isSuccessful();
+}
+
 std::optional<long long> redis::RedisReply::getInterger() const {
   if (m_redisReply.get() != nullptr) {
     return m_redisReply->integer;
@@ -55,3 +103,40 @@ std::optional<std::string> redis::RedisReply::getMessage() const {
   }
   return std::nullopt;
 }
+
+std::optional<std::vector<std::optional<std::string>>>
+redis::RedisReply::getArray() const {
+  return toArray(m_redisReply.get());
+}
+
+std::optional<std::vector<std::optional<std::string>>>
+redis::RedisReply::getArray(const std::size_t index) const {
+  if (m_redisReply.get() == nullptr ||
+      m_redisReply->type != REDIS_REPLY_ARRAY ||
+      index >= m_redisReply->elements) {
+    return std::nullopt;
+  }
+  return toArray(m_redisReply->element[index]);
+}
+
+std::optional<std::vector<std::optional<std::string>>>
+redis::RedisReply::toArray(const redisReply *reply) {
+  if (reply == nullptr || reply->type != REDIS_REPLY_ARRAY) {
+    return std::nullopt;
+  }
+
+  std::vector<std::optional<std::string>> result;
+  result.reserve(reply->elements);
+
+  for (std::size_t i = 0; i < reply->elements; ++i) {
+    const redisReply *element = reply->element[i];
+    if (element == nullptr || element->type == REDIS_REPLY_NIL) {
+      result.push_back(std::nullopt);
+    } else if (element->type == REDIS_REPLY_INTEGER) {
+      result.push_back(std::to_string(element->integer));
+    } else {
+      result.push_back(std::string(element->str, element->len));
+    }
+  }
+  return result;
+}
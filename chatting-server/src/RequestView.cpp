@@ -0,0 +1,74 @@
+#include <handler/RequestView.hpp>
+
+/*buffers of parser grow to the largest request and are reused afterwards*/
+static thread_local simdjson::dom::parser local_parser;
+
+std::optional<RequestView> RequestView::parse(std::string_view body) {
+  simdjson::dom::element root;
+  simdjson::dom::object obj;
+
+  /*body is copied into the padded buffer of parser*/
+  if (local_parser.parse(body.data(), body.size()).get(root) ||
+      root.get_object().get(obj)) {
+    return std::nullopt;
+  }
+  return RequestView(obj);
+}
+
+bool RequestView::contains(std::string_view key) const {
+  simdjson::dom::element value;
+  return !m_obj.at_key(key).get(value);
+}
+
+std::optional<std::string_view>
+RequestView::getString(std::string_view key) const {
+  std::string_view value;
+  if (m_obj.at_key(key).get_string().get(value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<bool> RequestView::getBool(std::string_view key) const {
+  bool value;
+  if (m_obj.at_key(key).get_bool().get(value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<std::uint64_t>
+RequestView::getUInt(std::string_view key) const {
+  std::uint64_t value;
+  if (m_obj.at_key(key).get_uint64().get(value)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+std::optional<RequestView>
+RequestView::getObject(std::string_view key) const {
+  simdjson::dom::object obj;
+  if (m_obj.at_key(key).get_object().get(obj)) {
+    return std::nullopt;
+  }
+  return RequestView(obj);
+}
+
+std::optional<std::vector<RequestView>>
+RequestView::getObjects(std::string_view key) const {
+  simdjson::dom::array arr;
+  if (m_obj.at_key(key).get_array().get(arr)) {
+    return std::nullopt;
+  }
+
+  std::vector<RequestView> ret;
+  ret.reserve(arr.size());
+  for (simdjson::dom::element item : arr) {
+    simdjson::dom::object obj;
+    if (!item.get_object().get(obj)) {
+      ret.push_back(RequestView(obj));
+    }
+  }
+  return ret;
+}
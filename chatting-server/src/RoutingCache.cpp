@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <config/ServerConfig.hpp>
+#include <spdlog/spdlog.h>
+#include <user/RoutingCache.hpp>
+
+/*store the server name that this user belongs to*/
+std::string user::RoutingCache::server_prefix = "uuid_";
+
+/*uuid_[uuid] invalidation channel*/
+std::string user::RoutingCache::invalidate_channel = "routing_invalidate";
+
+user::RoutingCache::RoutingCache()
+    : m_subscribed(false), m_version(0), m_epoch(0) {
+  m_subscriber.start(1, [this](const std::size_t) { subscriber(); });
+}
+
+/*subscriber blocked inside redisGetReply is interrupted and joined*/
+user::RoutingCache::~RoutingCache() { m_subscriber.stop(); }
+
+std::optional<std::string>
+user::RoutingCache::getServer([[maybe_unused]] RedisRAII &raii,
+                              const std::string &uuid) {
+  if (auto server = find(uuid); server) {
+    return server;
+  }
+
+  const auto version = m_version.load();
+  auto server_op =
+      raii->get()->checkValue(server_prefix + redis::hashTag(uuid));
+  if (server_op.has_value()) {
+    store(uuid, server_op.value(), version);
+  }
+  return server_op;
+}
+
+std::unordered_map<std::string, std::vector<std::string>>
+user::RoutingCache::groupByServer([[maybe_unused]] RedisRAII &raii,
+                                  const std::vector<std::string> &uuids,
+                                  std::vector<std::string> &offline) {
+
+  std::unordered_map<std::string, std::vector<std::string>> servers;
+  std::vector<std::string> missed;
+
+  for (const auto &uuid : uuids) {
+    if (auto server = find(uuid); server) {
+      servers[*server].push_back(uuid);
+    } else {
+      missed.push_back(uuid);
+    }
+  }
+
+  if (missed.empty()) {
+    return servers;
+  }
+
+  std::vector<std::string> keys;
+  keys.reserve(missed.size());
+  for (const auto &uuid : missed) {
+    keys.push_back(server_prefix + redis::hashTag(uuid));
+  }
+
+  /*MGET uuid_{uuid1} uuid_{uuid2} ... with only one network round trip*/
+  const auto version = m_version.load();
+  auto values = raii->get()->getValues(keys);
+
+  for (std::size_t i = 0; i < missed.size(); ++i) {
+    if (i >= values.size() || !values[i].has_value()) {
+      offline.push_back(missed[i]);
+      continue;
+    }
+    store(missed[i], *values[i], version);
+    servers[*values[i]].push_back(missed[i]);
+  }
+  return servers;
+}
+
+void user::RoutingCache::publishInvalidation([[maybe_unused]] RedisRAII &raii,
+                                             const std::string &uuid) {
+  m_routes.erase(uuid);
+
+  if (!raii->get()->publish(invalidate_channel, uuid)) {
+    spdlog::warn("[{}] UUID = {} Publish Routing Invalidation Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, uuid);
+  }
+}
+
+std::optional<std::string>
+user::RoutingCache::find(const std::string &uuid) {
+  if (!m_subscribed) {
+    return std::nullopt;
+  }
+
+  decltype(m_routes)::const_accessor accessor;
+  if (m_routes.find(accessor, uuid) && accessor->second.epoch == m_epoch) {
+    return accessor->second.server;
+  }
+  return std::nullopt;
+}
+
+void user::RoutingCache::store(const std::string &uuid,
+                               const std::string &server,
+                               const std::size_t version) {
+  if (!m_subscribed) {
+    return;
+  }
+
+  decltype(m_routes)::accessor accessor;
+  m_routes.insert(accessor, uuid);
+
+  /*invalidation happened during redis query, this value might be stale*/
+  if (m_version.load() != version) {
+    m_routes.erase(accessor);
+    return;
+  }
+  accessor->second.server = server;
+  accessor->second.epoch = m_epoch;
+}
+
+void user::RoutingCache::subscriber() {
+  auto retry = min_retry_interval;
+
+  while (!m_subscriber.stopped()) {
+    redis::RedisContext context(
+        redis::RedisConnectionPool::get_instance()->ring(),
+        ServerConfig::get_instance()->Redis_passwd);
+    if (!m_subscriber.attach(context)) {
+      break;
+    }
+
+    if (!context.isValid() || !context.subscribe(invalidate_channel)) {
+      m_subscriber.detach(context);
+      spdlog::warn("[{}] Subscribe Routing Invalidation Channel Failed, "
+                   "Retrying...",
+                   ServerConfig::get_instance()->GrpcServerName);
+      m_subscriber.backoff(retry);
+      retry = std::min(retry * 2, max_retry_interval);
+      continue;
+    }
+
+    m_subscribed = true;
+
+    while (!m_subscriber.stopped() && context.isValid()) {
+      auto msg = context.waitForMessage();
+      if (!msg.has_value()) {
+        continue;
+      }
+
+      retry = min_retry_interval;
+      ++m_version;
+      m_routes.erase(msg->second);
+    }
+
+    m_subscriber.detach(context);
+
+    /*messages might be lost, local cache can not be trusted anymore*/
+    m_subscribed = false;
+    ++m_version;
+    ++m_epoch;
+
+    spdlog::warn("[{}] Routing Invalidation Subscriber Disconnected!",
+                 ServerConfig::get_instance()->GrpcServerName);
+
+    /*a connection dropped right after subscribing must not spin*/
+    m_subscriber.backoff(retry);
+    retry = std::min(retry * 2, max_retry_interval);
+  }
+}
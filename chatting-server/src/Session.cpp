@@ -1,12 +1,15 @@
 #include <boost/json.hpp>
 #include <boost/json/object.hpp>
 #include <boost/json/parse.hpp>
+#include <buffer/FrameCompression.hpp>
 #include <config/ServerConfig.hpp>
 #include <handler/SyncLogic.hpp>
+#include <redis/LockService.hpp>
 #include <server/AsyncServer.hpp>
 #include <server/Session.hpp>
 #include <spdlog/spdlog.h>
 #include <tools/tools.hpp>
+#include <user/RoutingCache.hpp>
 #include <user/UserManager.hpp>
 
 /*store the current session id that this user belongs to*/
@@ -70,36 +73,22 @@ void Session::terminateAndRemoveFromServer(
 
 void Session::removeRedisCache(const std::string &uuid,
                                const std::string &session_id) {
-  /*we need to add distributed-lock here to remove session-id and user id*/
   RedisRAII raii;
-  if (auto opt =
-          raii->get()->acquire(uuid, 10, 10, redis::TimeUnit::Milliseconds);
-      opt) {
-
-    // Get user id which Current UUID Belongs to
-    auto redis_user_id = raii->get()->checkValue(server_prefix + uuid);
-
-    // Get Session id which Current UUID Belongs to
-    auto redis_session_id = raii->get()->checkValue(session_prefix + uuid);
-
-    if (redis_user_id.has_value() && redis_session_id.has_value()) {
-      auto &r_user_id = *redis_user_id;
-      auto &r_session_id = *redis_session_id;
-
-      /*
-       * If THERE IS NO other server already modify this value
-       * THIS USER might already logined on other server, then skip this process
-       */
-      if (r_session_id == session_id) {
-        // Remove the pair relation of server_[uuid]<->[WHICH SERVER]
-        raii->get()->delPair(server_prefix + uuid);
-
-        // Remove the pair relation of session_[uuid]<->[SESSION_NUMBER]
-        raii->get()->delPair(session_prefix + uuid);
-      }
-    }
 
-    raii->get()->release(uuid, opt.value());
+  /*
+   * If THERE IS NO other server already modify this value
+   * THIS USER might already logined on other server, then skip this process
+   * compared and removed by one script, no distributed-lock is needed
+   */
+  auto removed = raii->get()->evalScript(
+      release_lua_script,
+      {server_prefix + redis::hashTag(uuid),
+       session_prefix + redis::hashTag(uuid)},
+      {session_id});
+
+  if (removed.has_value() && !removed->empty() && removed->front() == "1") {
+    // Drop uuid_[uuid] from every server's local routing cache
+    user::RoutingCache::get_instance()->publishInvalidation(raii, uuid);
   }
 }
 
@@ -123,40 +112,88 @@ void Session::purgeRemoveConnection(std::shared_ptr<Session> session) {
 void Session::sendMessage(ServiceType srv_type, const std::string &message,
                           std::shared_ptr<Session> self) {
   try {
-    /*inside SendNode ctor, temporary must be modifiable*/
-    std::string temporary = message;
-
-    m_concurrent_sent_queue.push(
-        std::make_unique<Send>(static_cast<uint16_t>(srv_type), temporary,
-                               ByteOrderConverterReverse{}));
+    const auto id = static_cast<uint16_t>(srv_type);
+    const auto chunk =
+        std::max<std::size_t>(ServerConfig::get_instance()->FrameChunkSize, 1);
+
+    /*compressed body is only used when it is really smaller*/
+    std::string compressed;
+    std::string_view payload = message;
+    uint16_t flags = 0;
+
+    if (m_compression &&
+        message.size() >= ServerConfig::get_instance()->CompressionThreshold) {
+      auto res = compression::compress(
+          message, ServerConfig::get_instance()->CompressionLevel);
+      if (res.has_value() && res->size() < message.size()) {
+        compressed = std::move(*res);
+        payload = compressed;
+        flags |= MSGNODE_FLAG_COMPRESSED;
+      }
+    }
 
-    bool expected = false;
-    if (m_write_in_progress.compare_exchange_strong(expected, true)) {
-      if (m_concurrent_sent_queue.try_pop(m_current_write_msg)) {
+    {
+      std::lock_guard<std::mutex> _lckg(m_send_mtx);
 
-        if (checkDeferredTermination()) {
-          m_write_in_progress = false;
+      /*small messages always use normal frame, every client understands it*/
+      if (!flags && (!m_extended_frame || payload.size() <= chunk)) {
+        if (payload.size() > MAX_NORMAL_LENGTH) {
+          spdlog::error("[{}] Client Session {} UUID {} Message Of Service {} "
+                        "Is Too Large For Normal Frame, {} Bytes Dropped!",
+                        ServerConfig::get_instance()->GrpcServerName,
+                        s_session_id, s_uuid, id, payload.size());
           return;
         }
 
-        boost::asio::async_write(
-            s_socket,
-            boost::asio::buffer(m_current_write_msg->get_header_base(),
-                                m_current_write_msg->get_full_length()),
-            [self](const boost::system::error_code &ec,
-                   std::size_t /*bytes_transferred*/) {
-              self->handle_write(self, ec);
-            });
+        /*inside SendNode ctor, temporary must be modifiable*/
+        std::string temporary = message;
+        m_concurrent_sent_queue.push(std::make_unique<Send>(
+            id, temporary, ByteOrderConverterReverse{}));
       } else {
-        m_write_in_progress = false;
+        /*every fragment only copies its own part of the message*/
+        for (std::size_t offset = 0; offset < payload.size(); offset += chunk) {
+          std::string temporary(payload.substr(offset, chunk));
+          m_concurrent_sent_queue.push(std::make_unique<Send>(
+              id, temporary, ByteOrderConverterReverse{},
+              MsgNodeType::MSGNODE_EXTENDED,
+              offset + chunk < payload.size()
+                  ? static_cast<uint16_t>(flags | MSGNODE_FLAG_MORE_FRAGMENTS)
+                  : flags));
+        }
       }
     }
+
+    start_write(self);
   } catch (const std::exception &e) {
     spdlog::error("[{}] Session::sendMessage {}",
                   ServerConfig::get_instance()->GrpcServerName, e.what());
   }
 }
 
+void Session::start_write(std::shared_ptr<Session> self) {
+  bool expected = false;
+  if (m_write_in_progress.compare_exchange_strong(expected, true)) {
+    if (m_concurrent_sent_queue.try_pop(m_current_write_msg)) {
+
+      if (checkDeferredTermination()) {
+        m_write_in_progress = false;
+        return;
+      }
+
+      boost::asio::async_write(
+          s_socket,
+          boost::asio::buffer(m_current_write_msg->get_header_base(),
+                              m_current_write_msg->get_full_length()),
+          [self](const boost::system::error_code &ec,
+                 std::size_t /*bytes_transferred*/) {
+            self->handle_write(self, ec);
+          });
+    } else {
+      m_write_in_progress = false;
+    }
+  }
+}
+
 bool Session::isSessionTimeout(const std::time_t &now) const {
   return std::difftime(now, m_last_heartbeat) >
          static_cast<double>(ServerConfig::get_instance()->heart_beat_timeout);
@@ -235,6 +272,76 @@ void Session::handle_header(std::shared_ptr<Session> session,
       return;
     }
 
+    /*extended frame, 32-bit length follows the flags*/
+    if (m_recv_buffer->is_extended_header()) {
+      if (!m_extended_frame) {
+        spdlog::warn("[{}] Client Session {} UUID {} Header Error! Extended "
+                     "Frame Was Not Negotiated!",
+                     ServerConfig::get_instance()->GrpcServerName,
+                     session->s_session_id, session->s_uuid);
+
+        purgeRemoveConnection(session);
+        return;
+      }
+
+      const auto received = m_recv_buffer->get_header_length();
+      m_recv_buffer->upgrade_to_extended();
+
+      boost::asio::async_read(
+          session->s_socket,
+          boost::asio::buffer(m_recv_buffer->get_header_base() + received,
+                              m_recv_buffer->get_header_length() - received),
+          std::bind(&Session::handle_extended_header, this, session,
+                    std::placeholders::_1, std::placeholders::_2));
+      return;
+    }
+
+    read_msgbody(session);
+
+  } catch (const std::exception &e) {
+    spdlog::error("[{}] handle_header {}",
+                  ServerConfig::get_instance()->GrpcServerName, e.what());
+  }
+}
+
+void Session::handle_extended_header(std::shared_ptr<Session> session,
+                                     boost::system::error_code ec,
+                                     std::size_t bytes_transferred) {
+  try {
+    /*error occured*/
+    if (ec) {
+      spdlog::warn("[{}] Client Session {} UUID {} Extended Header Error! "
+                   "Error message {}",
+                   ServerConfig::get_instance()->GrpcServerName,
+                   session->s_session_id, session->s_uuid, ec.message());
+
+      purgeRemoveConnection(session);
+      return;
+    }
+
+    /*update remainning data to acquire*/
+    m_recv_buffer->update_pointer_pos(bytes_transferred);
+
+    if (m_recv_buffer->check_header_remaining()) {
+      spdlog::warn("[{}] Client Session {} UUID {} Extended Header Error! "
+                   "Only {} Bytes Received!",
+                   ServerConfig::get_instance()->GrpcServerName,
+                   session->s_session_id, session->s_uuid, bytes_transferred);
+
+      purgeRemoveConnection(session);
+      return;
+    }
+
+    read_msgbody(session);
+
+  } catch (const std::exception &e) {
+    spdlog::error("[{}] handle_extended_header {}",
+                  ServerConfig::get_instance()->GrpcServerName, e.what());
+  }
+}
+
+void Session::read_msgbody(std::shared_ptr<Session> session) {
+  try {
     /*
      * get msg_id and msg_length
      * and change the network sequence and convert network ----> host
@@ -261,7 +368,7 @@ void Session::handle_header(std::shared_ptr<Session> session,
       return;
     }
 
-    std::optional<uint16_t> length = m_recv_buffer->get_length();
+    std::optional<std::size_t> length = m_recv_buffer->get_length();
     if (!length.has_value()) {
       spdlog::warn(
           "[{}] Client Session {} UUID {} Header Error! Invalid Length! ",
@@ -272,14 +379,29 @@ void Session::handle_header(std::shared_ptr<Session> session,
       return;
     }
 
-    uint16_t msg_length = length.value();
+    std::size_t msg_length = length.value();
 
-    if (msg_length > MAX_LENGTH) {
+    /*fragments of another message could not be inserted in between*/
+    if (!m_fragments.empty() && msg_id != m_fragment_id) {
+      spdlog::warn(
+          "[{}] Client Session {} UUID {} Header Error! Service ID {} Inside "
+          "Fragments Of Service ID {}",
+          ServerConfig::get_instance()->GrpcServerName, session->s_session_id,
+          session->s_uuid, msg_id, m_fragment_id);
+
+      purgeRemoveConnection(session);
+      return;
+    }
+
+    /*limit is applied to the whole message, not a single fragment*/
+    if (m_fragments.size() + msg_length >
+        ServerConfig::get_instance()->getFrameLimit(
+            static_cast<ServiceType>(msg_id))) {
       spdlog::warn(
           "[{}] Client Session {} UUID {} Header Error! Due To Invalid Data "
           "Length, {} Bytes Received!",
           ServerConfig::get_instance()->GrpcServerName, session->s_session_id,
-          session->s_uuid, msg_length);
+          session->s_uuid, m_fragments.size() + msg_length);
 
       purgeRemoveConnection(session);
       return;
@@ -296,11 +418,26 @@ void Session::handle_header(std::shared_ptr<Session> session,
                   std::placeholders::_1, std::placeholders::_2));
 
   } catch (const std::exception &e) {
-    spdlog::error("[{}] handle_header {}",
+    spdlog::error("[{}] read_msgbody {}",
                   ServerConfig::get_instance()->GrpcServerName, e.what());
   }
 }
 
+void Session::read_header(std::shared_ptr<Session> session) {
+  /*
+   * Warning: m_header has already been init(cleared)
+   * RecvNode<std::string>: only create a Header
+   */
+  m_recv_buffer.reset(new Recv(ByteOrderConverter{}));
+
+  boost::asio::async_read(
+      session->s_socket,
+      boost::asio::buffer(m_recv_buffer->get_header_base(),
+                          m_recv_buffer->get_header_length()),
+      std::bind(&Session::handle_header, this, session, std::placeholders::_1,
+                std::placeholders::_2));
+}
+
 void Session::handle_msgbody(std::shared_ptr<Session> session,
                              boost::system::error_code ec,
                              std::size_t bytes_transferred) {
@@ -334,25 +471,50 @@ void Session::handle_msgbody(std::shared_ptr<Session> session,
     /*update heart beat*/
     updateLastHeartBeat();
 
+    const auto flags = m_recv_buffer->get_flags().value_or(0);
+
+    /*keep the fragment and wait for the rest of this message*/
+    if (flags & MSGNODE_FLAG_MORE_FRAGMENTS) {
+      m_fragment_id = m_recv_buffer->_id;
+      m_fragments.append(m_recv_buffer->get_msg_body().value());
+      read_header(session);
+      return;
+    }
+
+    /*last fragment, SyncLogic receives the whole message*/
+    if (!m_fragments.empty()) {
+      m_fragments.append(m_recv_buffer->get_msg_body().value());
+      m_recv_buffer->replace_msg_body(m_fragments);
+      m_fragments.clear();
+    }
+
+    /*inflated message is still restricted by the limit of its service*/
+    if (flags & MSGNODE_FLAG_COMPRESSED) {
+      auto inflated = compression::decompress(
+          m_recv_buffer->get_msg_body().value(),
+          ServerConfig::get_instance()->getFrameLimit(
+              static_cast<ServiceType>(m_recv_buffer->_id)));
+
+      if (!inflated.has_value()) {
+        spdlog::warn("[{}] Client Session {} UUID {} Decompress Message "
+                     "Failed!",
+                     ServerConfig::get_instance()->GrpcServerName,
+                     session->s_session_id, session->s_uuid);
+
+        purgeRemoveConnection(session);
+        return;
+      }
+      m_recv_buffer->replace_msg_body(*inflated);
+    }
+
     /*release owner ship of the data, you must release in another unique_ptr*/
     RecvPtr recv(m_recv_buffer.release());
 
     /*send the received data to SyncLogic to process it */
     SyncLogic::get_instance()->commit(std::make_pair(session, std::move(recv)));
 
-    /*
-     * if handle_msgbody is finished, then go back to header reader
-     * Warning: m_header has already been init(cleared)
-     * RecvNode<std::string>: only create a Header
-     */
-    m_recv_buffer.reset(new Recv(ByteOrderConverter{}));
-
-    boost::asio::async_read(
-        session->s_socket,
-        boost::asio::buffer(m_recv_buffer->get_header_base(),
-                            m_recv_buffer->get_header_length()),
-        std::bind(&Session::handle_header, this, session, std::placeholders::_1,
-                  std::placeholders::_2));
+    /*if handle_msgbody is finished, then go back to header reader*/
+    read_header(session);
   } catch (const std::exception &e) {
     spdlog::error("[{}] handle_msgbody {}",
                   ServerConfig::get_instance()->GrpcServerName, e.what());
@@ -415,11 +577,10 @@ void Session::sendOfflineMessage() {
 }
 
 void Session::decrementConnection() {
-  RedisRAII raii;
-
-  auto get_distributed_lock =
-      raii->get()->acquire(ServerConfig::get_instance()->GrpcServerName, 10, 10,
-                           redis::TimeUnit::Milliseconds);
+  auto get_distributed_lock = redis::LockService::get_instance()->acquire(
+      ServerConfig::get_instance()->GrpcServerName,
+      std::chrono::milliseconds(ServerConfig::get_instance()->LockWaitTime),
+      std::chrono::milliseconds(ServerConfig::get_instance()->LockLeaseTime));
 
   if (!get_distributed_lock.has_value()) {
     spdlog::error(
@@ -432,6 +593,8 @@ void Session::decrementConnection() {
       "[{}] Acquire Distributed-Lock In DecrementConnection Successful!",
       ServerConfig::get_instance()->GrpcServerName);
 
+  RedisRAII raii;
+
   /*try to acquire value from redis*/
   std::optional<std::string> counter = raii->get()->getValueFromHash(
       redis_server_login, ServerConfig::get_instance()->GrpcServerName);
@@ -457,8 +620,7 @@ void Session::decrementConnection() {
   }
 
   // release lock
-  raii->get()->release(ServerConfig::get_instance()->GrpcServerName,
-                       get_distributed_lock.value());
+  redis::LockService::get_instance()->release(get_distributed_lock.value());
 
   /*store this user belonged server into redis*/
   spdlog::info("[{}] Now {} Client Has Connected To Current Server",
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <redis/RedisContextRAII.hpp>
+#include <redis/SubscriberGroup.hpp>
+
+redis::SubscriberGroup::SubscriberGroup() : m_stop(false) {}
+
+redis::SubscriberGroup::~SubscriberGroup() { stop(); }
+
+void redis::SubscriberGroup::start(
+    const std::size_t count, std::function<void(const std::size_t)> body) {
+  for (std::size_t index = 0; index < count; ++index) {
+    m_threads.emplace_back([body, index]() { body(index); });
+  }
+}
+
+bool redis::SubscriberGroup::attach(RedisContext &context) {
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+  if (m_stop) {
+    return false;
+  }
+  m_attached.push_back(&context);
+  return true;
+}
+
+void redis::SubscriberGroup::detach(RedisContext &context) {
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+  m_attached.erase(
+      std::remove(m_attached.begin(), m_attached.end(), &context),
+      m_attached.end());
+}
+
+bool redis::SubscriberGroup::backoff(const std::chrono::milliseconds duration) {
+  std::unique_lock<std::mutex> _lckg(m_mtx);
+  return !m_cv.wait_for(_lckg, duration, [this]() { return m_stop.load(); });
+}
+
+void redis::SubscriberGroup::stop() {
+  {
+    std::lock_guard<std::mutex> _lckg(m_mtx);
+    m_stop = true;
+
+    /*threads blocked inside redisGetReply return at once*/
+    for (auto context : m_attached) {
+      context->interrupt();
+    }
+    m_cv.notify_all();
+  }
+
+  for (auto &thread : m_threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  m_threads.clear();
+}
@@ -1,11 +1,16 @@
 #include <chat/ChattingThreadDef.hpp>
+#include <chat/OfflineInbox.hpp>
 #include <config/ServerConfig.hpp>
 #include <grpc/GrpcDistributedChattingService.hpp>
 #include <grpc/GrpcRegisterChattingService.hpp>
 #include <grpc/GrpcUserService.hpp>
 #include <handler/SyncLogic.hpp>
+#include <redis/LockService.hpp>
 #include <server/AsyncServer.hpp>
+#include <service/IOServicePool.hpp>
 #include <spdlog/spdlog.h>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <user/RoutingCache.hpp>
 
 /*redis*/
 std::string SyncLogic::redis_server_login = "redis_server";
@@ -20,9 +25,6 @@ std::string SyncLogic::server_prefix = "uuid_";
 std::string SyncLogic::session_prefix = "session_";
 
 SyncLogic::SyncLogic() : m_stop(false) {
-  /*register callbacks*/
-  registerCallbacks();
-
   /*start processing thread to process queue*/
   m_working = std::thread(&SyncLogic::processing, this);
 }
@@ -56,11 +58,10 @@ void SyncLogic::shutdown() {
  * 2. HGET exist: Increment by 1
  */
 void SyncLogic::incrementConnection() {
-  RedisRAII raii;
-
-  auto get_distributed_lock =
-      raii->get()->acquire(ServerConfig::get_instance()->GrpcServerName, 10, 10,
-                           redis::TimeUnit::Milliseconds);
+  auto get_distributed_lock = redis::LockService::get_instance()->acquire(
+      ServerConfig::get_instance()->GrpcServerName,
+      std::chrono::milliseconds(ServerConfig::get_instance()->LockWaitTime),
+      std::chrono::milliseconds(ServerConfig::get_instance()->LockLeaseTime));
 
   if (!get_distributed_lock.has_value()) {
     spdlog::error(
@@ -73,6 +74,8 @@ void SyncLogic::incrementConnection() {
       "[{}] Acquire Distributed-Lock In  IncrementConnection Successful!",
       ServerConfig::get_instance()->GrpcServerName);
 
+  RedisRAII raii;
+
   /*try to acquire value from redis*/
   std::optional<std::string> counter = raii->get()->getValueFromHash(
       redis_server_login, ServerConfig::get_instance()->GrpcServerName);
@@ -95,23 +98,13 @@ void SyncLogic::incrementConnection() {
   }
 
   // release lock
-  raii->get()->release(ServerConfig::get_instance()->GrpcServerName,
-                       get_distributed_lock.value());
+  redis::LockService::get_instance()->release(get_distributed_lock.value());
 
   /*store this user belonged server into redis*/
   spdlog::info("[{}] Now {} Client Has Connected To Current Server",
                ServerConfig::get_instance()->GrpcServerName, new_number);
 }
 
-/*
- * check user status current online status, with distributed lock support
- * is this user current on any other server?
- */
-std::optional<std::string>
-SyncLogic::checkCurrentUser(RedisRAII &raii, const std::string &uuid) {
-  return raii->get()->checkValue(server_prefix + uuid);
-}
-
 void SyncLogic::kick_session(std::shared_ptr<Session> session) {
   session->sendOfflineMessage();
   session->removeRedisCache(session->get_user_uuid(),
@@ -141,23 +134,26 @@ bool SyncLogic::check_and_kick_existing_session(
   return false;
 }
 
-bool SyncLogic::labelCurrentUser(RedisRAII &raii, const std::string &uuid) {
-
-  const auto key = server_prefix + uuid;
+std::optional<std::pair<std::optional<std::string>, std::optional<std::string>>>
+SyncLogic::handoverCurrentUser([[maybe_unused]] RedisRAII &raii,
+                               const std::string &uuid,
+                               const std::string &session_id) {
 
-  return raii->get()->delPair(key) &&
-         raii->get()->setValue(key,
-                               ServerConfig::get_instance()->GrpcServerName);
-}
-
-/*store this user belonged session id into redis*/
-bool SyncLogic::labelUserSessionID([[maybe_unused]] RedisRAII &raii,
-                                   const std::string &uuid,
-                                   const std::string &session_id) {
+  /*both keys share the hash tag of uuid, so they live on the same node*/
+  auto previous = raii->get()->evalScript(
+      handover_lua_script,
+      {server_prefix + redis::hashTag(uuid),
+       session_prefix + redis::hashTag(uuid)},
+      {ServerConfig::get_instance()->GrpcServerName, session_id});
 
-  const auto key = session_prefix + uuid;
+  if (!previous.has_value() || previous->size() != 2) {
+    return std::nullopt;
+  }
 
-  return raii->get()->delPair(key) && raii->get()->setValue(key, session_id);
+  /*other servers might still cache the previous server of this user*/
+  user::RoutingCache::get_instance()->publishInvalidation(raii, uuid);
+  return std::make_pair(std::move(previous->at(0)),
+                        std::move(previous->at(1)));
 }
 
 void SyncLogic::updateRedisCache([[maybe_unused]] RedisRAII &raii,
@@ -165,86 +161,98 @@ void SyncLogic::updateRedisCache([[maybe_unused]] RedisRAII &raii,
                                  std::shared_ptr<Session> session) {
 
   auto uuid_int = std::stoi(uuid);
-  auto &new_session = session;
   auto &new_session_id = session->get_session_id();
 
-  /*Distributed-Lock on lock:[uuid], waiting time = 10ms, EX = 10ms*/
-  auto get_distributed_lock =
-      raii->get()->acquire(uuid, 10, 10, redis::TimeUnit::Milliseconds);
-
-  if (!get_distributed_lock.has_value()) {
-    spdlog::error("[{}] UUID = {} Distributed-Lock Acquire Failed!",
-                  ServerConfig::get_instance()->GrpcServerName, uuid);
+  /*
+   * store this user belonged server & session id into redis, ownership
+   * moves to this session at once, the previous owner is kicked afterwards
+   */
+  auto previous = handoverCurrentUser(raii, uuid, new_session_id);
+  if (!previous.has_value()) {
+    spdlog::error("[{}] UUID={} & Session ID={} Can Not Be Written To Redis "
+                  "Cache! Error Occured!",
+                  ServerConfig::get_instance()->GrpcServerName, uuid,
+                  new_session_id);
     return;
   }
 
-  spdlog::info("[{}] UUID = {} Acquire Distributed-Lock Successful!",
-               ServerConfig::get_instance()->GrpcServerName, uuid);
-
-  /* check user current online status, with distributed lock support */
-  if (auto status = checkCurrentUser(raii, uuid)) {
-    const auto &current = *status;
-
-    /*this user existing on current server*/
-    if (current == ServerConfig::get_instance()->GrpcServerName) {
-      /*Get Existing old session object and send offline message then delete it
-       * from server*/
-      if (auto kick_session = UserManager::get_instance()->getSession(uuid);
-          kick_session) {
-        auto &old_session = *kick_session;
-        old_session->sendOfflineMessage();
-        UserManager::get_instance()->moveUserToTerminationZone(
-            old_session->get_user_uuid());
-        UserManager::get_instance()->removeUsrSession(
-            old_session->get_user_uuid(), old_session->get_session_id());
-      }
-    }
-    /*This user  Already Logined On Other Server*/
-    else {
-      spdlog::info("[{}] UUID = {} Has Already Logined On Other [{}] GRPC "
-                   "Server, Executing Distributed Kick Method!",
-                   current, uuid, current);
-
-      message::TerminationRequest req;
-      req.set_kick_uuid(uuid_int);
-      auto response = gRPCDistributedChattingService::get_instance()
-                          ->forceTerminateLoginedUser(current, req);
-
-      if (response.error() !=
-              static_cast<std::size_t>(ServiceStatus::SERVICE_SUCCESS) ||
-          response.kick_uuid() != uuid_int) {
+  spdlog::info("[{}] UUID={}& Session ID={} Has Written To Redis Cache",
+               ServerConfig::get_instance()->GrpcServerName, uuid,
+               new_session_id);
 
-        spdlog::warn("[{}] Trying to Executing Distributed Kick Method On "
-                     "Other [{}] GRPC Server Failed",
-                     ServerConfig::get_instance()->GrpcServerName, current);
+  auto &[current, old_session_id] = *previous;
 
-        generateErrorMessage("Internel Server Error",
-                             ServiceType::SERVICE_LOGINRESPONSE,
-                             ServiceStatus::LOGIN_UNSUCCESSFUL, session);
+  /*this user was offline*/
+  if (!current.has_value()) {
+    return;
+  }
 
-        // release lock
-        raii->get()->release(uuid, get_distributed_lock.value());
-        return;
-      }
+  /*this user existing on current server*/
+  if (*current == ServerConfig::get_instance()->GrpcServerName) {
+    /*Get Existing old session object and send offline message then delete it
+     * from server*/
+    if (auto kick_session = UserManager::get_instance()->getSession(uuid);
+        kick_session && (*kick_session)->get_session_id() != new_session_id) {
+      auto &old_session = *kick_session;
+      old_session->sendOfflineMessage();
+      UserManager::get_instance()->moveUserToTerminationZone(
+          old_session->get_user_uuid());
+      UserManager::get_instance()->removeUsrSession(
+          old_session->get_user_uuid(), old_session->get_session_id());
     }
+    return;
   }
 
-  /* store this user belonged server & session idinto redis */
-  if (!labelCurrentUser(raii, uuid) ||
-      !labelUserSessionID(raii, uuid, new_session_id)) {
-    spdlog::error("[{}] UUID={} & Session ID={} Can Not Be Written To Redis "
-                  "Cache! Error Occured!",
-                  ServerConfig::get_instance()->GrpcServerName, uuid,
-                  new_session_id);
-  }
+  /*
+   * This user Already Logined On Other Server, login does not wait for it,
+   * that server only kicks the session which has just been replaced
+   */
+  spdlog::info("[{}] UUID = {} Has Already Logined On Other [{}] GRPC "
+               "Server, Executing Distributed Kick Method!",
+               ServerConfig::get_instance()->GrpcServerName, uuid, *current);
+
+  message::TerminationRequest req;
+  req.set_kick_uuid(uuid_int);
+  req.set_kick_session_id(old_session_id.value_or(""));
+  kickRemoteSession(*current, req);
+}
 
-  /*store this user belonged server into redis*/
-  spdlog::info("[{}] UUID={}& Session ID={} Has Written To Redis Cache",
-               ServerConfig::get_instance()->GrpcServerName, uuid,
-               new_session_id);
+void SyncLogic::kickRemoteSession(const std::string &server,
+                                  const message::TerminationRequest &req,
+                                  const std::size_t attempt) {
+  auto &service = gRPCDistributedChattingService::get_instance();
+  service->asyncForceTerminateLoginedUser(
+      server, req,
+      [server, req, attempt](message::TerminationResponse response) {
+        if (response.error() ==
+                static_cast<std::size_t>(ServiceStatus::SERVICE_SUCCESS) &&
+            response.kick_uuid() == req.kick_uuid()) {
+          return;
+        }
+
+        if (attempt + 1 >= max_kick_attempts) {
+          spdlog::error("[{}] Distributed Kick Method Of UUID = {} On Other "
+                        "[{}] GRPC Server Failed {} Times, Giving Up",
+                        ServerConfig::get_instance()->GrpcServerName,
+                        req.kick_uuid(), server, max_kick_attempts);
+          return;
+        }
 
-  // release lock
-  raii->get()->release(uuid, get_distributed_lock.value());
+        spdlog::warn("[{}] Trying to Executing Distributed Kick Method On "
+                     "Other [{}] GRPC Server Failed, Retrying...",
+                     ServerConfig::get_instance()->GrpcServerName, server);
+
+        /*grpc callback thread must not sleep, retry it on a timer*/
+        auto timer = std::make_shared<boost::asio::steady_timer>(
+            IOServicePool::get_instance()->getIOServiceContext(),
+            kick_retry_delay * (std::size_t{1} << attempt));
+        timer->async_wait([timer, server, req,
+                           attempt](const boost::system::error_code &ec) {
+          if (!ec) {
+            kickRemoteSession(server, req, attempt + 1);
+          }
+        });
+      });
 }
 
 /*parse Json*/
@@ -270,6 +278,26 @@ bool SyncLogic::parseJson(std::shared_ptr<Session> session, NodePtr &recv,
   return true;
 }
 
+std::optional<RequestView> SyncLogic::parseRequest(
+    std::shared_ptr<Session> session, NodePtr &recv, ServiceType type) {
+  std::optional<std::string_view> body = recv->get_msg_body_view();
+  std::optional<RequestView> ret;
+
+  if (body.has_value()) {
+    ret = RequestView::parse(body.value());
+  }
+  if (!ret.has_value()) {
+    generateErrorMessage("Invalid JSON format", type,
+                         ServiceStatus::JSONPARSE_ERROR, session);
+  }
+  return ret;
+}
+
+std::chrono::milliseconds SyncLogic::acquireTimeout() {
+  return std::chrono::milliseconds(
+      ServerConfig::get_instance()->PoolAcquireTimeout);
+}
+
 void SyncLogic::generateErrorMessage(const std::string &log, ServiceType type,
                                      ServiceStatus status, SessionPtr conn) {
 
@@ -304,15 +332,15 @@ void SyncLogic::processing() {
 void SyncLogic::execute(pair &&node) {
   std::shared_ptr<Session> session = node.first;
 
-  ServiceType type = static_cast<ServiceType>(node.second->_id);
+  const std::size_t index = node.second->_id;
+  ServiceType type = static_cast<ServiceType>(index);
   try {
     /*executing callback on specific type*/
-    auto it = m_callbacks.find(type);
-    if (it == m_callbacks.end()) {
+    if (index >= handler_table.size() || handler_table[index] == nullptr) {
       spdlog::warn("Service Type Not Found!");
       return;
     }
-    m_callbacks[type](type, session, std::move(node.second));
+    (this->*handler_table[index])(type, session, std::move(node.second));
   } catch (const std::exception &e) {
     spdlog::error("Excute Method Failed, Internel Server Error! Error Code {}",
                   e.what());
@@ -322,77 +350,120 @@ void SyncLogic::execute(pair &&node) {
 /*get user's basic info(name, age, sex, ...) from redis*/
 std::optional<std::unique_ptr<user::UserNameCard>>
 SyncLogic::getUserBasicInfo(const std::string &key) {
+  auto list = getUserProfiles({key});
+  if (!list.front()) {
+    return std::nullopt;
+  }
+  return std::move(list.front());
+}
 
-  RedisRAII raii;
+std::vector<std::unique_ptr<user::UserNameCard>>
+SyncLogic::getUserProfiles(const std::vector<std::string> &uuids) {
+  std::vector<std::unique_ptr<user::UserNameCard>> result(uuids.size());
+  if (uuids.empty()) {
+    return result;
+  }
+
+  RedisRAII raii(acquireTimeout());
+  if (!raii.is_active()) {
+    return result;
+  }
 
   /*
    * Search For Info Cache in Redis
-   * find key = user_prefix  + uuid in redis, GET
+   * find key = user_prefix + uuid in redis, MGET
    */
-  std::optional<std::string> info_str =
-      raii->get()->checkValue(user_prefix + key);
-
-  /*we could find it in Redis directly*/
-  if (info_str.has_value()) {
-
-    /*parse cache data inside Redis*/
-    boost::json::object root;
-    try {
-      root = boost::json::parse(info_str.value()).as_object();
-    } catch (const boost::json::system_error &e) {
-      spdlog::error("Failed to parse json data!");
-      return std::nullopt;
+  std::vector<std::string> keys;
+  keys.reserve(uuids.size());
+  for (const auto &uuid : uuids) {
+    keys.push_back(user_prefix + uuid);
+  }
+  auto cached = raii->get()->getValues(keys);
+
+  /*uuid -> positions in result, the same user might be asked twice*/
+  std::unordered_map<std::size_t, std::vector<std::size_t>> misses;
+  for (std::size_t i = 0; i < uuids.size(); ++i) {
+    if (cached[i].has_value()) {
+      try {
+        auto root = boost::json::parse(cached[i].value()).as_object();
+        result[i] = std::make_unique<user::UserNameCard>(
+            boost::json::value_to<std::string>(root["uuid"]),
+            boost::json::value_to<std::string>(root["avator"]),
+            boost::json::value_to<std::string>(root["username"]),
+            boost::json::value_to<std::string>(root["nickname"]),
+            boost::json::value_to<std::string>(root["description"]),
+            static_cast<user::Sex>(root["sex"].as_int64()));
+        continue;
+      } catch (const boost::json::system_error &e) {
+        spdlog::error("Failed to parse json data!");
+      }
     }
 
-    return std::make_unique<user::UserNameCard>(
-        boost::json::value_to<std::string>(root["uuid"]),
-        boost::json::value_to<std::string>(root["avator"]),
-        boost::json::value_to<std::string>(root["username"]),
-        boost::json::value_to<std::string>(root["nickname"]),
-        boost::json::value_to<std::string>(root["description"]),
-        static_cast<user::Sex>(root["sex"].as_int64()));
-
-  } else {
-    boost::json::object redis_root;
+    auto uuid_op = tools::string_to_value<std::size_t>(uuids[i]);
+    if (!uuid_op.has_value()) {
+      spdlog::error("Casting string typed key to std::size_t!");
+      continue;
+    }
+    misses[uuid_op.value()].push_back(i);
+  }
 
-    /*search it in mysql*/
-    connection::ConnectionRAII<mysql::MySQLConnectionPool,
-                               mysql::MySQLConnection>
-        mysql;
+  if (misses.empty()) {
+    return result;
+  }
 
-    auto uuid_op = tools::string_to_value<std::size_t>(key);
+  std::vector<std::size_t> ids;
+  ids.reserve(misses.size());
+  for (const auto &[uuid, _] : misses) {
+    ids.push_back(uuid);
+  }
 
-    if (!uuid_op.has_value()) {
-      spdlog::error("Casting string typed key to std::size_t!");
-      return std::nullopt;
+  /*search all misses in mysql at once*/
+  std::optional<std::vector<std::unique_ptr<user::UserNameCard>>> profiles;
+  {
+    MySQLRAII mysql(mysql::MySQLReplicaRouter::get_instance()->read(
+                        mysql::MySQLConnectionPool::get_instance(), ids),
+                    acquireTimeout());
+    if (mysql.is_active()) {
+      profiles = mysql->get()->getUserProfiles(ids);
     }
+  }
 
-    std::size_t uuid = uuid_op.value();
-    auto profile_op = mysql->get()->getUserProfile(uuid);
+  if (!profiles.has_value()) {
+    spdlog::warn("[{}] Load {} User Profiles From MySQL Failed!",
+                 ServerConfig::get_instance()->GrpcServerName, ids.size());
+    return result;
+  }
 
-    /*when user info not found!*/
-    if (!profile_op.has_value()) {
-      spdlog::warn("[UUID = {}] No User Profile Found!", uuid);
-      return std::nullopt;
+  /*write data into redis as cache*/
+  std::vector<std::vector<std::string>> commands;
+  commands.reserve(profiles->size());
+  for (auto &info : *profiles) {
+    auto uuid_op = tools::string_to_value<std::size_t>(info->m_uuid);
+    if (!uuid_op.has_value() || !misses.count(uuid_op.value())) {
+      continue;
     }
 
-    std::unique_ptr<user::UserNameCard> info = std::move(profile_op.value());
+    boost::json::object redis_root;
     redis_root["uuid"] = info->m_uuid;
     redis_root["sex"] = static_cast<uint8_t>(info->m_sex);
     redis_root["avator"] = info->m_avatorPath;
     redis_root["username"] = info->m_username;
     redis_root["nickname"] = info->m_nickname;
     redis_root["description"] = info->m_description;
+    commands.push_back({"SET", user_prefix + info->m_uuid,
+                        boost::json::serialize(redis_root)});
 
-    /*write data into redis as cache*/
-    if (!raii->get()->setValue(user_prefix + key,
-                               boost::json::serialize(redis_root))) {
-      spdlog::error("[UUID = {}] Write Data To Redis Failed!", uuid);
-      return std::nullopt;
+    for (const auto pos : misses[uuid_op.value()]) {
+      result[pos] = std::make_unique<user::UserNameCard>(*info);
     }
-    return info;
   }
-  return std::nullopt;
+
+  if (!commands.empty() && !raii->get()->pipeline(commands)) {
+    spdlog::error("[{}] Write {} User Profiles To Redis Failed!",
+                  ServerConfig::get_instance()->GrpcServerName,
+                  commands.size());
+  }
+  return result;
 }
 
 /*
@@ -412,7 +483,9 @@ SyncLogic::getFriendRequestInfo(const std::string &dst_uuid,
   }
 
   /*search it in mysql*/
-  MySQLRAII mysql;
+  MySQLRAII mysql(
+      mysql::MySQLReplicaRouter::get_instance()->read(uuid_op.value()),
+      acquireTimeout());
 
   // check if we got a valid RAII pointer
   if (auto opt = mysql.get_native(); opt) {
@@ -440,7 +513,9 @@ SyncLogic::getAuthFriendsInfo(const std::string &dst_uuid,
   }
 
   /*search it in mysql*/
-  MySQLRAII mysql;
+  MySQLRAII mysql(
+      mysql::MySQLReplicaRouter::get_instance()->read(uuid_op.value()),
+      acquireTimeout());
 
   // check if we got a valid RAII pointer
   if (auto opt = mysql.get_native(); opt) {
@@ -470,7 +545,9 @@ SyncLogic::getChatThreadInfo(const std::string &self_uuid,
   }
 
   /*search it in mysql*/
-  MySQLRAII mysql;
+  MySQLRAII mysql(
+      mysql::MySQLReplicaRouter::get_instance()->read(uuid_op.value()),
+      acquireTimeout());
 
   // check if we got a valid RAII pointer
   if (auto opt = mysql.get_native(); opt) {
@@ -480,3 +557,58 @@ SyncLogic::getChatThreadInfo(const std::string &self_uuid,
 
   return std::nullopt;
 }
+
+void SyncLogic::deliverOfflineMessages([[maybe_unused]] RedisRAII &raii,
+                                       const std::string &uuid,
+                                       std::shared_ptr<Session> session) {
+
+  auto messages = chat::OfflineInbox::get_instance()->drain(raii, uuid);
+  if (messages.empty()) {
+    return;
+  }
+
+  const std::size_t budget = ServerConfig::get_instance()->SyncFrameSize;
+
+  boost::json::array msg_arr;
+  std::size_t frame_size = 0;
+
+  /*messages come from different senders, every item carries its own sender*/
+  auto flush = [&]() {
+    boost::json::object dst_root;
+    dst_root["error"] = static_cast<uint8_t>(ServiceStatus::SERVICE_SUCCESS);
+    dst_root["text_receiver"] = uuid;
+    dst_root["text_msg"] = std::move(msg_arr);
+    session->sendMessage(ServiceType::SERVICE_TEXTCHATMSGICOMINGREQUEST,
+                         boost::json::serialize(dst_root), session);
+
+    msg_arr = boost::json::array{};
+    frame_size = 0;
+  };
+
+  for (const auto &item : messages) {
+    boost::json::value value;
+    try {
+      value = boost::json::parse(item);
+    } catch (const std::exception &e) {
+      spdlog::warn("[{}] UUID = {} Invalid Offline Message, Error = {}",
+                   ServerConfig::get_instance()->GrpcServerName, uuid,
+                   e.what());
+      continue;
+    }
+
+    if (frame_size && frame_size + item.size() > budget) {
+      flush();
+    }
+
+    frame_size += item.size();
+    msg_arr.push_back(std::move(value));
+  }
+
+  if (!msg_arr.empty()) {
+    flush();
+  }
+
+  spdlog::info("[{}] UUID = {} Delivered {} Offline Messages",
+               ServerConfig::get_instance()->GrpcServerName, uuid,
+               messages.size());
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <condition_variable>
+#include <config/ServerConfig.hpp>
+#include <mutex>
+#include <redis/RedisManager.hpp>
+#include <redis/TrackingCache.hpp>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+redis::TrackingCache::TrackingCache()
+    : m_enabled(ServerConfig::get_instance()->RedisTrackingEnabled),
+      m_prefixes(ServerConfig::get_instance()->RedisTrackingPrefixes),
+      m_capacity(ServerConfig::get_instance()->RedisTrackingCapacity),
+      m_check_interval(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->RedisTrackingCheckInterval)),
+      m_nodes(0), m_subscribed(0), m_version(0), m_epoch(0) {
+
+  /*routing entries already have their own invalidation channel*/
+  auto routing = std::find(m_prefixes.begin(), m_prefixes.end(),
+                           std::string(routing_prefix));
+  if (routing != m_prefixes.end()) {
+    spdlog::warn("[{}] Prefix {} Is Cached By RoutingCache, Not Tracked!",
+                 ServerConfig::get_instance()->GrpcServerName,
+                 routing_prefix);
+    m_prefixes.erase(routing);
+  }
+
+  if (!m_enabled || m_prefixes.empty()) {
+    m_enabled = false;
+    return;
+  }
+
+  m_nodes = RedisConnectionPool::get_instance()->ring()->size();
+  m_subscribers.start(m_nodes,
+                      [this](const std::size_t node) { subscriber(node); });
+}
+
+redis::TrackingCache::~TrackingCache() { shutdown(); }
+
+void redis::TrackingCache::shutdown() { m_subscribers.stop(); }
+
+bool redis::TrackingCache::tracked(const std::string &key) const {
+  if (!m_enabled) {
+    return false;
+  }
+  for (const auto &prefix : m_prefixes) {
+    if (!key.compare(0, prefix.size(), prefix)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::optional<std::string>
+redis::TrackingCache::find(const std::string &key) {
+  if (m_subscribed != m_nodes) {
+    return std::nullopt;
+  }
+
+  decltype(m_entries)::const_accessor accessor;
+  if (m_entries.find(accessor, key) && accessor->second.epoch == m_epoch) {
+    return accessor->second.value;
+  }
+  return std::nullopt;
+}
+
+void redis::TrackingCache::store(const std::string &key,
+                                 const std::string &value,
+                                 const std::size_t version) {
+  if (m_subscribed != m_nodes) {
+    return;
+  }
+
+  /*no eviction order is kept, hot keys come back on their next read*/
+  if (m_entries.size() >= m_capacity) {
+    m_entries.clear();
+  }
+
+  decltype(m_entries)::accessor accessor;
+  m_entries.insert(accessor, key);
+
+  /*invalidation happened during redis query, this value might be stale*/
+  if (m_version.load() != version) {
+    m_entries.erase(accessor);
+    return;
+  }
+  accessor->second.value = value;
+  accessor->second.epoch = m_epoch;
+}
+
+void redis::TrackingCache::drop(const std::string &key) {
+  if (!tracked(key)) {
+    return;
+  }
+  ++m_version;
+  m_entries.erase(key);
+}
+
+void redis::TrackingCache::subscriber(const std::size_t node) {
+  const auto &address =
+      RedisConnectionPool::get_instance()->ring()->nodes().at(node);
+
+  /*subscriber and tracking connections only talk to this node*/
+  auto ring = std::make_shared<const RedisShardRing>(
+      std::vector<RedisNode>{address});
+
+  while (!m_subscribers.stopped()) {
+    RedisContext context(ring, ServerConfig::get_instance()->Redis_passwd);
+    RedisContext tracking(ring, ServerConfig::get_instance()->Redis_passwd);
+
+    auto id = context.isValid() ? context.clientId(0) : std::nullopt;
+    if (!id.has_value() || !tracking.isValid() ||
+        !tracking.enableTracking(0, id.value(), m_prefixes) ||
+        !context.subscribe(invalidate_channel)) {
+      spdlog::warn("[{}] Enable Client Tracking On Redis {}:{} Failed, "
+                   "Retrying...",
+                   ServerConfig::get_instance()->GrpcServerName,
+                   address.first, address.second);
+      if (!m_subscribers.backoff(std::chrono::seconds(1))) {
+        break;
+      }
+      continue;
+    }
+
+    if (!m_subscribers.attach(context)) {
+      break;
+    }
+
+    ++m_subscribed;
+
+    /*
+     * tracking stops silently once its connection is gone, ping it and
+     * break the subscriber, so it is handled as a lost subscriber
+     */
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done = false;
+    std::thread checker([&]() {
+      std::unique_lock<std::mutex> _lckg(mtx);
+      while (!cv.wait_for(_lckg, m_check_interval, [&]() { return done; })) {
+        if (!tracking.heartBeat()) {
+          spdlog::warn("[{}] Client Tracking Connection Of Redis {}:{} Lost!",
+                       ServerConfig::get_instance()->GrpcServerName,
+                       address.first, address.second);
+          context.interrupt();
+          return;
+        }
+      }
+    });
+
+    while (!m_subscribers.stopped() && context.isValid()) {
+      auto keys = context.waitForInvalidation();
+      if (!keys.has_value()) {
+        continue;
+      }
+
+      ++m_version;
+      if (keys->empty()) {
+        m_entries.clear();
+      }
+      for (const auto &key : keys.value()) {
+        m_entries.erase(key);
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> _lckg(mtx);
+      done = true;
+    }
+    cv.notify_one();
+    checker.join();
+    m_subscribers.detach(context);
+
+    /*invalidations might be lost, local copies can not be trusted anymore*/
+    --m_subscribed;
+    ++m_version;
+    ++m_epoch;
+
+    spdlog::warn("[{}] Client Tracking Subscriber Of Redis {}:{} "
+                 "Disconnected!",
+                 ServerConfig::get_instance()->GrpcServerName, address.first,
+                 address.second);
+  }
+}
@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cctype>
+#include <config/ServerConfig.hpp>
+#include <functional>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <tools/tools.hpp>
+#include <tuple>
+#include <user/UserSearchIndex.hpp>
+
+user::UserSearchIndex::UserSearchIndex()
+    : m_stop(false),
+      m_batch_size(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->UserSearchScanBatchSize)),
+      m_max_typos(ServerConfig::get_instance()->UserSearchMaxTypos),
+      m_refresh_interval(
+          ServerConfig::get_instance()->UserSearchRefreshInterval) {
+
+  /*load all users page by page before serving any search*/
+  while (loadNewUsers()) {
+  }
+
+  spdlog::info("[{}] User Search Index Loaded {} Users",
+               ServerConfig::get_instance()->GrpcServerName,
+               m_entries.size());
+
+  m_refresher = std::thread([this]() { refresher(); });
+}
+
+user::UserSearchIndex::~UserSearchIndex() { shutdown(); }
+
+void user::UserSearchIndex::shutdown() {
+  if (m_stop.exchange(true)) {
+    return;
+  }
+
+  m_cv.notify_all();
+  if (m_refresher.joinable()) {
+    m_refresher.join();
+  }
+}
+
+void user::UserSearchIndex::insert(const std::size_t uuid,
+                                   std::string_view username,
+                                   std::string_view nickname) {
+  Entry entry{toLower(username), toLower(nickname)};
+
+  std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+  auto it = m_entries.find(uuid);
+  if (it != m_entries.end()) {
+    eraseTerms(uuid, it->second);
+  }
+  insertTerms(uuid, entry);
+  m_entries[uuid] = std::move(entry);
+}
+
+user::UserSearchIndex::SearchResult
+user::UserSearchIndex::search(std::string_view query, const std::size_t offset,
+                              const std::size_t limit) const {
+  SearchResult ret;
+  const std::string key = toLower(query);
+  if (key.empty()) {
+    return ret;
+  }
+
+  std::unordered_map<std::size_t, Rank> ranks;
+  auto update = [&ranks](const std::size_t uuid, const Rank &rank) {
+    auto [it, inserted] = ranks.try_emplace(uuid, rank);
+    if (!inserted && std::tie(rank.tier, rank.distance, rank.length) <
+                         std::tie(it->second.tier, it->second.distance,
+                                  it->second.length)) {
+      it->second = rank;
+    }
+  };
+
+  /*short names tolerate less typos*/
+  const std::size_t typos = key.size() <= 4
+                                ? std::min<std::size_t>(1, m_max_typos)
+                                : m_max_typos;
+
+  /*fuzzy candidates are copied out, edit distance never blocks writers*/
+  struct Candidate {
+    std::size_t uuid;
+    std::size_t hits; // trigrams of key found in its names
+    Entry entry;
+  };
+  std::vector<Candidate> fuzzy;
+  std::vector<std::string> grams;
+  std::size_t full_typos = 0, prefix_typos = 0;
+  {
+    std::shared_lock<std::shared_mutex> _lckg(m_index_mtx);
+
+    /*exact and prefix match*/
+    std::size_t scanned = 0;
+    for (auto it = m_terms.lower_bound(std::make_pair(key, std::size_t{0}));
+         it != m_terms.end() && scanned < max_prefix_candidates &&
+         it->first.compare(0, key.size(), key) == 0;
+         ++it, ++scanned) {
+      const std::size_t extra = it->first.size() - key.size();
+      update(it->second, Rank{extra ? 1u : 0u, extra, it->first.size()});
+    }
+
+    /*
+     * fuzzy match, q-gram lemma: one typo breaks at most 4 trigrams of key
+     * (3 for an edit, 4 for swapping adjacent chars), a prefix match also
+     * loses the trigram of trailing padding. typos are capped until at least
+     * one trigram must be shared, otherwise postings could not find every
+     * name within the distance
+     */
+    if (typos && key.size() >= 3) {
+      grams = trigrams(key);
+      full_typos = std::min(typos, (grams.size() - 1) / grams_per_typo);
+      prefix_typos = std::min(typos, (grams.size() - 2) / grams_per_typo);
+    }
+
+    if (full_typos || prefix_typos) {
+      const std::size_t required =
+          std::min(grams.size() - grams_per_typo * full_typos,
+                   grams.size() - grams_per_typo * prefix_typos - 1);
+
+      std::unordered_map<std::size_t, std::size_t> hits;
+      for (const auto &gram : grams) {
+        auto it = m_grams.find(gram);
+        if (it == m_grams.end()) {
+          continue;
+        }
+        for (const auto uuid : it->second) {
+          ++hits[uuid];
+        }
+      }
+
+      std::vector<std::pair</*hits*/ std::size_t, std::size_t>> candidates;
+      for (const auto &[uuid, count] : hits) {
+        if (count >= required) {
+          candidates.emplace_back(count, uuid);
+        }
+      }
+
+      /*names sharing most trigrams are verified first*/
+      if (candidates.size() > max_fuzzy_candidates) {
+        std::nth_element(candidates.begin(),
+                         candidates.begin() + max_fuzzy_candidates,
+                         candidates.end(), std::greater<>());
+        candidates.resize(max_fuzzy_candidates);
+      }
+
+      fuzzy.reserve(candidates.size());
+      for (const auto &[count, uuid] : candidates) {
+        fuzzy.push_back(Candidate{uuid, count, m_entries.at(uuid)});
+      }
+    }
+  }
+
+  for (const auto &candidate : fuzzy) {
+    const auto &entry = candidate.entry;
+    for (const std::string *term : {&entry.username, &entry.nickname}) {
+      if (term->empty()) {
+        continue;
+      }
+      std::size_t d = full_typos + 1;
+      if (candidate.hits + grams_per_typo * full_typos >= grams.size()) {
+        d = editDistance(key, *term, full_typos);
+      }
+      if (d <= full_typos) {
+        update(candidate.uuid, Rank{2, d, term->size()});
+      } else if (term->size() > key.size() &&
+                 candidate.hits + grams_per_typo * prefix_typos + 1 >=
+                     grams.size()) {
+        /*typo inside the prefix of a longer name*/
+        std::string_view prefix(term->data(), key.size());
+        if (d = editDistance(key, prefix, prefix_typos); d <= prefix_typos) {
+          update(candidate.uuid, Rank{3, d, term->size()});
+        }
+      }
+    }
+  }
+
+  std::vector<std::pair<Rank, std::size_t>> ranked;
+  ranked.reserve(ranks.size());
+  for (const auto &[uuid, rank] : ranks) {
+    ranked.emplace_back(rank, uuid);
+  }
+  std::sort(ranked.begin(), ranked.end(), [](const auto &lhs, const auto &rhs) {
+    return std::tie(lhs.first.tier, lhs.first.distance, lhs.first.length,
+                    lhs.second) < std::tie(rhs.first.tier, rhs.first.distance,
+                                           rhs.first.length, rhs.second);
+  });
+
+  ret.total = ranked.size();
+  for (std::size_t i = offset; i < ranked.size() && i - offset < limit; ++i) {
+    ret.uuids.push_back(ranked[i].second);
+  }
+  return ret;
+}
+
+bool user::UserSearchIndex::loadNewUsers() {
+  std::size_t after_uuid{};
+  {
+    std::shared_lock<std::shared_mutex> _lckg(m_index_mtx);
+    after_uuid = m_max_uuid;
+  }
+
+  std::optional<std::vector<std::unique_ptr<user::UserNameCard>>> list;
+  {
+    /*a lagging replica only delays new users until the next round*/
+    MySQLRAII mysql(mysql::MySQLReplicaRouter::get_instance()->read(
+        mysql::MySQLConnectionPool::get_instance()));
+    list = mysql->get()->getUserSearchEntries(after_uuid, m_batch_size);
+  }
+
+  if (!list.has_value() || list->empty()) {
+    return false;
+  }
+
+  std::size_t max_uuid = after_uuid;
+  for (const auto &card : *list) {
+    auto uuid = tools::string_to_value<std::size_t>(card->m_uuid);
+    if (!uuid.has_value()) {
+      continue;
+    }
+    insert(*uuid, card->m_username, card->m_nickname);
+    max_uuid = std::max(max_uuid, *uuid);
+  }
+
+  {
+    std::unique_lock<std::shared_mutex> _lckg(m_index_mtx);
+    m_max_uuid = std::max(m_max_uuid, max_uuid);
+  }
+
+  /*a full batch means there might be more*/
+  return list->size() >= m_batch_size;
+}
+
+void user::UserSearchIndex::refresher() {
+  while (!m_stop) {
+    {
+      std::unique_lock<std::mutex> _lckg(m_mtx);
+      if (m_cv.wait_for(_lckg, m_refresh_interval,
+                        [this]() { return m_stop.load(); })) {
+        break;
+      }
+    }
+
+    while (!m_stop && loadNewUsers()) {
+    }
+  }
+}
+
+void user::UserSearchIndex::insertTerms(const std::size_t uuid,
+                                        const Entry &entry) {
+  std::set<std::string> grams;
+  for (const std::string *term : {&entry.username, &entry.nickname}) {
+    if (term->empty()) {
+      continue;
+    }
+    m_terms.emplace(*term, uuid);
+    auto term_grams = trigrams(*term);
+    grams.insert(term_grams.begin(), term_grams.end());
+  }
+
+  for (const auto &gram : grams) {
+    m_grams[gram].push_back(uuid);
+  }
+}
+
+void user::UserSearchIndex::eraseTerms(const std::size_t uuid,
+                                       const Entry &entry) {
+  std::set<std::string> grams;
+  for (const std::string *term : {&entry.username, &entry.nickname}) {
+    if (term->empty()) {
+      continue;
+    }
+    m_terms.erase(std::make_pair(*term, uuid));
+    auto term_grams = trigrams(*term);
+    grams.insert(term_grams.begin(), term_grams.end());
+  }
+
+  for (const auto &gram : grams) {
+    auto it = m_grams.find(gram);
+    if (it == m_grams.end()) {
+      continue;
+    }
+    auto &postings = it->second;
+    postings.erase(std::remove(postings.begin(), postings.end(), uuid),
+                   postings.end());
+    if (postings.empty()) {
+      m_grams.erase(it);
+    }
+  }
+}
+
+std::string user::UserSearchIndex::toLower(std::string_view str) {
+  std::string ret(str);
+  std::transform(ret.begin(), ret.end(), ret.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return ret;
+}
+
+std::vector<std::string>
+user::UserSearchIndex::trigrams(std::string_view term) {
+  /*padding makes leading and trailing chars count as much as others*/
+  const std::string padded = "$$" + std::string(term) + "$";
+
+  std::set<std::string> grams;
+  for (std::size_t i = 0; i + 3 <= padded.size(); ++i) {
+    grams.insert(padded.substr(i, 3));
+  }
+  return std::vector<std::string>(grams.begin(), grams.end());
+}
+
+std::size_t user::UserSearchIndex::editDistance(std::string_view lhs,
+                                                std::string_view rhs,
+                                                const std::size_t limit) {
+  const std::size_t diff = lhs.size() > rhs.size() ? lhs.size() - rhs.size()
+                                                   : rhs.size() - lhs.size();
+  if (diff > limit) {
+    return limit + 1;
+  }
+
+  /*optimal string alignment, swapping two adjacent chars is one typo*/
+  std::vector<std::size_t> prev2(rhs.size() + 1), prev(rhs.size() + 1),
+      cur(rhs.size() + 1);
+  for (std::size_t j = 0; j <= rhs.size(); ++j) {
+    prev[j] = j;
+  }
+
+  for (std::size_t i = 1; i <= lhs.size(); ++i) {
+    cur[0] = i;
+    std::size_t row_min = cur[0];
+    for (std::size_t j = 1; j <= rhs.size(); ++j) {
+      const std::size_t cost = lhs[i - 1] == rhs[j - 1] ? 0 : 1;
+      cur[j] = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + cost});
+      if (i > 1 && j > 1 && lhs[i - 1] == rhs[j - 2] &&
+          lhs[i - 2] == rhs[j - 1]) {
+        cur[j] = std::min(cur[j], prev2[j - 2] + 1);
+      }
+      row_min = std::min(row_min, cur[j]);
+    }
+
+    /*every path is already beyond limit*/
+    if (row_min > limit) {
+      return limit + 1;
+    }
+    std::swap(prev2, prev);
+    std::swap(prev, cur);
+  }
+  return std::min(prev[rhs.size()], limit + 1);
+}
@@ -0,0 +1,305 @@
+#include <array>
+#include <chat/WriteAheadLog.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <spdlog/spdlog.h>
+#include <tools/tools.hpp>
+
+namespace {
+constexpr std::size_t header_size = sizeof(std::uint32_t) * 2;
+
+/*a single record should never be larger than this*/
+constexpr std::uint32_t max_payload = 16 * 1024 * 1024;
+
+template <typename _Ty> void put(std::string &out, const _Ty value) {
+  out.append(reinterpret_cast<const char *>(&value), sizeof(_Ty));
+}
+
+template <typename _Ty> bool take(const std::string &in, std::size_t &pos,
+                                  _Ty &value) {
+  if (pos + sizeof(_Ty) > in.size()) {
+    return false;
+  }
+  std::memcpy(&value, in.data() + pos, sizeof(_Ty));
+  pos += sizeof(_Ty);
+  return true;
+}
+} // namespace
+
+chat::WriteAheadLog::WriteAheadLog(const std::string &dir)
+    : m_log_path((std::filesystem::path(dir) / "chatting.wal").string()),
+      m_checkpoint_path(
+          (std::filesystem::path(dir) / "chatting.checkpoint").string()),
+      m_file(nullptr), m_end(0), m_dirty(false) {}
+
+chat::WriteAheadLog::~WriteAheadLog() {
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+  if (m_file != nullptr) {
+    std::fflush(m_file);
+    tools::syncFile(m_file);
+    std::fclose(m_file);
+    m_file = nullptr;
+  }
+}
+
+std::optional<std::vector<chat::WriteAheadLog::Record>>
+chat::WriteAheadLog::open() {
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+
+  std::error_code ec;
+  std::filesystem::create_directories(
+      std::filesystem::path(m_log_path).parent_path(), ec);
+
+  auto start = loadCheckpoint();
+  if (!start.has_value()) {
+    return std::nullopt;
+  }
+
+  std::vector<Record> records;
+  std::size_t valid_end = 0;
+
+  if (std::filesystem::exists(m_log_path, ec)) {
+    std::ifstream in(m_log_path, std::ios::binary);
+    std::string header(header_size, '\0');
+    std::string payload;
+    std::size_t pos = 0;
+
+    while (in.read(header.data(), header_size)) {
+      std::uint32_t length{}, checksum{};
+      std::memcpy(&length, header.data(), sizeof(length));
+      std::memcpy(&checksum, header.data() + sizeof(length), sizeof(checksum));
+
+      if (length > max_payload) {
+        break;
+      }
+
+      payload.resize(length);
+      if (!in.read(payload.data(), length) ||
+          crc32(payload.data(), length) != checksum) {
+        break;
+      }
+
+      pos += header_size + length;
+
+      /*records before checkpoint are already in MySQL*/
+      if (pos > *start) {
+        auto record = decode(payload);
+        if (!record.has_value()) {
+          break;
+        }
+        record->end_offset = pos;
+        records.push_back(std::move(record.value()));
+      }
+      valid_end = pos;
+    }
+  }
+
+  /*crashed after log was truncated but before checkpoint was reset*/
+  if (*start > valid_end) {
+    spdlog::warn("[WAL]: Checkpoint {} Exceeds Log End {}, Reset To Zero",
+                 *start, valid_end);
+    if (!storeCheckpoint(0)) {
+      return std::nullopt;
+    }
+  }
+
+  /*cut off torn tail, so new records will not be appended after garbage*/
+  if (std::filesystem::exists(m_log_path, ec) &&
+      std::filesystem::file_size(m_log_path, ec) != valid_end) {
+    spdlog::warn("[WAL]: Cut Off Incomplete Records After Offset {}",
+                 valid_end);
+    std::filesystem::resize_file(m_log_path, valid_end, ec);
+    if (ec) {
+      spdlog::error("[WAL]: Truncate {} Failed: {}", m_log_path, ec.message());
+      return std::nullopt;
+    }
+  }
+
+  if (!reopen("ab")) {
+    return std::nullopt;
+  }
+
+  m_end = valid_end;
+  spdlog::info("[WAL]: {} Records Need To Be Replayed From {}", records.size(),
+               m_log_path);
+  return records;
+}
+
+bool chat::WriteAheadLog::append(std::vector<Record> &records) {
+  std::string buffer;
+  std::vector<std::size_t> ends;
+  ends.reserve(records.size());
+
+  for (const auto &record : records) {
+    auto payload = encode(record);
+    put(buffer, static_cast<std::uint32_t>(payload.size()));
+    put(buffer, crc32(payload.data(), payload.size()));
+    buffer.append(payload);
+    ends.push_back(buffer.size());
+  }
+
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+  if (m_file == nullptr) {
+    return false;
+  }
+
+  /*handover to kernel, so records survive a process crash at once*/
+  if (std::fwrite(buffer.data(), 1, buffer.size(), m_file) != buffer.size() ||
+      std::fflush(m_file) != 0) {
+    spdlog::error("[WAL]: Append {} Records To {} Failed!", records.size(),
+                  m_log_path);
+
+    /*drop partial write, do not leave garbage between records*/
+    std::error_code ec;
+    std::filesystem::resize_file(m_log_path, m_end, ec);
+    return false;
+  }
+
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    records[i].end_offset = m_end + ends[i];
+  }
+
+  m_end += buffer.size();
+  m_dirty = true;
+  return true;
+}
+
+bool chat::WriteAheadLog::sync() {
+  if (!m_dirty.exchange(false)) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+  if (m_file == nullptr) {
+    return false;
+  }
+  if (tools::syncFile(m_file) != 0) {
+    spdlog::error("[WAL]: Fsync {} Failed!", m_log_path);
+    m_dirty = true;
+    return false;
+  }
+  return true;
+}
+
+bool chat::WriteAheadLog::checkpoint(const std::size_t offset) {
+  std::lock_guard<std::mutex> _lckg(m_mtx);
+
+  /*everything is in MySQL, start over with an empty log*/
+  if (offset == m_end) {
+    if (!reopen("wb") || !reopen("ab")) {
+      return false;
+    }
+    m_end = 0;
+    return storeCheckpoint(0);
+  }
+  return storeCheckpoint(offset);
+}
+
+std::optional<std::size_t> chat::WriteAheadLog::loadCheckpoint() {
+  std::error_code ec;
+  if (!std::filesystem::exists(m_checkpoint_path, ec)) {
+    return 0;
+  }
+
+  std::ifstream in(m_checkpoint_path, std::ios::binary);
+  std::uint64_t offset{};
+  if (!in.read(reinterpret_cast<char *>(&offset), sizeof(offset))) {
+    spdlog::error("[WAL]: Read Checkpoint {} Failed!", m_checkpoint_path);
+    return std::nullopt;
+  }
+  return static_cast<std::size_t>(offset);
+}
+
+bool chat::WriteAheadLog::storeCheckpoint(const std::size_t offset) {
+  /*write to a temporary file then rename, checkpoint is never half written*/
+  const auto temp = m_checkpoint_path + ".tmp";
+  {
+    std::FILE *file = std::fopen(temp.c_str(), "wb");
+    if (file == nullptr) {
+      spdlog::error("[WAL]: Open Checkpoint {} Failed!", temp);
+      return false;
+    }
+
+    const auto value = static_cast<std::uint64_t>(offset);
+    const bool status =
+        std::fwrite(&value, sizeof(value), 1, file) == 1 &&
+        std::fflush(file) == 0 && tools::syncFile(file) == 0;
+    std::fclose(file);
+
+    if (!status) {
+      spdlog::error("[WAL]: Write Checkpoint {} Failed!", temp);
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temp, m_checkpoint_path, ec);
+  if (ec) {
+    spdlog::error("[WAL]: Rename Checkpoint {} Failed: {}", temp,
+                  ec.message());
+    return false;
+  }
+  return true;
+}
+
+bool chat::WriteAheadLog::reopen(const char *mode) {
+  if (m_file != nullptr) {
+    std::fclose(m_file);
+  }
+
+  m_file = std::fopen(m_log_path.c_str(), mode);
+  if (m_file == nullptr) {
+    spdlog::error("[WAL]: Open {} Failed!", m_log_path);
+    return false;
+  }
+  return true;
+}
+
+std::string chat::WriteAheadLog::encode(const Record &record) {
+  std::string payload;
+  payload.reserve(sizeof(std::uint64_t) * 5 + record.content.size());
+  put(payload, record.message_id);
+  put(payload, record.thread_id);
+  put(payload, record.sender);
+  put(payload, record.receiver);
+  put(payload, record.timestamp);
+  payload.append(record.content);
+  return payload;
+}
+
+std::optional<chat::WriteAheadLog::Record>
+chat::WriteAheadLog::decode(const std::string &payload) {
+  Record record;
+  std::size_t pos = 0;
+  if (!take(payload, pos, record.message_id) ||
+      !take(payload, pos, record.thread_id) ||
+      !take(payload, pos, record.sender) ||
+      !take(payload, pos, record.receiver) ||
+      !take(payload, pos, record.timestamp)) {
+    return std::nullopt;
+  }
+  record.content = payload.substr(pos);
+  return record;
+}
+
+std::uint32_t chat::WriteAheadLog::crc32(const char *data,
+                                         std::size_t length) {
+  static const auto table = []() {
+    std::array<std::uint32_t, 256> t{};
+    for (std::uint32_t i = 0; i < 256; ++i) {
+      std::uint32_t c = i;
+      for (int k = 0; k < 8; ++k) {
+        c = (c & 1) ? 0xEDB88320U ^ (c >> 1) : c >> 1;
+      }
+      t[i] = c;
+    }
+    return t;
+  }();
+
+  std::uint32_t crc = 0xFFFFFFFFU;
+  for (std::size_t i = 0; i < length; ++i) {
+    crc = table[(crc ^ static_cast<std::uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFU;
+}
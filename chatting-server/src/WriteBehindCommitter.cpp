@@ -0,0 +1,266 @@
+#include <algorithm>
+#include <chat/MessageIdGenerator.hpp>
+#include <chat/WriteBehindCommitter.hpp>
+#include <config/ServerConfig.hpp>
+#include <map>
+#include <spdlog/spdlog.h>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <sql/MySQLShardRouter.hpp>
+#include <tools/tools.hpp>
+
+chat::WriteBehindCommitter::WriteBehindCommitter()
+    : m_enabled(ServerConfig::get_instance()->WriteBehindEnabled),
+      m_stop(false),
+      m_batch_size(std::max<std::size_t>(
+          1, ServerConfig::get_instance()->WriteBehindBatchSize)),
+      m_fsync_interval(ServerConfig::get_instance()->WriteBehindFsyncInterval),
+      m_commit_interval(
+          ServerConfig::get_instance()->WriteBehindCommitInterval) {
+
+  if (!m_enabled) {
+    return;
+  }
+
+  m_wal = std::make_unique<WriteAheadLog>(
+      ServerConfig::get_instance()->WriteBehindDirectory);
+
+  auto replay = m_wal->open();
+  if (!replay.has_value()) {
+    spdlog::critical("[{}] Open Write-Ahead Log In {} Failed!",
+                     ServerConfig::get_instance()->GrpcServerName,
+                     ServerConfig::get_instance()->WriteBehindDirectory);
+    std::abort();
+  }
+
+  /*messages acknowledged before crash, but not stored in MySQL*/
+  m_pending.insert(m_pending.end(),
+                   std::make_move_iterator(replay->begin()),
+                   std::make_move_iterator(replay->end()));
+
+  m_committer = std::thread([this]() { committer(); });
+  m_syncer = std::thread([this]() { syncer(); });
+}
+
+chat::WriteBehindCommitter::~WriteBehindCommitter() { shutdown(); }
+
+bool chat::WriteBehindCommitter::submit(
+    std::vector<std::shared_ptr<chat::MsgInfo>> &info) {
+
+  if (!m_enabled || m_stop) {
+    return false;
+  }
+
+  const auto timestamp = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::seconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+
+  std::vector<WriteAheadLog::Record> records;
+  records.reserve(info.size());
+
+  for (auto &item : info) {
+    auto thread_id_op = tools::string_to_value<std::size_t>(item->thread_id);
+    auto sender_op = tools::string_to_value<std::size_t>(item->msg_sender);
+    auto receiver_op = tools::string_to_value<std::size_t>(item->msg_receiver);
+
+    if (!thread_id_op.has_value() || !sender_op.has_value() ||
+        !receiver_op.has_value() || *sender_op == *receiver_op ||
+        item->msg_content.size() > max_content_length) {
+      return false;
+    }
+
+    auto message_id = MessageIdGenerator::get_instance()->next();
+    if (!message_id.has_value()) {
+      return false;
+    }
+
+    WriteAheadLog::Record record;
+    record.message_id = *message_id;
+    record.thread_id = *thread_id_op;
+    record.sender = *sender_op;
+    record.receiver = *receiver_op;
+    record.timestamp = timestamp;
+    record.content = item->msg_content;
+    records.push_back(std::move(record));
+  }
+
+  {
+    /*
+     * WAL offset and pending queue must share the same order, otherwise
+     * checkpoint might skip a record which is not yet committed
+     */
+    std::lock_guard<std::mutex> _lckg(m_mtx);
+    if (!m_wal->append(records)) {
+      return false;
+    }
+
+    for (std::size_t i = 0; i < info.size(); ++i) {
+      info[i]->timestamp = std::to_string(timestamp);
+      info[i]->setMsgID(std::to_string(records[i].message_id));
+    }
+
+    m_pending.insert(m_pending.end(), std::make_move_iterator(records.begin()),
+                     std::make_move_iterator(records.end()));
+  }
+
+  m_cv.notify_one();
+  return true;
+}
+
+bool chat::WriteBehindCommitter::checkPrivateChatThread(
+    const std::size_t thread_id, const std::size_t sender,
+    const std::size_t receiver) {
+
+  if (sender == receiver) {
+    return false;
+  }
+
+  const auto users =
+      std::make_pair(std::min(sender, receiver), std::max(sender, receiver));
+  {
+    std::shared_lock<std::shared_mutex> _lckg(m_threads_mtx);
+    auto it = m_private_threads.find(thread_id);
+    if (it != m_private_threads.end()) {
+      return it->second == users;
+    }
+  }
+
+  bool owned = false;
+  {
+    MySQLRAII mysql(
+        mysql::MySQLReplicaRouter::get_instance()->read(
+            mysql::MySQLShardRouter::get_instance()->route(thread_id), sender),
+        std::chrono::milliseconds(
+            ServerConfig::get_instance()->PoolAcquireTimeout));
+    owned = mysql.is_active() &&
+            mysql->get()->checkPrivateChatThread(thread_id, sender, receiver);
+  }
+
+  /*a failed check is never cached, thread might be created right now*/
+  if (!owned) {
+    return false;
+  }
+
+  std::lock_guard<std::shared_mutex> _lckg(m_threads_mtx);
+  if (m_private_threads.size() >= max_private_threads) {
+    m_private_threads.clear();
+  }
+  m_private_threads.emplace(thread_id, users);
+  return true;
+}
+
+void chat::WriteBehindCommitter::shutdown() {
+  if (!m_enabled || m_stop.exchange(true)) {
+    return;
+  }
+
+  m_cv.notify_all();
+
+  if (m_committer.joinable()) {
+    m_committer.join();
+  }
+  if (m_syncer.joinable()) {
+    m_syncer.join();
+  }
+
+  m_wal->sync();
+}
+
+void chat::WriteBehindCommitter::committer() {
+  std::chrono::milliseconds backoff = m_commit_interval;
+
+  while (true) {
+    std::vector<WriteAheadLog::Record> batch;
+    {
+      std::unique_lock<std::mutex> _lckg(m_mtx);
+
+      /*wait for a full batch, or commit whatever we have after interval*/
+      m_cv.wait_for(_lckg, m_commit_interval, [this]() {
+        return m_stop || m_pending.size() >= m_batch_size;
+      });
+
+      if (m_pending.empty()) {
+        if (m_stop) {
+          break;
+        }
+        continue;
+      }
+
+      const auto count = std::min(m_batch_size, m_pending.size());
+      batch.assign(m_pending.begin(), m_pending.begin() + count);
+    }
+
+    if (!persist(batch)) {
+      /*records stay in WAL and memory, retry later*/
+      if (m_stop) {
+        spdlog::warn("[{}] Uncommitted Messages Left In Write-Ahead Log, "
+                     "Will Be Replayed On Next Startup",
+                     ServerConfig::get_instance()->GrpcServerName);
+        break;
+      }
+
+      std::this_thread::sleep_for(backoff);
+      backoff = std::min(backoff * 2, std::chrono::milliseconds(5000));
+      continue;
+    }
+
+    backoff = m_commit_interval;
+
+    {
+      std::lock_guard<std::mutex> _lckg(m_mtx);
+      m_pending.erase(m_pending.begin(), m_pending.begin() + batch.size());
+    }
+
+    if (!m_wal->checkpoint(batch.back().end_offset)) {
+      spdlog::warn("[{}] Write-Ahead Log Checkpoint Update Failed!",
+                   ServerConfig::get_instance()->GrpcServerName);
+    }
+  }
+}
+
+void chat::WriteBehindCommitter::syncer() {
+  while (!m_stop) {
+    std::this_thread::sleep_for(m_fsync_interval);
+    m_wal->sync();
+  }
+}
+
+bool chat::WriteBehindCommitter::persist(
+    const std::vector<WriteAheadLog::Record> &batch) {
+
+  std::vector<std::shared_ptr<chat::MsgInfo>> info;
+  info.reserve(batch.size());
+
+  for (const auto &record : batch) {
+    auto item = std::make_shared<chat::TextMsgInfo>(
+        std::to_string(record.thread_id), std::to_string(record.sender),
+        std::to_string(record.receiver), record.content, 0,
+        std::to_string(record.timestamp));
+    item->setMsgID(std::to_string(record.message_id));
+    info.push_back(std::move(item));
+  }
+
+  /*every shard stores its own part, rows are inserted with IGNORE so a
+   * retry after a partial failure is harmless*/
+  std::map<mysql::MySQLShardRouter::pool_ptr,
+           std::vector<std::shared_ptr<chat::MsgInfo>>>
+      shards;
+  for (auto &item : info) {
+    shards[mysql::MySQLShardRouter::get_instance()->route(item->thread_id)]
+        .push_back(std::move(item));
+  }
+
+  for (const auto &[pool, items] : shards) {
+    MySQLRAII mysql(pool);
+    if (!mysql.is_active() ||
+        !mysql->get()->createChattingHistoryRecordBatch(items)) {
+      return false;
+    }
+  }
+
+  for (const auto &record : batch) {
+    mysql::MySQLReplicaRouter::get_instance()->wrote(record.sender);
+    mysql::MySQLReplicaRouter::get_instance()->wrote(record.receiver);
+  }
+  return true;
+}
@@ -1,24 +1,108 @@
+#include <algorithm>
+#include <boost/asio/steady_timer.hpp>
+#include <chat/ChatSearchIndex.hpp>
+#include <chat/HistoryArchive.hpp>
+#include <chat/MessageIdGenerator.hpp>
+#include <chat/ReadCursorManager.hpp>
+#include <chat/WriteBehindCommitter.hpp>
 #include <config/ServerConfig.hpp>
+#include <functional>
 #include <grpc/DistributedChattingServicePool.hpp>
 #include <grpc/GrpcDistributedChattingImpl.hpp>
 #include <grpc/GrpcRegisterChattingService.hpp>
 #include <grpc/RegisterChattingServicePool.hpp>
 #include <grpc/UserServicePool.hpp>
 #include <handler/SyncLogic.hpp>
+#include <redis/AsyncRedisClient.hpp>
+#include <redis/LockService.hpp>
 #include <redis/RedisManager.hpp>
+#include <redis/TrackingCache.hpp>
 #include <server/AsyncServer.hpp>
 #include <service/IOServicePool.hpp>
 #include <spdlog/spdlog.h>
 #include <sql/MySQLConnectionPool.hpp>
+#include <sql/MySQLReplicaRouter.hpp>
+#include <sql/MySQLShardRouter.hpp>
+#include <tools/tools.hpp>
+#include <user/RoutingCache.hpp>
+#include <user/UserSearchIndex.hpp>
 
 // redis_server_login hash
 static std::string redis_server_login = "redis_server";
 
-int main() {
+/*how long requests waited for pooled stubs since last, last is moved on*/
+template <typename PoolPtr, typename Statistics>
+static void reportPool(const std::string &name, const PoolPtr &pool,
+                       Statistics &last) {
+  auto current = pool->statistics();
+  auto delta = current.since(last);
+  last = current;
+
+  spdlog::info("[{}] {} Pool Wait p50 <= {}us, p99 <= {}us, Timeouts {}, "
+               "Utilisation {}",
+               ServerConfig::get_instance()->GrpcServerName, name,
+               delta.waitQuantile(0.5), delta.waitQuantile(0.99),
+               delta.timeouts, delta.utilisationHistogram());
+}
+
+/*
+ * Move chat history between MySQL shards, servers could stay online
+ * ChattingServer --migrate [bucket] [shard]
+ * ChattingServer --split [from shard] [to shard]
+ */
+static int shardTool(int argc, char *argv[]) {
+  const std::string command = argv[1];
+  if (argc != 4 || (command != "--migrate" && command != "--split")) {
+    spdlog::error("Usage: {} --migrate [bucket] [shard] | "
+                  "--split [from shard] [to shard]",
+                  argv[0]);
+    return 1;
+  }
+
+  auto router = mysql::MySQLShardRouter::get_instance();
+  bool status = false;
+  if (command == "--split") {
+    status = router->split(argv[2], argv[3]);
+  } else if (auto bucket = tools::string_to_value<std::size_t>(argv[2]);
+             bucket.has_value()) {
+    status = router->migrate(*bucket, argv[3]);
+  } else {
+    spdlog::error("Invalid Bucket {}!", argv[2]);
+  }
+
+  router->shutdown();
+  return status ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
   try {
+    if (argc > 1) {
+      return shardTool(argc, argv);
+    }
+
     [[maybe_unused]] auto &service_pool = IOServicePool::get_instance();
     [[maybe_unused]] auto &mysql = mysql::MySQLConnectionPool::get_instance();
     [[maybe_unused]] auto &redis = redis::RedisConnectionPool::get_instance();
+    [[maybe_unused]] auto &async_redis =
+        redis::AsyncRedisClient::get_instance();
+    [[maybe_unused]] auto &tracking = redis::TrackingCache::get_instance();
+    [[maybe_unused]] auto &locks = redis::LockService::get_instance();
+    [[maybe_unused]] auto &shard_router =
+        mysql::MySQLShardRouter::get_instance();
+    [[maybe_unused]] auto &replica_router =
+        mysql::MySQLReplicaRouter::get_instance();
+    [[maybe_unused]] auto &routing = user::RoutingCache::get_instance();
+    [[maybe_unused]] auto &message_id =
+        chat::MessageIdGenerator::get_instance();
+    [[maybe_unused]] auto &write_behind =
+        chat::WriteBehindCommitter::get_instance();
+    [[maybe_unused]] auto &read_cursor =
+        chat::ReadCursorManager::get_instance();
+    [[maybe_unused]] auto &user_search =
+        user::UserSearchIndex::get_instance();
+    [[maybe_unused]] auto &chat_search =
+        chat::ChatSearchIndex::get_instance();
+    [[maybe_unused]] auto &archive = chat::HistoryArchive::get_instance();
     [[maybe_unused]] auto &user = stubpool::UserServicePool::get_instance();
     [[maybe_unused]] auto &chatting =
         stubpool::RegisterChattingServicePool::get_instance();
@@ -50,6 +134,11 @@ int main() {
     builder.AddListeningPort(address, grpc::InsecureServerCredentials());
     builder.RegisterService(&impl);
 
+    /*responses to peer chatting servers are compressed as well*/
+    if (ServerConfig::get_instance()->GrpcCompressionEnabled) {
+      builder.SetDefaultCompressionAlgorithm(GRPC_COMPRESS_GZIP);
+    }
+
     std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
 
     /*execute grpc server in another thread*/
@@ -111,9 +200,11 @@ int main() {
     /*set current server connection counter value(0) to hash by using HSET*/
     connection::ConnectionRAII<redis::RedisConnectionPool, redis::RedisContext>
         raii;
-    auto get_distributed_lock =
-        raii->get()->acquire(ServerConfig::get_instance()->GrpcServerName, 10,
-                             10, redis::TimeUnit::Milliseconds);
+    auto get_distributed_lock = locks->acquire(
+        ServerConfig::get_instance()->GrpcServerName,
+        std::chrono::milliseconds(ServerConfig::get_instance()->LockWaitTime),
+        std::chrono::milliseconds(
+            ServerConfig::get_instance()->LockLeaseTime));
 
     if (!get_distributed_lock.has_value()) {
       spdlog::error("[{}] Acquire Distributed-Lock In Startup Phase Failed!",
@@ -137,8 +228,30 @@ int main() {
     }
 
     // release lock
-    raii->get()->release(ServerConfig::get_instance()->GrpcServerName,
-                         get_distributed_lock.value());
+    locks->release(get_distributed_lock.value());
+
+    /*report pool statistics every interval while server is running*/
+    const std::chrono::seconds report_interval(std::max<std::size_t>(
+        1, ServerConfig::get_instance()->PoolStatisticsInterval));
+    auto redis_last = redis->statistics();
+    auto mysql_last = mysql->statistics();
+    auto user_last = user->statistics();
+
+    boost::asio::steady_timer report_timer(ioc);
+    std::function<void(const boost::system::error_code &)> report =
+        [&](const boost::system::error_code &ec) {
+          if (ec) {
+            return;
+          }
+          reportPool("Redis", redis, redis_last);
+          reportPool("MySQL", mysql, mysql_last);
+          reportPool("UserService", user, user_last);
+
+          report_timer.expires_after(report_interval);
+          report_timer.async_wait(report);
+        };
+    report_timer.expires_after(report_interval);
+    report_timer.async_wait(report);
 
     /*create chatting server*/
     std::shared_ptr<AsyncServer> async = std::make_shared<AsyncServer>(
@@ -159,13 +272,47 @@ int main() {
     async->stopTimer(); // terminate timer!
     async->shutdown();  // shutdown system and kick out all the clients
 
+    /*store messages left in write-ahead log before mysql pool is gone*/
+    write_behind->shutdown();
+
+    /*store coalesced read cursors*/
+    read_cursor->shutdown();
+
+    /*stop loading newly registered users*/
+    user_search->shutdown();
+
+    /*stop tailing messages and flush search postings to segment*/
+    chat_search->shutdown();
+
+    /*stop moving old messages into archive segments*/
+    archive->shutdown();
+
+    /*give message node id back*/
+    message_id->shutdown();
+
+    /*stop reloading mysql shard map*/
+    shard_router->shutdown();
+
+    /*io_contexts are stopped, close non-blocking redis connections*/
+    async_redis->shutdown();
+
+    /*stop receiving redis invalidations*/
+    tracking->shutdown();
+
+    /*what is left since the last periodic report*/
+    reportPool("Redis", redis, redis_last);
+    reportPool("MySQL", mysql, mysql_last);
+    reportPool("UserService", user, user_last);
+
     /*
      * Chatting server shutdown
      * Delete current chatting server connection counter by using HDEL
      */
-    get_distributed_lock =
-        raii->get()->acquire(ServerConfig::get_instance()->GrpcServerName, 10,
-                             10, redis::TimeUnit::Milliseconds);
+    get_distributed_lock = locks->acquire(
+        ServerConfig::get_instance()->GrpcServerName,
+        std::chrono::milliseconds(ServerConfig::get_instance()->LockWaitTime),
+        std::chrono::milliseconds(
+            ServerConfig::get_instance()->LockLeaseTime));
 
     if (!get_distributed_lock.has_value()) {
       spdlog::error("[{}] Acquire Distributed-Lock In Shutdown Phase Failed!",
@@ -186,8 +333,10 @@ int main() {
     }
 
     // release lock
-    raii->get()->release(ServerConfig::get_instance()->GrpcServerName,
-                         get_distributed_lock.value());
+    locks->release(get_distributed_lock.value());
+
+    /*no more distributed locks from now on*/
+    locks->shutdown();
 
     /*
      * Chatting Server Shutdown
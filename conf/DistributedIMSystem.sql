@@ -83,14 +83,24 @@ Create TABLE chatting.GroupMember(
 
 -- Create Chatting Messages' History recored
 CREATE TABLE chatting.ChatMsgHistoryBank(
-	message_id BIGINT UNSIGNED NOT NULL AUTO_INCREMENT COMMENT 'for server or client to recored their unique message',
+	message_id BIGINT UNSIGNED NOT NULL AUTO_INCREMENT COMMENT 'for server or client to recored their unique message, generated by chatting server(time | node | sequence)',
     thread_id BIGINT UNSIGNED NOT NULL COMMENT 'refer to chatting.GlobalThreadIndexTable.id',
     message_status TINYINT NOT NULL DEFAULT 0 COMMENT '0=unread, 1=read, 2=revoke',
     message_sender BIGINT UNSIGNED NOT NULL COMMENT 'The sender of this message, refering to chatting.Authentication.uuid',
+    message_receiver BIGINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'The receiver of a private chat message, 0 for group chat message',
     created_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP,
     updated_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE current_timestamp,
     message_content TEXT NOT NULL,
     primary key (message_id),
     KEY search_thread_created  (thread_id, created_at),
     KEY search_thread_message (thread_id, message_id)
-);
\ No newline at end of file
+);
+
+-- Create Read Cursor Table(last message of a thread which has been read by user)
+CREATE TABLE chatting.ChatReadCursor(
+    user_uuid BIGINT UNSIGNED NOT NULL COMMENT 'chatting.Authentication.uuid',
+    thread_id BIGINT UNSIGNED NOT NULL COMMENT 'refer to chatting.GlobalThreadIndexTable.id',
+    last_read_message_id BIGINT UNSIGNED NOT NULL DEFAULT 0 COMMENT 'refer to chatting.ChatMsgHistoryBank.message_id',
+    updated_at TIMESTAMP NOT NULL DEFAULT CURRENT_TIMESTAMP ON UPDATE current_timestamp,
+    PRIMARY KEY (user_uuid, thread_id)
+);
@@ -20,7 +20,7 @@ public:
   bool redisCommand(RedisContext &context, const std::string &command,
                     Args &&...args) {
     m_redisReply.reset(reinterpret_cast<redisReply *>(
-        ::redisCommand(context.m_redisContext.get(), command.c_str(),
+        ::redisCommand(context.m_redisContext, command.c_str(),
                        std::forward<Args>(args)...)));
     return isSuccessful();
   }
@@ -2,6 +2,8 @@
 #ifndef _REDISCONTEXTRAII_HPP_
 #define _REDISCONTEXTRAII_HPP_
 #include <chrono>
+#include <memory>
+#include <redis/RedisShardRing.hpp>
 #include <string>
 #include <string_view>
 #include <tools/tools.hpp>
@@ -29,8 +31,11 @@ public:
   ~RedisContext() = default;
   RedisContext() noexcept;
 
-  /*connect to redis automatically*/
-  RedisContext(const std::string &ip, unsigned short port,
+  /*
+   * connect to every node of ring automatically
+   * each command is sent to the node which owns its key
+   */
+  RedisContext(std::shared_ptr<const RedisShardRing> ring,
                const std::string &password) noexcept;
 
   /*RedisTools will shutdown connection automatically!*/
@@ -70,6 +75,12 @@ private:
 
   std::optional<tools::RedisContextWrapper> operator->();
 
+  /*following commands are sent to node*/
+  void use(const std::size_t node);
+
+  /*following commands are sent to the node which owns key*/
+  void route(std::string_view key);
+
   static constexpr const char *lock = "lock:";
 
   // Lock Might be acquired by others, so when  KEYS[1]!=ARGV[1]
@@ -85,8 +96,12 @@ private:
   /*if check error failed, m_valid will be set to false*/
   bool m_valid;
 
-  /*redis context*/
-  tools::RedisSmartPtr<redisContext> m_redisContext;
+  /*node -> redis context*/
+  std::shared_ptr<const RedisShardRing> m_ring;
+  std::vector<tools::RedisSmartPtr<redisContext>> m_nodes;
+
+  /*node selected by use() or route()*/
+  redisContext *m_redisContext;
 
   /*last operation time*/
   std::chrono::steady_clock::time_point last_operation_time;
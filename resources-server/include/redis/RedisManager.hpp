@@ -16,25 +16,26 @@ class RedisConnectionPool
   friend class Singleton<RedisConnectionPool>;
 
   RedisConnectionPool() noexcept;
-  RedisConnectionPool(const std::size_t _timeout, const std::string &_ip,
-                      const std::string &_passwd,
-                      const unsigned short _port) noexcept;
+  RedisConnectionPool(const std::size_t _timeout,
+                      const std::vector<RedisNode> &_nodes,
+                      const std::string &_passwd) noexcept;
 
 public:
   ~RedisConnectionPool() = default;
 
+  /*key -> node mapping shared by every connection*/
+  std::shared_ptr<const RedisShardRing> ring() const { return m_ring; }
+
 protected:
   void roundRobinChecking();
 
 private:
-  bool connector(const std::string &_ip, const std::string &_passwd,
-                 const unsigned short _port);
+  bool connector();
 
 private:
   /*redis connector*/
-  std::string m_ip;
   std::string m_passwd;
-  unsigned short m_port;
+  std::shared_ptr<const RedisShardRing> m_ring;
 
   /*round robin thread*/
   std::size_t m_timeout;
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cctype>
+#include <redis/RedisShardRing.hpp>
+
+redis::RedisShardRing::RedisShardRing(const std::vector<RedisNode> &nodes)
+    : m_nodes(nodes) {
+
+  m_ring.reserve(m_nodes.size() * virtual_nodes);
+  for (std::size_t i = 0; i < m_nodes.size(); ++i) {
+    /*points depend on node address only, not on its order in config*/
+    const auto name =
+        m_nodes[i].first + ":" + std::to_string(m_nodes[i].second) + "#";
+    for (std::size_t v = 0; v < virtual_nodes; ++v) {
+      m_ring.emplace_back(hash(name + std::to_string(v)), i);
+    }
+  }
+  std::sort(m_ring.begin(), m_ring.end());
+}
+
+std::size_t redis::RedisShardRing::locate(std::string_view key) const {
+  if (m_nodes.size() < 2) {
+    return 0;
+  }
+
+  auto it = std::lower_bound(
+      m_ring.begin(), m_ring.end(),
+      std::make_pair(hash(routingKey(key)), std::size_t{0}));
+  return it == m_ring.end() ? m_ring.front().second : it->second;
+}
+
+std::size_t
+redis::RedisShardRing::locate(const std::vector<std::string> &command) const {
+  if (command.size() < 2) {
+    return 0;
+  }
+
+  std::string name = command.front();
+  std::transform(name.begin(), name.end(), name.begin(),
+                 [](unsigned char c) { return std::toupper(c); });
+
+  /*EVAL script numkeys key1 ..., the first key decides*/
+  if (name == "EVAL" || name == "EVALSHA") {
+    if (command.size() < 4 || command[2] == "0") {
+      return 0;
+    }
+    return locate(command[3]);
+  }
+  return locate(command[1]);
+}
+
+std::string_view redis::RedisShardRing::routingKey(std::string_view key) {
+  auto begin = key.find('{');
+  if (begin == std::string_view::npos) {
+    return key;
+  }
+  auto end = key.find('}', begin + 1);
+  if (end == std::string_view::npos || end == begin + 1) {
+    return key;
+  }
+  return key.substr(begin + 1, end - begin - 1);
+}
+
+std::uint64_t redis::RedisShardRing::hash(std::string_view key) {
+  /*FNV-1a, stable across compilers unlike std::hash*/
+  std::uint64_t h = 14695981039346656037ULL;
+  for (unsigned char c : key) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+
+  /*spread similar inputs such as virtual node names over the ring*/
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
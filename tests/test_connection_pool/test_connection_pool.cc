@@ -0,0 +1,138 @@
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <service/ConnectionPool.hpp>
+#include <thread>
+#include <vector>
+
+struct FakeConnection {
+  int id;
+};
+
+// A pool with three connections, the same way redis/mysql pools are built
+class FakePool : public connection::ConnectionPool<FakePool, FakeConnection> {
+  friend class Singleton<FakePool>;
+
+  FakePool() {
+    for (int i = 0; i < 3; ++i) {
+      add(std::make_unique<FakeConnection>(FakeConnection{i}));
+    }
+  }
+
+public:
+  // a broken connection is replaced, like heartbeat does
+  void reconnect(int id) {
+    add(std::make_unique<FakeConnection>(FakeConnection{id}));
+  }
+};
+
+using FakeRAII = connection::ConnectionRAII<FakePool, FakeConnection>;
+
+TEST(ConnectionPoolTest, NeverHandsOutMoreThanItOwns) {
+  std::atomic<int> in_use{0}, max_in_use{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 16; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 2000; ++i) {
+        FakeRAII raii;
+        ASSERT_TRUE(raii.is_active());
+
+        int current = ++in_use;
+        int seen = max_in_use;
+        while (current > seen &&
+               !max_in_use.compare_exchange_weak(seen, current)) {
+        }
+        if (i % 7 == 0) {
+          std::this_thread::sleep_for(std::chrono::microseconds(20));
+        }
+        --in_use;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_LE(max_in_use.load(), 3);
+  EXPECT_EQ(FakePool::get_instance()->outstanding(), 0);
+}
+
+TEST(ConnectionPoolTest, AcquireGivesUpAtDeadline) {
+  auto pool = FakePool::get_instance();
+  const auto before = pool->statistics().timeouts;
+
+  FakeRAII a(pool, std::chrono::milliseconds(10));
+  FakeRAII b(pool, std::chrono::milliseconds(10));
+  FakeRAII c(pool, std::chrono::milliseconds(10));
+  ASSERT_TRUE(a.is_active() && b.is_active() && c.is_active());
+
+  auto start = std::chrono::steady_clock::now();
+  FakeRAII d(pool, std::chrono::milliseconds(20));
+  EXPECT_FALSE(d.is_active());
+  EXPECT_GE(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(20));
+  EXPECT_EQ(pool->statistics().timeouts, before + 1);
+}
+
+TEST(ConnectionPoolTest, WaiterIsWokenUpByRelease) {
+  auto pool = FakePool::get_instance();
+
+  std::vector<FakePool::stub_ptr> held;
+  for (int i = 0; i < 3; ++i) {
+    held.push_back(std::move(pool->acquire().value()));
+  }
+
+  std::thread releaser([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    pool->release(std::move(held.back()));
+  });
+
+  auto stub = pool->acquire(std::chrono::seconds(5));
+  releaser.join();
+  ASSERT_TRUE(stub.has_value());
+
+  pool->release(std::move(stub.value()));
+  pool->release(std::move(held[0]));
+  pool->release(std::move(held[1]));
+
+  auto statistics = pool->statistics();
+  EXPECT_GE(statistics.waitQuantile(1.0), 1000u);
+}
+
+TEST(ConnectionPoolTest, DiscardedStubIsNotOutstanding) {
+  auto pool = FakePool::get_instance();
+
+  auto stub = pool->acquire();
+  ASSERT_TRUE(stub.has_value());
+  EXPECT_EQ(pool->outstanding(), 1);
+
+  pool->discard(std::move(stub.value()));
+  EXPECT_EQ(pool->outstanding(), 0);
+  pool->reconnect(3);
+
+  FakeRAII a, b, c;
+  EXPECT_TRUE(a.is_active() && b.is_active() && c.is_active());
+}
+
+TEST(ConnectionPoolTest, RAIIGivesUpAtTimeout) {
+  auto pool = FakePool::get_instance();
+  const auto before = pool->statistics();
+
+  {
+    FakeRAII a, b, c;
+    ASSERT_TRUE(a.is_active() && b.is_active() && c.is_active());
+
+    FakeRAII d(std::chrono::milliseconds(10));
+    EXPECT_FALSE(d.is_active());
+  }
+
+  // only what happened after before was taken is reported
+  auto delta = pool->statistics().since(before);
+  EXPECT_EQ(delta.timeouts, 1u);
+  EXPECT_EQ(delta.utilisation[10], 1u);
+  EXPECT_NE(delta.utilisationHistogram().find("100%:1"), std::string::npos);
+
+  FakeRAII e(std::chrono::milliseconds(10));
+  EXPECT_TRUE(e.is_active());
+}
@@ -0,0 +1,51 @@
+#include <chat/MessageTokenizer.hpp>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using Terms = std::vector<std::string>;
+
+TEST(MessageTokenizerTest, SplitsLatinWords) {
+  EXPECT_EQ(chat::MessageTokenizer::tokenize("Hello, World! v2.0"),
+            (Terms{"hello", "world", "v2", "0"}));
+
+  // non-ascii letters are part of the word
+  EXPECT_EQ(chat::MessageTokenizer::tokenize("caf\xC3\xA9 ok"),
+            (Terms{"caf\xC3\xA9", "ok"}));
+
+  // duplicated terms are kept for term frequency
+  EXPECT_EQ(chat::MessageTokenizer::tokenize("ha ha"), (Terms{"ha", "ha"}));
+}
+
+TEST(MessageTokenizerTest, SplitsCJKIntoCharactersAndBigrams) {
+  // "北京欢"
+  EXPECT_EQ(chat::MessageTokenizer::tokenize(
+                "\xE5\x8C\x97\xE4\xBA\xAC\xE6\xAC\xA2"),
+            (Terms{"\xE5\x8C\x97", "\xE5\x8C\x97\xE4\xBA\xAC", "\xE4\xBA\xAC",
+                   "\xE4\xBA\xAC\xE6\xAC\xA2", "\xE6\xAC\xA2"}));
+
+  // CJK punctuation "，" breaks the run, latin word breaks it as well
+  EXPECT_EQ(chat::MessageTokenizer::tokenize(
+                "\xE5\x8C\x97\xEF\xBC\x8C\xE4\xBA\xAC" "ok\xE6\xAC\xA2"),
+            (Terms{"\xE5\x8C\x97", "\xE4\xBA\xAC", "ok", "\xE6\xAC\xA2"}));
+}
+
+TEST(MessageTokenizerTest, FoldsFullwidthLetters) {
+  // "ＡＢｃ１"
+  EXPECT_EQ(chat::MessageTokenizer::tokenize(
+                "\xEF\xBC\xA1\xEF\xBC\xA2\xEF\xBD\x83\xEF\xBC\x91"),
+            (Terms{"abc1"}));
+}
+
+TEST(MessageTokenizerTest, SkipsSymbolsAndBrokenBytes) {
+  // emoji separates words
+  EXPECT_EQ(chat::MessageTokenizer::tokenize("ok\xF0\x9F\x98\x80go"),
+            (Terms{"ok", "go"}));
+
+  // invalid lead byte and truncated sequence
+  EXPECT_EQ(chat::MessageTokenizer::tokenize("\xFF" "abc\xE4\xBD"),
+            (Terms{"abc"}));
+
+  EXPECT_TRUE(chat::MessageTokenizer::tokenize("").empty());
+  EXPECT_TRUE(chat::MessageTokenizer::tokenize(std::string(100, 'a')).empty());
+}
@@ -0,0 +1,46 @@
+#include "request_samples.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Prints the cost of both ways, it is not part of the unit tests
+int main(int argc, char **argv) {
+  const std::size_t rounds =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+  if (!rounds) {
+    std::cerr << "usage: " << argv[0] << " [rounds]" << std::endl;
+    return 1;
+  }
+
+  for (std::size_t n : {1, 10, 100}) {
+    auto body = TextChatRequest(n);
+    std::size_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+      sink += ReadByBoostJson(body);
+    }
+    auto boost_cost = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < rounds; ++i) {
+      sink += ReadByRequestView(body);
+    }
+    auto view_cost = std::chrono::steady_clock::now() - start;
+
+    std::cout << "text_msg = " << n << ", body = " << body.size()
+              << " bytes, boost::json = "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     boost_cost)
+                         .count() /
+                     rounds
+              << " ns/op, RequestView = "
+              << std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     view_cost)
+                         .count() /
+                     rounds
+              << " ns/op, sink = " << sink << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef _REQUEST_SAMPLES_HPP_
+#define _REQUEST_SAMPLES_HPP_
+#include <boost/json.hpp>
+#include <handler/RequestView.hpp>
+#include <string>
+
+// Text message request which is sent by client, with n messages inside
+inline std::string TextChatRequest(std::size_t n) {
+  boost::json::object root;
+  boost::json::array arr;
+  for (std::size_t i = 0; i < n; ++i) {
+    boost::json::object obj;
+    obj["msg_content"] = std::string(64, 'a' + i % 26);
+    obj["msg_receiver"] = "10002";
+    obj["msg_sender"] = "10001";
+    obj["unique_id"] = "6f1c2a4e-0b7d-4c1e-9a53-" + std::to_string(i);
+    arr.push_back(std::move(obj));
+  }
+  root["text_msg"] = std::move(arr);
+  root["text_receiver"] = "10002";
+  root["text_sender"] = "10001";
+  root["thread_id"] = "42";
+  return boost::json::serialize(root);
+}
+
+// The way handlers read requests before, every field is copied out
+inline std::size_t ReadByBoostJson(const std::string &body) {
+  auto root = boost::json::parse(body).as_object();
+  std::size_t total =
+      boost::json::value_to<std::string>(root["thread_id"]).size() +
+      boost::json::value_to<std::string>(root["text_sender"]).size() +
+      boost::json::value_to<std::string>(root["text_receiver"]).size();
+  for (auto &item : root["text_msg"].as_array()) {
+    auto obj = item.as_object();
+    total += boost::json::value_to<std::string>(obj["unique_id"]).size() +
+             boost::json::value_to<std::string>(obj["msg_content"]).size();
+  }
+  return total;
+}
+
+inline std::size_t ReadByRequestView(const std::string &body) {
+  auto root = RequestView::parse(body);
+  std::size_t total = root->getString("thread_id")->size() +
+                      root->getString("text_sender")->size() +
+                      root->getString("text_receiver")->size();
+  for (const auto &obj : *root->getObjects("text_msg")) {
+    total += obj.getString("unique_id")->size() +
+             obj.getString("msg_content")->size();
+  }
+  return total;
+}
+
+#endif //_REQUEST_SAMPLES_HPP_
@@ -0,0 +1,98 @@
+#include "request_samples.hpp"
+#include <boost/json.hpp>
+#include <gtest/gtest.h>
+#include <handler/RequestView.hpp>
+#include <handler/ServiceSchema.hpp>
+#include <string>
+
+TEST(RequestViewTest, ReadsFields) {
+  auto view = RequestView::parse(
+      R"({"uuid":"1","extended_frame":true,"count":7,"list":[{"a":"b"},3]})");
+  ASSERT_TRUE(view.has_value());
+  EXPECT_EQ(view->getString("uuid"), std::string_view("1"));
+  EXPECT_EQ(view->getBool("extended_frame"), true);
+  EXPECT_EQ(view->getUInt("count"), 7u);
+  EXPECT_TRUE(view->contains("list"));
+  EXPECT_FALSE(view->contains("token"));
+
+  // wrong type is reported as missing
+  EXPECT_FALSE(view->getString("count").has_value());
+
+  // non-object items are skipped
+  auto list = view->getObjects("list");
+  ASSERT_TRUE(list.has_value());
+  ASSERT_EQ(list->size(), 1u);
+  EXPECT_EQ((*list)[0].getString("a"), std::string_view("b"));
+}
+
+TEST(RequestViewTest, RejectsBrokenRequest) {
+  EXPECT_FALSE(RequestView::parse("").has_value());
+  EXPECT_FALSE(RequestView::parse("[1,2]").has_value());
+  EXPECT_FALSE(RequestView::parse(R"({"uuid":)").has_value());
+}
+
+TEST(RequestViewTest, MatchesBoostJson) {
+  for (std::size_t n : {1, 10, 100}) {
+    auto body = TextChatRequest(n);
+    EXPECT_EQ(ReadByBoostJson(body), ReadByRequestView(body));
+  }
+}
+
+TEST(RequestSchemaTest, DecodesTypedRequest) {
+  auto view = RequestView::parse(
+      R"({"uuid":"10001","thread_id":"42","msg_id":"7","extra":1})");
+  ASSERT_TRUE(view.has_value());
+
+  auto request = schema::decode<schema::MarkReadRequest>(*view);
+  ASSERT_TRUE(request.has_value());
+  EXPECT_EQ(request->uuid, 10001u);
+  EXPECT_EQ(request->thread_id, 42u);
+  EXPECT_EQ(request->msg_id, 7u);
+
+  // msg_id is not a number
+  view = RequestView::parse(
+      R"({"uuid":"10001","thread_id":"42","msg_id":"x"})");
+  ASSERT_TRUE(view.has_value());
+  EXPECT_FALSE(schema::decode<schema::MarkReadRequest>(*view).has_value());
+}
+
+TEST(RequestSchemaTest, DecodesNestedAndOptionalFields) {
+  auto body = TextChatRequest(3);
+  auto view = RequestView::parse(body);
+  ASSERT_TRUE(view.has_value());
+
+  auto request = schema::decode<schema::TextChatMsgRequest>(*view);
+  ASSERT_TRUE(request.has_value());
+  EXPECT_FALSE(request->isGroupChat());
+  EXPECT_EQ(request->text_receiver, std::string_view("10002"));
+  ASSERT_EQ(request->text_msg.size(), 3u);
+  EXPECT_EQ(request->text_msg[2].msg_content, std::string(64, 'c'));
+
+  // message without content
+  view = RequestView::parse(
+      R"({"thread_id":"42","text_sender":"1","text_msg":[{"unique_id":"a"}]})");
+  ASSERT_TRUE(view.has_value());
+  EXPECT_FALSE(schema::decode<schema::TextChatMsgRequest>(*view).has_value());
+}
+
+TEST(RequestSchemaTest, EncodesResponse) {
+  schema::MarkReadResponse response;
+  response.uuid = 10001;
+  response.thread_id = 42;
+  response.msg_id = 7;
+
+  auto root = boost::json::parse(schema::encode(response)).as_object();
+  EXPECT_EQ(root["error"].as_int64(), 0);
+  EXPECT_EQ(root["uuid"].as_string(), "10001");
+  EXPECT_EQ(root["thread_id"].as_string(), "42");
+  EXPECT_EQ(root["msg_id"].as_string(), "7");
+
+  // strings are escaped
+  schema::TextChatMsgItem item;
+  item.unique_id = "a\"b";
+  item.msg_content = "line\n\x01";
+  auto obj = boost::json::parse(schema::encode(item)).as_object();
+  EXPECT_EQ(obj["unique_id"].as_string(), "a\"b");
+  EXPECT_EQ(obj["msg_content"].as_string(), "line\n\x01");
+  EXPECT_FALSE(obj.contains("msg_sender"));
+}